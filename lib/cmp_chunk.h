@@ -77,7 +77,9 @@
 struct cmp_par {
 	enum cmp_mode cmp_mode;		/**< compression mode parameter */
 	uint32_t model_value;		/**< model weighting parameter */
-	uint32_t lossy_par;		/**< lossy compression parameter */
+	uint32_t lossy_par;		/**< lossy compression parameter; only used for offset, background and smearing chunks in a non-raw mode,
+					 * where all fields of the chunk (means, variances and outlier pixel counts) are rounded
+					 */
 
 	uint32_t nc_imagette;		/**< compression parameter for imagette compression */
 
@@ -162,10 +164,11 @@ void compress_chunk_init(uint64_t (*return_timestamp)(void), uint32_t version_id
  *				model mode compression; has the same size as the
  *				chunk (can be the same as the model_of_data
  *				buffer for in-place update or NULL if updated
- *				model is not needed)
+ *				model is not needed); not used if dst is NULL
  * @param dst			destination pointer to the compressed data
  *				buffer; has to be 4-byte aligned; can be NULL to
- *				only get the compressed data size
+ *				only get the compressed data size, in this case
+ *				no updated model is created
  * @param dst_capacity		capacity of the dst buffer; it's recommended to
  *				provide a dst_capacity >=
  *				compress_chunk_cmp_size_bound(chunk, chunk_size)
@@ -184,6 +187,560 @@ uint32_t compress_chunk(const void *chunk, uint32_t chunk_size,
 			const struct cmp_par *cmp_par);
 
 
+/**
+ * @brief function type executing the jobs of compress_chunk_parallel() and
+ *	decompress_cmp_entity_mt()
+ *
+ * The function has to call job(job_arg, i) exactly once for every i in the
+ * range [0, n_jobs). The jobs are independent from each other and can be
+ * executed in any order and in parallel. The function returns after all jobs
+ * are finished.
+ *
+ * @param job		job function to execute
+ * @param job_arg	argument passed to every job
+ * @param n_jobs	number of jobs to execute
+ * @param pool		opaque pointer given to compress_chunk_parallel() or
+ *			decompress_cmp_entity_mt(), e.g. a thread pool
+ */
+
+typedef void (*cmp_run_jobs_func)(void (*job)(void *job_arg, uint32_t i),
+				  void *job_arg, uint32_t n_jobs, void *pool);
+
+
+/**
+ * @brief chunk compression context
+ *
+ * Holds the settings of the chunk compression which would otherwise be
+ * process-wide, so that several compressions with different settings can run
+ * at the same time. Initialise it with cmp_ctx_init().
+ */
+
+struct cmp_ctx {
+	uint64_t (*return_timestamp)(void); /**< function returning a current 48-bit timestamp; can be NULL */
+	uint32_t version_id;                /**< application software version identifier */
+	void *work_buf;                     /**< work buffer for the parallel compression; can be NULL */
+	uint32_t work_buf_size;             /**< byte size of the work buffer */
+	cmp_run_jobs_func run_jobs;         /**< function executing the compression jobs; can be NULL */
+	void *pool;                         /**< opaque pointer passed to the run_jobs function */
+	int col_pars;                       /**< non-zero if the parameters are selected per collection (see cmp_ctx_set_col_pars()) */
+	int equal_model;                    /**< non-zero if collections equal to their model are stored without data (see cmp_ctx_set_equal_model()) */
+	struct {
+		struct cmp_cfg cfg;         /**< compression configuration of the chunk */
+		struct cmp_par par;         /**< copy of the compression parameters */
+		uint32_t *dst;              /**< destination buffer; can be NULL */
+		uint32_t dst_capacity;      /**< capacity of the dst buffer */
+		uint32_t cmp_size;          /**< compressed size so far; 0 if no compression is started; or an error code */
+		uint32_t chunk_size;        /**< size of the collections added so far */
+		int chunk_type;             /**< chunk type of the first collection */
+		uint64_t start_timestamp;   /**< start timestamp of the compression */
+	} stream;                           /**< state of the compress_chunk_begin() and compress_chunk_resume_begin() compression */
+	struct {
+		const uint8_t *chunk;       /**< chunk to compress */
+		const uint8_t *chunk_model; /**< model of the chunk; can be NULL */
+		uint8_t *updated_chunk_model; /**< buffer for the updated model of the chunk; can be NULL */
+		uint32_t *col_buf;          /**< buffer for one compressed collection */
+		uint32_t col_buf_size;      /**< byte size of the collection buffer */
+		uint32_t read_bytes;        /**< size of the already compressed collections */
+		const uint8_t *pending;     /**< compressed bytes not yet put into an output buffer */
+		uint32_t pending_size;      /**< number of pending bytes */
+		uint32_t hdr[NON_IMAGETTE_HEADER_SIZE/4]; /**< compression entity header */
+	} resume;                           /**< state of the compress_chunk_resume_begin() compression */
+};
+
+
+/**
+ * @brief size of the collection buffer needed by compress_chunk_resume_begin()
+ *	to compress collections of any size
+ */
+
+#define COMPRESS_CHUNK_RESUME_COL_BUF_SIZE \
+	ROUND_UP_TO_4(3 + CMP_COLLECTION_FILD_SIZE + COLLECTION_HDR_SIZE + UINT16_MAX)
+
+
+/**
+ * @brief return value of compress_chunk_resume() if the output buffer is full
+ *	and the compression is not completed
+ */
+
+#define CMP_NEED_MORE_OUTPUT	1U
+
+
+/**
+ * @brief maximum number of bytes of a back-patch entry
+ */
+
+#define CMP_PATCH_MAX_SIZE	8
+
+
+/**
+ * @brief back-patch entry; bytes of the compression entity which are only
+ *	known after the entity is put into the output buffers
+ */
+
+struct cmp_patch {
+	uint32_t offset;                  /**< byte offset in the compression entity */
+	uint32_t size;                    /**< number of bytes to patch */
+	uint8_t data[CMP_PATCH_MAX_SIZE]; /**< bytes to write at the offset */
+};
+
+
+/**
+ * @brief back-patch table of a compress_chunk_resume() compression
+ */
+
+struct cmp_patch_table {
+	uint32_t n_patches;          /**< number of used entries */
+	struct cmp_patch patch[2];   /**< compression entity size and end timestamp */
+};
+
+
+/**
+ * @brief get the size of the work buffer needed by compress_chunk_parallel()
+ *
+ * @param chunk		pointer to the chunk to be compressed
+ * @param chunk_size	byte size of the chunk
+ *
+ * @returns the needed work buffer size in bytes or an error code if it fails
+ *	(which can be tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_parallel_work_size(const void *chunk, uint32_t chunk_size);
+
+
+/**
+ * @brief compress a data chunk with the collections compressed in parallel
+ *
+ * The collections of the chunk are compressed independently from each other
+ * by jobs executed with the run_jobs function; afterwards the compressed
+ * collections are put together into the dst buffer. The result is identical
+ * to the result of compress_chunk().
+ * The library does not create threads or allocate memory itself; the thread
+ * pool and the work buffer are provided by the caller.
+ * The compression is done sequentially by compress_chunk() if no run_jobs
+ * function or work buffer is provided, if the work buffer is smaller than
+ * compress_chunk_parallel_work_size() or if dst_capacity is smaller than
+ * compress_chunk_cmp_size_bound().
+ *
+ * @param chunk			pointer to the chunk to be compressed
+ * @param chunk_size		byte size of the chunk
+ * @param chunk_model		pointer to a model of a chunk; has the same size
+ *				as the chunk (can be NULL if no model compression
+ *				mode is used)
+ * @param updated_chunk_model	pointer to store the updated model for the next
+ *				model mode compression; has the same size as the
+ *				chunk (can be the same as the model_of_data
+ *				buffer for in-place update or NULL if updated
+ *				model is not needed); not used if dst is NULL
+ * @param dst			destination pointer to the compressed data
+ *				buffer; has to be 4-byte aligned; can be NULL to
+ *				only get the compressed data size
+ * @param dst_capacity		capacity of the dst buffer
+ * @param cmp_par		pointer to a compression parameters struct
+ * @param work_buf		pointer to a work buffer; has to be aligned for
+ *				pointer access; must not overlap with any other
+ *				buffer
+ * @param work_buf_size		byte size of the work buffer
+ * @param run_jobs		function executing the compression jobs
+ * @param pool			opaque pointer passed to the run_jobs function
+ *
+ * @returns the byte size of the compressed data or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_parallel(const void *chunk, uint32_t chunk_size,
+				 const void *chunk_model, void *updated_chunk_model,
+				 uint32_t *dst, uint32_t dst_capacity,
+				 const struct cmp_par *cmp_par,
+				 void *work_buf, uint32_t work_buf_size,
+				 cmp_run_jobs_func run_jobs, void *pool);
+
+
+/**
+ * @brief initialise a compression context
+ *
+ * A compression context holds the settings of the chunk compression, so that
+ * compressions with different settings can run at the same time. The context
+ * is owned by the caller; the library does not allocate any memory. The
+ * collections are compressed sequentially until a work buffer is set with
+ * cmp_ctx_set_parallel().
+ *
+ * @param ctx			pointer to the compression context to initialise
+ * @param return_timestamp	pointer to a function returning a current 48-bit
+ *				timestamp; can be NULL, then the timestamps in
+ *				the compression entity header are set to zero
+ * @param version_id		application software version identifier
+ */
+
+void cmp_ctx_init(struct cmp_ctx *ctx, uint64_t (*return_timestamp)(void),
+		  uint32_t version_id);
+
+
+/**
+ * @brief set up a compression context to compress the collections of a
+ *	chunk in parallel
+ *
+ * @param ctx		pointer to an initialised compression context
+ * @param work_buf	pointer to a work buffer; has to be aligned for pointer
+ *			access; must not overlap with any other buffer; can
+ *			be NULL to compress sequentially
+ * @param work_buf_size	byte size of the work buffer; should be at least
+ *			compress_chunk_parallel_work_size() of the largest
+ *			chunk to compress
+ * @param run_jobs	function executing the compression jobs
+ * @param pool		opaque pointer passed to the run_jobs function
+ *
+ * @note a context with a work buffer must not be used by more than one
+ *	compression at the same time
+ */
+
+void cmp_ctx_set_parallel(struct cmp_ctx *ctx, void *work_buf, uint32_t work_buf_size,
+			  cmp_run_jobs_func run_jobs, void *pool);
+
+
+/**
+ * @brief enable or disable the selection of the compression parameters per
+ *	collection
+ *
+ * If enabled, the compressor estimates the best compression parameters for
+ * every collection from a histogram of its residuals. Parameters which save
+ * more than they cost are stored as overrides after the compressed data of
+ * the collection. The compression entity is marked with the
+ * CMP_ENT_FLAG_COL_PARS flag in the reserved field of the header; every
+ * compressed (not raw) collection has a parameter override field, also if no
+ * parameter is overridden. The compressed size is never larger than
+ * compress_chunk_cmp_size_bound(). The selection needs some extra passes over
+ * the data and the collections are always compressed sequentially. The
+ * setting is disabled by cmp_ctx_init().
+ *
+ * @param ctx		pointer to an initialised compression context
+ * @param enable	non-zero to enable the per-collection parameters
+ */
+
+void cmp_ctx_set_col_pars(struct cmp_ctx *ctx, int enable);
+
+
+/**
+ * @brief enable or disable the storage of collections identical to their
+ *	model without compressed data
+ *
+ * If enabled, a collection whose data are equal to its model data is stored
+ * in a lossless model mode as the collection header with a compressed data
+ * size of zero; the updated model is a copy of the data. The compression
+ * entity is marked with the CMP_ENT_FLAG_EQUAL_MODEL flag in the reserved
+ * field of the header. Decompressors without support for the flag can not
+ * decompress such an entity. The setting is disabled by cmp_ctx_init().
+ *
+ * @param ctx		pointer to an initialised compression context
+ * @param enable	non-zero to enable the shortcut for collections equal
+ *			to their model
+ */
+
+void cmp_ctx_set_equal_model(struct cmp_ctx *ctx, int enable);
+
+
+/**
+ * @brief compress a data chunk with the settings of a compression context
+ *
+ * The result is identical to the result of compress_chunk() with the same
+ * timestamp function and version identifier, unless the per-collection
+ * parameters are enabled with cmp_ctx_set_col_pars() or the shortcut for
+ * collections equal to their model is enabled with cmp_ctx_set_equal_model().
+ * If a work buffer is set with cmp_ctx_set_parallel() the collections are
+ * compressed in parallel as described for compress_chunk_parallel().
+ *
+ * @param ctx			pointer to a compression context initialised
+ *				with cmp_ctx_init()
+ * @param chunk			pointer to the chunk to be compressed
+ * @param chunk_size		byte size of the chunk
+ * @param chunk_model		pointer to a model of a chunk; has the same size
+ *				as the chunk (can be NULL if no model compression
+ *				mode is used)
+ * @param updated_chunk_model	pointer to store the updated model for the next
+ *				model mode compression; has the same size as the
+ *				chunk (can be the same as the model_of_data
+ *				buffer for in-place update or NULL if updated
+ *				model is not needed); not used if dst is NULL
+ * @param dst			destination pointer to the compressed data
+ *				buffer; has to be 4-byte aligned; can be NULL to
+ *				only get the compressed data size
+ * @param dst_capacity		capacity of the dst buffer
+ * @param cmp_par		pointer to a compression parameters struct
+ *
+ * @returns the byte size of the compressed data or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_ctx(const struct cmp_ctx *ctx,
+			    const void *chunk, uint32_t chunk_size,
+			    const void *chunk_model, void *updated_chunk_model,
+			    uint32_t *dst, uint32_t dst_capacity,
+			    const struct cmp_par *cmp_par);
+
+
+/**
+ * @brief compress many data chunks with the same compression parameters
+ *
+ * The compression parameters are prepared only once for every chunk type and
+ * the code word tables are shared by all chunks. Every chunk gives the same
+ * result as compress_chunk_ctx() with the same context. If the context has a
+ * run_jobs function (see cmp_ctx_set_parallel()) the chunks are compressed in
+ * parallel, one job per chunk; the work buffer of the context is not needed.
+ * In this case the timestamp function of the context has to be thread-safe.
+ *
+ * @param ctx			pointer to a compression context initialised
+ *				with cmp_ctx_init()
+ * @param n_chunks		number of chunks to compress
+ * @param chunks		array of pointers to the chunks to compress
+ * @param chunk_sizes		array with the byte sizes of the chunks
+ * @param chunk_models		array of pointers to the models of the chunks
+ *				(can be NULL if no model compression mode is
+ *				used)
+ * @param updated_chunk_models	array of pointers to store the updated models
+ *				(can be NULL if the updated models are not
+ *				needed)
+ * @param dst			array of destination pointers to the
+ *				compressed data buffers; has to be 4-byte
+ *				aligned; can be NULL to only get the compressed
+ *				data sizes
+ * @param dst_capacities	array with the capacities of the dst buffers;
+ *				can be NULL if dst is NULL
+ * @param cmp_par		pointer to a compression parameters struct used
+ *				for all chunks
+ * @param cmp_sizes		array to store the byte size of the compressed
+ *				data or an error code (which can be tested with
+ *				cmp_is_error()) for every chunk
+ *
+ * @returns the number of successfully compressed chunks or an error code if
+ *	the arguments of the batch are invalid (which can be tested with
+ *	cmp_is_error())
+ */
+
+uint32_t compress_chunks_batch(const struct cmp_ctx *ctx, uint32_t n_chunks,
+			       const void *const chunks[], const uint32_t chunk_sizes[],
+			       const void *const chunk_models[], void *const updated_chunk_models[],
+			       uint32_t *const dst[], const uint32_t dst_capacities[],
+			       const struct cmp_par *cmp_par, uint32_t cmp_sizes[]);
+
+
+/**
+ * @brief compress a data chunk so that the compression entity fits in a
+ *	maximum size
+ *
+ * The compressed size with the given compression parameters is calculated
+ * first (without writing any data). If it is larger than max_cmp_size, the
+ * compression parameters used by the chunk type are tuned one after another
+ * with size-only trial compressions until the compressed size fits. Only then
+ * the chunk is compressed into the dst buffer. The tuned parameters are
+ * returned in cmp_par, so they can be the starting point for the next chunk.
+ *
+ * @param ctx			pointer to a compression context initialised
+ *				with cmp_ctx_init()
+ * @param chunk			pointer to the chunk to be compressed
+ * @param chunk_size		byte size of the chunk
+ * @param chunk_model		pointer to a model of a chunk; has the same size
+ *				as the chunk (can be NULL if no model compression
+ *				mode is used)
+ * @param updated_chunk_model	pointer to store the updated model for the next
+ *				model mode compression; has the same size as the
+ *				chunk (can be the same as the model_of_data
+ *				buffer for in-place update or NULL if updated
+ *				model is not needed); not used if dst is NULL
+ * @param dst			destination pointer to the compressed data
+ *				buffer; has to be 4-byte aligned; can be NULL to
+ *				only tune the compression parameters
+ * @param max_cmp_size		maximum byte size of the compression entity;
+ *				the dst buffer must be at least this large;
+ *				size is internally rounded down to a multiple
+ *				of 4
+ * @param cmp_par		pointer to a compression parameters struct with
+ *				valid start parameters; the tuned parameters
+ *				are stored there
+ *
+ * @returns the byte size of the compressed data or an error code if it
+ *	fails (which can be tested with cmp_is_error()); if no parameters are
+ *	found for which the chunk fits, a CMP_ERROR_SMALL_BUFFER error is
+ *	returned
+ */
+
+uint32_t compress_chunk_to_budget(const struct cmp_ctx *ctx,
+				  const void *chunk, uint32_t chunk_size,
+				  const void *chunk_model, void *updated_chunk_model,
+				  uint32_t *dst, uint32_t max_cmp_size,
+				  struct cmp_par *cmp_par);
+
+
+/**
+ * @brief start the compression of a chunk collection by collection
+ *
+ * The collections of the chunk are added one after another with
+ * compress_chunk_add_collection() as they arrive; compress_chunk_finish()
+ * completes the compression entity. The chunk does not need to exist in one
+ * contiguous buffer. The result is identical to the result of
+ * compress_chunk_ctx() of the concatenated collections (compressed
+ * sequentially).
+ *
+ * @param ctx		pointer to a compression context initialised with
+ *			cmp_ctx_init(); holds the state of the compression
+ *			until compress_chunk_finish() is called
+ * @param dst		destination pointer to the compressed data buffer; has
+ *			to be 4-byte aligned; can be NULL to only get the
+ *			compressed data size, in this case no updated model
+ *			is created
+ * @param dst_capacity	capacity of the dst buffer
+ * @param cmp_par	pointer to a compression parameters struct; the
+ *			parameters are copied into the context
+ *
+ * @returns the byte size of the compression entity header reserved in the dst
+ *	buffer or an error code if it fails (which can be tested with
+ *	cmp_is_error())
+ */
+
+uint32_t compress_chunk_begin(struct cmp_ctx *ctx, uint32_t *dst, uint32_t dst_capacity,
+			      const struct cmp_par *cmp_par);
+
+
+/**
+ * @brief compress the next collection of a chunk started with
+ *	compress_chunk_begin()
+ *
+ * After an error, the compression has to be restarted with
+ * compress_chunk_begin(); all following calls return the same error.
+ *
+ * @param ctx		pointer to the compression context
+ * @param col		pointer to the collection (collection header followed
+ *			by the collection data)
+ * @param model_col	pointer to the model of the collection; has the same
+ *			size as the collection (can be NULL if no model
+ *			compression mode is used)
+ * @param up_model_col	pointer to store the updated model of the collection;
+ *			has the same size as the collection (can be the same
+ *			as the model_col buffer for in-place update or NULL if
+ *			updated model is not needed)
+ *
+ * @returns the byte size of the compressed data so far (including the
+ *	compression entity header) or an error code if it fails (which can be
+ *	tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_add_collection(struct cmp_ctx *ctx, const void *col,
+				       const void *model_col, void *up_model_col);
+
+
+/**
+ * @brief complete the compression of a chunk started with
+ *	compress_chunk_begin() by building the compression entity header
+ *
+ * @param ctx	pointer to the compression context
+ *
+ * @returns the byte size of the compressed data (size of the compression
+ *	entity) or an error code if it fails (which can be tested with
+ *	cmp_is_error())
+ */
+
+uint32_t compress_chunk_finish(struct cmp_ctx *ctx);
+
+
+/**
+ * @brief start a resumable compression of a chunk, which puts the compression
+ *	entity piece by piece into output buffers of any size
+ *
+ * The collections are compressed one after another into the collection buffer
+ * and copied from there into the output buffers given to
+ * compress_chunk_resume(). No buffer for the whole compression entity is
+ * needed. The fields of the entity header which are only known at the end
+ * (entity size and end timestamp) are returned as back-patch table by
+ * compress_chunk_resume_finish(). After applying the back-patch table, the
+ * compression entity is identical to the result of compress_chunk_ctx() with
+ * the same context.
+ *
+ * @param ctx			pointer to a compression context initialised
+ *				with cmp_ctx_init(); holds the state of the
+ *				compression until compress_chunk_resume_finish()
+ *				is called
+ * @param chunk			pointer to the chunk to be compressed; has to
+ *				stay valid until the compression is finished
+ * @param chunk_size		byte size of the chunk
+ * @param chunk_model		pointer to a model of a chunk; has the same size
+ *				as the chunk (can be NULL if no model compression
+ *				mode is used)
+ * @param updated_chunk_model	pointer to store the updated model for the next
+ *				model mode compression; has the same size as the
+ *				chunk (can be the same as the model_of_data
+ *				buffer for in-place update or NULL if updated
+ *				model is not needed)
+ * @param col_buf		pointer to a buffer for one compressed
+ *				collection; has to be 4-byte aligned
+ * @param col_buf_size		byte size of the collection buffer; has to be
+ *				at least 3 + CMP_COLLECTION_FILD_SIZE + the size
+ *				of the largest collection of the chunk (see
+ *				COMPRESS_CHUNK_RESUME_COL_BUF_SIZE)
+ * @param cmp_par		pointer to a compression parameters struct; the
+ *				parameters are copied into the context
+ *
+ * @returns the byte size of the compression entity header or an error code if
+ *	it fails (which can be tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_resume_begin(struct cmp_ctx *ctx,
+				     const void *chunk, uint32_t chunk_size,
+				     const void *chunk_model, void *updated_chunk_model,
+				     uint32_t *col_buf, uint32_t col_buf_size,
+				     const struct cmp_par *cmp_par);
+
+
+/**
+ * @brief continue a compression started with compress_chunk_resume_begin()
+ *	and put the next part of the compression entity into an output buffer
+ *
+ * After an error, the compression has to be restarted with
+ * compress_chunk_resume_begin(); all following calls return the same error.
+ *
+ * @param ctx		pointer to the compression context
+ * @param dst		pointer to the output buffer
+ * @param dst_capacity	byte size of the output buffer
+ * @param dst_size	pointer to store the number of bytes put into the output
+ *			buffer
+ *
+ * @returns 0 if the compression entity is complete, CMP_NEED_MORE_OUTPUT if
+ *	the output buffer is full and the function has to be called again with
+ *	the next output buffer, or an error code if it fails (which can be
+ *	tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_resume(struct cmp_ctx *ctx, void *dst, uint32_t dst_capacity,
+			       uint32_t *dst_size);
+
+
+/**
+ * @brief complete a compression started with compress_chunk_resume_begin()
+ *
+ * @param ctx		pointer to the compression context
+ * @param patches	pointer to store the back-patch table; the entries have
+ *			to be applied to the output buffers (see
+ *			compress_chunk_apply_patches())
+ *
+ * @returns the byte size of the compression entity or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_resume_finish(struct cmp_ctx *ctx, struct cmp_patch_table *patches);
+
+
+/**
+ * @brief apply the entries of a back-patch table to a part of a compression
+ *	entity
+ *
+ * @param buf		pointer to the part of the compression entity, e.g. an
+ *			output buffer of compress_chunk_resume()
+ * @param buf_offset	byte offset of the part in the compression entity
+ * @param buf_size	byte size of the part
+ * @param patches	pointer to the back-patch table
+ */
+
+void compress_chunk_apply_patches(void *buf, uint32_t buf_offset, uint32_t buf_size,
+				  const struct cmp_patch_table *patches);
+
+
 /**
  * @brief set the model id and model counter in the compression entity header
  *
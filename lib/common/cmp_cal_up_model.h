@@ -20,6 +20,9 @@
 #define CMP_CAL_UP_MODEL_H
 
 #include <stdint.h>
+#include <stddef.h>
+
+#include "compiler.h"
 
 
 /* the maximal model values used in the update equation for the new model */
@@ -99,20 +102,90 @@ static __inline uint16_t cmp_up_model16(uint32_t data, uint32_t model,
 }
 
 
-/* slow calculation for uint32_t data size */
+/*
+ * calculation for uint32_t data size without 64-bit arithmetic
+ * The weighted sum of the data and the model can need up to 36 bits. Therefore,
+ * the values are split into the part divisible by MAX_MODEL_VALUE and the
+ * remainder; the weighted sum of the divisible parts divided by
+ * MAX_MODEL_VALUE fits in 32 bits, the remainders only contribute the carry.
+ * The result is the same as with a 64-bit calculation.
+ */
 static __inline uint32_t cmp_up_model32(uint32_t data, uint32_t model,
 				      unsigned int model_value, unsigned int round)
 {
 	/* round and round back input because for decompression the accurate
 	 * data values are not available
-	 * cast to uint64_t to prevent overflow in the multiplication
 	 */
-	uint64_t const weighted_data = (uint64_t)round_inv(round_fwd(data, round), round)
-		* (MAX_MODEL_VALUE - model_value);
-	uint64_t const weighted_model = (uint64_t)model * model_value;
+	uint32_t const data_r = round_inv(round_fwd(data, round), round);
+	uint32_t const data_weight = MAX_MODEL_VALUE - model_value;
+
+	uint32_t const weighted_high = (model / MAX_MODEL_VALUE) * model_value
+		+ (data_r / MAX_MODEL_VALUE) * data_weight;
+	uint32_t const weighted_low = (model % MAX_MODEL_VALUE) * model_value
+		+ (data_r % MAX_MODEL_VALUE) * data_weight;
 
 	/* truncation is intended */
-	return (uint32_t)((weighted_model + weighted_data) / MAX_MODEL_VALUE);
+	return weighted_high + weighted_low / MAX_MODEL_VALUE;
+}
+
+
+/**
+ * @brief update the model of an array of 16-bit values
+ * @note the samples are independent of each other, so the loop is vectorised
+ *	by the compiler if possible; use this function instead of calling
+ *	cmp_up_model() for each sample of an array
+ *
+ * @param up_model	pointer to the buffer where the updated model is
+ *			stored; can be the same as the model buffer for an
+ *			in-place update
+ * @param data		pointer to the data
+ * @param model		pointer to the (current) model of the data
+ * @param n		number of samples to process
+ * @param model_value	model weighting parameter
+ * @param round		routing parameter
+ */
+
+static __inline void cmp_up_model16_batch(uint16_t *up_model, const uint16_t *data,
+					  const uint16_t *model, size_t n,
+					  unsigned int model_value, unsigned int round)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		uint16_t const new_model = cmp_up_model16(get_unaligned(&data[i]),
+							  get_unaligned(&model[i]),
+							  model_value, round);
+		put_unaligned(new_model, &up_model[i]);
+	}
+}
+
+
+/**
+ * @brief update the model of an array of 32-bit values
+ * @note see cmp_up_model16_batch()
+ *
+ * @param up_model	pointer to the buffer where the updated model is
+ *			stored; can be the same as the model buffer for an
+ *			in-place update
+ * @param data		pointer to the data
+ * @param model		pointer to the (current) model of the data
+ * @param n		number of samples to process
+ * @param model_value	model weighting parameter
+ * @param round		routing parameter
+ */
+
+static __inline void cmp_up_model32_batch(uint32_t *up_model, const uint32_t *data,
+					  const uint32_t *model, size_t n,
+					  unsigned int model_value, unsigned int round)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		uint32_t const new_model = cmp_up_model32(get_unaligned(&data[i]),
+							  get_unaligned(&model[i]),
+							  model_value, round);
+		put_unaligned(new_model, &up_model[i]);
+	}
 }
 
 #endif /* CMP_CAL_UP_MODEL */
@@ -274,6 +274,7 @@ struct offset {
 	uint32_t mean;
 	uint32_t variance;
 } __attribute__((packed));
+compile_time_assert(sizeof(struct offset) == 2*sizeof(uint32_t), OFFSET_ENTRY_IS_NOT_AN_ARRAY_OF_TWO_UINT32);
 
 
 /**
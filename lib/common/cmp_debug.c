@@ -64,7 +64,7 @@ static void cmp_debug_puts(const char *str)
 
 void cmp_debug_print_impl(const char *fmt, ...)
 {
-	static char print_buffer[PRINT_BUFFER_SIZE];
+	char print_buffer[PRINT_BUFFER_SIZE];
 	int len;
 	va_list args;
 
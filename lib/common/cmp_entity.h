@@ -52,6 +52,10 @@
 
 #define CMP_TOOL_VERSION_ID_BIT 0x80000000U
 
+/* flags of the reserved field of a chunk compression entity */
+#define CMP_ENT_FLAG_COL_PARS 0x01U /* every compressed collection carries parameter overrides */
+#define CMP_ENT_FLAG_EQUAL_MODEL 0x02U /* collections equal to their model have no compressed data */
+
 
 /**
  * @brief PALTO CUC timestamp format
@@ -338,6 +338,100 @@ uint32_t cmp_icu_max_spill(unsigned int cmp_par)
 }
 
 
+/**
+ * @brief get the compression parameter and the spillover threshold of a
+ *	parameter slot of a compression configuration
+ *
+ * @param cfg		pointer to a compression configuration
+ * @param slot		number of the parameter slot (1 to CMP_COL_PAR_SLOTS);
+ *			slot 1 is cmp_par_1/spill_par_1 and so on
+ * @param cmp_par	pointer to store the compression parameter
+ * @param spill		pointer to store the spillover threshold parameter
+ *
+ * @note both parameters are set to 0 for an invalid slot number
+ */
+
+void cmp_cfg_get_par_slot(const struct cmp_cfg *cfg, unsigned int slot,
+			  uint32_t *cmp_par, uint32_t *spill)
+{
+	switch (slot) {
+	case 1:
+		*cmp_par = cfg->cmp_par_1;
+		*spill = cfg->spill_par_1;
+		break;
+	case 2:
+		*cmp_par = cfg->cmp_par_2;
+		*spill = cfg->spill_par_2;
+		break;
+	case 3:
+		*cmp_par = cfg->cmp_par_3;
+		*spill = cfg->spill_par_3;
+		break;
+	case 4:
+		*cmp_par = cfg->cmp_par_4;
+		*spill = cfg->spill_par_4;
+		break;
+	case 5:
+		*cmp_par = cfg->cmp_par_5;
+		*spill = cfg->spill_par_5;
+		break;
+	case 6:
+		*cmp_par = cfg->cmp_par_6;
+		*spill = cfg->spill_par_6;
+		break;
+	default:
+		*cmp_par = 0;
+		*spill = 0;
+		break;
+	}
+}
+
+
+/**
+ * @brief set the compression parameter and the spillover threshold of a
+ *	parameter slot of a compression configuration
+ *
+ * @param cfg		pointer to a compression configuration
+ * @param slot		number of the parameter slot (1 to CMP_COL_PAR_SLOTS);
+ *			an invalid slot number is ignored
+ * @param cmp_par	compression parameter to set
+ * @param spill		spillover threshold parameter to set
+ */
+
+void cmp_cfg_set_par_slot(struct cmp_cfg *cfg, unsigned int slot,
+			  uint32_t cmp_par, uint32_t spill)
+{
+	switch (slot) {
+	case 1:
+		cfg->cmp_par_1 = cmp_par;
+		cfg->spill_par_1 = spill;
+		break;
+	case 2:
+		cfg->cmp_par_2 = cmp_par;
+		cfg->spill_par_2 = spill;
+		break;
+	case 3:
+		cfg->cmp_par_3 = cmp_par;
+		cfg->spill_par_3 = spill;
+		break;
+	case 4:
+		cfg->cmp_par_4 = cmp_par;
+		cfg->spill_par_4 = spill;
+		break;
+	case 5:
+		cfg->cmp_par_5 = cmp_par;
+		cfg->spill_par_5 = spill;
+		break;
+	case 6:
+		cfg->cmp_par_6 = cmp_par;
+		cfg->spill_par_6 = spill;
+		break;
+	default:
+		break;
+	}
+}
+
+
 /**
  * @brief calculate the need bytes to hold a bitstream
  *
@@ -25,6 +25,12 @@
 
 #define CMP_COLLECTION_FILD_SIZE 2
 
+/* per-collection compression parameter overrides (see CMP_ENT_FLAG_COL_PARS) */
+#define CMP_COL_PAR_SLOTS	6 /* number of compression parameter slots (cmp_par_1 to cmp_par_6) */
+#define CMP_COL_PAR_MASK_SIZE	1 /* size of the bit mask of the overridden slots */
+#define CMP_COL_PAR_SIZE	5 /* size of one override: 24-bit spill and 16-bit cmp_par */
+#define CMP_COL_PARS_MAX_SIZE	(CMP_COL_PAR_MASK_SIZE + CMP_COL_PAR_SLOTS * CMP_COL_PAR_SIZE)
+
 
 #define CMP_LOSSLESS	0
 #define CMP_PAR_UNUNSED	0
@@ -133,6 +139,10 @@ enum cmp_mode {
 };
 
 
+struct cw_table_cache; /* code word table cache of the compressor */
+struct col_hist; /* residual histogram of the compressor */
+
+
 /**
  * @brief The cmp_cfg structure can contain the complete configuration for a SW
  *	(de)compression
@@ -226,6 +236,11 @@ struct cmp_cfg {
 		uint32_t spill_background_pixels_error; /**< Spillover threshold parameter for auxiliary science outlier pixels number compression */
 		uint32_t spill_smearing_pixels_error;   /**< Spillover threshold parameter for auxiliary science outlier pixels number compression */
 	};
+	struct cw_table_cache *cw_cache; /**< Pointer to a code word table cache used by the compressor (can be NULL) */
+	uint32_t checked_data_types;     /**< Bit mask of the data types whose compression parameters are already checked (used by the chunk compression) */
+	uint32_t col_pars;               /**< non-zero if the compressed collections carry compression parameter overrides (see CMP_ENT_FLAG_COL_PARS) */
+	uint32_t equal_model;            /**< non-zero if collections equal to their model are stored without compressed data (see CMP_ENT_FLAG_EQUAL_MODEL) */
+	struct col_hist *col_hist;       /**< Pointer to the residual histograms of the parameter slots; only set while the compressor collects them */
 };
 
 
@@ -329,6 +344,10 @@ int cmp_cfg_fx_cob_is_invalid(const struct cmp_cfg *cfg);
 int cmp_cfg_aux_is_invalid(const struct cmp_cfg *cfg);
 uint32_t cmp_ima_max_spill(unsigned int golomb_par);
 uint32_t cmp_icu_max_spill(unsigned int cmp_par);
+void cmp_cfg_get_par_slot(const struct cmp_cfg *cfg, unsigned int slot,
+			  uint32_t *cmp_par, uint32_t *spill);
+void cmp_cfg_set_par_slot(struct cmp_cfg *cfg, unsigned int slot,
+			  uint32_t cmp_par, uint32_t spill);
 
 int cmp_data_type_is_invalid(enum cmp_data_type data_type);
 int rdcu_supported_data_type_is_used(enum cmp_data_type data_type);
@@ -44,6 +44,19 @@
 #define likely(x)      __builtin_expect(!!(x), 1)
 #define unlikely(x)    __builtin_expect(!!(x), 0)
 
+/**
+ * @brief force the compiler to inline a static function
+ *
+ * Used for small functions in the hot path and for function templates which
+ * are specialised by arguments known at compile time.
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define FORCE_INLINE static __inline __attribute__((always_inline))
+#else
+#  define FORCE_INLINE static __inline
+#endif
+
 /**
  *
  * ARRAY_SIZE - get the number of elements in a visible array
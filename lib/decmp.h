@@ -23,10 +23,19 @@
 
 #include "common/cmp_entity.h"
 #include "common/cmp_support.h"
+#include "cmp_chunk.h"
 
 int decompress_cmp_entiy(const struct cmp_entity *ent, const void *model_of_data,
 			 void *up_model_buf, void *decompressed_data);
 
+uint32_t decompress_cmp_entity_mt_work_size(const struct cmp_entity *ent,
+					    uint32_t n_threads);
+
+int decompress_cmp_entity_mt(const struct cmp_entity *ent, const void *model_of_data,
+			     void *up_model_buf, void *decompressed_data,
+			     uint32_t n_threads, void *work_buf, uint32_t work_buf_size,
+			     cmp_run_jobs_func run_jobs, void *pool);
+
 int decompress_rdcu_data(const uint32_t *compressed_data, const struct cmp_info *info,
 			 const uint16_t *model_of_data, uint16_t *up_model_buf,
 			 uint16_t *decompressed_data);
@@ -43,6 +43,9 @@
 
 #define CORRUPTION_DETECTED (-1)
 
+/* number of samples of which the model is updated at once */
+#define UP_MODEL_BLOCK_SIZE 64U
+
 
 MAYBE_UNUSED static const char *please_check_str =
 	"Please check that the compression parameters match those used to compress the data and that the compressed data are not corrupted.";
@@ -297,6 +300,33 @@ static __inline uint32_t re_map_to_pos(uint32_t value_to_unmap)
 }
 
 
+/**
+ * @brief decorrelate a decoded (mapped) value with the model
+ *
+ * @param setup		pointer to the decoder setup
+ * @param mapped_value	decoded value as returned by the decoding function
+ * @param model		model of the decoded_value (0 if not used)
+ *
+ * @returns the decompressed value
+ */
+
+static __inline uint32_t decorrelate_value(const struct decoder_setup *setup,
+					   uint32_t mapped_value, uint32_t model)
+{
+	/* map the unsigned decode value back to a signed value */
+	uint32_t value = re_map_to_pos(mapped_value);
+
+	/* decorrelate data the data with the model */
+	value += round_fwd(model, setup->lossy_par);
+
+	/* we mask only the used bits in case there is an overflow when adding the model */
+	value &= BIT_MASK[setup->max_data_bits];
+
+	/* inverse step of the lossy compression */
+	return round_inv(value, setup->lossy_par);
+}
+
+
 /**
  * @brief decompress the next code word in the bitstream and decorrelate it with
  *	the model
@@ -314,17 +344,7 @@ static int decode_value(const struct decoder_setup *setup, uint32_t *decoded_val
 	/* decode the next value from the bitstream */
 	int const err = setup->decode_method_f(setup, decoded_value);
 
-	/* map the unsigned decode value back to a signed value */
-	*decoded_value = re_map_to_pos(*decoded_value);
-
-	/* decorrelate data the data with the model */
-	*decoded_value += round_fwd(model, setup->lossy_par);
-
-	/* we mask only the used bits in case there is an overflow when adding the model */
-	*decoded_value &= BIT_MASK[setup->max_data_bits];
-
-	/* inverse step of the lossy compression */
-	*decoded_value = round_inv(*decoded_value, setup->lossy_par);
+	*decoded_value = decorrelate_value(setup, *decoded_value, model);
 
 	return err;
 }
@@ -370,6 +390,172 @@ static void configure_decoder_setup(struct decoder_setup *setup, struct bit_deco
 }
 
 
+/* number of bits of the bitstream used to look up a decode table entry */
+#define DECODE_TABLE_BITS 11U
+
+/* maximum number of values decoded with one decode table look up */
+#define DECODE_TABLE_VALUES 3U
+
+/* minimum number of samples for which building a decode table pays off */
+#define DECODE_TABLE_MIN_SAMPLES (2U << DECODE_TABLE_BITS)
+
+/* maximum average code word length for which a decode table pays off; for
+ * longer code words most look ups miss the table
+ */
+#define DECODE_TABLE_MAX_AVG_BITS 8U
+
+
+/**
+ * @brief entry of a multi-symbol decode table
+ */
+
+struct decode_table_entry {
+	uint8_t n_values;  /* number of decoded values; 0 if the next code word is not in the table */
+	uint8_t n_bits;    /* summed up length of the code words of the decoded values */
+	uint16_t value[DECODE_TABLE_VALUES]; /* decoded values as returned by the decoding function */
+};
+
+
+/**
+ * @brief entry of a single-symbol decode table used to build a decode table
+ */
+
+struct decode_symbol {
+	uint16_t value;  /* decoded value as returned by the decoding function */
+	uint8_t n_bits;  /* length of the code word; 0 if the code word is not in the table */
+};
+
+
+/**
+ * @brief build a multi-symbol decode table for a decoder setup
+ *
+ * Every entry of the table holds the values of the code words which are
+ * completely contained in the next DECODE_TABLE_BITS bits of the bitstream.
+ * Escape symbols and code words not fitting into the look up bits are not put
+ * in the table; they are decoded with the decoding function of the setup.
+ *
+ * @param table	pointer to a decode table with 2^DECODE_TABLE_BITS entries
+ * @param setup	pointer to the decoder setup
+ */
+
+static void build_decode_table(struct decode_table_entry *table,
+			       const struct decoder_setup *setup)
+{
+	uint32_t const table_size = 1U << DECODE_TABLE_BITS;
+	int const multi_escape = setup->decode_method_f == &decode_multi;
+	struct decode_symbol symbol[1U << DECODE_TABLE_BITS];
+	uint32_t idx;
+
+	/* The code words are ordered like their values and a longer code word
+	 * never comes before a shorter one. Therefore, the look up bits
+	 * starting with a code word form a contiguous range and only one code
+	 * word per range has to be decoded.
+	 */
+	for (idx = 0; idx < table_size;) {
+		struct bit_decoder window;
+		uint32_t cw, n, j;
+
+		/* the bits after the look up bits are zero; code words using
+		 * them are detected by the number of consumed bits
+		 */
+		window.bit_container = (uint64_t)idx << (64 - DECODE_TABLE_BITS);
+		window.bits_consumed = 0;
+		window.cursor = NULL;
+		window.limit_ptr = NULL;
+		cw = setup->decode_cw_f(&window, setup->encoder_par1, setup->encoder_par2);
+
+		if (window.bits_consumed > DECODE_TABLE_BITS) {
+			/* all remaining code words are too long */
+			for (; idx < table_size; idx++)
+				symbol[idx].n_bits = 0;
+			break;
+		}
+
+		n = 1U << (DECODE_TABLE_BITS - window.bits_consumed);
+		for (j = idx; j < idx + n; j++) {
+			symbol[j].value = (uint16_t)(multi_escape ? cw : cw - 1);
+			symbol[j].n_bits = (uint8_t)window.bits_consumed;
+			/* escape symbols and invalid code words (see
+			 * decode_zero() and decode_multi())
+			 */
+			if (cw >= setup->outlier_par || (!multi_escape && cw == 0))
+				symbol[j].n_bits = 0;
+		}
+		idx += n;
+	}
+
+	/* put the following code words of the look up bits together */
+	for (idx = 0; idx < table_size; idx++) {
+		struct decode_table_entry *entry = &table[idx];
+		uint32_t n_bits = 0;
+
+		entry->n_values = 0;
+		while (entry->n_values < DECODE_TABLE_VALUES) {
+			const struct decode_symbol *sym =
+				&symbol[(idx << n_bits) & (table_size - 1)];
+
+			if (!sym->n_bits || n_bits + sym->n_bits > DECODE_TABLE_BITS)
+				break;
+			entry->value[entry->n_values++] = sym->value;
+			n_bits += sym->n_bits;
+		}
+		entry->n_bits = (uint8_t)n_bits;
+	}
+}
+
+
+/**
+ * @brief decode the next values in the bitstream using a decode table
+ *
+ * Several values are decoded with one table look up. If the next code word is
+ * not in the table or if no table is given, a single value is decoded with
+ * the decoding function of the setup.
+ *
+ * @param setup		pointer to the decoder setup
+ * @param table		pointer to a decode table build with
+ *			build_decode_table() for the setup (can be NULL)
+ * @param values	buffer where the decoded values are stored; has to
+ *			have space for n + DECODE_TABLE_VALUES - 1 values
+ * @param n		number of values to decode
+ *
+ * @returns 0 on success; otherwise error
+ */
+
+static int decode_values(const struct decoder_setup *setup,
+			 const struct decode_table_entry *table,
+			 uint32_t *values, size_t n)
+{
+	size_t i = 0;
+
+	while (i < n) {
+		int err;
+
+		if (table) {
+			const struct decode_table_entry *entry =
+				&table[bit_peek_bits(setup->dec, DECODE_TABLE_BITS)];
+
+			/* no code words after the last value are consumed */
+			if (entry->n_values && entry->n_values <= n - i) {
+				values[i] = entry->value[0];
+				values[i+1] = entry->value[1];
+				values[i+2] = entry->value[2];
+				i += entry->n_values;
+				bit_consume_bits(setup->dec, entry->n_bits);
+				if (bit_refill(setup->dec) == BIT_OVERFLOW)
+					return 1;
+				continue;
+			}
+		}
+
+		err = setup->decode_method_f(setup, &values[i]);
+		if (err)
+			return err;
+		i++;
+	}
+	return 0;
+}
+
+
 /**
  * @brief return a pointer of the data of a collection
  *
@@ -402,6 +588,88 @@ static const void *get_collection_data_const(const void *col)
 }
 
 
+/**
+ * @brief decode and decorrelate the samples of imagette data
+ *
+ * @param setup		pointer to the decoder setup
+ * @param table		pointer to a decode table build with
+ *			build_decode_table() for the setup (can be NULL)
+ * @param samples	number of samples to decode
+ * @param data_buf	buffer where the decompressed data are stored
+ * @param next_model_p	pointer to the model of the second sample
+ * @param model		model of the first sample
+ * @param up_model_buf	buffer where the updated model is stored (can be NULL)
+ * @param model_value	model weighting parameter
+ *
+ * @returns 0 on success; otherwise error
+ */
+
+static int decode_imagette_samples(const struct decoder_setup *setup,
+				   const struct decode_table_entry *table,
+				   uint32_t samples, uint16_t *data_buf,
+				   const uint16_t *next_model_p, uint16_t model,
+				   uint16_t *up_model_buf, uint32_t model_value)
+{
+	size_t i, n;
+
+	/* the used models are buffered, because the decompressed data can
+	 * overwrite the model buffer
+	 */
+	for (i = 0; i < samples; i += n) {
+		uint16_t model_blk[UP_MODEL_BLOCK_SIZE];
+		uint32_t values[UP_MODEL_BLOCK_SIZE + DECODE_TABLE_VALUES - 1];
+		size_t j;
+		int err;
+
+		n = samples - i;
+		if (n > UP_MODEL_BLOCK_SIZE)
+			n = UP_MODEL_BLOCK_SIZE;
+		err = decode_values(setup, table, values, n);
+		if (err)
+			return err;
+
+		for (j = 0; j < n; j++) {
+			uint32_t decoded_value = decorrelate_value(setup, values[j], model);
+
+			put_unaligned((uint16_t)decoded_value, &data_buf[i+j]);
+			model_blk[j] = model;
+
+			if (i+j < samples-1)
+				model = get_unaligned(&next_model_p[i+j]);
+		}
+
+		if (up_model_buf)
+			cmp_up_model16_batch(&up_model_buf[i], &data_buf[i], model_blk, n,
+					     model_value, setup->lossy_par);
+	}
+	return 0;
+}
+
+
+/**
+ * @brief decode the samples of imagette data using a decode table
+ *
+ * The decode table is only put on the stack when it is used; the function is
+ * not inlined so that decompress_imagette() does not reserve it.
+ *
+ * @see decode_imagette_samples() for the parameters
+ *
+ * @returns 0 on success; otherwise error
+ */
+
+static __attribute__((noinline)) int decode_imagette_samples_table(
+	const struct decoder_setup *setup, uint32_t samples, uint16_t *data_buf,
+	const uint16_t *next_model_p, uint16_t model, uint16_t *up_model_buf,
+	uint32_t model_value)
+{
+	struct decode_table_entry table[1U << DECODE_TABLE_BITS];
+
+	build_decode_table(table, setup);
+	return decode_imagette_samples(setup, table, samples, data_buf, next_model_p,
+				       model, up_model_buf, model_value);
+}
+
+
 /**
  * @brief decompress imagette data
  *
@@ -413,9 +681,6 @@ static const void *get_collection_data_const(const void *col)
 
 static int decompress_imagette(const struct cmp_cfg *cfg, struct bit_decoder *dec, enum decmp_type decmp_type)
 {
-	size_t i;
-	int err;
-	uint32_t decoded_value;
 	uint32_t max_data_bits;
 	struct decoder_setup setup;
 	uint16_t *data_buf;
@@ -465,25 +730,18 @@ static int decompress_imagette(const struct cmp_cfg *cfg, struct bit_decoder *de
 	configure_decoder_setup(&setup, dec, cfg->cmp_mode, cfg->cmp_par_imagette,
 				cfg->spill_imagette, cfg->round, max_data_bits);
 
-	for (i = 0; ; i++) {
-		err = decode_value(&setup, &decoded_value, model);
-		if (err)
-			break;
-
-		put_unaligned((uint16_t)decoded_value, &data_buf[i]);
-
-		if (up_model_buf) {
-			uint16_t up_model = cmp_up_model((uint16_t)decoded_value, model, cfg->model_value,
-						       setup.lossy_par);
-			put_unaligned(up_model, &up_model_buf[i]);
-		}
-
-		if (i >= cfg->samples-1)
-			break;
-
-		model = get_unaligned(&next_model_p[i]);
-	}
-	return err;
+	/* all samples are coded with the same parameters; several short code
+	 * words can be decoded at once with a table if the code words are
+	 * short on average
+	 */
+	if (cfg->samples >= DECODE_TABLE_MIN_SAMPLES &&
+	    bit_stream_bits_left(dec) <= cfg->samples * DECODE_TABLE_MAX_AVG_BITS)
+		return decode_imagette_samples_table(&setup, cfg->samples, data_buf,
+						     next_model_p, model, up_model_buf,
+						     cfg->model_value);
+
+	return decode_imagette_samples(&setup, NULL, cfg->samples, data_buf, next_model_p,
+				       model, up_model_buf, cfg->model_value);
 }
 
 
@@ -1204,8 +1462,8 @@ static int decompress_l_fx_efx_ncob_ecob(const struct cmp_cfg *cfg, struct bit_d
 
 static int decompress_offset(const struct cmp_cfg *cfg, struct bit_decoder *dec)
 {
-	size_t i;
-	int err;
+	size_t i, n;
+	int err = 0;
 	uint32_t decoded_value;
 	struct decoder_setup setup_mean, setup_var;
 	struct offset *data_buf = get_collection_data(cfg->dst);
@@ -1246,28 +1504,39 @@ static int decompress_offset(const struct cmp_cfg *cfg, struct bit_decoder *dec)
 
 	}
 
-	for (i = 0; ; i++) {
-		err = decode_value(&setup_mean, &decoded_value, model.mean);
-		if (err)
-			break;
-		data_buf[i].mean = decoded_value;
-
-		err = decode_value(&setup_var, &decoded_value, model.variance);
-		if (err)
-			break;
-		data_buf[i].variance = decoded_value;
-
-		if (up_model_buf) {
-			up_model_buf[i].mean = cmp_up_model(data_buf[i].mean,
-				model.mean, cfg->model_value, setup_mean.lossy_par);
-			up_model_buf[i].variance = cmp_up_model(data_buf[i].variance,
-				model.variance, cfg->model_value, setup_var.lossy_par);
+	/* the used models are buffered, because the decompressed data can
+	 * overwrite the model buffer; all fields have the same size and
+	 * lossy_par, so the model can be updated as an array of 32-bit values
+	 */
+	for (i = 0; i < cfg->samples; i += n) {
+		uint32_t model_blk[UP_MODEL_BLOCK_SIZE];
+		size_t j;
+
+		n = cfg->samples - i;
+		if (n > UP_MODEL_BLOCK_SIZE/2)
+			n = UP_MODEL_BLOCK_SIZE/2;
+		for (j = 0; j < n; j++) {
+			err = decode_value(&setup_mean, &decoded_value, model.mean);
+			if (err)
+				return err;
+			data_buf[i+j].mean = decoded_value;
+
+			err = decode_value(&setup_var, &decoded_value, model.variance);
+			if (err)
+				return err;
+			data_buf[i+j].variance = decoded_value;
+
+			model_blk[2*j] = model.mean;
+			model_blk[2*j+1] = model.variance;
+
+			if (i+j < cfg->samples-1)
+				model = next_model_p[i+j];
 		}
 
-		if (i >= cfg->samples-1)
-			break;
-
-		model = next_model_p[i];
+		if (up_model_buf)
+			cmp_up_model32_batch((uint32_t *)get_collection_data(cfg->updated_model_buf) + 2*i,
+					     (const uint32_t *)get_collection_data(cfg->dst) + 2*i,
+					     model_blk, 2*n, cfg->model_value, cfg->round);
 	}
 	return err;
 }
@@ -1465,6 +1734,39 @@ static int decompress_collection_hdr(const struct cmp_cfg *cfg)
 }
 
 
+/**
+ * @brief decompress a collection which is identical to its model
+ *
+ * In an entity with the CMP_ENT_FLAG_EQUAL_MODEL flag, a compressed collection
+ * without compressed data marks collection data which are identical to the
+ * model data; the data and the updated model are copies of the model.
+ *
+ * @param cfg		pointer to a compression configuration of the collection
+ * @param hdr_size	size of the collection header in the dst buffer
+ * @param data_size	size of the collection data
+ *
+ * @returns 0 on success; returns -1 if no model mode is used
+ */
+
+static int decompress_equal_to_model(const struct cmp_cfg *cfg, int hdr_size,
+				     uint32_t data_size)
+{
+	const uint8_t *model = (const uint8_t *)cfg->model_buf + hdr_size;
+
+	if (!model_mode_is_used(cfg->cmp_mode)) {
+		debug_print("Error: A collection without compressed data needs a model mode.");
+		return -1;
+	}
+
+	/* the buffers can be the same for an in-place decompression */
+	memmove((uint8_t *)cfg->dst + hdr_size, model, data_size);
+	if (cfg->updated_model_buf)
+		memmove((uint8_t *)cfg->updated_model_buf + hdr_size, model, data_size);
+
+	return 0;
+}
+
+
 /**
  * @brief decompress the data based on a compression configuration
  *
@@ -1541,6 +1843,12 @@ static int decompressed_data_internal(const struct cmp_cfg *cfg, enum decmp_type
 			hdr_size = decompress_collection_hdr(cfg);
 			if (hdr_size < 0)
 				return -1;
+			if (cfg->equal_model && cfg->stream_size == (uint32_t)hdr_size) {
+				if (decompress_equal_to_model(cfg, hdr_size,
+							      data_size - (uint32_t)hdr_size))
+					return -1;
+				return (int)data_size;
+			}
 		}
 
 		bit_init_decoder(&dec, (const uint8_t *)cfg->src+hdr_size,
@@ -1693,8 +2001,17 @@ static int cmp_ent_read_header(const struct cmp_entity *ent, struct cmp_cfg *cfg
 
 	cfg->src = cmp_ent_get_data_buf_const(ent);
 
-	if (cmp_ent_get_reserved(ent))
-		debug_print("Warning: The reserved field in the compressed header should be zero.");
+	{
+		uint8_t reserved = cmp_ent_get_reserved(ent);
+
+		if (cfg->data_type == DATA_TYPE_CHUNK && cfg->cmp_mode != CMP_MODE_RAW) {
+			cfg->col_pars = reserved & CMP_ENT_FLAG_COL_PARS;
+			cfg->equal_model = reserved & CMP_ENT_FLAG_EQUAL_MODEL;
+			reserved &= (uint8_t)~(CMP_ENT_FLAG_COL_PARS | CMP_ENT_FLAG_EQUAL_MODEL);
+		}
+		if (reserved)
+			debug_print("Warning: The reserved field in the compressed header should be zero.");
+	}
 
 	if (cfg->cmp_mode == CMP_MODE_RAW) {
 		if (cmp_ent_get_original_size(ent) != cmp_ent_get_cmp_data_size(ent)) {
@@ -1801,129 +2118,356 @@ static uint16_t get_cmp_collection_data_length(const uint8_t *cmp_col)
 }
 
 
+/**
+ * @brief get the parameter override field of a compressed collection
+ *
+ * If the collections of a chunk carry parameter overrides (see
+ * CMP_ENT_FLAG_COL_PARS), the compressed data of a collection are followed
+ * by a bit mask of the overridden parameter slots (bit 0 for slot 1) and a
+ * 24-bit spillover threshold and a 16-bit compression parameter (big-endian)
+ * for every overridden slot. Collections which are put uncompressed into the
+ * entity and collections equal to their model (see CMP_ENT_FLAG_EQUAL_MODEL)
+ * have no parameter override field.
+ *
+ * @param cmp_col	pointer to a compressed collection
+ * @param equal_model	non-zero if collections without compressed data are
+ *			equal to their model
+ *
+ * @return a pointer to the parameter override field or NULL if the collection
+ *	data are not compressed
+ */
+
+static const uint8_t *get_cmp_col_pars_field(const uint8_t *cmp_col, uint32_t equal_model)
+{
+	const struct collection_hdr *col_hdr =
+		(const struct collection_hdr *)(cmp_col + CMP_COLLECTION_FILD_SIZE);
+	uint16_t const cmp_data_size = get_cmp_collection_data_length(cmp_col);
+
+	/* an uncompressed collection or a collection equal to its model */
+	if (cmp_data_size == cmp_col_get_data_length(col_hdr) ||
+	    (equal_model && cmp_data_size == 0))
+		return NULL;
+
+	return cmp_col + CMP_COLLECTION_FILD_SIZE + COLLECTION_HDR_SIZE + cmp_data_size;
+}
+
+
+/**
+ * @brief get the size of a parameter override field
+ *
+ * @param mask	bit mask of the overridden parameter slots
+ *
+ * @return the size of the parameter override field in bytes
+ */
+
+static uint32_t cmp_col_pars_field_size(uint8_t mask)
+{
+	return CMP_COL_PAR_MASK_SIZE +
+		CMP_COL_PAR_SIZE * (uint32_t)__builtin_popcount(mask);
+}
+
+
 /**
  * @brief get the total size of the compressed collection
- * j
+ *
  * This function returns the total size of the compressed collection in bytes,
  * including the size of the compressed size field itself, the collection header,
- * and the compressed collection data.
+ * the compressed collection data and the parameter override field (if any).
  *
  * @param cmp_col	pointer to a compressed collection
+ * @param col_pars	non-zero if the collections carry parameter overrides
+ * @param equal_model	non-zero if collections without compressed data are
+ *			equal to their model
  *
  * @return The total size of the compressed collection in bytes
  */
 
-static uint32_t get_cmp_collection_size(const uint8_t *cmp_col)
+static uint32_t get_cmp_collection_size(const uint8_t *cmp_col, uint32_t col_pars,
+					uint32_t equal_model)
 {
-	return CMP_COLLECTION_FILD_SIZE + COLLECTION_HDR_SIZE
+	uint32_t size = CMP_COLLECTION_FILD_SIZE + COLLECTION_HDR_SIZE
 		+ get_cmp_collection_data_length(cmp_col);
+
+	if (col_pars) {
+		const uint8_t *pars_field = get_cmp_col_pars_field(cmp_col, equal_model);
+
+		if (pars_field)
+			size += cmp_col_pars_field_size(pars_field[0]);
+	}
+	return size;
+}
+
+
+/**
+ * @brief entry of a compressed collection index
+ */
+
+struct cmp_col_index {
+	uint32_t cmp_offset;    /* byte offset of the compressed collection in the compressed data */
+	uint32_t decmp_offset;  /* byte offset of the collection in the decompressed data */
+	uint16_t cmp_data_size; /* size of the compressed collection data (without the header) */
+	uint16_t data_length;   /* size of the decompressed collection data (without the header) */
+	enum cmp_data_type data_type; /* data type of the collection */
+};
+
+
+/* number of collection index entries build at once by decompress_cmp_entiy() */
+#define CMP_COL_INDEX_BATCH 64U
+
+
+/**
+ * @brief position of the indexing of the compressed collections of an entity
+ */
+
+struct cmp_col_walk {
+	const uint8_t *cmp_data; /* start of the compressed collections */
+	uint32_t cmp_data_size;  /* size of the compressed collections */
+	uint32_t col_pars;       /* non-zero if the collections carry parameter overrides */
+	uint32_t equal_model;    /* non-zero if collections without compressed data are equal to their model */
+	uint32_t decmp_size;     /* size of the decompressed data */
+	uint32_t cmp_pos;        /* byte offset of the next compressed collection */
+	uint32_t decmp_pos;      /* byte offset of the next decompressed collection */
+	uint32_t n_cols;         /* number of already indexed collections */
+};
+
+
+/**
+ * @brief start the indexing of the compressed collections of an entity
+ *
+ * @param walk		pointer to the indexing position to initialise
+ * @param ent		pointer to the compression entity
+ * @param col_pars	non-zero if the collections carry parameter overrides
+ * @param equal_model	non-zero if collections without compressed data are
+ *			equal to their model
+ * @param decmp_size	size of the original decompressed data
+ */
+
+static void cmp_col_walk_init(struct cmp_col_walk *walk, const struct cmp_entity *ent,
+			      uint32_t col_pars, uint32_t equal_model, uint32_t decmp_size)
+{
+	walk->cmp_data = cmp_ent_get_data_buf_const(ent);
+	walk->cmp_data_size = cmp_ent_get_cmp_data_size(ent);
+	walk->col_pars = col_pars;
+	walk->equal_model = equal_model;
+	walk->decmp_size = decmp_size;
+	walk->cmp_pos = 0;
+	walk->decmp_pos = 0;
+	walk->n_cols = 0;
 }
 
 
 /**
- * @brief get the number of compressed collections in a compression entity
+ * @brief index the next compressed collections of a compression entity
  *
- * This function returns the number of compressed collections in a compression
- * entity, by iterating over the compressed collection data
+ * The compressed collections are walked only once; every call continues
+ * where the previous call has stopped. All checks of the collection sizes
+ * are done here, so an indexed collection lies completely within the
+ * compressed data and its decompressed data within the decompressed data.
  *
- * @param ent	 pointer to the compression entity
+ * @param walk		pointer to the indexing position
+ * @param index		pointer to an array to store the index entries
+ * @param max_entries	maximum number of entries to store
  *
- * @return the number of compressed collections in the compressed entity, or -1
- *	on error
+ * @returns the number of indexed collections, 0 if all collections are
+ *	already indexed, or -1 on error
  */
 
-static int get_num_of_chunks(const struct cmp_entity *ent)
+static int index_cmp_collections(struct cmp_col_walk *walk, struct cmp_col_index *index,
+				 uint32_t max_entries)
 {
-	const uint8_t *cmp_data_p = cmp_ent_get_data_buf_const(ent);
-	long const cmp_data_size = cmp_ent_get_cmp_data_size(ent);
-	int n = 0;
-	const uint8_t *p = cmp_data_p;
-	/* highest plausible address of compressed collection */
-	const uint8_t *limit_ptr = cmp_data_p + cmp_data_size - COLLECTION_HDR_SIZE;
-
-	while (p < limit_ptr) {
-		p += get_cmp_collection_size(p);
-		n++;
-	}
+	uint32_t n;
+
+	for (n = 0; n < max_entries && walk->cmp_pos < walk->cmp_data_size; n++) {
+		struct cmp_col_index *entry = &index[n];
+		const uint8_t *cmp_col = walk->cmp_data + walk->cmp_pos;
+		uint32_t const remaining = walk->cmp_data_size - walk->cmp_pos;
+		const struct collection_hdr *col_hdr =
+			(const struct collection_hdr *)(cmp_col + CMP_COLLECTION_FILD_SIZE);
+		uint32_t col_size = CMP_COLLECTION_FILD_SIZE + COLLECTION_HDR_SIZE;
+		size_t sample_size;
+
+		if (remaining < col_size) {
+			debug_print("Error: The sum of the compressed collection does not match the size of the data in the compression header.");
+			return -1;
+		}
 
-	if (p-cmp_data_p != cmp_data_size) {
-		debug_print("Error: The sum of the compressed collection does not match the size of the data in the compression header.");
-		return -1;
+		entry->cmp_offset = walk->cmp_pos;
+		entry->decmp_offset = walk->decmp_pos;
+		entry->cmp_data_size = get_cmp_collection_data_length(cmp_col);
+		entry->data_length = cmp_col_get_data_length(col_hdr);
+
+		if (entry->cmp_data_size > entry->data_length) {
+			debug_print("Error: Collection %u, the size of the compressed collection is larger than that of the uncompressed collection.", walk->n_cols);
+			return -1;
+		}
+
+		if (walk->col_pars) {
+			const uint8_t *pars_field = get_cmp_col_pars_field(cmp_col,
+									   walk->equal_model);
+
+			/* the bit mask of the parameter override field has to be
+			 * in the compressed data
+			 */
+			if (pars_field && col_size + entry->cmp_data_size >= remaining) {
+				debug_print("Error: The sum of the compressed collection does not match the size of the data in the compression header.");
+				return -1;
+			}
+			if (pars_field && pars_field[0] >> CMP_COL_PAR_SLOTS) {
+				debug_print("Error: Collection %u, the parameter override field is corrupted.", walk->n_cols);
+				return -1;
+			}
+		}
+
+		col_size = get_cmp_collection_size(cmp_col, walk->col_pars, walk->equal_model);
+		if (col_size > remaining) {
+			debug_print("Error: The sum of the compressed collection does not match the size of the data in the compression header.");
+			return -1;
+		}
+
+		entry->data_type = convert_subservice_to_cmp_data_type(cmp_col_get_subservice(col_hdr));
+		sample_size = size_of_a_sample(entry->data_type);
+		if (!sample_size)
+			return -1;
+
+		if (entry->data_length % sample_size) {
+			debug_print("Error: The size of the collection is not a multiple of a collection entry.");
+			return -1;
+		}
+
+		if ((uint64_t)walk->decmp_pos + COLLECTION_HDR_SIZE + entry->data_length > walk->decmp_size) {
+			debug_print("Error: The compressed data and the original size do not match.");
+			return -1;
+		}
+
+		walk->cmp_pos += col_size;
+		walk->decmp_pos += cmp_col_get_size(col_hdr);
+		walk->n_cols++;
 	}
-	return n;
+
+	return (int)n;
 }
 
 
 /**
- * @brief Parse n'th compressed collection and set configuration parameters
- *	for decompression it
- *
- * @param cmp_col		pointer to a compressed collection to parse
- * @param n			the number of the compressed collection to
- *				parse, starting from 1
- * @param cfg			pointer to the configuration structure
- * @param coll_uncompressed	pointer to store whether the collection is
- *				uncompressed or not
- * @param decmp_size		size of the original decompressed data
- *
- * @return the byte offset where to put the uncompressed result in the
- *	decompressed data, or -1 on error.
+ * @brief check all compressed collections of a compression entity
+ *
+ * The collections are walked with index_cmp_collections() without keeping
+ * the index, so that a corrupted entity is detected before any data are
+ * decompressed.
+ *
+ * @param start		pointer to the indexing position to start from; is
+ *			not changed
+ * @param index		pointer to a buffer for CMP_COL_INDEX_BATCH index
+ *			entries used during the walk
+ *
+ * @returns the number of compressed collections; -1 on error
  */
 
-static long parse_cmp_collection(const uint8_t *cmp_col, int n, struct cmp_cfg *cfg,
-				 int *coll_uncompressed, int decmp_size)
+static int count_cmp_collections(const struct cmp_col_walk *start,
+				 struct cmp_col_index *index)
 {
-	int i;
-	long decmp_pos = 0; /* position where to put the uncompressed result */
-	/* pointer to the collection header */
-	const struct collection_hdr *col_hdr =
-		(const struct collection_hdr *)(cmp_col + CMP_COLLECTION_FILD_SIZE);
-	uint32_t cmp_data_size; /* size of the compressed data in the collection (not including the header) */
-	uint16_t original_col_size; /* size of the decompressed collection data (not including the header) */
-	size_t sample_size;
-
-	/* get to the collection we want to decompress */
-	for (i = 0; i < n; i++) {
-		decmp_pos += cmp_col_get_size(col_hdr);
-		cmp_col += get_cmp_collection_size(cmp_col);
-		col_hdr = (const struct collection_hdr *)(cmp_col + CMP_COLLECTION_FILD_SIZE);
-	}
+	struct cmp_col_walk walk = *start;
+	int n_cols;
+
+	do {
+		n_cols = index_cmp_collections(&walk, index, CMP_COL_INDEX_BATCH);
+		if (n_cols < 0)
+			return -1;
+	} while (n_cols);
 
-	cmp_data_size = get_cmp_collection_data_length(cmp_col);
-	original_col_size = cmp_col_get_data_length(col_hdr);
+	return (int)walk.n_cols;
+}
 
-	if (cmp_data_size > original_col_size) {
-		debug_print("Error: Collection %i, the size of the compressed collection is larger than that of the uncompressed collection.", i);
-		return -1;
-	}
 
+/**
+ * @brief set the configuration parameters to decompress an indexed collection
+ *
+ * @param cfg		pointer to the configuration structure
+ * @param cmp_data	pointer to the compressed collections of the entity
+ * @param entry		pointer to the index entry of the collection
+ *
+ * @return non-zero if the collection data are uncompressed, otherwise 0
+ */
+
+static int set_cmp_collection_cfg(struct cmp_cfg *cfg, const uint8_t *cmp_data,
+				  const struct cmp_col_index *entry)
+{
+	const uint8_t *cmp_col = cmp_data + entry->cmp_offset;
 	/* if the compressed data size == original_col_size the collection data
 	 * was put uncompressed into the bitstream */
-	if (cmp_data_size == original_col_size)
-		*coll_uncompressed = 1;
-	else
-		*coll_uncompressed = 0;
+	int const coll_uncompressed = entry->cmp_data_size == entry->data_length;
+
+	/* the parameter overrides only apply to this collection */
+	if (cfg->col_pars && !coll_uncompressed) {
+		const uint8_t *p = get_cmp_col_pars_field(cmp_col, cfg->equal_model);
+		/* a collection equal to its model has no parameter override field */
+		uint8_t const mask = p ? p[0] : 0;
+		unsigned int slot;
+
+		p += CMP_COL_PAR_MASK_SIZE;
+		for (slot = 1; slot <= CMP_COL_PAR_SLOTS; slot++) {
+			if (mask & (1U << (slot-1))) {
+				uint32_t const spill = (uint32_t)p[0] << 16 |
+					(uint32_t)p[1] << 8 | p[2];
+				uint32_t const cmp_par = (uint32_t)p[3] << 8 | p[4];
+
+				/* the parameters are checked by the decompression */
+				cmp_cfg_set_par_slot(cfg, slot, cmp_par, spill);
+				p += CMP_COL_PAR_SIZE;
+			}
+		}
+	}
 
-	cfg->src = col_hdr;
-	cfg->stream_size = cmp_data_size + COLLECTION_HDR_SIZE;
+	cfg->src = cmp_col + CMP_COLLECTION_FILD_SIZE;
+	cfg->stream_size = entry->cmp_data_size + COLLECTION_HDR_SIZE;
+	cfg->data_type = entry->data_type;
+	cfg->samples = entry->data_length / size_of_a_sample(entry->data_type);
 
-	cfg->data_type = convert_subservice_to_cmp_data_type(cmp_col_get_subservice(col_hdr));
-	sample_size = size_of_a_sample(cfg->data_type);
-	if (!sample_size)
-		return -1;
+	return coll_uncompressed;
+}
 
-	if (original_col_size % sample_size) {
-		debug_print("Error: The size of the collection is not a multiple of a collection entry.");
-		return -1;
-	}
-	cfg->samples = original_col_size / sample_size;
 
-	if (decmp_pos + original_col_size + COLLECTION_HDR_SIZE > decmp_size) {
-		debug_print("Error: The compressed data and the original size do not match.");
-		return -1;
+/**
+ * @brief decompress an indexed collection of a compression entity
+ *
+ * @param cfg			pointer to the configuration read from the
+ *				entity header
+ * @param cmp_data		pointer to the compressed collections of the entity
+ * @param entry			pointer to the index entry of the collection
+ * @param model_of_data		pointer to model data buffer (can be NULL)
+ * @param up_model_buf		pointer to store the updated model (can be NULL)
+ * @param decompressed_data	pointer to the decompressed data buffer (can be NULL)
+ *
+ * @returns the size of the decompressed collection on success; returns
+ *	negative on failure
+ */
+
+static int decompress_cmp_collection(const struct cmp_cfg *cfg, const uint8_t *cmp_data,
+				     const struct cmp_col_index *entry,
+				     const void *model_of_data, void *up_model_buf,
+				     void *decompressed_data)
+{
+	struct cmp_cfg cmp_cpy = *cfg;
+	int const col_uncompressed = set_cmp_collection_cfg(&cmp_cpy, cmp_data, entry);
+
+	if (decompressed_data)
+		cmp_cpy.dst = (uint8_t *)decompressed_data + entry->decmp_offset;
+	if (model_of_data)
+		cmp_cpy.model_buf = (const uint8_t *)model_of_data + entry->decmp_offset;
+	if (up_model_buf)
+		cmp_cpy.updated_model_buf = (uint8_t *)up_model_buf + entry->decmp_offset;
+
+	if (col_uncompressed) {
+		if (cmp_cpy.updated_model_buf && model_mode_is_used(cmp_cpy.cmp_mode)) {
+			uint32_t s = cmp_cpy.stream_size;
+			memcpy(cmp_cpy.updated_model_buf, cmp_cpy.src, s);
+			if (be_to_cpu_chunk(cmp_cpy.updated_model_buf, s))
+				return -1;
+		}
+		cmp_cpy.cmp_mode = CMP_MODE_RAW;
 	}
 
-	return decmp_pos;
+	return decompressed_data_internal(&cmp_cpy, ICU_DECOMRESSION);
 }
 
 
@@ -1931,6 +2475,9 @@ static long parse_cmp_collection(const uint8_t *cmp_col, int n, struct cmp_cfg *
  * @brief decompress a compression entity
  *
  * @note this function assumes that the entity size in the ent header is correct
+ * @note the sizes of all collections of a chunk entity are checked before the
+ *	first collection is decompressed; if the bitstream of a collection is
+ *	corrupted, the collections in front of it are already decompressed
  * @param ent			pointer to the compression entity to be decompressed
  * @param model_of_data		pointer to model data buffer (can be NULL if no
  *				model compression mode is used)
@@ -1946,8 +2493,10 @@ int decompress_cmp_entiy(const struct cmp_entity *ent, const void *model_of_data
 			 void *up_model_buf, void *decompressed_data)
 {
 	struct cmp_cfg cfg;
+	struct cmp_col_walk walk;
+	struct cmp_col_index index[CMP_COL_INDEX_BATCH];
 	int decmp_size;
-	int i, n_chunks;
+	int i, n_cols;
 
 	memset(&cfg, 0, sizeof(struct cmp_cfg));
 
@@ -1992,41 +2541,255 @@ int decompress_cmp_entiy(const struct cmp_entity *ent, const void *model_of_data
 		return (int)cfg.stream_size;
 	}
 
-	n_chunks = get_num_of_chunks(ent);
-	if (n_chunks <= 0)
+	/* all collections are checked before the first one is decompressed;
+	 * afterwards they are indexed again in batches and decompressed
+	 */
+	cmp_col_walk_init(&walk, ent, cfg.col_pars, cfg.equal_model, (uint32_t)decmp_size);
+	if (count_cmp_collections(&walk, index) <= 0)
 		return -1;
-
-	for (i = 0; i < n_chunks; i++) {
-		int decmp_chunk_size;
-		int col_uncompressed;
-		struct cmp_cfg cmp_cpy = cfg;
-		long offset = parse_cmp_collection(cmp_ent_get_data_buf_const(ent), i,
-						   &cmp_cpy, &col_uncompressed, decmp_size);
-		if (offset < 0)
+	do {
+		n_cols = index_cmp_collections(&walk, index, ARRAY_SIZE(index));
+		if (n_cols < 0)
 			return -1;
 
-		if (decompressed_data)
-			cmp_cpy.dst = (uint8_t *)decompressed_data + offset;
-		if (model_of_data)
-			cmp_cpy.model_buf = (const uint8_t *)model_of_data + offset;
-		if (up_model_buf)
-			cmp_cpy.updated_model_buf = (uint8_t *)up_model_buf + offset;
+		for (i = 0; i < n_cols; i++) {
+			int const decmp_col_size = decompress_cmp_collection(&cfg,
+				walk.cmp_data, &index[i], model_of_data, up_model_buf,
+				decompressed_data);
+			if (decmp_col_size < 0)
+				return decmp_col_size;
+		}
+	} while (n_cols);
 
-		if (col_uncompressed) {
-			if (cmp_cpy.updated_model_buf && model_mode_is_used(cmp_cpy.cmp_mode)) {
-				uint32_t s = cmp_cpy.stream_size;
-				memcpy(cmp_cpy.updated_model_buf, cmp_cpy.src, s);
-				if (be_to_cpu_chunk(cmp_cpy.updated_model_buf, s))
-					return -1;
-			}
-			cmp_cpy.cmp_mode = CMP_MODE_RAW;
+	return decmp_size;
+}
+
+
+/**
+ * @brief group of collections decompressed by a job of
+ *	decompress_cmp_entity_mt()
+ */
+
+struct decmp_col_job {
+	uint32_t first; /* index of the first collection of the job */
+	uint32_t end;   /* index after the last collection of the job */
+	int result;     /* 0 on success or the error of the first failed collection */
+};
+
+
+/**
+ * @brief argument of the decmp_col_job_run() jobs
+ */
+
+struct decmp_col_jobs {
+	const struct cmp_cfg *cfg;         /* configuration read from the entity header */
+	const uint8_t *cmp_data;           /* compressed collections of the entity */
+	const struct cmp_col_index *index; /* index of the compressed collections */
+	struct decmp_col_job *job;         /* array with the state of every job */
+	const void *model_of_data;         /* model data buffer; can be NULL */
+	void *up_model_buf;                /* updated model buffer; can be NULL */
+	void *decompressed_data;           /* decompressed data buffer; can be NULL */
+};
+
+
+/**
+ * @brief decompress a group of indexed collections
+ *
+ * Every collection is decompressed into its own region of the decompressed
+ * data and the updated model buffer, so the jobs do not interfere with each
+ * other.
+ *
+ * @param job_arg	pointer to a struct decmp_col_jobs
+ * @param i		index of the job
+ */
+
+static void decmp_col_job_run(void *job_arg, uint32_t i)
+{
+	const struct decmp_col_jobs *jobs = (const struct decmp_col_jobs *)job_arg;
+	struct decmp_col_job *job = &jobs->job[i];
+	uint32_t c;
+
+	job->result = 0;
+	for (c = job->first; c < job->end; c++) {
+		int const decmp_col_size = decompress_cmp_collection(jobs->cfg,
+			jobs->cmp_data, &jobs->index[c], jobs->model_of_data,
+			jobs->up_model_buf, jobs->decompressed_data);
+		if (decmp_col_size < 0) {
+			job->result = decmp_col_size;
+			break;
 		}
+	}
+}
+
+
+/**
+ * @brief count the collections of a compressed chunk entity
+ *
+ * @param ent	pointer to the compression entity
+ * @param cfg	pointer to a configuration structure where the parameters of
+ *		the entity header are stored
+ * @param walk	pointer to the indexing position; is set to the first
+ *		collection
+ *
+ * @returns the number of compressed collections; 0 if the entity is not a
+ *	compressed chunk entity; -1 if the collections are corrupted
+ */
+
+static int count_entity_collections(const struct cmp_entity *ent, struct cmp_cfg *cfg,
+				    struct cmp_col_walk *walk)
+{
+	struct cmp_col_index index[CMP_COL_INDEX_BATCH];
+	int decmp_size;
+
+	memset(cfg, 0, sizeof(struct cmp_cfg));
+	decmp_size = (int)cmp_ent_get_original_size(ent);
+	if (decmp_size <= 0 || cmp_ent_read_header(ent, cfg) ||
+	    cfg->data_type != DATA_TYPE_CHUNK || cfg->cmp_mode == CMP_MODE_RAW)
+		return 0;
+
+	cmp_col_walk_init(walk, ent, cfg->col_pars, cfg->equal_model, (uint32_t)decmp_size);
+	return count_cmp_collections(walk, index);
+}
 
-		decmp_chunk_size = decompressed_data_internal(&cmp_cpy, ICU_DECOMRESSION);
-		if (decmp_chunk_size < 0)
-			return decmp_chunk_size;
+
+/**
+ * @brief get the size of the work buffer for a number of collections and jobs
+ *
+ * @param n_cols	number of compressed collections
+ * @param n_jobs	number of decompression jobs
+ *
+ * @returns the needed work buffer size in bytes
+ */
+
+static uint32_t decmp_mt_work_size(uint32_t n_cols, uint32_t n_jobs)
+{
+	if (n_jobs > n_cols)
+		n_jobs = n_cols;
+
+	return n_jobs * (uint32_t)sizeof(struct decmp_col_job) +
+		n_cols * (uint32_t)sizeof(struct cmp_col_index);
+}
+
+
+/**
+ * @brief get the size of the work buffer needed by decompress_cmp_entity_mt()
+ *
+ * The collection headers of the entity are walked once to count the
+ * collections.
+ *
+ * @param ent		pointer to the compression entity to be decompressed
+ * @param n_threads	number of threads used for the decompression
+ *
+ * @returns the needed work buffer size in bytes; 0 if ent is NULL or if the
+ *	entity is not a compressed chunk entity or is corrupted
+ */
+
+uint32_t decompress_cmp_entity_mt_work_size(const struct cmp_entity *ent,
+					    uint32_t n_threads)
+{
+	struct cmp_cfg cfg;
+	struct cmp_col_walk walk;
+	int n_cols;
+
+	if (!ent)
+		return 0;
+
+	n_cols = count_entity_collections(ent, &cfg, &walk);
+	if (n_cols <= 0)
+		return 0;
+
+	return decmp_mt_work_size((uint32_t)n_cols, n_threads);
+}
+
+
+/**
+ * @brief decompress a compression entity with the collections decompressed in
+ *	parallel
+ *
+ * The collections of a chunk entity are counted and checked, then indexed
+ * into the work buffer; afterwards they are split into up to n_threads groups
+ * of consecutive collections, which are decompressed by jobs executed with
+ * the run_jobs function. The result is identical to the result of
+ * decompress_cmp_entiy(). If a collection fails to decompress, the error of
+ * the first failed collection is returned, but unlike decompress_cmp_entiy()
+ * the collections behind it may be decompressed.
+ * The library does not create threads or allocate memory itself; the thread
+ * pool and the work buffer are provided by the caller.
+ * The entity is decompressed sequentially by decompress_cmp_entiy() if it is
+ * not a compressed chunk entity, if no run_jobs function or work buffer is
+ * provided, if n_threads is smaller than 2 or if the work buffer is smaller
+ * than decompress_cmp_entity_mt_work_size().
+ *
+ * @param ent			pointer to the compression entity to be decompressed
+ * @param model_of_data		pointer to model data buffer (can be NULL if no
+ *				model compression mode is used)
+ * @param up_model_buf		pointer to store the updated model for the next model
+ *				mode compression (can be the same as the model_of_data
+ *				buffer for an in-place update or NULL if the updated model is not needed)
+ * @param decompressed_data	pointer to the decompressed data buffer (can be NULL)
+ * @param n_threads		number of threads used for the decompression;
+ *				the collections are split into up to n_threads jobs
+ * @param work_buf		pointer to a work buffer; has to be aligned for
+ *				pointer access; must not overlap with any other
+ *				buffer
+ * @param work_buf_size		byte size of the work buffer
+ * @param run_jobs		function executing the decompression jobs
+ * @param pool			opaque pointer passed to the run_jobs function
+ *
+ * @returns the size of the decompressed data on success; returns negative on failure
+ */
+
+int decompress_cmp_entity_mt(const struct cmp_entity *ent, const void *model_of_data,
+			     void *up_model_buf, void *decompressed_data,
+			     uint32_t n_threads, void *work_buf, uint32_t work_buf_size,
+			     cmp_run_jobs_func run_jobs, void *pool)
+{
+	struct cmp_cfg cfg;
+	struct cmp_col_walk walk;
+	struct decmp_col_jobs jobs;
+	struct cmp_col_index *index;
+	uint32_t n_jobs, j;
+	int n_cols;
+
+	if (!ent || !run_jobs || !work_buf || n_threads < 2)
+		return decompress_cmp_entiy(ent, model_of_data, up_model_buf,
+					    decompressed_data);
+
+	/* a corrupted entity is also handled by decompress_cmp_entiy() */
+	n_cols = count_entity_collections(ent, &cfg, &walk);
+	if (n_cols <= 0 || work_buf_size < decmp_mt_work_size((uint32_t)n_cols, n_threads))
+		return decompress_cmp_entiy(ent, model_of_data, up_model_buf,
+					    decompressed_data);
+
+	n_jobs = n_threads;
+	if (n_jobs > (uint32_t)n_cols)
+		n_jobs = (uint32_t)n_cols;
+	jobs.job = (struct decmp_col_job *)work_buf;
+	index = (struct cmp_col_index *)(jobs.job + n_jobs);
+
+	/* the index has room for all collections */
+	if (index_cmp_collections(&walk, index, (uint32_t)n_cols) != n_cols)
+		return -1;
+
+	for (j = 0; j < n_jobs; j++) {
+		jobs.job[j].first = (uint32_t)((uint64_t)n_cols * j / n_jobs);
+		jobs.job[j].end = (uint32_t)((uint64_t)n_cols * (j+1) / n_jobs);
 	}
-	return decmp_size;
+	jobs.cfg = &cfg;
+	jobs.cmp_data = walk.cmp_data;
+	jobs.index = index;
+	jobs.model_of_data = model_of_data;
+	jobs.up_model_buf = up_model_buf;
+	jobs.decompressed_data = decompressed_data;
+
+	run_jobs(decmp_col_job_run, &jobs, n_jobs, pool);
+
+	/* the jobs hold consecutive collections; the first error is reported */
+	for (j = 0; j < n_jobs; j++) {
+		if (jobs.job[j].result < 0)
+			return jobs.job[j].result;
+	}
+	return (int)walk.decmp_size;
 }
 
 
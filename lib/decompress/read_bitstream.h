@@ -79,6 +79,7 @@ static __inline uint64_t bit_read_bits(struct bit_decoder *dec, unsigned int nb_
 static __inline uint32_t bit_read_bits32(struct bit_decoder *dec, unsigned int nb_bits);
 static __inline uint32_t bit_read_bits32_sub_1(struct bit_decoder *dec, unsigned int nb_bits);
 static __inline unsigned int bit_end_of_stream(const struct bit_decoder *dec);
+static __inline size_t bit_stream_bits_left(const struct bit_decoder *dec);
 static __inline int bit_refill(struct bit_decoder *dec);
 
 
@@ -376,4 +377,24 @@ static __inline unsigned int bit_end_of_stream(const struct bit_decoder *dec)
 		(dec->bits_consumed == sizeof(dec->bit_container)*8));
 }
 
+
+/**
+ * @brief get the number of not consumed bits of the bitstream
+ *
+ * @param dec	a bitstream decoding context
+ *
+ * @returns the number of bits which are not yet consumed; 0 if more bits are
+ *	consumed than the bitstream contains
+ */
+
+static __inline size_t bit_stream_bits_left(const struct bit_decoder *dec)
+{
+	size_t const bits = (size_t)(dec->limit_ptr - dec->cursor) * 8 +
+		sizeof(dec->bit_container) * 8;
+
+	if (dec->bits_consumed > bits)
+		return 0;
+	return bits - dec->bits_consumed;
+}
+
 #endif /* READ_BITSTREAM_H */
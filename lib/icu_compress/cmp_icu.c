@@ -34,37 +34,120 @@
 #include "../common/cmp_error_list.h"
 #include "../common/leon_inttypes.h"
 #include "cmp_chunk_type.h"
+#include "write_bitstream.h"
 
 #include "../cmp_icu.h"
 #include "../cmp_chunk.h"
 
 
 /**
- * @brief default implementation of the get_timestamp() function
+ * @brief get a current PLATO timestamp with the function of a compression
+ *	context
  *
- * @returns 0
+ * @param ctx	pointer to a compression context
+ *
+ * @returns the current timestamp or 0 if the context has no timestamp function
  */
 
-static uint64_t default_get_timestamp(void)
+static uint64_t get_timestamp(const struct cmp_ctx *ctx)
 {
-	return 0;
+	if (!ctx->return_timestamp)
+		return 0;
+
+	return ctx->return_timestamp();
 }
 
 
 /**
- * @brief function pointer to a function returning a current PLATO timestamp
- *	initialised with the compress_chunk_init() function
+ * @brief compression context used by compress_chunk() and
+ *	compress_chunk_parallel(); initialised with the compress_chunk_init()
+ *	function
+ */
+
+static struct cmp_ctx default_ctx;
+
+
+/**
+ * @brief encoder variant flags; the compression loops are specialised at
+ *	compile time for every combination of these flags
+ *
+ * select_encoder_variant() selects ENC_RICE, ENC_MULTI and ENC_SIZE_ONLY,
+ * or ENC_SIZE_ONLY | ENC_HISTOGRAM to collect the residual histograms of the
+ * per-collection parameter selection. The encoding loops add ENC_UNCHECKED
+ * for blocks which fit into the bitstream in any case. The functions taking
+ * a variant parameter evaluate the flags of this list which apply to them.
+ */
+
+#define ENC_RICE	0x1U /**< use the Rice code word generator instead of the Golomb one */
+#define ENC_MULTI	0x2U /**< use the multi escape symbol mechanism instead of the zero one */
+#define ENC_SIZE_ONLY	0x4U /**< only calculate the bitstream length without forming code words */
+#define ENC_UNCHECKED	0x8U /**< the bitstream buffer is large enough and all code words are valid; nothing is checked */
+#define ENC_HISTOGRAM	0x10U /**< only count the mapped residuals in the histogram of the setup; used with ENC_SIZE_ONLY */
+
+
+/**
+ * @brief maximum number of bits put into the bitstream for one value: a code
+ *	word of up to 32 bits followed by up to 32 bits of unencoded data
+ */
+
+#define MAX_BITS_PER_VALUE	64U
+
+
+/**
+ * @brief number of small values for which the Golomb code words are
+ *	precomputed in a code word table
+ */
+
+#define CW_TABLE_SIZE	256U
+
+/**
+ * @brief maximum number of code word tables in a cache; this is the highest
+ *	number of different compression parameters used by one data type
+ */
+
+#define CW_CACHE_ENTRIES	6U
+
+
+/**
+ * @brief table of the precomputed Golomb code words for the values smaller
+ *	than CW_TABLE_SIZE
+ */
+
+struct cw_table {
+	uint32_t golomb_par;         /**< Golomb parameter of the table; 0 if the table is not built */
+	uint32_t cw[CW_TABLE_SIZE];  /**< code words */
+	uint8_t len[CW_TABLE_SIZE];  /**< code word lengths; lengths greater than 32 are stored as 33 */
+};
+
+
+/**
+ * @brief cache of code word tables; a table is only built once for a Golomb
+ *	parameter as long as it is in the cache
+ */
+
+struct cw_table_cache {
+	struct cw_table table[CW_CACHE_ENTRIES]; /**< code word tables */
+	unsigned int n_built;                    /**< number of tables built so far */
+};
+
+
+/**
+ * @brief number of buckets of a residual histogram; a mapped residual is
+ *	counted in the bucket of its bit length (0 to 32)
  */
 
-static uint64_t (*get_timestamp)(void) = default_get_timestamp;
+#define COL_HIST_BUCKETS	33U
 
 
 /**
- * @brief holding the version_identifier for the compression header
- *	initialised with the compress_chunk_init() function
+ * @brief histogram of the mapped residuals of a compression parameter slot
+ *	(see select_col_pars())
  */
 
-static uint32_t version_identifier;
+struct col_hist {
+	uint32_t count[COL_HIST_BUCKETS]; /**< number of mapped residuals of every bit length */
+	uint32_t max_data_bits;           /**< highest max_data_bits of the fields of the slot; 0 if the slot is not used */
+};
 
 
 /**
@@ -72,17 +155,17 @@ static uint32_t version_identifier;
  */
 
 struct encoder_setup {
-	uint32_t (*generate_cw_f)(uint32_t value, uint32_t encoder_par1,
-				  uint32_t encoder_par2, uint32_t *cw); /**< function pointer to a code word encoder */
-	uint32_t (*encode_method_f)(uint32_t data, uint32_t model, uint32_t stream_len,
-				    const struct encoder_setup *setup); /**< pointer to the encoding function */
-	uint32_t *bitstream_adr; /**< start address of the compressed data bitstream */
-	uint32_t max_stream_len; /**< maximum length of the bitstream in bits */
+	struct bit_encoder *enc; /**< pointer to the bitstream encoder */
+	const struct cw_table *cw_table; /**< precomputed Golomb code words of small values; can be NULL */
 	uint32_t encoder_par1;   /**< encoding parameter 1 */
 	uint32_t encoder_par2;   /**< encoding parameter 2 */
+	uint32_t golomb_recip;   /**< reciprocal of the Golomb parameter (see golomb_recip()) */
+	uint32_t max_cw_len;     /**< upper bound of the length of all code words of the setup */
+	uint32_t min_cw_len;     /**< lower bound of the length of all code words of the setup */
 	uint32_t spillover_par;  /**< outlier parameter */
 	uint32_t lossy_par;      /**< lossy compression parameter */
 	uint32_t max_data_bits;  /**< how many bits are needed to represent the highest possible value */
+	struct col_hist *hist;   /**< residual histogram of the parameter slot; only used with ENC_HISTOGRAM */
 };
 
 
@@ -96,99 +179,19 @@ struct encoder_setup {
  * @returns the positive mapped value
  */
 
-static uint32_t map_to_pos(uint32_t value_to_map, unsigned int max_data_bits)
+static __inline uint32_t map_to_pos(uint32_t value_to_map, unsigned int max_data_bits)
 {
 	uint32_t const mask = (~0U >> (32 - max_data_bits)); /* mask the used bits */
-	uint32_t result;
-
-	value_to_map &= mask;
-	if (value_to_map >> (max_data_bits - 1)) { /* check the leading signed bit */
-		value_to_map |= ~mask; /* convert to 32-bit signed integer */
-		/* map negative values to uneven numbers */
-		result = (-value_to_map) * 2 - 1; /* possible integer overflow is intended */
-	} else {
-		/* map positive values to even numbers */
-		result = value_to_map * 2; /* possible integer overflow is intended */
-	}
-
-	return result;
-}
+	uint32_t const sign = (value_to_map & mask) >> (max_data_bits - 1); /* leading signed bit */
 
-
-/**
- * @brief put the value of up to 32 bits into a big-endian bitstream
- *
- * @param value			the value to put into the bitstream
- * @param n_bits		number of bits to put into the bitstream
- * @param bit_offset		bit index where the bits will be put, seen from
- *				the very beginning of the bitstream
- * @param bitstream_adr		this is the pointer to the beginning of the
- *				bitstream (can be NULL)
- * @param max_stream_len	maximum length of the bitstream in *bits*; is
- *				ignored if bitstream_adr is NULL
- *
- * @returns the length of the generated bitstream in bits on success or an error
- *          code (which can be tested with cmp_is_error()) in the event of an
- *          incorrect input or if the bitstream buffer is too small to put the
- *          value in the bitstream.
- */
-
-static uint32_t put_n_bits32(uint32_t value, unsigned int n_bits, uint32_t bit_offset,
-			     uint32_t *bitstream_adr, unsigned int max_stream_len)
-{
 	/*
-	 *                               UNSEGMENTED
-	 * |-----------|XXXXXX|---------------|--------------------------------|
-	 * |-bits_left-|n_bits|-------------------bits_right-------------------|
-	 * ^
-	 * local_adr
-	 *                               SEGMENTED
-	 * |-----------------------------|XXX|XXX|-----------------------------|
-	 * |----------bits_left----------|n_bits-|---------bits_right----------|
+	 * positive values are mapped to even numbers: value * 2
+	 * negative values are mapped to uneven numbers: -value * 2 - 1, which
+	 * is the same as ~value * 2 + 1
+	 * this is done without a branch, so that loops using this function can
+	 * be vectorised by the compiler
 	 */
-	uint32_t const bits_left = bit_offset & 0x1F;
-	uint32_t const bits_right = 64 - bits_left - n_bits;
-	uint32_t const shift_left = 32 - n_bits;
-	uint32_t const stream_len = n_bits + bit_offset; /* no check for overflow */
-	uint32_t *local_adr;
-	uint32_t mask, tmp;
-
-	/* Leave in case of erroneous input */
-	RETURN_ERROR_IF((int)shift_left < 0, INT_DECODER, "cannot insert more than 32 bits into the bit stream");  /* check n_bits <= 32 */
-
-	if (n_bits == 0)
-		return stream_len;
-
-	if (!bitstream_adr)  /* Do we need to write data to the bitstream? */
-		return stream_len;
-
-	/* Check if the bitstream buffer is large enough */
-	if (stream_len > max_stream_len)
-		return CMP_ERROR(SMALL_BUFFER);
-
-	local_adr = bitstream_adr + (bit_offset >> 5);
-
-	/* clear the destination with inverse mask */
-	mask = (0XFFFFFFFFU << shift_left) >> bits_left;
-	tmp = be32_to_cpu(*local_adr) & ~mask;
-
-	/* put (the first part of) the value into the bitstream */
-	tmp |= (value << shift_left) >> bits_left;
-	*local_adr = cpu_to_be32(tmp);
-
-	/* Do we need to split the value over two words (SEGMENTED case) */
-	if (bits_right < 32) {
-		local_adr++;  /* adjust address */
-
-		/* clear the destination */
-		mask = 0XFFFFFFFFU << bits_right;
-		tmp = be32_to_cpu(*local_adr) & ~mask;
-
-		/* put the 2nd part of the value into the bitstream */
-		tmp |= value << bits_right;
-		*local_adr = cpu_to_be32(tmp);
-	}
-	return stream_len;
+	return (((value_to_map ^ (0U - sign)) & mask) << 1) | sign;
 }
 
 
@@ -207,8 +210,8 @@ static uint32_t put_n_bits32(uint32_t value, unsigned int n_bits, uint32_t bit_o
  *	if the return value is greater than 32
  */
 
-static uint32_t rice_encoder(uint32_t value, uint32_t m, uint32_t log2_m,
-			     uint32_t *cw)
+FORCE_INLINE uint32_t rice_encoder(uint32_t value, uint32_t m, uint32_t log2_m,
+			   uint32_t *cw)
 {
 	uint32_t const q = value >> log2_m;  /* quotient of value/m */
 	uint32_t const qc = (1U << q) - 1;   /* quotient code without ending zero */
@@ -228,12 +231,71 @@ static uint32_t rice_encoder(uint32_t value, uint32_t m, uint32_t log2_m,
 }
 
 
+/**
+ * @brief calculate the reciprocal of a Golomb parameter to replace the
+ *	division by the parameter with a multiplication and shifts
+ *
+ * This is the branch-free unsigned division algorithm of libdivide
+ * (https://libdivide.com): n/m = (((n - q) >> 1) + q) >> ilog_2(m) with
+ * q = (n * recip) >> 32. It is exact for all 32-bit values of n.
+ *
+ * @param m	Golomb parameter (have to be bigger than 0)
+ *
+ * @returns the reciprocal of the Golomb parameter; 0 if the Golomb parameter
+ *	is a power of two, in this case a shift is used for the division
+ */
+
+static uint32_t golomb_recip(uint32_t m)
+{
+	uint64_t num;
+	uint32_t recip, rem, twice_rem;
+
+	if (is_a_pow_of_2(m))
+		return 0;
+
+	/* the reciprocal has 33 bits, the highest bit is added in golomb_div() */
+	num = (uint64_t)1 << (32 + ilog_2(m));
+	recip = (uint32_t)(num / m);
+	rem = (uint32_t)(num % m);
+	recip += recip;
+	twice_rem = rem + rem;
+	if (twice_rem >= m || twice_rem < rem)
+		recip += 1;
+
+	return recip + 1;
+}
+
+
+/**
+ * @brief divide a value by a Golomb parameter without a division instruction
+ *
+ * @param n		dividend
+ * @param log2_m	is ilog_2(m) of the Golomb parameter m
+ * @param recip		reciprocal of the Golomb parameter (see golomb_recip())
+ *
+ * @returns n/m rounded down
+ */
+
+FORCE_INLINE uint32_t golomb_div(uint32_t n, uint32_t log2_m, uint32_t recip)
+{
+	uint32_t q;
+
+	if (!recip) /* power of two */
+		return n >> log2_m;
+
+	q = (uint32_t)(((uint64_t)n * recip) >> 32);
+	return (((n - q) >> 1) + q) >> log2_m;
+}
+
+
 /**
  * @brief forms a codeword according to the Golomb code
  *
  * @param value		value to be encoded (must be smaller or equal than cmp_ima_max_spill(m))
  * @param m		Golomb parameter (have to be bigger than 0)
  * @param log2_m	is ilog_2(m) calculate outside function for better performance
+ * @param recip		is golomb_recip(m) calculate outside function for better
+ *			performance
  * @param cw		address where the code word is stored
  *
  * @warning there is no check of the validity of the input parameters!
@@ -241,8 +303,8 @@ static uint32_t rice_encoder(uint32_t value, uint32_t m, uint32_t log2_m,
  *	if the return value is greater than 32
  */
 
-static uint32_t golomb_encoder(uint32_t value, uint32_t m, uint32_t log2_m,
-			       uint32_t *cw)
+FORCE_INLINE uint32_t golomb_encoder(uint32_t value, uint32_t m, uint32_t log2_m,
+				     uint32_t recip, uint32_t *cw)
 {
 	uint32_t len = log2_m + 1;  /* codeword length in group 0 */
 	uint32_t const cutoff = (0x2U << log2_m) - m;  /* members in group 0 */
@@ -251,7 +313,7 @@ static uint32_t golomb_encoder(uint32_t value, uint32_t m, uint32_t log2_m,
 		*cw = value;
 	} else {  /* other groups */
 		uint32_t const reg_mask = 0x1FU;  /* mask for the right shift operand to prevent undefined behavior */
-		uint32_t const g = (value-cutoff) / m;  /* group number of same cw length */
+		uint32_t const g = golomb_div(value-cutoff, log2_m, recip);  /* group number of same cw length */
 		uint32_t const r = (value-cutoff) - g * m; /* member in the group */
 		uint32_t const gc = (1U << (g & reg_mask)) - 1; /* prepare the left side in unary */
 		uint32_t const b = cutoff << 1;         /* form the base codeword */
@@ -264,53 +326,174 @@ static uint32_t golomb_encoder(uint32_t value, uint32_t m, uint32_t log2_m,
 }
 
 
+/**
+ * @brief calculate the length of a Rice code word without forming it
+ *
+ * @param value		value to be encoded
+ * @param log2_m	Rice parameter, is ilog_2(m) of the Golomb parameter m
+ *
+ * @returns the length of the code word in bits; the code word is invalid if
+ *	the return value is greater than 32
+ */
+
+FORCE_INLINE uint32_t rice_cw_len(uint32_t value, uint32_t log2_m)
+{
+	return (value >> log2_m) + log2_m + 1;
+}
+
+
+/**
+ * @brief calculate the length of a Golomb code word without forming it
+ *
+ * @param value		value to be encoded
+ * @param m		Golomb parameter (have to be bigger than 0)
+ * @param log2_m	is ilog_2(m) calculate outside function for better performance
+ * @param recip		is golomb_recip(m) calculate outside function for better
+ *			performance
+ *
+ * @returns the length of the code word in bits; the code word is invalid if
+ *	the return value is greater than 32
+ */
+
+FORCE_INLINE uint32_t golomb_cw_len(uint32_t value, uint32_t m, uint32_t log2_m,
+				    uint32_t recip)
+{
+	uint32_t const cutoff = (0x2U << log2_m) - m;  /* members in group 0 */
+
+	if (value < cutoff)  /* group 0 */
+		return log2_m + 1;
+
+	return log2_m + 2 + golomb_div(value-cutoff, log2_m, recip);
+}
+
+
+/**
+ * @brief calculate the length of the code word of a value without forming it
+ *
+ * @param value		value to be encoded
+ * @param setup		pointer to the encoder setup
+ * @param variant	encoder variant flags; if ENC_RICE is set the Rice code
+ *			is used, otherwise the Golomb code
+ *
+ * @returns the length of the code word in bits; the code word is invalid if
+ *	the return value is greater than 32
+ */
+
+FORCE_INLINE uint32_t code_word_len(uint32_t value, const struct encoder_setup *setup,
+				    unsigned int const variant)
+{
+	if (variant & ENC_RICE)
+		return rice_cw_len(value, setup->encoder_par2);
+	if (setup->cw_table && value < CW_TABLE_SIZE)
+		return setup->cw_table->len[value];
+	return golomb_cw_len(value, setup->encoder_par1, setup->encoder_par2,
+			     setup->golomb_recip);
+}
+
+
+/**
+ * @brief put the value of up to 32 bits into the bitstream of an encoder setup
+ *
+ * @param setup		pointer to the encoder setup
+ * @param value		the value to put into the bitstream
+ * @param n_bits	number of bits to put into the bitstream
+ * @param variant	encoder variant flags; if ENC_UNCHECKED is set nothing
+ *			is checked (see bit_write_bits32_unchecked())
+ *
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ */
+
+FORCE_INLINE uint32_t encoder_write_bits(const struct encoder_setup *setup,
+					 uint32_t value, unsigned int n_bits,
+					 unsigned int const variant)
+{
+	if (variant & ENC_UNCHECKED)
+		return bit_write_bits32_unchecked(setup->enc, value, n_bits);
+	return bit_write_bits32(setup->enc, value, n_bits);
+}
+
+
 /**
  * @brief generate a code word without an outlier mechanism and put it in the
  *	bitstream
  *
  * @param value		value to encode in the bitstream
- * @param stream_len	length of the bitstream in bits
  * @param setup		pointer to the encoder setup
+ * @param variant	encoder variant flags; if ENC_RICE is set the Rice code
+ *			is used, otherwise the Golomb code; if ENC_SIZE_ONLY is
+ *			set only the code word length is calculated
  *
  * @returns the bit length of the bitstream on success or an error code if it
  *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t encode_normal(uint32_t value, uint32_t stream_len,
-			      const struct encoder_setup *setup)
+FORCE_INLINE uint32_t encode_normal(uint32_t value, const struct encoder_setup *setup,
+				    unsigned int const variant)
 {
 	uint32_t code_word, cw_len;
 
-	cw_len = setup->generate_cw_f(value, setup->encoder_par1,
+	if (variant & ENC_SIZE_ONLY) {
+		cw_len = code_word_len(value, setup, variant);
+		/* the bitstream encoder only counts the bits in this case */
+		return bit_write_bits32(setup->enc, 0, cw_len);
+	}
+
+	if (variant & ENC_RICE) {
+		cw_len = rice_encoder(value, setup->encoder_par1,
 				      setup->encoder_par2, &code_word);
+	} else if (setup->cw_table && value < CW_TABLE_SIZE) {
+		code_word = setup->cw_table->cw[value];
+		cw_len = setup->cw_table->len[value];
+	} else {
+		cw_len = golomb_encoder(value, setup->encoder_par1,
+					setup->encoder_par2, setup->golomb_recip,
+					&code_word);
+	}
 
-	return put_n_bits32(code_word, cw_len, stream_len, setup->bitstream_adr,
-			    setup->max_stream_len);
+	return encoder_write_bits(setup, code_word, cw_len, variant);
 }
 
 
 /**
- * @brief subtracts the model from the data, encodes the result and puts it into
- *	bitstream, for encoding outlier use the zero escape symbol mechanism
+ * @brief count an already mapped value in the residual histogram of the
+ *	encoder setup instead of encoding it (ENC_HISTOGRAM variant)
  *
- * @param data		data to encode
- * @param model		model of the data (0 if not used)
- * @param stream_len	length of the bitstream in bits
+ * @param data		mapped value to count (see map_to_pos())
+ * @param setup		pointer to the encoder setup
+ *
+ * @returns the unchanged bit length of the bitstream
+ */
+
+static __inline uint32_t histogram_add(uint32_t data, const struct encoder_setup *setup)
+{
+	unsigned int const bucket = data ? 32U - (unsigned int)__builtin_clz(data) : 0;
+
+	setup->hist->count[bucket]++;
+	return setup->enc->stream_len;
+}
+
+
+/**
+ * @brief encodes an already mapped value and puts it into bitstream, for
+ *	encoding outlier use the zero escape symbol mechanism
+ *
+ * @param data		mapped value to encode (see map_to_pos())
  * @param setup		pointer to the encoder setup
+ * @param variant	encoder variant flags (ENC_MULTI is not evaluated)
  *
  * @returns the bit length of the bitstream on success or an error code if it
  *	fails (which can be tested with cmp_is_error())
  *
- * @note no check if the data or model are in the allowed range
  * @note no check if the setup->spillover_par is in the allowed range
  */
 
-static uint32_t encode_value_zero(uint32_t data, uint32_t model, uint32_t stream_len,
-				  const struct encoder_setup *setup)
+FORCE_INLINE uint32_t encode_mapped_zero(uint32_t data,
+					 const struct encoder_setup *setup,
+					 unsigned int const variant)
 {
-	data -= model; /* possible underflow is intended */
-
-	data = map_to_pos(data, setup->max_data_bits);
+	if (variant & ENC_HISTOGRAM)
+		return histogram_add(data, setup);
 
 	/* For performance reasons, we check to see if there is an outlier
 	 * before adding one, rather than the other way around:
@@ -320,31 +503,27 @@ static uint32_t encode_value_zero(uint32_t data, uint32_t model, uint32_t stream
 	 */
 	if (data < (setup->spillover_par - 1)) { /* detect non-outlier */
 		data++; /* add 1 to every value so we can use 0 as the escape symbol */
-		return encode_normal(data, stream_len, setup);
+		return encode_normal(data, setup, variant);
 	}
 
 	data++; /* add 1 to every value so we can use 0 as the escape symbol */
 
 	/* use zero as escape symbol */
-	stream_len = encode_normal(0, stream_len, setup);
-	if (cmp_is_error(stream_len))
-		return stream_len;
+	FORWARD_IF_ERROR(encode_normal(0, setup, variant), "");
 
 	/* put the data unencoded in the bitstream */
-	stream_len = put_n_bits32(data, setup->max_data_bits, stream_len,
-				  setup->bitstream_adr, setup->max_stream_len);
-	return stream_len;
+	return encoder_write_bits(setup, data, setup->max_data_bits, variant);
 }
 
 
 /**
- * @brief subtract the model from the data, encode the result and puts it into
- *	bitstream, for encoding outlier use the multi escape symbol mechanism
+ * @brief subtracts the model from the data, encodes the result and puts it into
+ *	bitstream, for encoding outlier use the zero escape symbol mechanism
  *
  * @param data		data to encode
  * @param model		model of the data (0 if not used)
- * @param stream_len	length of the bitstream in bits
  * @param setup		pointer to the encoder setup
+ * @param variant	encoder variant flags (ENC_MULTI is not evaluated)
  *
  * @returns the bit length of the bitstream on success or an error code if it
  *	fails (which can be tested with cmp_is_error())
@@ -353,19 +532,44 @@ static uint32_t encode_value_zero(uint32_t data, uint32_t model, uint32_t stream
  * @note no check if the setup->spillover_par is in the allowed range
  */
 
-static uint32_t encode_value_multi(uint32_t data, uint32_t model, uint32_t stream_len,
-				   const struct encoder_setup *setup)
+FORCE_INLINE uint32_t encode_value_zero(uint32_t data, uint32_t model,
+					const struct encoder_setup *setup,
+					unsigned int const variant)
+{
+	data -= model; /* possible underflow is intended */
+
+	return encode_mapped_zero(map_to_pos(data, setup->max_data_bits),
+				  setup, variant);
+}
+
+
+/**
+ * @brief encodes an already mapped value and puts it into bitstream, for
+ *	encoding outlier use the multi escape symbol mechanism
+ *
+ * @param data		mapped value to encode (see map_to_pos())
+ * @param setup		pointer to the encoder setup
+ * @param variant	encoder variant flags (ENC_MULTI is not evaluated)
+ *
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ *
+ * @note no check if the setup->spillover_par is in the allowed range
+ */
+
+FORCE_INLINE uint32_t encode_mapped_multi(uint32_t data,
+					  const struct encoder_setup *setup,
+					  unsigned int const variant)
 {
 	uint32_t unencoded_data;
 	unsigned int unencoded_data_len;
 	uint32_t escape_sym, escape_sym_offset;
 
-	data -= model; /* possible underflow is intended */
-
-	data = map_to_pos(data, setup->max_data_bits);
+	if (variant & ENC_HISTOGRAM)
+		return histogram_add(data, setup);
 
 	if (data < setup->spillover_par) /* detect non-outlier */
-		return  encode_normal(data, stream_len, setup);
+		return  encode_normal(data, setup, variant);
 
 	/*
 	 * In this mode we put the difference between the data and the spillover
@@ -389,1713 +593,4236 @@ static uint32_t encode_value_multi(uint32_t data, uint32_t model, uint32_t strea
 	unencoded_data_len = (escape_sym_offset + 1U) << 1;
 
 	/* put the escape symbol in the bitstream */
-	stream_len = encode_normal(escape_sym, stream_len, setup);
-	if (cmp_is_error(stream_len))
-		return stream_len;
+	FORWARD_IF_ERROR(encode_normal(escape_sym, setup, variant), "");
 
 	/* put the unencoded data in the bitstream */
-	stream_len = put_n_bits32(unencoded_data, unencoded_data_len, stream_len,
-				  setup->bitstream_adr, setup->max_stream_len);
-	return stream_len;
+	return encoder_write_bits(setup, unencoded_data, unencoded_data_len, variant);
 }
 
 
 /**
- * @brief encodes the data with the model and the given setup and put it into
- *	the bitstream
+ * @brief subtract the model from the data, encode the result and puts it into
+ *	bitstream, for encoding outlier use the multi escape symbol mechanism
  *
  * @param data		data to encode
  * @param model		model of the data (0 if not used)
- * @param stream_len	length of the bitstream in bits
  * @param setup		pointer to the encoder setup
+ * @param variant	encoder variant flags (ENC_MULTI is not evaluated)
  *
  * @returns the bit length of the bitstream on success or an error code if it
  *	fails (which can be tested with cmp_is_error())
+ *
+ * @note no check if the data or model are in the allowed range
+ * @note no check if the setup->spillover_par is in the allowed range
  */
 
-static uint32_t encode_value(uint32_t data, uint32_t model, uint32_t stream_len,
-			     const struct encoder_setup *setup)
+FORCE_INLINE uint32_t encode_value_multi(uint32_t data, uint32_t model,
+					 const struct encoder_setup *setup,
+					 unsigned int const variant)
 {
-	uint32_t const mask = ~(0xFFFFFFFFU >> (32-setup->max_data_bits));
-
-	/* lossy rounding of the data if lossy_par > 0 */
-	data = round_fwd(data, setup->lossy_par);
-	model = round_fwd(model, setup->lossy_par);
-
-	RETURN_ERROR_IF(data & mask || model & mask, DATA_VALUE_TOO_LARGE, "");
+	data -= model; /* possible underflow is intended */
 
-	return setup->encode_method_f(data, model, stream_len, setup);
+	return encode_mapped_multi(map_to_pos(data, setup->max_data_bits),
+				   setup, variant);
 }
 
 
 /**
- * @brief calculate the maximum length of the bitstream in bits
- * @note we round down to the next 4-byte allied address because we access the
- *	cmp_buffer in uint32_t words
+ * @brief encodes an already mapped value with the escape symbol mechanism of
+ *	the encoder variant and puts it into the bitstream
  *
- * @param stream_size	size of the bitstream in bytes
+ * @param mapped	mapped value to encode (see map_to_pos())
+ * @param setup		pointer to the encoder setup
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
- * @returns buffer size in bits
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t cmp_stream_size_to_bits(uint32_t stream_size)
+FORCE_INLINE uint32_t encode_mapped(uint32_t mapped,
+				    const struct encoder_setup *setup,
+				    unsigned int const variant)
 {
-	return (stream_size & ~0x3U) * 8;
+	if (variant & ENC_MULTI)
+		return encode_mapped_multi(mapped, setup, variant);
+	return encode_mapped_zero(mapped, setup, variant);
 }
 
 
 /**
- * @brief configure an encoder setup structure to have a setup to encode a value
+ * @brief encodes the data with the model and the given setup and put it into
+ *	the bitstream
  *
+ * @param data		data to encode
+ * @param model		model of the data (0 if not used)
  * @param setup		pointer to the encoder setup
- * @param cmp_par	compression parameter
- * @param spillover	spillover_par parameter
- * @param lossy_par	lossy compression parameter
- * @param max_data_bits	how many bits are needed to represent the highest possible value
- * @param cfg		pointer to the compression configuration structure
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
- * @warning input parameters are not checked for validity
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
  */
 
-static void configure_encoder_setup(struct encoder_setup *setup,
-				    uint32_t cmp_par, uint32_t spillover,
-				    uint32_t lossy_par, uint32_t max_data_bits,
-				    const struct cmp_cfg *cfg)
+FORCE_INLINE uint32_t encode_value(uint32_t data, uint32_t model,
+				   const struct encoder_setup *setup,
+				   unsigned int const variant)
 {
-	memset(setup, 0, sizeof(struct encoder_setup));
+	uint32_t const mask = ~(0xFFFFFFFFU >> (32-setup->max_data_bits));
 
-	setup->encoder_par1 = cmp_par;
-	setup->max_data_bits = max_data_bits;
-	setup->lossy_par = lossy_par;
-	setup->bitstream_adr = cfg->dst;
-	setup->max_stream_len = cmp_stream_size_to_bits(cfg->stream_size);
-	setup->encoder_par2 = ilog_2(cmp_par);
-	setup->spillover_par = spillover;
+	/* lossy rounding of the data if lossy_par > 0 */
+	data = round_fwd(data, setup->lossy_par);
+	model = round_fwd(model, setup->lossy_par);
 
-	/* for encoder_par1 which is a power of two we can use the faster rice_encoder */
-	if (is_a_pow_of_2(setup->encoder_par1))
-		setup->generate_cw_f = &rice_encoder;
-	else
-		setup->generate_cw_f = &golomb_encoder;
+	RETURN_ERROR_IF(data & mask || model & mask, DATA_VALUE_TOO_LARGE, "");
 
-	/* CMP_MODE_RAW is already handled before */
-	if (cfg->cmp_mode == CMP_MODE_MODEL_ZERO ||
-	    cfg->cmp_mode == CMP_MODE_DIFF_ZERO)
-		setup->encode_method_f = &encode_value_zero;
-	else
-		setup->encode_method_f = &encode_value_multi;
+	if (variant & ENC_MULTI)
+		return encode_value_multi(data, model, setup, variant);
+	return encode_value_zero(data, model, setup, variant);
 }
 
 
 /**
- * @brief compress imagette data
+ * @brief get the minimum number of bits needed to encode a sample
  *
- * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
+ * The minimum is only given if no code word of the setups can be invalid;
+ * otherwise, the compression has to report an invalid code word and must not
+ * be stopped early (see stop_if_stream_cannot_fit()).
  *
- * @returns the bit length of the bitstream on success or an error code if it
- *	fails (which can be tested with cmp_is_error())
+ * @param setup		array of pointers to the encoder setups of the fields
+ *			of a sample
+ * @param n_fields	number of fields of a sample
+ *
+ * @returns the minimum number of bits of a sample; 0 if a code word can be
+ *	invalid
  */
 
-static uint32_t compress_imagette(const struct cmp_cfg *cfg, uint32_t stream_len)
+static uint32_t min_sample_bits(const struct encoder_setup *const *setup,
+				unsigned int n_fields)
 {
-	size_t i;
-	struct encoder_setup setup;
-	uint32_t max_data_bits;
-
-	const uint16_t *data_buf = cfg->src;
-	const uint16_t *model_buf = cfg->model_buf;
-	uint16_t model = 0;
-	const uint16_t *next_model_p = data_buf;
-	uint16_t *up_model_buf = NULL;
+	uint32_t min_bits = 0;
+	unsigned int f;
 
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		model = get_unaligned(&model_buf[0]);
-		next_model_p = &model_buf[1];
-		up_model_buf = cfg->updated_model_buf;
-	}
-
-	if (cfg->data_type == DATA_TYPE_F_CAM_IMAGETTE ||
-	    cfg->data_type == DATA_TYPE_F_CAM_IMAGETTE_ADAPTIVE) {
-		max_data_bits = MAX_USED_BITS.fc_imagette;
-	} else if (cfg->data_type == DATA_TYPE_SAT_IMAGETTE ||
-		   cfg->data_type == DATA_TYPE_SAT_IMAGETTE_ADAPTIVE) {
-		max_data_bits = MAX_USED_BITS.saturated_imagette;
-	} else { /* DATA_TYPE_IMAGETTE, DATA_TYPE_IMAGETTE_ADAPTIVE */
-		max_data_bits = MAX_USED_BITS.nc_imagette;
+	for (f = 0; f < n_fields; f++) {
+		if (setup[f]->max_cw_len > 32)
+			return 0;
+		min_bits += setup[f]->min_cw_len;
 	}
+	return min_bits;
+}
 
-	configure_encoder_setup(&setup, cfg->cmp_par_imagette,
-				cfg->spill_imagette, cfg->round, max_data_bits, cfg);
-
-	for (i = 0;; i++) {
-		stream_len = encode_value(get_unaligned(&data_buf[i]),
-					  model, stream_len, &setup);
-		if (cmp_is_error(stream_len))
-			break;
 
-		if (up_model_buf) {
-			uint16_t data = get_unaligned(&data_buf[i]);
-			up_model_buf[i] = cmp_up_model(data, model, cfg->model_value,
-						       setup.lossy_par);
-		}
-		if (i >= cfg->samples-1)
-			break;
+/**
+ * @brief stop a compression early if the bitstream can no longer fit into
+ *	the bitstream buffer
+ *
+ * The remaining samples need at least min_bits bits each. If this lower bound
+ * of the bitstream length exceeds the buffer, the compression fails anyway
+ * with a CMP_ERROR_SMALL_BUFFER error, so it can stop here. This saves most of
+ * the compression of an incompressible collection before the fallback to the
+ * raw mode (see cmp_collection()).
+ *
+ * @param enc		pointer to the bitstream encoder
+ * @param remaining	number of samples which are not yet encoded
+ * @param min_bits	minimum number of bits of a sample (see
+ *			min_sample_bits())
+ *
+ * @returns the bit length of the bitstream if it can still fit, otherwise a
+ *	CMP_ERROR_SMALL_BUFFER error code; an encoder without a bitstream buffer
+ *	is never stopped
+ */
 
-		model = get_unaligned(&next_model_p[i]);
+static __inline uint32_t stop_if_stream_cannot_fit(struct bit_encoder *enc,
+						   size_t remaining, uint32_t min_bits)
+{
+	if (enc->cursor && (uint64_t)enc->stream_len + (uint64_t)remaining * min_bits >
+	    enc->max_stream_len) {
+		/* the same state as a failed bit_write_bits32() */
+		bit_flush_encoder(enc);
+		return CMP_ERROR(SMALL_BUFFER);
 	}
-	return stream_len;
+	return enc->stream_len;
 }
 
 
 /**
- * @brief compress short normal light flux (S_FX) data
+ * @brief calculate the maximum length of the bitstream in bits
+ * @note we round down to the next 4-byte allied address because we access the
+ *	cmp_buffer in uint32_t words
  *
- * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
+ * @param stream_size	size of the bitstream in bytes
  *
- * @returns the bit length of the bitstream on success or an error code if it
- *	fails (which can be tested with cmp_is_error())
+ * @returns buffer size in bits
  */
 
-static uint32_t compress_s_fx(const struct cmp_cfg *cfg, uint32_t stream_len)
+static uint32_t cmp_stream_size_to_bits(uint32_t stream_size)
 {
-	size_t i;
+	return (stream_size & ~0x3U) * 8;
+}
 
-	const struct s_fx *data_buf = cfg->src;
-	const struct s_fx *model_buf = cfg->model_buf;
-	struct s_fx *up_model_buf = NULL;
-	const struct s_fx *next_model_p;
-	struct s_fx model;
-	struct encoder_setup setup_exp_flag, setup_fx;
 
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		model = model_buf[0];
-		next_model_p = &model_buf[1];
-		up_model_buf = cfg->updated_model_buf;
-	} else {
-		memset(&model, 0, sizeof(model));
-		next_model_p = data_buf;
-	}
+/**
+ * @brief initialise an empty code word table cache
+ *
+ * @param cache	pointer to the code word table cache
+ */
 
-	configure_encoder_setup(&setup_exp_flag, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
-				cfg->round, MAX_USED_BITS.s_exp_flags, cfg);
-	configure_encoder_setup(&setup_fx, cfg->cmp_par_fx, cfg->spill_fx,
-				cfg->round, MAX_USED_BITS.s_fx, cfg);
+static void cw_cache_init(struct cw_table_cache *cache)
+{
+	unsigned int i;
 
-	for (i = 0;; i++) {
-		stream_len = encode_value(data_buf[i].exp_flags, model.exp_flags,
-					  stream_len, &setup_exp_flag);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].fx, model.fx, stream_len,
-					  &setup_fx);
-		if (cmp_is_error(stream_len))
-			break;
+	for (i = 0; i < CW_CACHE_ENTRIES; i++)
+		cache->table[i].golomb_par = 0;
+	cache->n_built = 0;
+}
 
-		if (up_model_buf) {
-			up_model_buf[i].exp_flags = cmp_up_model(data_buf[i].exp_flags, model.exp_flags,
-								 cfg->model_value, setup_exp_flag.lossy_par);
-			up_model_buf[i].fx = cmp_up_model(data_buf[i].fx, model.fx,
-							  cfg->model_value, setup_fx.lossy_par);
-		}
 
-		if (i >= cfg->samples-1)
-			break;
+/**
+ * @brief get the code word table for a Golomb parameter from the cache; the
+ *	table is built if it is not in the cache
+ *
+ * If the cache is full, the oldest table is replaced. As long as a
+ * collection uses no more than CW_CACHE_ENTRIES different parameters, no
+ * table used by the collection is replaced.
+ *
+ * @param cache		pointer to the code word table cache
+ * @param golomb_par	Golomb parameter of the table (have to be bigger than 0)
+ *
+ * @returns a pointer to the code word table
+ */
 
-		model = next_model_p[i];
+static const struct cw_table *cw_cache_get(struct cw_table_cache *cache,
+					   uint32_t golomb_par)
+{
+	uint32_t const log2_g_par = ilog_2(golomb_par);
+	uint32_t const recip = golomb_recip(golomb_par);
+	struct cw_table *table;
+	uint32_t value;
+	unsigned int i;
+
+	for (i = 0; i < CW_CACHE_ENTRIES; i++)
+		if (cache->table[i].golomb_par == golomb_par)
+			return &cache->table[i];
+
+	table = &cache->table[cache->n_built % CW_CACHE_ENTRIES];
+	cache->n_built++;
+
+	for (value = 0; value < CW_TABLE_SIZE; value++) {
+		uint32_t const len = golomb_encoder(value, golomb_par, log2_g_par,
+						    recip, &table->cw[value]);
+		/* all lengths greater than 32 result in the same error */
+		table->len[value] = (uint8_t)(len > 32 ? 33 : len);
 	}
-	return stream_len;
+	table->golomb_par = golomb_par;
+
+	return table;
 }
 
 
 /**
- * @brief compress S_FX_EFX data
+ * @brief configure an encoder setup structure to have a setup to encode a value
  *
+ * @param setup		pointer to the encoder setup
+ * @param enc		pointer to the bitstream encoder used by the setup
+ * @param cmp_par	compression parameter
+ * @param spillover	spillover_par parameter
+ * @param lossy_par	lossy compression parameter
+ * @param max_data_bits	how many bits are needed to represent the highest possible value
  * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
  *
- * @returns the bit length of the bitstream on success or an error code if it
- *	fails (which can be tested with cmp_is_error())
+ * @note a code word table is only used for compression parameters which are
+ *	not a power of two; the Rice code does not need one
+ * @note the Golomb code of a power of two parameter is the Rice code, so
+ *	golomb_cw_len() gives the maximum code word length for both codes
+ * @warning input parameters are not checked for validity
  */
 
-static uint32_t compress_s_fx_efx(const struct cmp_cfg *cfg, uint32_t stream_len)
+static void configure_encoder_setup(struct encoder_setup *setup,
+				    struct bit_encoder *enc,
+				    uint32_t cmp_par, uint32_t spillover,
+				    uint32_t lossy_par, uint32_t max_data_bits,
+				    const struct cmp_cfg *cfg)
 {
-	size_t i;
+	memset(setup, 0, sizeof(struct encoder_setup));
 
-	const struct s_fx_efx *data_buf = cfg->src;
-	const struct s_fx_efx *model_buf = cfg->model_buf;
-	struct s_fx_efx *up_model_buf = NULL;
-	const struct s_fx_efx *next_model_p;
-	struct s_fx_efx model;
-	struct encoder_setup setup_exp_flag, setup_fx, setup_efx;
+	setup->encoder_par1 = cmp_par;
+	setup->max_data_bits = max_data_bits;
+	setup->lossy_par = lossy_par;
+	setup->enc = enc;
+	setup->encoder_par2 = ilog_2(cmp_par);
+	setup->golomb_recip = golomb_recip(cmp_par);
+	setup->spillover_par = spillover;
+	if (cfg->cw_cache && !is_a_pow_of_2(cmp_par))
+		setup->cw_table = cw_cache_get(cfg->cw_cache, cmp_par);
+	if (cfg->col_hist) {
+		/* in the histogram pass the compression parameters are the
+		 * numbers of the parameter slots (see collect_col_hist())
+		 */
+		setup->hist = &cfg->col_hist[cmp_par - 1];
+		if (setup->hist->max_data_bits < max_data_bits)
+			setup->hist->max_data_bits = max_data_bits;
+	}
 
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		model = model_buf[0];
-		next_model_p = &model_buf[1];
-		up_model_buf = cfg->updated_model_buf;
-	} else {
-		memset(&model, 0, sizeof(model));
-		next_model_p = data_buf;
+	/*
+	 * The code word length grows with the encoded value. The highest value
+	 * encoded with the zero escape symbol mechanism is spillover - 1, the
+	 * highest escape symbol of the multi escape symbol mechanism is
+	 * spillover + 15.
+	 */
+	setup->max_cw_len = 33; /* unknown; longer than any valid code word */
+	if (cmp_par) {
+		/* no code word is shorter than the code words of group 0 */
+		setup->min_cw_len = setup->encoder_par2 + 1;
+		if (cfg->cmp_mode == CMP_MODE_MODEL_ZERO || cfg->cmp_mode == CMP_MODE_DIFF_ZERO) {
+			if (spillover)
+				setup->max_cw_len = golomb_cw_len(spillover - 1, cmp_par,
+								  setup->encoder_par2,
+								  setup->golomb_recip);
+		} else if (spillover <= UINT32_MAX - 15) {
+			setup->max_cw_len = golomb_cw_len(spillover + 15, cmp_par,
+							  setup->encoder_par2,
+							  setup->golomb_recip);
+		}
 	}
+}
 
-	configure_encoder_setup(&setup_exp_flag, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
-				cfg->round, MAX_USED_BITS.s_exp_flags, cfg);
-	configure_encoder_setup(&setup_fx, cfg->cmp_par_fx, cfg->spill_fx,
-				cfg->round, MAX_USED_BITS.s_fx, cfg);
-	configure_encoder_setup(&setup_efx, cfg->cmp_par_efx, cfg->spill_efx,
-				cfg->round, MAX_USED_BITS.s_efx, cfg);
 
-	for (i = 0;; i++) {
-		stream_len = encode_value(data_buf[i].exp_flags, model.exp_flags,
-					  stream_len, &setup_exp_flag);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].fx, model.fx, stream_len,
-					  &setup_fx);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].efx, model.efx,
-					  stream_len, &setup_efx);
-		if (cmp_is_error(stream_len))
-			return stream_len;
+/**
+ * @brief define a compression function which calls the inlined compression
+ *	template name##_generic() specialised for the selected encoder variant
+ *
+ * @param name	name of the defined compression function
+ */
 
-		if (up_model_buf) {
-			up_model_buf[i].exp_flags = cmp_up_model(data_buf[i].exp_flags, model.exp_flags,
-				cfg->model_value, setup_exp_flag.lossy_par);
-			up_model_buf[i].fx = cmp_up_model(data_buf[i].fx, model.fx,
-				cfg->model_value, setup_fx.lossy_par);
-			up_model_buf[i].efx = cmp_up_model(data_buf[i].efx, model.efx,
-				cfg->model_value, setup_efx.lossy_par);
-		}
+#define DEFINE_COMPRESS_FUNCTION(name)						\
+static uint32_t name(const struct cmp_cfg *cfg, struct bit_encoder *enc,	\
+		     unsigned int variant)					\
+{										\
+	switch (variant) {							\
+	case 0:									\
+		return name##_generic(cfg, enc, 0);				\
+	case ENC_RICE:								\
+		return name##_generic(cfg, enc, ENC_RICE);			\
+	case ENC_MULTI:								\
+		return name##_generic(cfg, enc, ENC_MULTI);			\
+	case ENC_MULTI | ENC_RICE:						\
+		return name##_generic(cfg, enc, ENC_MULTI | ENC_RICE);		\
+	case ENC_SIZE_ONLY:							\
+		return name##_generic(cfg, enc, ENC_SIZE_ONLY);			\
+	case ENC_SIZE_ONLY | ENC_RICE:						\
+		return name##_generic(cfg, enc, ENC_SIZE_ONLY | ENC_RICE);	\
+	case ENC_SIZE_ONLY | ENC_MULTI:						\
+		return name##_generic(cfg, enc, ENC_SIZE_ONLY | ENC_MULTI);	\
+	case ENC_SIZE_ONLY | ENC_HISTOGRAM:					\
+		return name##_generic(cfg, enc, ENC_SIZE_ONLY | ENC_HISTOGRAM);	\
+	case ENC_SIZE_ONLY | ENC_MULTI | ENC_RICE:				\
+	default:								\
+		return name##_generic(cfg, enc,					\
+				      ENC_SIZE_ONLY | ENC_MULTI | ENC_RICE);	\
+	}									\
+}
 
-		if (i >= cfg->samples-1)
-			break;
 
-		model = next_model_p[i];
-	}
-	return stream_len;
-}
+/**
+ * @brief number of imagette samples processed by one residual pre-pass
+ */
+
+#define IMA_BLOCK_SIZE	64U
 
 
 /**
- * @brief compress S_FX_NCOB data
+ * @brief calculate the mapped residuals and the updated model of a block of
+ *	imagette samples
  *
- * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
+ * The loop has no branches and no dependencies between the samples, so the
+ * compiler can vectorise it for the target (no target specific intrinsics are
+ * used, the same code is used for all targets).
  *
- * @returns the bit length of the bitstream on success or an error code if it
- *	fails (which can be tested with cmp_is_error())
+ * @param residual	pointer to the buffer where the mapped residuals are
+ *			stored (at least n samples long)
+ * @param up_model	pointer to the buffer where the updated model is stored
+ *			(at least n samples long); NULL if no model update is
+ *			needed; must not overlap with the data or the model,
+ *			otherwise the loop cannot be vectorised
+ * @param data		pointer to the imagette data
+ * @param model		pointer to the model of the data
+ * @param n		number of samples to process
+ * @param lossy_par	lossy compression parameter
+ * @param max_data_bits	how many bits are needed to represent the highest
+ *			possible value
+ * @param model_value	model weighting parameter
+ * @param aligned	non-zero if the data and the model are 2-byte aligned;
+ *			otherwise they are read with get_unaligned()
+ *
+ * @returns non-zero if a (rounded) data or model value is greater than
+ *	max_data_bits allows, otherwise zero
  */
 
-static uint32_t compress_s_fx_ncob(const struct cmp_cfg *cfg, uint32_t stream_len)
+FORCE_INLINE uint32_t imagette_residuals_generic(uint32_t *residual,
+						 uint16_t *__restrict up_model,
+						 const uint16_t *data,
+						 const uint16_t *model, size_t n,
+						 uint32_t lossy_par,
+						 uint32_t max_data_bits,
+						 uint32_t model_value,
+						 int const aligned)
 {
-	size_t i;
-
-	const struct s_fx_ncob *data_buf = cfg->src;
-	const struct s_fx_ncob *model_buf = cfg->model_buf;
-	struct s_fx_ncob *up_model_buf = NULL;
-	const struct s_fx_ncob *next_model_p;
-	struct s_fx_ncob model;
-	struct encoder_setup setup_exp_flag, setup_fx, setup_ncob;
-
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		model = model_buf[0];
-		next_model_p = &model_buf[1];
-		up_model_buf = cfg->updated_model_buf;
-	} else {
-		memset(&model, 0, sizeof(model));
-		next_model_p = data_buf;
+	uint32_t const mask = ~(0xFFFFFFFFU >> (32-max_data_bits));
+	uint32_t used_bits = 0;
+	size_t j;
+
+	for (j = 0; j < n; j++) {
+		uint16_t const d_raw = aligned ? data[j] : get_unaligned(&data[j]);
+		uint16_t const m_raw = aligned ? model[j] : get_unaligned(&model[j]);
+		uint32_t const d = round_fwd(d_raw, lossy_par);
+		uint32_t const m = round_fwd(m_raw, lossy_par);
+
+		used_bits |= d | m;
+		residual[j] = map_to_pos(d - m, max_data_bits);
+		if (up_model)
+			up_model[j] = cmp_up_model16(d_raw, m_raw, model_value, lossy_par);
 	}
 
-	configure_encoder_setup(&setup_exp_flag, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
-				cfg->round, MAX_USED_BITS.s_exp_flags, cfg);
-	configure_encoder_setup(&setup_fx, cfg->cmp_par_fx, cfg->spill_fx,
-				cfg->round, MAX_USED_BITS.s_fx, cfg);
-	configure_encoder_setup(&setup_ncob, cfg->cmp_par_ncob, cfg->spill_ncob,
-				cfg->round, MAX_USED_BITS.s_ncob, cfg);
-
-	for (i = 0;; i++) {
-		stream_len = encode_value(data_buf[i].exp_flags, model.exp_flags,
-					  stream_len, &setup_exp_flag);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].fx, model.fx, stream_len,
-					  &setup_fx);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].ncob_x, model.ncob_x,
-					  stream_len, &setup_ncob);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].ncob_y, model.ncob_y,
-					  stream_len, &setup_ncob);
-		if (cmp_is_error(stream_len))
-			break;
+	return used_bits & mask;
+}
 
-		if (up_model_buf) {
-			up_model_buf[i].exp_flags = cmp_up_model(data_buf[i].exp_flags, model.exp_flags,
-				cfg->model_value, setup_exp_flag.lossy_par);
-			up_model_buf[i].fx = cmp_up_model(data_buf[i].fx, model.fx,
-				cfg->model_value, setup_fx.lossy_par);
-			up_model_buf[i].ncob_x = cmp_up_model(data_buf[i].ncob_x, model.ncob_x,
-				cfg->model_value, setup_ncob.lossy_par);
-			up_model_buf[i].ncob_y = cmp_up_model(data_buf[i].ncob_y, model.ncob_y,
-				cfg->model_value, setup_ncob.lossy_par);
-		}
 
-		if (i >= cfg->samples-1)
-			break;
+/**
+ * @brief calculate the mapped residuals and the updated model of a block of
+ *	imagette samples
+ *
+ * Full blocks of aligned samples are processed by specialised loops.
+ * @see imagette_residuals_generic() for the parameters
+ */
 
-		model = next_model_p[i];
+static uint32_t imagette_residuals(uint32_t *residual, uint16_t *up_model,
+				   const uint16_t *data, const uint16_t *model,
+				   size_t n, uint32_t lossy_par,
+				   uint32_t max_data_bits, uint32_t model_value)
+{
+	int const aligned = !(((uintptr_t)data | (uintptr_t)model) & 1);
+
+	if (n != IMA_BLOCK_SIZE)
+		return imagette_residuals_generic(residual, up_model, data, model, n,
+						  lossy_par, max_data_bits,
+						  model_value, 0);
+
+	/* a constant sample number helps the compiler to vectorise */
+	if (up_model) {
+		if (aligned)
+			return imagette_residuals_generic(residual, up_model, data, model,
+							  IMA_BLOCK_SIZE, lossy_par,
+							  max_data_bits, model_value, 1);
+		return imagette_residuals_generic(residual, up_model, data, model,
+						  IMA_BLOCK_SIZE, lossy_par,
+						  max_data_bits, model_value, 0);
 	}
-	return stream_len;
+	if (aligned)
+		return imagette_residuals_generic(residual, NULL, data, model,
+						  IMA_BLOCK_SIZE, lossy_par,
+						  max_data_bits, model_value, 1);
+	return imagette_residuals_generic(residual, NULL, data, model,
+					  IMA_BLOCK_SIZE, lossy_par,
+					  max_data_bits, model_value, 0);
 }
 
 
 /**
- * @brief compress S_FX_EFX_NCOB_ECOB data
- *
- * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
- *
- * @returns the bit length of the bitstream on success or an error code if it
- *	fails (which can be tested with cmp_is_error())
+ * @brief calculation of the bitstream length of an imagette for an additional
+ *	pair of compression parameters, done in the same pass as the compression
+ *	of the imagette (used for the adaptive parameters of compress_like_rdcu())
  */
 
-static uint32_t compress_s_fx_efx_ncob_ecob(const struct cmp_cfg *cfg, uint32_t stream_len)
-{
-	size_t i;
+struct ima_size_probe {
+	uint32_t cmp_par;            /**< Golomb parameter of the probe */
+	uint32_t spill;              /**< spillover threshold parameter of the probe */
+	unsigned int variant;        /**< encoder variant flags of the parameters (ENC_RICE, ENC_MULTI) */
+	uint32_t *cmp_size;          /**< where the bitstream length in bits is stored after the compression */
+	uint32_t stream_len;         /**< bitstream length in bits so far or an error code */
+	struct encoder_setup setup;  /**< encoder setup of the probe */
+};
 
-	const struct s_fx_efx_ncob_ecob *data_buf = cfg->src;
-	const struct s_fx_efx_ncob_ecob *model_buf = cfg->model_buf;
-	struct s_fx_efx_ncob_ecob *up_model_buf = NULL;
-	const struct s_fx_efx_ncob_ecob *next_model_p;
-	struct s_fx_efx_ncob_ecob model;
-	struct encoder_setup setup_exp_flag, setup_fx, setup_ncob, setup_efx,
-			      setup_ecob;
 
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		model = model_buf[0];
-		next_model_p = &model_buf[1];
-		up_model_buf = cfg->updated_model_buf;
-	} else {
-		memset(&model, 0, sizeof(model));
-		next_model_p = data_buf;
-	}
+/**
+ * @brief calculate the number of bits needed to encode an already mapped value
+ *	with the escape symbol mechanism of the encoder variant
+ *
+ * @param data		mapped value to encode (see map_to_pos())
+ * @param setup		pointer to the encoder setup
+ * @param variant	encoder variant flags (ENC_RICE, ENC_MULTI)
+ * @param invalid	pointer to a flag which is set if a code word is invalid
+ *
+ * @returns the number of bits; only valid if the invalid flag is not set
+ */
 
-	configure_encoder_setup(&setup_exp_flag, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
-				cfg->round, MAX_USED_BITS.s_exp_flags, cfg);
-	configure_encoder_setup(&setup_fx, cfg->cmp_par_fx, cfg->spill_fx,
-				cfg->round, MAX_USED_BITS.s_fx, cfg);
-	configure_encoder_setup(&setup_ncob, cfg->cmp_par_ncob, cfg->spill_ncob,
-				cfg->round, MAX_USED_BITS.s_ncob, cfg);
-	configure_encoder_setup(&setup_efx, cfg->cmp_par_efx, cfg->spill_efx,
-				cfg->round, MAX_USED_BITS.s_efx, cfg);
-	configure_encoder_setup(&setup_ecob, cfg->cmp_par_ecob, cfg->spill_ecob,
-				cfg->round, MAX_USED_BITS.s_ecob, cfg);
+FORCE_INLINE uint32_t encoded_mapped_len(uint32_t data,
+					 const struct encoder_setup *setup,
+					 unsigned int const variant,
+					 uint32_t *invalid)
+{
+	uint32_t cw_len;
 
-	for (i = 0;; i++) {
-		stream_len = encode_value(data_buf[i].exp_flags, model.exp_flags,
-					  stream_len, &setup_exp_flag);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].fx, model.fx, stream_len,
-					  &setup_fx);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].ncob_x, model.ncob_x,
-					  stream_len, &setup_ncob);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].ncob_y, model.ncob_y,
-					  stream_len, &setup_ncob);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].efx, model.efx,
-					  stream_len, &setup_efx);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].ecob_x, model.ecob_x,
-					  stream_len, &setup_ecob);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].ecob_y, model.ecob_y,
-					  stream_len, &setup_ecob);
-		if (cmp_is_error(stream_len))
-			break;
+	if (variant & ENC_MULTI) {
+		uint32_t escape_sym_offset;
 
-		if (up_model_buf) {
-			up_model_buf[i].exp_flags = cmp_up_model(data_buf[i].exp_flags, model.exp_flags,
-				cfg->model_value, setup_exp_flag.lossy_par);
-			up_model_buf[i].fx = cmp_up_model(data_buf[i].fx, model.fx,
-				cfg->model_value, setup_fx.lossy_par);
-			up_model_buf[i].ncob_x = cmp_up_model(data_buf[i].ncob_x, model.ncob_x,
-				cfg->model_value, setup_ncob.lossy_par);
-			up_model_buf[i].ncob_y = cmp_up_model(data_buf[i].ncob_y, model.ncob_y,
-				cfg->model_value, setup_ncob.lossy_par);
-			up_model_buf[i].efx = cmp_up_model(data_buf[i].efx, model.efx,
-				cfg->model_value, setup_efx.lossy_par);
-			up_model_buf[i].ecob_x = cmp_up_model(data_buf[i].ecob_x, model.ecob_x,
-				cfg->model_value, setup_ecob.lossy_par);
-			up_model_buf[i].ecob_y = cmp_up_model(data_buf[i].ecob_y, model.ecob_y,
-				cfg->model_value, setup_ecob.lossy_par);
+		if (data < setup->spillover_par) { /* detect non-outlier */
+			cw_len = code_word_len(data, setup, variant);
+			*invalid |= cw_len > 32;
+			return cw_len;
 		}
+		/* see encode_mapped_multi() */
+		data -= setup->spillover_par;
+		escape_sym_offset = data ? (31U - (uint32_t)__builtin_clz(data)) >> 1 : 0;
+		cw_len = code_word_len(setup->spillover_par + escape_sym_offset,
+				       setup, variant);
+		*invalid |= cw_len > 32;
+		return cw_len + ((escape_sym_offset + 1U) << 1);
+	}
 
-		if (i >= cfg->samples-1)
-			break;
-
-		model = next_model_p[i];
+	if (data < (setup->spillover_par - 1)) { /* detect non-outlier */
+		cw_len = code_word_len(data + 1, setup, variant);
+		*invalid |= cw_len > 32;
+		return cw_len;
 	}
-	return stream_len;
+	/* zero escape symbol followed by the unencoded data */
+	cw_len = code_word_len(0, setup, variant);
+	*invalid |= cw_len > 32;
+	return cw_len + setup->max_data_bits;
 }
 
 
 /**
- * @brief compress L_FX data
+ * @brief count the bits needed to encode a block of mapped residuals
  *
- * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
+ * This gives the same length as encoding the residuals with encode_mapped()
+ * in the ENC_SIZE_ONLY mode, but the bits are summed up locally.
  *
- * @returns the bit length of the bitstream on success or an error code if it
- *	fails (which can be tested with cmp_is_error())
+ * @param stream_len	bitstream length in bits before the block
+ * @param residual	pointer to the mapped residuals
+ * @param n		number of residuals
+ * @param setup		pointer to the encoder setup
+ * @param variant	encoder variant flags (ENC_RICE, ENC_MULTI)
+ *
+ * @returns the bit length of the bitstream on success or an error code if a
+ *	code word is invalid (which can be tested with cmp_is_error())
  */
 
-static uint32_t compress_l_fx(const struct cmp_cfg *cfg, uint32_t stream_len)
+FORCE_INLINE uint32_t count_mapped_generic(uint32_t stream_len,
+					   const uint32_t *residual, size_t n,
+					   const struct encoder_setup *setup,
+					   unsigned int const variant)
 {
-	size_t i;
+	uint32_t invalid = 0;
+	size_t j;
 
-	const struct l_fx *data_buf = cfg->src;
-	const struct l_fx *model_buf = cfg->model_buf;
-	struct l_fx *up_model_buf = NULL;
-	const struct l_fx *next_model_p;
-	struct l_fx model;
-	struct encoder_setup setup_exp_flag, setup_fx, setup_fx_var;
+	for (j = 0; j < n; j++)
+		stream_len += encoded_mapped_len(residual[j], setup, variant, &invalid);
 
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		model = model_buf[0];
-		next_model_p = &model_buf[1];
-		up_model_buf = cfg->updated_model_buf;
-	} else {
-		memset(&model, 0, sizeof(model));
-		next_model_p = data_buf;
-	}
+	/* the same error as bit_write_bits32() reports for a too long code word */
+	RETURN_ERROR_IF(invalid, INT_DECODER, "cannot insert more than 32 bits into the bit stream");
 
-	configure_encoder_setup(&setup_exp_flag, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
-				cfg->round, MAX_USED_BITS.l_exp_flags, cfg);
-	configure_encoder_setup(&setup_fx, cfg->cmp_par_fx, cfg->spill_fx,
-				cfg->round, MAX_USED_BITS.l_fx, cfg);
-	configure_encoder_setup(&setup_fx_var, cfg->cmp_par_fx_cob_variance, cfg->spill_fx_cob_variance,
-				cfg->round, MAX_USED_BITS.l_fx_cob_variance, cfg);
+	return stream_len;
+}
 
-	for (i = 0;; i++) {
-		stream_len = encode_value(data_buf[i].exp_flags, model.exp_flags,
-					  stream_len, &setup_exp_flag);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].fx, model.fx, stream_len,
-					  &setup_fx);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].fx_variance, model.fx_variance,
-					  stream_len, &setup_fx_var);
-		if (cmp_is_error(stream_len))
-			break;
 
-		if (up_model_buf) {
-			up_model_buf[i].exp_flags = cmp_up_model32(data_buf[i].exp_flags, model.exp_flags,
-				cfg->model_value, setup_exp_flag.lossy_par);
-			up_model_buf[i].fx = cmp_up_model(data_buf[i].fx, model.fx,
-				cfg->model_value, setup_fx.lossy_par);
-			up_model_buf[i].fx_variance = cmp_up_model(data_buf[i].fx_variance, model.fx_variance,
-				cfg->model_value, setup_fx_var.lossy_par);
-		}
+/**
+ * @brief add the bits needed to encode a block of mapped residuals with the
+ *	parameters of a size probe to the bitstream length of the probe
+ *
+ * @param probe		pointer to the size probe
+ * @param residual	pointer to the mapped residuals
+ * @param n		number of residuals
+ */
 
-		if (i >= cfg->samples-1)
-			break;
+static void ima_size_probe_count(struct ima_size_probe *probe,
+				 const uint32_t *residual, size_t n)
+{
+	if (cmp_is_error(probe->stream_len))
+		return;
 
-		model = next_model_p[i];
+	switch (probe->variant & (ENC_RICE | ENC_MULTI)) {
+	case 0:
+		probe->stream_len = count_mapped_generic(probe->stream_len, residual, n,
+							 &probe->setup, 0);
+		break;
+	case ENC_RICE:
+		probe->stream_len = count_mapped_generic(probe->stream_len, residual, n,
+							 &probe->setup, ENC_RICE);
+		break;
+	case ENC_MULTI:
+		probe->stream_len = count_mapped_generic(probe->stream_len, residual, n,
+							 &probe->setup, ENC_MULTI);
+		break;
+	case ENC_MULTI | ENC_RICE:
+	default:
+		probe->stream_len = count_mapped_generic(probe->stream_len, residual, n,
+							 &probe->setup, ENC_MULTI | ENC_RICE);
+		break;
 	}
-	return stream_len;
 }
 
 
 /**
- * @brief compress L_FX_EFX data
+ * @brief compress imagette data
+ *
+ * The samples are processed in blocks: first the mapped residuals of a block
+ * are calculated in one pass (see imagette_residuals()), then they are
+ * encoded one by one. The residuals do not depend on the Golomb and spill
+ * parameters, so the bitstream lengths for other parameters are calculated
+ * from the same residuals with the size probes.
  *
  * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
+ * @param probe		pointer to an array of size probes (can be NULL)
+ * @param n_probes	number of size probes
  *
  * @returns the bit length of the bitstream on success or an error code if it
- *	fails (which can be tested with cmp_is_error())
+ *	fails (which can be tested with cmp_is_error()); the lengths of the size
+ *	probes are only valid on success
  */
 
-static uint32_t compress_l_fx_efx(const struct cmp_cfg *cfg, uint32_t stream_len)
+FORCE_INLINE uint32_t compress_imagette_generic(const struct cmp_cfg *cfg,
+						struct bit_encoder *enc,
+						unsigned int const variant,
+						struct ima_size_probe *probe,
+						unsigned int n_probes)
 {
-	size_t i;
+	size_t i, j, n;
+	unsigned int k;
+	uint32_t stream_len;
+	struct encoder_setup setup;
+	const struct encoder_setup *setup_p = &setup;
+	uint32_t max_data_bits, min_bits;
+	uint32_t residual[IMA_BLOCK_SIZE];
+	uint16_t up_model[IMA_BLOCK_SIZE];
 
-	const struct l_fx_efx *data_buf = cfg->src;
-	const struct l_fx_efx *model_buf = cfg->model_buf;
-	struct l_fx_efx *up_model_buf = NULL;
-	const struct l_fx_efx *next_model_p;
-	struct l_fx_efx model;
-	struct encoder_setup setup_exp_flag, setup_fx, setup_efx, setup_fx_var;
+	const uint16_t *data_buf = cfg->src;
+	const uint16_t *model_buf = cfg->model_buf;
+	uint16_t *up_model_buf = NULL;
 
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		model = model_buf[0];
-		next_model_p = &model_buf[1];
+	if (model_mode_is_used(cfg->cmp_mode))
 		up_model_buf = cfg->updated_model_buf;
-	} else {
-		memset(&model, 0, sizeof(model));
-		next_model_p = data_buf;
+
+	if (cfg->data_type == DATA_TYPE_F_CAM_IMAGETTE ||
+	    cfg->data_type == DATA_TYPE_F_CAM_IMAGETTE_ADAPTIVE) {
+		max_data_bits = MAX_USED_BITS.fc_imagette;
+	} else if (cfg->data_type == DATA_TYPE_SAT_IMAGETTE ||
+		   cfg->data_type == DATA_TYPE_SAT_IMAGETTE_ADAPTIVE) {
+		max_data_bits = MAX_USED_BITS.saturated_imagette;
+	} else { /* DATA_TYPE_IMAGETTE, DATA_TYPE_IMAGETTE_ADAPTIVE */
+		max_data_bits = MAX_USED_BITS.nc_imagette;
 	}
 
-	configure_encoder_setup(&setup_exp_flag, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
-				cfg->round, MAX_USED_BITS.l_exp_flags, cfg);
-	configure_encoder_setup(&setup_fx, cfg->cmp_par_fx, cfg->spill_fx,
-				cfg->round, MAX_USED_BITS.l_fx, cfg);
-	configure_encoder_setup(&setup_efx, cfg->cmp_par_efx, cfg->spill_efx,
-				cfg->round, MAX_USED_BITS.l_efx, cfg);
-	configure_encoder_setup(&setup_fx_var, cfg->cmp_par_fx_cob_variance, cfg->spill_fx_cob_variance,
-				cfg->round, MAX_USED_BITS.l_fx_cob_variance, cfg);
+	configure_encoder_setup(&setup, enc, cfg->cmp_par_imagette,
+				cfg->spill_imagette, cfg->round, max_data_bits, cfg);
+	min_bits = min_sample_bits(&setup_p, 1);
+	for (k = 0; k < n_probes; k++) {
+		configure_encoder_setup(&probe[k].setup, NULL, probe[k].cmp_par,
+					probe[k].spill, cfg->round, max_data_bits, cfg);
+		probe[k].stream_len = 0;
+	}
 
-	for (i = 0;; i++) {
-		stream_len = encode_value(data_buf[i].exp_flags, model.exp_flags,
-					  stream_len, &setup_exp_flag);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].fx, model.fx, stream_len,
-					  &setup_fx);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].efx, model.efx,
-					  stream_len, &setup_efx);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].fx_variance, model.fx_variance,
-					  stream_len, &setup_fx_var);
+	i = 0;
+	stream_len = enc->stream_len;
+	if (!model_mode_is_used(cfg->cmp_mode)) {
+		/* in 1d-differencing mode the first sample has no predecessor */
+		stream_len = encode_value(get_unaligned(&data_buf[0]), 0, &setup, variant);
 		if (cmp_is_error(stream_len))
-			break;
+			return stream_len;
+		/* the value is not too large, otherwise encode_value() fails */
+		residual[0] = map_to_pos(round_fwd(get_unaligned(&data_buf[0]), setup.lossy_par),
+					 max_data_bits);
+		for (k = 0; k < n_probes; k++)
+			ima_size_probe_count(&probe[k], residual, 1);
+		i = 1;
+	}
 
-		if (up_model_buf) {
-			up_model_buf[i].exp_flags = cmp_up_model32(data_buf[i].exp_flags, model.exp_flags,
-				cfg->model_value, setup_exp_flag.lossy_par);
-			up_model_buf[i].fx = cmp_up_model(data_buf[i].fx, model.fx,
-				cfg->model_value, setup_fx.lossy_par);
-			up_model_buf[i].efx = cmp_up_model(data_buf[i].efx, model.efx,
-				cfg->model_value, setup_efx.lossy_par);
-			up_model_buf[i].fx_variance = cmp_up_model(data_buf[i].fx_variance, model.fx_variance,
-				cfg->model_value, setup_fx_var.lossy_par);
+	for (; i < cfg->samples; i += n) {
+		const uint16_t *model_p = model_mode_is_used(cfg->cmp_mode) ?
+			&model_buf[i] : &data_buf[i-1];
+
+		uint32_t too_large;
+
+		n = cfg->samples - i;
+		if (n > IMA_BLOCK_SIZE)
+			n = IMA_BLOCK_SIZE;
+		too_large = imagette_residuals(residual, up_model_buf ? up_model : NULL,
+					       &data_buf[i], model_p, n, setup.lossy_par,
+					       max_data_bits, cfg->model_value);
+
+		if (too_large) {
+			/* a value is too large; encode_value() reports the
+			 * error at the same sample as without the pre-pass
+			 */
+			for (j = 0; j < n; j++) {
+				stream_len = encode_value(get_unaligned(&data_buf[i+j]),
+							  get_unaligned(&model_p[j]),
+							  &setup, variant);
+				if (cmp_is_error(stream_len))
+					break;
+			}
+			return stream_len;
 		}
 
-		if (i >= cfg->samples-1)
-			break;
+		if (!(variant & ENC_SIZE_ONLY) && setup.max_cw_len <= 32 &&
+		    bit_free_bits(enc) >= n * MAX_BITS_PER_VALUE) {
+			/* the block fits in any case; no checks are needed */
+			for (j = 0; j < n; j++)
+				stream_len = encode_mapped(residual[j], &setup,
+							   variant | ENC_UNCHECKED);
+		} else {
+			for (j = 0; j < n; j++) {
+				stream_len = encode_mapped(residual[j], &setup, variant);
+				if (cmp_is_error(stream_len))
+					return stream_len;
+			}
+		}
+		if (!(variant & ENC_SIZE_ONLY) && min_bits) {
+			stream_len = stop_if_stream_cannot_fit(enc, cfg->samples - i - n,
+							       min_bits);
+			if (cmp_is_error(stream_len))
+				return stream_len;
+		}
+		for (k = 0; k < n_probes; k++)
+			ima_size_probe_count(&probe[k], residual, n);
 
-		model = next_model_p[i];
+		/* the updated model is stored after the block is encoded,
+		 * because the updated model buffer can be the model buffer
+		 */
+		if (up_model_buf)
+			memcpy(&up_model_buf[i], up_model, n * sizeof(up_model[0]));
 	}
 	return stream_len;
 }
 
 
 /**
- * @brief compress L_FX_NCOB data
+ * @brief number of multi-field samples processed by one residual pre-pass
+ */
+
+#define COL_BLOCK_SIZE	32U
+
+
+/**
+ * @brief number of samples after which the compression of offset, background
+ *	and smearing data checks if the bitstream can still fit (see
+ *	stop_if_stream_cannot_fit())
+ */
+
+#define FIT_CHECK_INTERVAL	32U
+
+
+/**
+ * @brief staging area of one field of a block of multi-field samples
  *
- * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
+ * The fields of the flux and centre of brightness data types are not aligned,
+ * because the packed structures start with an 8-bit or 24-bit exposure flags
+ * field. To process them with loops the compiler can vectorise, a block of
+ * samples is transposed into one aligned array per field (a column).
+ */
+
+struct column {
+	const struct encoder_setup *setup; /**< encoder setup of the field */
+	uint32_t last;                     /**< last data value of the previous block */
+	uint32_t data[COL_BLOCK_SIZE];     /**< data of the field */
+	uint32_t model[COL_BLOCK_SIZE];    /**< model of the field; replaced by the updated model by update_columns() */
+	uint32_t residual[COL_BLOCK_SIZE]; /**< mapped residuals of the field */
+};
+
+
+/**
+ * @brief initialise a column
  *
- * @returns the bit length of the bitstream on success or an error code if it
- *	fails (which can be tested with cmp_is_error())
+ * @param col	pointer to the column to initialise
+ * @param setup	pointer to the encoder setup of the field
  */
 
-static uint32_t compress_l_fx_ncob(const struct cmp_cfg *cfg, uint32_t stream_len)
+static __inline void init_column(struct column *col, const struct encoder_setup *setup)
 {
-	size_t i;
+	col->setup = setup;
+	col->last = 0;
+}
 
-	const struct l_fx_ncob *data_buf = cfg->src;
-	const struct l_fx_ncob *model_buf = cfg->model_buf;
-	struct l_fx_ncob *up_model_buf = NULL;
-	const struct l_fx_ncob *next_model_p;
-	struct l_fx_ncob model;
-	struct encoder_setup setup_exp_flag, setup_fx, setup_ncob,
-			      setup_fx_var, setup_cob_var;
 
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		model = model_buf[0];
-		next_model_p = &model_buf[1];
-		up_model_buf = cfg->updated_model_buf;
-	} else {
-		memset(&model, 0, sizeof(model));
-		next_model_p = data_buf;
-	}
+/**
+ * @brief calculate the mapped residuals of a column
+ * @note the same as imagette_residuals() for aligned 32-bit values
+ *
+ * @param residual	pointer to the buffer where the mapped residuals are
+ *			stored (at least n samples long)
+ * @param data		pointer to the data of the field
+ * @param model		pointer to the model of the field
+ * @param n		number of samples to process
+ * @param lossy_par	lossy compression parameter
+ * @param max_data_bits	how many bits are needed to represent the highest
+ *			possible value
+ *
+ * @returns non-zero if a (rounded) data or model value is greater than
+ *	max_data_bits allows, otherwise zero
+ */
 
-	configure_encoder_setup(&setup_exp_flag, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
-				cfg->round, MAX_USED_BITS.l_exp_flags, cfg);
-	configure_encoder_setup(&setup_fx, cfg->cmp_par_fx, cfg->spill_fx,
-				cfg->round, MAX_USED_BITS.l_fx, cfg);
-	configure_encoder_setup(&setup_ncob, cfg->cmp_par_ncob, cfg->spill_ncob,
-				cfg->round, MAX_USED_BITS.l_ncob, cfg);
-	/* we use the cmp_par_fx_cob_variance parameter for fx and cob variance data */
-	configure_encoder_setup(&setup_fx_var, cfg->cmp_par_fx_cob_variance, cfg->spill_fx_cob_variance,
-				cfg->round, MAX_USED_BITS.l_fx_cob_variance, cfg);
-	configure_encoder_setup(&setup_cob_var, cfg->cmp_par_fx_cob_variance, cfg->spill_fx_cob_variance,
-				cfg->round, MAX_USED_BITS.l_fx_cob_variance, cfg);
+static __inline uint32_t column_residuals(uint32_t *residual, const uint32_t *data,
+					  const uint32_t *model, size_t n,
+					  uint32_t lossy_par, uint32_t max_data_bits)
+{
+	uint32_t const mask = ~(0xFFFFFFFFU >> (32-max_data_bits));
+	uint32_t used_bits = 0;
+	size_t j;
 
-	for (i = 0;; i++) {
-		stream_len = encode_value(data_buf[i].exp_flags, model.exp_flags,
-					  stream_len, &setup_exp_flag);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].fx, model.fx, stream_len,
-					  &setup_fx);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].ncob_x, model.ncob_x,
-					  stream_len, &setup_ncob);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].ncob_y, model.ncob_y,
-					  stream_len, &setup_ncob);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].fx_variance, model.fx_variance,
-					  stream_len, &setup_fx_var);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].cob_x_variance, model.cob_x_variance,
-					  stream_len, &setup_cob_var);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].cob_y_variance, model.cob_y_variance,
-					  stream_len, &setup_cob_var);
-		if (cmp_is_error(stream_len))
-			break;
+	for (j = 0; j < n; j++) {
+		uint32_t const d = round_fwd(data[j], lossy_par);
+		uint32_t const m = round_fwd(model[j], lossy_par);
 
-		if (up_model_buf) {
-			up_model_buf[i].exp_flags = cmp_up_model32(data_buf[i].exp_flags, model.exp_flags,
-				cfg->model_value, setup_exp_flag.lossy_par);
-			up_model_buf[i].fx = cmp_up_model(data_buf[i].fx, model.fx,
-				cfg->model_value, setup_fx.lossy_par);
-			up_model_buf[i].ncob_x = cmp_up_model(data_buf[i].ncob_x, model.ncob_x,
-				cfg->model_value, setup_ncob.lossy_par);
-			up_model_buf[i].ncob_y = cmp_up_model(data_buf[i].ncob_y, model.ncob_y,
-				cfg->model_value, setup_ncob.lossy_par);
-			up_model_buf[i].fx_variance = cmp_up_model(data_buf[i].fx_variance, model.fx_variance,
-				cfg->model_value, setup_fx_var.lossy_par);
-			up_model_buf[i].cob_x_variance = cmp_up_model(data_buf[i].cob_x_variance, model.cob_x_variance,
-				cfg->model_value, setup_cob_var.lossy_par);
-			up_model_buf[i].cob_y_variance = cmp_up_model(data_buf[i].cob_y_variance, model.cob_y_variance,
-				cfg->model_value, setup_cob_var.lossy_par);
-		}
+		used_bits |= d | m;
+		residual[j] = map_to_pos(d - m, max_data_bits);
+	}
 
-		if (i >= cfg->samples-1)
-			break;
+	return used_bits & mask;
+}
 
-		model = next_model_p[i];
+
+/**
+ * @brief set the model of the columns for the 1d-differencing mode
+ *
+ * The model of a sample is the previous sample; the first sample of a
+ * collection has a zero model.
+ *
+ * @param col	pointer to the columns with the data of a block
+ * @param n_col	number of columns
+ * @param n	number of samples in the block
+ */
+
+static __inline void diff_model_columns(struct column *col, unsigned int n_col, size_t n)
+{
+	unsigned int c;
+	size_t j;
+
+	for (c = 0; c < n_col; c++) {
+		col[c].model[0] = col[c].last;
+		for (j = 1; j < n; j++)
+			col[c].model[j] = col[c].data[j-1];
+		col[c].last = col[c].data[n-1];
 	}
-	return stream_len;
 }
 
 
 /**
- * @brief compress L_FX_EFX_NCOB_ECOB data
+ * @brief encode a block of multi-field samples staged in columns
  *
- * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
+ * First the mapped residuals of all columns are calculated, then they are put
+ * into the bitstream in the original sample order (all fields of the first
+ * sample, then all fields of the second sample, ...).
+ *
+ * @param col		pointer to the columns with the data and model of a block
+ * @param n_col		number of columns
+ * @param n		number of samples in the block
+ * @param remaining	number of samples after the block; the compression
+ *			stops early if they can no longer fit (see
+ *			stop_if_stream_cannot_fit())
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
  * @returns the bit length of the bitstream on success or an error code if it
  *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t compress_l_fx_efx_ncob_ecob(const struct cmp_cfg *cfg, uint32_t stream_len)
+FORCE_INLINE uint32_t compress_columns(struct column *col, unsigned int n_col,
+				       size_t n, size_t remaining,
+				       unsigned int const variant)
 {
-	size_t i;
+	uint32_t stream_len = 0;
+	uint32_t too_large = 0;
+	uint32_t min_bits = 0;
+	int valid_cw = 1;
+	int unchecked = 0;
+	unsigned int c;
+	size_t j;
+
+	for (c = 0; c < n_col; c++) {
+		const struct encoder_setup *setup = col[c].setup;
+
+		if (n == COL_BLOCK_SIZE)
+			/* a constant sample number helps the compiler to vectorise */
+			too_large |= column_residuals(col[c].residual, col[c].data, col[c].model,
+						      COL_BLOCK_SIZE, setup->lossy_par,
+						      setup->max_data_bits);
+		else
+			too_large |= column_residuals(col[c].residual, col[c].data, col[c].model,
+						      n, setup->lossy_par, setup->max_data_bits);
+	}
 
-	const struct l_fx_efx_ncob_ecob *data_buf = cfg->src;
-	const struct l_fx_efx_ncob_ecob *model_buf = cfg->model_buf;
-	struct l_fx_efx_ncob_ecob *up_model_buf = NULL;
-	const struct l_fx_efx_ncob_ecob *next_model_p;
-	struct l_fx_efx_ncob_ecob model;
-	struct encoder_setup setup_exp_flag, setup_fx, setup_ncob, setup_efx,
-			      setup_ecob, setup_fx_var, setup_cob_var;
+	if (too_large) {
+		/* a value is too large; encode_value() reports the
+		 * error at the same value as without the pre-pass
+		 */
+		for (j = 0; j < n; j++) {
+			for (c = 0; c < n_col; c++) {
+				stream_len = encode_value(col[c].data[j], col[c].model[j],
+							  col[c].setup, variant);
+				if (cmp_is_error(stream_len))
+					return stream_len;
+			}
+		}
+		return stream_len;
+	}
 
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		model = model_buf[0];
-		next_model_p = &model_buf[1];
-		up_model_buf = cfg->updated_model_buf;
+	/* see min_sample_bits() */
+	for (c = 0; c < n_col; c++) {
+		if (col[c].setup->max_cw_len > 32)
+			valid_cw = 0;
+		min_bits += col[c].setup->min_cw_len;
+	}
+	if (!valid_cw)
+		min_bits = 0;
+
+	if (!(variant & ENC_SIZE_ONLY) && valid_cw &&
+	    bit_free_bits(col[0].setup->enc) >= n * n_col * MAX_BITS_PER_VALUE)
+		unchecked = 1;
+
+	if (unchecked) {
+		/* the block fits in any case; no checks are needed */
+		for (j = 0; j < n; j++)
+			for (c = 0; c < n_col; c++)
+				stream_len = encode_mapped(col[c].residual[j], col[c].setup,
+							   variant | ENC_UNCHECKED);
 	} else {
-		memset(&model, 0, sizeof(model));
-		next_model_p = data_buf;
+		for (j = 0; j < n; j++) {
+			for (c = 0; c < n_col; c++) {
+				stream_len = encode_mapped(col[c].residual[j], col[c].setup,
+							   variant);
+				if (cmp_is_error(stream_len))
+					return stream_len;
+			}
+		}
 	}
 
-	configure_encoder_setup(&setup_exp_flag, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
-				cfg->round, MAX_USED_BITS.l_exp_flags, cfg);
-	configure_encoder_setup(&setup_fx, cfg->cmp_par_fx, cfg->spill_fx,
-				cfg->round, MAX_USED_BITS.l_fx, cfg);
-	configure_encoder_setup(&setup_ncob, cfg->cmp_par_ncob, cfg->spill_ncob,
-				cfg->round, MAX_USED_BITS.l_ncob, cfg);
-	configure_encoder_setup(&setup_efx, cfg->cmp_par_efx, cfg->spill_efx,
-				cfg->round, MAX_USED_BITS.l_efx, cfg);
-	configure_encoder_setup(&setup_ecob, cfg->cmp_par_ecob, cfg->spill_ecob,
-				cfg->round, MAX_USED_BITS.l_ecob, cfg);
-	/* we use compression parameters for both variance data fields */
-	configure_encoder_setup(&setup_fx_var, cfg->cmp_par_fx_cob_variance, cfg->spill_fx_cob_variance,
-				cfg->round, MAX_USED_BITS.l_fx_cob_variance, cfg);
-	configure_encoder_setup(&setup_cob_var, cfg->cmp_par_fx_cob_variance, cfg->spill_fx_cob_variance,
-				cfg->round, MAX_USED_BITS.l_fx_cob_variance, cfg);
+	if (!(variant & ENC_SIZE_ONLY) && min_bits)
+		stream_len = stop_if_stream_cannot_fit(col[0].setup->enc, remaining, min_bits);
+	return stream_len;
+}
 
-	for (i = 0;; i++) {
-		stream_len = encode_value(data_buf[i].exp_flags, model.exp_flags,
-					  stream_len, &setup_exp_flag);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].fx, model.fx, stream_len,
-					  &setup_fx);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].ncob_x, model.ncob_x,
-					  stream_len, &setup_ncob);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].ncob_y, model.ncob_y,
-					  stream_len, &setup_ncob);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].efx, model.efx,
-					  stream_len, &setup_efx);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].ecob_x, model.ecob_x,
-					  stream_len, &setup_ecob);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].ecob_y, model.ecob_y,
-					  stream_len, &setup_ecob);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].fx_variance, model.fx_variance,
-					  stream_len, &setup_fx_var);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].cob_x_variance, model.cob_x_variance,
-					  stream_len, &setup_cob_var);
-		if (cmp_is_error(stream_len))
-			break;
-		stream_len = encode_value(data_buf[i].cob_y_variance, model.cob_y_variance,
-					  stream_len, &setup_cob_var);
-		if (cmp_is_error(stream_len))
-			break;
 
-		if (up_model_buf) {
-			up_model_buf[i].exp_flags = cmp_up_model32(data_buf[i].exp_flags, model.exp_flags,
-				cfg->model_value, setup_exp_flag.lossy_par);
-			up_model_buf[i].fx = cmp_up_model(data_buf[i].fx, model.fx,
-				cfg->model_value, setup_fx.lossy_par);
-			up_model_buf[i].ncob_x = cmp_up_model(data_buf[i].ncob_x, model.ncob_x,
-				cfg->model_value, setup_ncob.lossy_par);
-			up_model_buf[i].ncob_y = cmp_up_model(data_buf[i].ncob_y, model.ncob_y,
-				cfg->model_value, setup_ncob.lossy_par);
-			up_model_buf[i].efx = cmp_up_model(data_buf[i].efx, model.efx,
-				cfg->model_value, setup_efx.lossy_par);
-			up_model_buf[i].ecob_x = cmp_up_model(data_buf[i].ecob_x, model.ecob_x,
-				cfg->model_value, setup_ecob.lossy_par);
-			up_model_buf[i].ecob_y = cmp_up_model(data_buf[i].ecob_y, model.ecob_y,
-				cfg->model_value, setup_ecob.lossy_par);
-			up_model_buf[i].fx_variance = cmp_up_model(data_buf[i].fx_variance, model.fx_variance,
-				cfg->model_value, setup_fx_var.lossy_par);
-			up_model_buf[i].cob_x_variance = cmp_up_model(data_buf[i].cob_x_variance, model.cob_x_variance,
-				cfg->model_value, setup_cob_var.lossy_par);
-			up_model_buf[i].cob_y_variance = cmp_up_model(data_buf[i].cob_y_variance, model.cob_y_variance,
-				cfg->model_value, setup_cob_var.lossy_par);
-		}
+/**
+ * @brief update the model of a block of multi-field samples staged in columns
+ * @note the model arrays of the columns are overwritten with the updated model
+ *
+ * @param col		pointer to the columns with the data and model of a block
+ * @param n_col		number of columns
+ * @param n		number of samples in the block
+ * @param model_value	model weighting parameter
+ */
 
-		if (i >= cfg->samples-1)
-			break;
+static __inline void update_columns(struct column *col, unsigned int n_col, size_t n,
+				    unsigned int model_value)
+{
+	unsigned int c;
 
-		model = next_model_p[i];
-	}
-	return stream_len;
+	/* cmp_up_model32() gives the same result as cmp_up_model16() for
+	 * smaller fields
+	 */
+	for (c = 0; c < n_col; c++)
+		cmp_up_model32_batch(col[c].model, col[c].data, col[c].model, n,
+				     model_value, col[c].setup->lossy_par);
 }
 
 
 /**
- * @brief compress offset data from the normal and fast cameras
+ * @brief compress short normal light flux (S_FX) data
  *
  * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
  * @returns the bit length of the bitstream on success or an error code if it
  *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t compress_offset(const struct cmp_cfg *cfg, uint32_t stream_len)
+FORCE_INLINE uint32_t compress_s_fx_generic(const struct cmp_cfg *cfg,
+					    struct bit_encoder *enc,
+					    unsigned int const variant)
 {
-	size_t i;
+	size_t i, j, n;
+	uint32_t stream_len;
 
-	const struct offset *data_buf = cfg->src;
-	const struct offset *model_buf = cfg->model_buf;
-	struct offset *up_model_buf = NULL;
-	const struct offset *next_model_p;
-	struct offset model;
-	struct encoder_setup setup_mean, setup_var;
+	const struct s_fx *data_buf = cfg->src;
+	const struct s_fx *model_buf = cfg->model_buf;
+	struct s_fx *up_model_buf = NULL;
+	struct encoder_setup setup_exp_flag, setup_fx;
+	struct column col[2];
 
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		model = model_buf[0];
-		next_model_p = &model_buf[1];
+	if (model_mode_is_used(cfg->cmp_mode))
 		up_model_buf = cfg->updated_model_buf;
-	} else {
-		memset(&model, 0, sizeof(model));
-		next_model_p = data_buf;
-	}
 
-	{
-		unsigned int mean_bits_used, variance_bits_used;
+	configure_encoder_setup(&setup_exp_flag, enc, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
+				cfg->round, MAX_USED_BITS.s_exp_flags, cfg);
+	configure_encoder_setup(&setup_fx, enc, cfg->cmp_par_fx, cfg->spill_fx,
+				cfg->round, MAX_USED_BITS.s_fx, cfg);
 
-		if (cfg->data_type == DATA_TYPE_F_CAM_OFFSET) {
-			mean_bits_used = MAX_USED_BITS.fc_offset_mean;
-			variance_bits_used = MAX_USED_BITS.fc_offset_variance;
-		} else { /* DATA_TYPE_OFFSET */
-			mean_bits_used = MAX_USED_BITS.nc_offset_mean;
-			variance_bits_used = MAX_USED_BITS.nc_offset_variance;
-		}
+	init_column(&col[0], &setup_exp_flag);
+	init_column(&col[1], &setup_fx);
 
-		configure_encoder_setup(&setup_mean, cfg->cmp_par_offset_mean, cfg->spill_offset_mean,
-					cfg->round, mean_bits_used, cfg);
-		configure_encoder_setup(&setup_var, cfg->cmp_par_offset_variance, cfg->spill_offset_variance,
-					cfg->round, variance_bits_used, cfg);
-	}
+	stream_len = enc->stream_len;
+	for (i = 0; i < cfg->samples; i += n) {
+		n = cfg->samples - i;
+		if (n > COL_BLOCK_SIZE)
+			n = COL_BLOCK_SIZE;
 
-	for (i = 0;; i++) {
-		stream_len = encode_value(data_buf[i].mean, model.mean,
-					  stream_len, &setup_mean);
-		if (cmp_is_error(stream_len))
-			return stream_len;
-		stream_len = encode_value(data_buf[i].variance, model.variance,
-					  stream_len, &setup_var);
+		for (j = 0; j < n; j++) {
+			col[0].data[j] = data_buf[i+j].exp_flags;
+			col[1].data[j] = data_buf[i+j].fx;
+		}
+		if (model_mode_is_used(cfg->cmp_mode)) {
+			for (j = 0; j < n; j++) {
+				col[0].model[j] = model_buf[i+j].exp_flags;
+				col[1].model[j] = model_buf[i+j].fx;
+			}
+		} else {
+			diff_model_columns(col, ARRAY_SIZE(col), n);
+		}
+
+		stream_len = compress_columns(col, ARRAY_SIZE(col), n, cfg->samples - i - n,
+					      variant);
 		if (cmp_is_error(stream_len))
 			return stream_len;
 
 		if (up_model_buf) {
-			up_model_buf[i].mean = cmp_up_model(data_buf[i].mean, model.mean,
-				cfg->model_value, setup_mean.lossy_par);
-			up_model_buf[i].variance = cmp_up_model(data_buf[i].variance, model.variance,
-				cfg->model_value, setup_var.lossy_par);
+			update_columns(col, ARRAY_SIZE(col), n, cfg->model_value);
+			for (j = 0; j < n; j++) {
+				up_model_buf[i+j].exp_flags = (uint8_t)col[0].model[j];
+				up_model_buf[i+j].fx = col[1].model[j];
+			}
 		}
-
-		if (i >= cfg->samples-1)
-			break;
-
-		model = next_model_p[i];
 	}
 	return stream_len;
 }
 
 
 /**
- * @brief compress background data from the normal and fast cameras
+ * @brief compress S_FX_EFX data
  *
  * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
  * @returns the bit length of the bitstream on success or an error code if it
  *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t compress_background(const struct cmp_cfg *cfg, uint32_t stream_len)
+FORCE_INLINE uint32_t compress_s_fx_efx_generic(const struct cmp_cfg *cfg,
+						struct bit_encoder *enc,
+						unsigned int const variant)
 {
-	size_t i;
+	size_t i, j, n;
+	uint32_t stream_len;
 
-	const struct background *data_buf = cfg->src;
-	const struct background *model_buf = cfg->model_buf;
-	struct background *up_model_buf = NULL;
-	const struct background *next_model_p;
-	struct background model;
-	struct encoder_setup setup_mean, setup_var, setup_pix;
+	const struct s_fx_efx *data_buf = cfg->src;
+	const struct s_fx_efx *model_buf = cfg->model_buf;
+	struct s_fx_efx *up_model_buf = NULL;
+	struct encoder_setup setup_exp_flag, setup_fx, setup_efx;
+	struct column col[3];
 
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		model = model_buf[0];
-		next_model_p = &model_buf[1];
+	if (model_mode_is_used(cfg->cmp_mode))
 		up_model_buf = cfg->updated_model_buf;
-	} else {
-		memset(&model, 0, sizeof(model));
-		next_model_p = data_buf;
-	}
 
-	{
-		unsigned int mean_used_bits, varinace_used_bits, pixels_error_used_bits;
+	configure_encoder_setup(&setup_exp_flag, enc, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
+				cfg->round, MAX_USED_BITS.s_exp_flags, cfg);
+	configure_encoder_setup(&setup_fx, enc, cfg->cmp_par_fx, cfg->spill_fx,
+				cfg->round, MAX_USED_BITS.s_fx, cfg);
+	configure_encoder_setup(&setup_efx, enc, cfg->cmp_par_efx, cfg->spill_efx,
+				cfg->round, MAX_USED_BITS.s_efx, cfg);
 
-		if (cfg->data_type == DATA_TYPE_F_CAM_BACKGROUND) {
-			mean_used_bits = MAX_USED_BITS.fc_background_mean;
-			varinace_used_bits = MAX_USED_BITS.fc_background_variance;
-			pixels_error_used_bits = MAX_USED_BITS.fc_background_outlier_pixels;
-		} else { /* DATA_TYPE_BACKGROUND */
-			mean_used_bits = MAX_USED_BITS.nc_background_mean;
-			varinace_used_bits = MAX_USED_BITS.nc_background_variance;
-			pixels_error_used_bits = MAX_USED_BITS.nc_background_outlier_pixels;
+	init_column(&col[0], &setup_exp_flag);
+	init_column(&col[1], &setup_fx);
+	init_column(&col[2], &setup_efx);
+
+	stream_len = enc->stream_len;
+	for (i = 0; i < cfg->samples; i += n) {
+		n = cfg->samples - i;
+		if (n > COL_BLOCK_SIZE)
+			n = COL_BLOCK_SIZE;
+
+		for (j = 0; j < n; j++) {
+			col[0].data[j] = data_buf[i+j].exp_flags;
+			col[1].data[j] = data_buf[i+j].fx;
+			col[2].data[j] = data_buf[i+j].efx;
+		}
+		if (model_mode_is_used(cfg->cmp_mode)) {
+			for (j = 0; j < n; j++) {
+				col[0].model[j] = model_buf[i+j].exp_flags;
+				col[1].model[j] = model_buf[i+j].fx;
+				col[2].model[j] = model_buf[i+j].efx;
+			}
+		} else {
+			diff_model_columns(col, ARRAY_SIZE(col), n);
 		}
-		configure_encoder_setup(&setup_mean, cfg->cmp_par_background_mean, cfg->spill_background_mean,
-					cfg->round, mean_used_bits, cfg);
-		configure_encoder_setup(&setup_var, cfg->cmp_par_background_variance, cfg->spill_background_variance,
-					cfg->round, varinace_used_bits, cfg);
-		configure_encoder_setup(&setup_pix, cfg->cmp_par_background_pixels_error, cfg->spill_background_pixels_error,
-					cfg->round, pixels_error_used_bits, cfg);
-	}
 
-	for (i = 0;; i++) {
-		stream_len = encode_value(data_buf[i].mean, model.mean,
-					  stream_len, &setup_mean);
-		if (cmp_is_error(stream_len))
-			return stream_len;
-		stream_len = encode_value(data_buf[i].variance, model.variance,
-					  stream_len, &setup_var);
-		if (cmp_is_error(stream_len))
-			return stream_len;
-		stream_len = encode_value(data_buf[i].outlier_pixels, model.outlier_pixels,
-					  stream_len, &setup_pix);
+		stream_len = compress_columns(col, ARRAY_SIZE(col), n, cfg->samples - i - n,
+					      variant);
 		if (cmp_is_error(stream_len))
 			return stream_len;
 
 		if (up_model_buf) {
-			up_model_buf[i].mean = cmp_up_model(data_buf[i].mean, model.mean,
-				cfg->model_value, setup_mean.lossy_par);
-			up_model_buf[i].variance = cmp_up_model(data_buf[i].variance, model.variance,
-				cfg->model_value, setup_var.lossy_par);
-			up_model_buf[i].outlier_pixels = cmp_up_model(data_buf[i].outlier_pixels, model.outlier_pixels,
-				cfg->model_value, setup_pix.lossy_par);
+			update_columns(col, ARRAY_SIZE(col), n, cfg->model_value);
+			for (j = 0; j < n; j++) {
+				up_model_buf[i+j].exp_flags = (uint8_t)col[0].model[j];
+				up_model_buf[i+j].fx = col[1].model[j];
+				up_model_buf[i+j].efx = col[2].model[j];
+			}
 		}
-
-		if (i >= cfg->samples-1)
-			break;
-
-		model = next_model_p[i];
 	}
 	return stream_len;
 }
 
 
 /**
- * @brief compress smearing data from the normal cameras
+ * @brief compress S_FX_NCOB data
  *
  * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
  * @returns the bit length of the bitstream on success or an error code if it
  *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t compress_smearing(const struct cmp_cfg *cfg, uint32_t stream_len)
+FORCE_INLINE uint32_t compress_s_fx_ncob_generic(const struct cmp_cfg *cfg,
+						 struct bit_encoder *enc,
+						 unsigned int const variant)
 {
-	size_t i;
+	size_t i, j, n;
+	uint32_t stream_len;
 
-	const struct smearing *data_buf = cfg->src;
-	const struct smearing *model_buf = cfg->model_buf;
-	struct smearing *up_model_buf = NULL;
-	const struct smearing *next_model_p;
-	struct smearing model;
-	struct encoder_setup setup_mean, setup_var_mean, setup_pix;
+	const struct s_fx_ncob *data_buf = cfg->src;
+	const struct s_fx_ncob *model_buf = cfg->model_buf;
+	struct s_fx_ncob *up_model_buf = NULL;
+	struct encoder_setup setup_exp_flag, setup_fx, setup_ncob;
+	struct column col[4];
 
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		model = model_buf[0];
-		next_model_p = &model_buf[1];
+	if (model_mode_is_used(cfg->cmp_mode))
 		up_model_buf = cfg->updated_model_buf;
-	} else {
-		memset(&model, 0, sizeof(model));
-		next_model_p = data_buf;
-	}
 
-	configure_encoder_setup(&setup_mean, cfg->cmp_par_smearing_mean, cfg->spill_smearing_mean,
-				cfg->round, MAX_USED_BITS.smearing_mean, cfg);
-	configure_encoder_setup(&setup_var_mean, cfg->cmp_par_smearing_variance, cfg->spill_smearing_variance,
-				cfg->round, MAX_USED_BITS.smearing_variance_mean, cfg);
-	configure_encoder_setup(&setup_pix, cfg->cmp_par_smearing_pixels_error, cfg->spill_smearing_pixels_error,
-				cfg->round, MAX_USED_BITS.smearing_outlier_pixels, cfg);
+	configure_encoder_setup(&setup_exp_flag, enc, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
+				cfg->round, MAX_USED_BITS.s_exp_flags, cfg);
+	configure_encoder_setup(&setup_fx, enc, cfg->cmp_par_fx, cfg->spill_fx,
+				cfg->round, MAX_USED_BITS.s_fx, cfg);
+	configure_encoder_setup(&setup_ncob, enc, cfg->cmp_par_ncob, cfg->spill_ncob,
+				cfg->round, MAX_USED_BITS.s_ncob, cfg);
 
-	for (i = 0;; i++) {
-		stream_len = encode_value(data_buf[i].mean, model.mean,
-					  stream_len, &setup_mean);
-		if (cmp_is_error(stream_len))
-			return stream_len;
-		stream_len = encode_value(data_buf[i].variance_mean, model.variance_mean,
-					  stream_len, &setup_var_mean);
-		if (cmp_is_error(stream_len))
-			return stream_len;
-		stream_len = encode_value(data_buf[i].outlier_pixels, model.outlier_pixels,
-					  stream_len, &setup_pix);
+	init_column(&col[0], &setup_exp_flag);
+	init_column(&col[1], &setup_fx);
+	init_column(&col[2], &setup_ncob);
+	init_column(&col[3], &setup_ncob);
+
+	stream_len = enc->stream_len;
+	for (i = 0; i < cfg->samples; i += n) {
+		n = cfg->samples - i;
+		if (n > COL_BLOCK_SIZE)
+			n = COL_BLOCK_SIZE;
+
+		for (j = 0; j < n; j++) {
+			col[0].data[j] = data_buf[i+j].exp_flags;
+			col[1].data[j] = data_buf[i+j].fx;
+			col[2].data[j] = data_buf[i+j].ncob_x;
+			col[3].data[j] = data_buf[i+j].ncob_y;
+		}
+		if (model_mode_is_used(cfg->cmp_mode)) {
+			for (j = 0; j < n; j++) {
+				col[0].model[j] = model_buf[i+j].exp_flags;
+				col[1].model[j] = model_buf[i+j].fx;
+				col[2].model[j] = model_buf[i+j].ncob_x;
+				col[3].model[j] = model_buf[i+j].ncob_y;
+			}
+		} else {
+			diff_model_columns(col, ARRAY_SIZE(col), n);
+		}
+
+		stream_len = compress_columns(col, ARRAY_SIZE(col), n, cfg->samples - i - n,
+					      variant);
 		if (cmp_is_error(stream_len))
 			return stream_len;
 
 		if (up_model_buf) {
-			up_model_buf[i].mean = cmp_up_model(data_buf[i].mean, model.mean,
-				cfg->model_value, setup_mean.lossy_par);
-			up_model_buf[i].variance_mean = cmp_up_model(data_buf[i].variance_mean, model.variance_mean,
-				cfg->model_value, setup_var_mean.lossy_par);
-			up_model_buf[i].outlier_pixels = cmp_up_model(data_buf[i].outlier_pixels, model.outlier_pixels,
-				cfg->model_value, setup_pix.lossy_par);
+			update_columns(col, ARRAY_SIZE(col), n, cfg->model_value);
+			for (j = 0; j < n; j++) {
+				up_model_buf[i+j].exp_flags = (uint8_t)col[0].model[j];
+				up_model_buf[i+j].fx = col[1].model[j];
+				up_model_buf[i+j].ncob_x = col[2].model[j];
+				up_model_buf[i+j].ncob_y = col[3].model[j];
+			}
 		}
-
-		if (i >= cfg->samples-1)
-			break;
-
-		model = next_model_p[i];
 	}
 	return stream_len;
 }
 
 
 /**
- * @brief check if two buffers are overlapping
- * @see https://stackoverflow.com/a/325964
+ * @brief compress S_FX_EFX_NCOB_ECOB data
  *
- * @param buf_a		start address of the 1st buffer (can be NULL)
- * @param size_a	byte size of the 1st buffer
- * @param buf_b		start address of the 2nd buffer (can be NULL)
- * @param size_b	byte size of the 2nd buffer
+ * @param cfg		pointer to the compression configuration structure
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
- * @returns 0 if buffers are not overlapping, otherwise buffers are
- *	overlapping
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
  */
 
-static int buffer_overlaps(const void *buf_a, size_t size_a,
-			   const void *buf_b, size_t size_b)
+FORCE_INLINE uint32_t compress_s_fx_efx_ncob_ecob_generic(const struct cmp_cfg *cfg,
+							  struct bit_encoder *enc,
+							  unsigned int const variant)
 {
-	if (!buf_a)
-		return 0;
+	size_t i, j, n;
+	uint32_t stream_len;
 
-	if (!buf_b)
-		return 0;
+	const struct s_fx_efx_ncob_ecob *data_buf = cfg->src;
+	const struct s_fx_efx_ncob_ecob *model_buf = cfg->model_buf;
+	struct s_fx_efx_ncob_ecob *up_model_buf = NULL;
+	struct encoder_setup setup_exp_flag, setup_fx, setup_ncob, setup_efx,
+			      setup_ecob;
+	struct column col[7];
 
-	if ((const char *)buf_a < (const char *)buf_b + size_b &&
-	    (const char *)buf_b < (const char *)buf_a + size_a)
-		return 1;
+	if (model_mode_is_used(cfg->cmp_mode))
+		up_model_buf = cfg->updated_model_buf;
 
-	return 0;
+	configure_encoder_setup(&setup_exp_flag, enc, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
+				cfg->round, MAX_USED_BITS.s_exp_flags, cfg);
+	configure_encoder_setup(&setup_fx, enc, cfg->cmp_par_fx, cfg->spill_fx,
+				cfg->round, MAX_USED_BITS.s_fx, cfg);
+	configure_encoder_setup(&setup_ncob, enc, cfg->cmp_par_ncob, cfg->spill_ncob,
+				cfg->round, MAX_USED_BITS.s_ncob, cfg);
+	configure_encoder_setup(&setup_efx, enc, cfg->cmp_par_efx, cfg->spill_efx,
+				cfg->round, MAX_USED_BITS.s_efx, cfg);
+	configure_encoder_setup(&setup_ecob, enc, cfg->cmp_par_ecob, cfg->spill_ecob,
+				cfg->round, MAX_USED_BITS.s_ecob, cfg);
+
+	init_column(&col[0], &setup_exp_flag);
+	init_column(&col[1], &setup_fx);
+	init_column(&col[2], &setup_ncob);
+	init_column(&col[3], &setup_ncob);
+	init_column(&col[4], &setup_efx);
+	init_column(&col[5], &setup_ecob);
+	init_column(&col[6], &setup_ecob);
+
+	stream_len = enc->stream_len;
+	for (i = 0; i < cfg->samples; i += n) {
+		n = cfg->samples - i;
+		if (n > COL_BLOCK_SIZE)
+			n = COL_BLOCK_SIZE;
+
+		for (j = 0; j < n; j++) {
+			col[0].data[j] = data_buf[i+j].exp_flags;
+			col[1].data[j] = data_buf[i+j].fx;
+			col[2].data[j] = data_buf[i+j].ncob_x;
+			col[3].data[j] = data_buf[i+j].ncob_y;
+			col[4].data[j] = data_buf[i+j].efx;
+			col[5].data[j] = data_buf[i+j].ecob_x;
+			col[6].data[j] = data_buf[i+j].ecob_y;
+		}
+		if (model_mode_is_used(cfg->cmp_mode)) {
+			for (j = 0; j < n; j++) {
+				col[0].model[j] = model_buf[i+j].exp_flags;
+				col[1].model[j] = model_buf[i+j].fx;
+				col[2].model[j] = model_buf[i+j].ncob_x;
+				col[3].model[j] = model_buf[i+j].ncob_y;
+				col[4].model[j] = model_buf[i+j].efx;
+				col[5].model[j] = model_buf[i+j].ecob_x;
+				col[6].model[j] = model_buf[i+j].ecob_y;
+			}
+		} else {
+			diff_model_columns(col, ARRAY_SIZE(col), n);
+		}
+
+		stream_len = compress_columns(col, ARRAY_SIZE(col), n, cfg->samples - i - n,
+					      variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
+
+		if (up_model_buf) {
+			update_columns(col, ARRAY_SIZE(col), n, cfg->model_value);
+			for (j = 0; j < n; j++) {
+				up_model_buf[i+j].exp_flags = (uint8_t)col[0].model[j];
+				up_model_buf[i+j].fx = col[1].model[j];
+				up_model_buf[i+j].ncob_x = col[2].model[j];
+				up_model_buf[i+j].ncob_y = col[3].model[j];
+				up_model_buf[i+j].efx = col[4].model[j];
+				up_model_buf[i+j].ecob_x = col[5].model[j];
+				up_model_buf[i+j].ecob_y = col[6].model[j];
+			}
+		}
+	}
+	return stream_len;
 }
 
 
 /**
- * @brief fill the last part of the bitstream with zeros
+ * @brief compress L_FX data
  *
  * @param cfg		pointer to the compression configuration structure
- * @param cmp_size	length of the bitstream in bits
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
  * @returns the bit length of the bitstream on success or an error code if it
  *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t pad_bitstream(const struct cmp_cfg *cfg, uint32_t cmp_size)
+FORCE_INLINE uint32_t compress_l_fx_generic(const struct cmp_cfg *cfg,
+					    struct bit_encoder *enc,
+					    unsigned int const variant)
 {
-	unsigned int output_buf_len_bits, n_pad_bits;
+	size_t i, j, n;
+	uint32_t stream_len;
 
-	if (!cfg->dst)
-		return cmp_size;
+	const struct l_fx *data_buf = cfg->src;
+	const struct l_fx *model_buf = cfg->model_buf;
+	struct l_fx *up_model_buf = NULL;
+	struct encoder_setup setup_exp_flag, setup_fx, setup_fx_var;
+	struct column col[3];
 
-	/* no padding in RAW mode; ALWAYS BIG-ENDIAN */
-	if (cfg->cmp_mode == CMP_MODE_RAW)
-		return cmp_size;
+	if (model_mode_is_used(cfg->cmp_mode))
+		up_model_buf = cfg->updated_model_buf;
+
+	configure_encoder_setup(&setup_exp_flag, enc, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
+				cfg->round, MAX_USED_BITS.l_exp_flags, cfg);
+	configure_encoder_setup(&setup_fx, enc, cfg->cmp_par_fx, cfg->spill_fx,
+				cfg->round, MAX_USED_BITS.l_fx, cfg);
+	configure_encoder_setup(&setup_fx_var, enc, cfg->cmp_par_fx_cob_variance, cfg->spill_fx_cob_variance,
+				cfg->round, MAX_USED_BITS.l_fx_cob_variance, cfg);
 
-	/* maximum length of the bitstream in bits */
-	output_buf_len_bits = cmp_stream_size_to_bits(cfg->stream_size);
+	init_column(&col[0], &setup_exp_flag);
+	init_column(&col[1], &setup_fx);
+	init_column(&col[2], &setup_fx_var);
 
-	n_pad_bits = 32 - (cmp_size & 0x1FU);
-	if (n_pad_bits < 32) {
-		FORWARD_IF_ERROR(put_n_bits32(0, n_pad_bits, cmp_size,
-				 cfg->dst, output_buf_len_bits), "");
-	}
+	stream_len = enc->stream_len;
+	for (i = 0; i < cfg->samples; i += n) {
+		n = cfg->samples - i;
+		if (n > COL_BLOCK_SIZE)
+			n = COL_BLOCK_SIZE;
 
-	return cmp_size;
+		for (j = 0; j < n; j++) {
+			col[0].data[j] = data_buf[i+j].exp_flags;
+			col[1].data[j] = data_buf[i+j].fx;
+			col[2].data[j] = data_buf[i+j].fx_variance;
+		}
+		if (model_mode_is_used(cfg->cmp_mode)) {
+			for (j = 0; j < n; j++) {
+				col[0].model[j] = model_buf[i+j].exp_flags;
+				col[1].model[j] = model_buf[i+j].fx;
+				col[2].model[j] = model_buf[i+j].fx_variance;
+			}
+		} else {
+			diff_model_columns(col, ARRAY_SIZE(col), n);
+		}
+
+		stream_len = compress_columns(col, ARRAY_SIZE(col), n, cfg->samples - i - n,
+					      variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
+
+		if (up_model_buf) {
+			update_columns(col, ARRAY_SIZE(col), n, cfg->model_value);
+			for (j = 0; j < n; j++) {
+				up_model_buf[i+j].exp_flags = col[0].model[j];
+				up_model_buf[i+j].fx = col[1].model[j];
+				up_model_buf[i+j].fx_variance = col[2].model[j];
+			}
+		}
+	}
+	return stream_len;
 }
 
 
 /**
- * @brief internal data compression function
- * This function can compress all types of collection data (one at a time).
- * This function does not take the header of a collection into account.
+ * @brief compress L_FX_EFX data
  *
  * @param cfg		pointer to the compression configuration structure
- * @param stream_len	already used length of the bitstream in bits
- *
- * @note the validity of the cfg structure is not checked
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
  * @returns the bit length of the bitstream on success or an error code if it
  *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t compress_data_internal(const struct cmp_cfg *cfg, uint32_t stream_len)
+FORCE_INLINE uint32_t compress_l_fx_efx_generic(const struct cmp_cfg *cfg,
+						struct bit_encoder *enc,
+						unsigned int const variant)
 {
-	uint32_t bitsize = 0;
-
-	FORWARD_IF_ERROR(stream_len, "");
-	RETURN_ERROR_IF(cfg == NULL, GENERIC, "");
-	RETURN_ERROR_IF(stream_len & 0x7, GENERIC, "The stream_len parameter must be a multiple of 8.");
+	size_t i, j, n;
+	uint32_t stream_len;
 
-	if (cfg->samples == 0) /* nothing to compress we are done */
-		return stream_len;
+	const struct l_fx_efx *data_buf = cfg->src;
+	const struct l_fx_efx *model_buf = cfg->model_buf;
+	struct l_fx_efx *up_model_buf = NULL;
+	struct encoder_setup setup_exp_flag, setup_fx, setup_efx, setup_fx_var;
+	struct column col[4];
 
-	if (raw_mode_is_used(cfg->cmp_mode)) {
-		uint32_t raw_size = cfg->samples * (uint32_t)size_of_a_sample(cfg->data_type);
+	if (model_mode_is_used(cfg->cmp_mode))
+		up_model_buf = cfg->updated_model_buf;
 
-		if (cfg->dst) {
-			uint32_t offset_bytes = stream_len >> 3;
-			uint8_t *p = (uint8_t *)cfg->dst + offset_bytes;
-			uint32_t new_stream_size = offset_bytes + raw_size;
+	configure_encoder_setup(&setup_exp_flag, enc, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
+				cfg->round, MAX_USED_BITS.l_exp_flags, cfg);
+	configure_encoder_setup(&setup_fx, enc, cfg->cmp_par_fx, cfg->spill_fx,
+				cfg->round, MAX_USED_BITS.l_fx, cfg);
+	configure_encoder_setup(&setup_efx, enc, cfg->cmp_par_efx, cfg->spill_efx,
+				cfg->round, MAX_USED_BITS.l_efx, cfg);
+	configure_encoder_setup(&setup_fx_var, enc, cfg->cmp_par_fx_cob_variance, cfg->spill_fx_cob_variance,
+				cfg->round, MAX_USED_BITS.l_fx_cob_variance, cfg);
 
-			RETURN_ERROR_IF(new_stream_size > cfg->stream_size, SMALL_BUFFER, "");
-			memcpy(p, cfg->src, raw_size);
-			RETURN_ERROR_IF(cpu_to_be_data_type(p, raw_size, cfg->data_type),
-					INT_DATA_TYPE_UNSUPPORTED, "");
+	init_column(&col[0], &setup_exp_flag);
+	init_column(&col[1], &setup_fx);
+	init_column(&col[2], &setup_efx);
+	init_column(&col[3], &setup_fx_var);
+
+	stream_len = enc->stream_len;
+	for (i = 0; i < cfg->samples; i += n) {
+		n = cfg->samples - i;
+		if (n > COL_BLOCK_SIZE)
+			n = COL_BLOCK_SIZE;
+
+		for (j = 0; j < n; j++) {
+			col[0].data[j] = data_buf[i+j].exp_flags;
+			col[1].data[j] = data_buf[i+j].fx;
+			col[2].data[j] = data_buf[i+j].efx;
+			col[3].data[j] = data_buf[i+j].fx_variance;
+		}
+		if (model_mode_is_used(cfg->cmp_mode)) {
+			for (j = 0; j < n; j++) {
+				col[0].model[j] = model_buf[i+j].exp_flags;
+				col[1].model[j] = model_buf[i+j].fx;
+				col[2].model[j] = model_buf[i+j].efx;
+				col[3].model[j] = model_buf[i+j].fx_variance;
+			}
+		} else {
+			diff_model_columns(col, ARRAY_SIZE(col), n);
 		}
-		bitsize += stream_len + raw_size * 8; /* convert to bits */
-	} else {
-		switch (cfg->data_type) {
-		case DATA_TYPE_IMAGETTE:
-		case DATA_TYPE_IMAGETTE_ADAPTIVE:
-		case DATA_TYPE_SAT_IMAGETTE:
-		case DATA_TYPE_SAT_IMAGETTE_ADAPTIVE:
-		case DATA_TYPE_F_CAM_IMAGETTE:
-		case DATA_TYPE_F_CAM_IMAGETTE_ADAPTIVE:
-			bitsize = compress_imagette(cfg, stream_len);
-			break;
 
-		case DATA_TYPE_S_FX:
-			bitsize = compress_s_fx(cfg, stream_len);
-			break;
-		case DATA_TYPE_S_FX_EFX:
-			bitsize = compress_s_fx_efx(cfg, stream_len);
-			break;
-		case DATA_TYPE_S_FX_NCOB:
-			bitsize = compress_s_fx_ncob(cfg, stream_len);
-			break;
-		case DATA_TYPE_S_FX_EFX_NCOB_ECOB:
-			bitsize = compress_s_fx_efx_ncob_ecob(cfg, stream_len);
-			break;
-
-
-		case DATA_TYPE_L_FX:
-			bitsize = compress_l_fx(cfg, stream_len);
-			break;
-		case DATA_TYPE_L_FX_EFX:
-			bitsize = compress_l_fx_efx(cfg, stream_len);
-			break;
-		case DATA_TYPE_L_FX_NCOB:
-			bitsize = compress_l_fx_ncob(cfg, stream_len);
-			break;
-		case DATA_TYPE_L_FX_EFX_NCOB_ECOB:
-			bitsize = compress_l_fx_efx_ncob_ecob(cfg, stream_len);
-			break;
-
-		case DATA_TYPE_OFFSET:
-		case DATA_TYPE_F_CAM_OFFSET:
-			bitsize = compress_offset(cfg, stream_len);
-			break;
-		case DATA_TYPE_BACKGROUND:
-		case DATA_TYPE_F_CAM_BACKGROUND:
-			bitsize = compress_background(cfg, stream_len);
-			break;
-		case DATA_TYPE_SMEARING:
-			bitsize = compress_smearing(cfg, stream_len);
-			break;
+		stream_len = compress_columns(col, ARRAY_SIZE(col), n, cfg->samples - i - n,
+					      variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
 
-		case DATA_TYPE_F_FX:
-		case DATA_TYPE_F_FX_EFX:
-		case DATA_TYPE_F_FX_NCOB:
-		case DATA_TYPE_F_FX_EFX_NCOB_ECOB:
-		case DATA_TYPE_CHUNK:
-		case DATA_TYPE_UNKNOWN:
-		default:
-			RETURN_ERROR(INT_DATA_TYPE_UNSUPPORTED, "");
+		if (up_model_buf) {
+			update_columns(col, ARRAY_SIZE(col), n, cfg->model_value);
+			for (j = 0; j < n; j++) {
+				up_model_buf[i+j].exp_flags = col[0].model[j];
+				up_model_buf[i+j].fx = col[1].model[j];
+				up_model_buf[i+j].efx = col[2].model[j];
+				up_model_buf[i+j].fx_variance = col[3].model[j];
+			}
 		}
 	}
-
-	if (cmp_is_error(bitsize))
-		return bitsize;
-
-	bitsize = pad_bitstream(cfg, bitsize);
-
-	return bitsize;
+	return stream_len;
 }
 
 
 /**
- * @brief check if the ICU buffer parameters are invalid
+ * @brief compress L_FX_NCOB data
  *
- * @param cfg	pointer to the compressor configuration to check
+ * @param cfg		pointer to the compression configuration structure
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
- * @returns 0 if the buffer parameters are valid, otherwise invalid
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t check_compression_buffers(const struct cmp_cfg *cfg)
+FORCE_INLINE uint32_t compress_l_fx_ncob_generic(const struct cmp_cfg *cfg,
+						 struct bit_encoder *enc,
+						 unsigned int const variant)
 {
-	size_t data_size;
-
-	RETURN_ERROR_IF(cfg == NULL, GENERIC, "");
-
-	RETURN_ERROR_IF(cfg->src == NULL, CHUNK_NULL, "");
+	size_t i, j, n;
+	uint32_t stream_len;
 
-	data_size = size_of_a_sample(cfg->data_type) * cfg->samples;
+	const struct l_fx_ncob *data_buf = cfg->src;
+	const struct l_fx_ncob *model_buf = cfg->model_buf;
+	struct l_fx_ncob *up_model_buf = NULL;
+	struct encoder_setup setup_exp_flag, setup_fx, setup_ncob,
+			      setup_fx_var, setup_cob_var;
+	struct column col[7];
 
-	if (cfg->samples == 0)
-		debug_print("Warning: The samples parameter is 0. No data are compressed. This behavior may not be intended.");
+	if (model_mode_is_used(cfg->cmp_mode))
+		up_model_buf = cfg->updated_model_buf;
 
-	RETURN_ERROR_IF(buffer_overlaps(cfg->dst, cfg->stream_size,
-					cfg->src, data_size), PAR_BUFFERS,
-		"The compressed data buffer and the data to compress buffer are overlapping.");
+	configure_encoder_setup(&setup_exp_flag, enc, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
+				cfg->round, MAX_USED_BITS.l_exp_flags, cfg);
+	configure_encoder_setup(&setup_fx, enc, cfg->cmp_par_fx, cfg->spill_fx,
+				cfg->round, MAX_USED_BITS.l_fx, cfg);
+	configure_encoder_setup(&setup_ncob, enc, cfg->cmp_par_ncob, cfg->spill_ncob,
+				cfg->round, MAX_USED_BITS.l_ncob, cfg);
+	/* we use the cmp_par_fx_cob_variance parameter for fx and cob variance data */
+	configure_encoder_setup(&setup_fx_var, enc, cfg->cmp_par_fx_cob_variance, cfg->spill_fx_cob_variance,
+				cfg->round, MAX_USED_BITS.l_fx_cob_variance, cfg);
+	configure_encoder_setup(&setup_cob_var, enc, cfg->cmp_par_fx_cob_variance, cfg->spill_fx_cob_variance,
+				cfg->round, MAX_USED_BITS.l_fx_cob_variance, cfg);
 
-	if (model_mode_is_used(cfg->cmp_mode)) {
-		RETURN_ERROR_IF(cfg->model_buf == NULL, PAR_NO_MODEL, "");
+	init_column(&col[0], &setup_exp_flag);
+	init_column(&col[1], &setup_fx);
+	init_column(&col[2], &setup_ncob);
+	init_column(&col[3], &setup_ncob);
+	init_column(&col[4], &setup_fx_var);
+	init_column(&col[5], &setup_cob_var);
+	init_column(&col[6], &setup_cob_var);
+
+	stream_len = enc->stream_len;
+	for (i = 0; i < cfg->samples; i += n) {
+		n = cfg->samples - i;
+		if (n > COL_BLOCK_SIZE)
+			n = COL_BLOCK_SIZE;
+
+		for (j = 0; j < n; j++) {
+			col[0].data[j] = data_buf[i+j].exp_flags;
+			col[1].data[j] = data_buf[i+j].fx;
+			col[2].data[j] = data_buf[i+j].ncob_x;
+			col[3].data[j] = data_buf[i+j].ncob_y;
+			col[4].data[j] = data_buf[i+j].fx_variance;
+			col[5].data[j] = data_buf[i+j].cob_x_variance;
+			col[6].data[j] = data_buf[i+j].cob_y_variance;
+		}
+		if (model_mode_is_used(cfg->cmp_mode)) {
+			for (j = 0; j < n; j++) {
+				col[0].model[j] = model_buf[i+j].exp_flags;
+				col[1].model[j] = model_buf[i+j].fx;
+				col[2].model[j] = model_buf[i+j].ncob_x;
+				col[3].model[j] = model_buf[i+j].ncob_y;
+				col[4].model[j] = model_buf[i+j].fx_variance;
+				col[5].model[j] = model_buf[i+j].cob_x_variance;
+				col[6].model[j] = model_buf[i+j].cob_y_variance;
+			}
+		} else {
+			diff_model_columns(col, ARRAY_SIZE(col), n);
+		}
 
-		RETURN_ERROR_IF(buffer_overlaps(cfg->model_buf, data_size,
-						cfg->src, data_size), PAR_BUFFERS,
-				"The model buffer and the data to compress buffer are overlapping.");
-		RETURN_ERROR_IF(buffer_overlaps(cfg->model_buf, data_size,
-						cfg->dst, cfg->stream_size), PAR_BUFFERS,
-				"The model buffer and the compressed data buffer are overlapping.");
+		stream_len = compress_columns(col, ARRAY_SIZE(col), n, cfg->samples - i - n,
+					      variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
 
-		RETURN_ERROR_IF(buffer_overlaps(cfg->updated_model_buf, data_size,
-						cfg->src, data_size), PAR_BUFFERS,
-				"The updated model buffer and the data to compress buffer are overlapping.");
-		RETURN_ERROR_IF(buffer_overlaps(cfg->updated_model_buf, data_size,
-						cfg->dst, cfg->stream_size), PAR_BUFFERS,
-				"The updated model buffer and the compressed data buffer are overlapping.");
+		if (up_model_buf) {
+			update_columns(col, ARRAY_SIZE(col), n, cfg->model_value);
+			for (j = 0; j < n; j++) {
+				up_model_buf[i+j].exp_flags = col[0].model[j];
+				up_model_buf[i+j].fx = col[1].model[j];
+				up_model_buf[i+j].ncob_x = col[2].model[j];
+				up_model_buf[i+j].ncob_y = col[3].model[j];
+				up_model_buf[i+j].fx_variance = col[4].model[j];
+				up_model_buf[i+j].cob_x_variance = col[5].model[j];
+				up_model_buf[i+j].cob_y_variance = col[6].model[j];
+			}
+		}
 	}
-
-	return CMP_ERROR(NO_ERROR);
+	return stream_len;
 }
 
 
 /**
- * @brief checks if the ICU compression configuration is valid
+ * @brief compress L_FX_EFX_NCOB_ECOB data
  *
- * @param cfg	pointer to the cmp_cfg structure to be validated
+ * @param cfg		pointer to the compression configuration structure
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
- * @returns an error code if any of the configuration parameters are invalid,
- *	otherwise returns CMP_ERROR_NO_ERROR on valid configuration
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t cmp_cfg_icu_is_invalid_error_code(const struct cmp_cfg *cfg)
+FORCE_INLINE uint32_t compress_l_fx_efx_ncob_ecob_generic(const struct cmp_cfg *cfg,
+							  struct bit_encoder *enc,
+							  unsigned int const variant)
 {
+	size_t i, j, n;
+	uint32_t stream_len;
 
-	RETURN_ERROR_IF(cmp_cfg_gen_par_is_invalid(cfg), PAR_GENERIC, "");
+	const struct l_fx_efx_ncob_ecob *data_buf = cfg->src;
+	const struct l_fx_efx_ncob_ecob *model_buf = cfg->model_buf;
+	struct l_fx_efx_ncob_ecob *up_model_buf = NULL;
+	struct encoder_setup setup_exp_flag, setup_fx, setup_ncob, setup_efx,
+			      setup_ecob, setup_fx_var, setup_cob_var;
+	struct column col[10];
 
-	if (cmp_imagette_data_type_is_used(cfg->data_type))
-		RETURN_ERROR_IF(cmp_cfg_imagette_is_invalid(cfg), PAR_SPECIFIC, "");
-	else if (cmp_fx_cob_data_type_is_used(cfg->data_type))
-		RETURN_ERROR_IF(cmp_cfg_fx_cob_is_invalid(cfg), PAR_SPECIFIC, "");
-	else
-		RETURN_ERROR_IF(cmp_cfg_aux_is_invalid(cfg), PAR_SPECIFIC, "");
+	if (model_mode_is_used(cfg->cmp_mode))
+		up_model_buf = cfg->updated_model_buf;
 
-	FORWARD_IF_ERROR(check_compression_buffers(cfg), "");
+	configure_encoder_setup(&setup_exp_flag, enc, cfg->cmp_par_exp_flags, cfg->spill_exp_flags,
+				cfg->round, MAX_USED_BITS.l_exp_flags, cfg);
+	configure_encoder_setup(&setup_fx, enc, cfg->cmp_par_fx, cfg->spill_fx,
+				cfg->round, MAX_USED_BITS.l_fx, cfg);
+	configure_encoder_setup(&setup_ncob, enc, cfg->cmp_par_ncob, cfg->spill_ncob,
+				cfg->round, MAX_USED_BITS.l_ncob, cfg);
+	configure_encoder_setup(&setup_efx, enc, cfg->cmp_par_efx, cfg->spill_efx,
+				cfg->round, MAX_USED_BITS.l_efx, cfg);
+	configure_encoder_setup(&setup_ecob, enc, cfg->cmp_par_ecob, cfg->spill_ecob,
+				cfg->round, MAX_USED_BITS.l_ecob, cfg);
+	/* we use compression parameters for both variance data fields */
+	configure_encoder_setup(&setup_fx_var, enc, cfg->cmp_par_fx_cob_variance, cfg->spill_fx_cob_variance,
+				cfg->round, MAX_USED_BITS.l_fx_cob_variance, cfg);
+	configure_encoder_setup(&setup_cob_var, enc, cfg->cmp_par_fx_cob_variance, cfg->spill_fx_cob_variance,
+				cfg->round, MAX_USED_BITS.l_fx_cob_variance, cfg);
 
-	return CMP_ERROR(NO_ERROR);
+	init_column(&col[0], &setup_exp_flag);
+	init_column(&col[1], &setup_fx);
+	init_column(&col[2], &setup_ncob);
+	init_column(&col[3], &setup_ncob);
+	init_column(&col[4], &setup_efx);
+	init_column(&col[5], &setup_ecob);
+	init_column(&col[6], &setup_ecob);
+	init_column(&col[7], &setup_fx_var);
+	init_column(&col[8], &setup_cob_var);
+	init_column(&col[9], &setup_cob_var);
+
+	stream_len = enc->stream_len;
+	for (i = 0; i < cfg->samples; i += n) {
+		n = cfg->samples - i;
+		if (n > COL_BLOCK_SIZE)
+			n = COL_BLOCK_SIZE;
+
+		for (j = 0; j < n; j++) {
+			col[0].data[j] = data_buf[i+j].exp_flags;
+			col[1].data[j] = data_buf[i+j].fx;
+			col[2].data[j] = data_buf[i+j].ncob_x;
+			col[3].data[j] = data_buf[i+j].ncob_y;
+			col[4].data[j] = data_buf[i+j].efx;
+			col[5].data[j] = data_buf[i+j].ecob_x;
+			col[6].data[j] = data_buf[i+j].ecob_y;
+			col[7].data[j] = data_buf[i+j].fx_variance;
+			col[8].data[j] = data_buf[i+j].cob_x_variance;
+			col[9].data[j] = data_buf[i+j].cob_y_variance;
+		}
+		if (model_mode_is_used(cfg->cmp_mode)) {
+			for (j = 0; j < n; j++) {
+				col[0].model[j] = model_buf[i+j].exp_flags;
+				col[1].model[j] = model_buf[i+j].fx;
+				col[2].model[j] = model_buf[i+j].ncob_x;
+				col[3].model[j] = model_buf[i+j].ncob_y;
+				col[4].model[j] = model_buf[i+j].efx;
+				col[5].model[j] = model_buf[i+j].ecob_x;
+				col[6].model[j] = model_buf[i+j].ecob_y;
+				col[7].model[j] = model_buf[i+j].fx_variance;
+				col[8].model[j] = model_buf[i+j].cob_x_variance;
+				col[9].model[j] = model_buf[i+j].cob_y_variance;
+			}
+		} else {
+			diff_model_columns(col, ARRAY_SIZE(col), n);
+		}
+
+		stream_len = compress_columns(col, ARRAY_SIZE(col), n, cfg->samples - i - n,
+					      variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
+
+		if (up_model_buf) {
+			update_columns(col, ARRAY_SIZE(col), n, cfg->model_value);
+			for (j = 0; j < n; j++) {
+				up_model_buf[i+j].exp_flags = col[0].model[j];
+				up_model_buf[i+j].fx = col[1].model[j];
+				up_model_buf[i+j].ncob_x = col[2].model[j];
+				up_model_buf[i+j].ncob_y = col[3].model[j];
+				up_model_buf[i+j].efx = col[4].model[j];
+				up_model_buf[i+j].ecob_x = col[5].model[j];
+				up_model_buf[i+j].ecob_y = col[6].model[j];
+				up_model_buf[i+j].fx_variance = col[7].model[j];
+				up_model_buf[i+j].cob_x_variance = col[8].model[j];
+				up_model_buf[i+j].cob_y_variance = col[9].model[j];
+			}
+		}
+	}
+	return stream_len;
 }
 
 
 /**
- * @brief calculate the optimal spill threshold value for zero escape mechanism
+ * @brief compress offset data from the normal and fast cameras
  *
- * @param golomb_par	Golomb parameter
- * @param max_data_bits	maximum number of used data bits
+ * @param cfg		pointer to the compression configuration structure
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
- * @returns the highest optimal spill threshold value for a given Golomb
- *	parameter, when the zero escape mechanism is used or 0 if the
- *	Golomb parameter is not valid
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t cmp_best_zero_spill(uint32_t golomb_par, uint32_t max_data_bits)
+FORCE_INLINE uint32_t compress_offset_generic(const struct cmp_cfg *cfg,
+					      struct bit_encoder *enc,
+					      unsigned int const variant)
 {
-	uint32_t const max_spill = cmp_icu_max_spill(golomb_par);
-	uint32_t cutoff;
-	uint32_t spill;
+	size_t i;
+	uint32_t stream_len;
 
-	if (golomb_par < MIN_NON_IMA_GOLOMB_PAR)
-		return 0;
-	if (golomb_par > MAX_NON_IMA_GOLOMB_PAR)
-		return 0;
+	const struct offset *data_buf = cfg->src;
+	const struct offset *model_buf = cfg->model_buf;
+	struct offset *up_model_buf = NULL;
+	const struct offset *next_model_p;
+	struct offset model;
+	struct encoder_setup setup_mean, setup_var;
+	const struct encoder_setup *setups[2];
+	uint32_t min_bits;
 
-	cutoff = (0x2U << ilog_2(golomb_par)) - golomb_par;
-	spill = max_data_bits * golomb_par + cutoff;
-	if (spill > max_spill)
-		spill = max_spill;
+	if (model_mode_is_used(cfg->cmp_mode)) {
+		model = model_buf[0];
+		next_model_p = &model_buf[1];
+		up_model_buf = cfg->updated_model_buf;
+	} else {
+		memset(&model, 0, sizeof(model));
+		next_model_p = data_buf;
+	}
 
-	return spill;
-}
+	{
+		unsigned int mean_bits_used, variance_bits_used;
 
+		if (cfg->data_type == DATA_TYPE_F_CAM_OFFSET) {
+			mean_bits_used = MAX_USED_BITS.fc_offset_mean;
+			variance_bits_used = MAX_USED_BITS.fc_offset_variance;
+		} else { /* DATA_TYPE_OFFSET */
+			mean_bits_used = MAX_USED_BITS.nc_offset_mean;
+			variance_bits_used = MAX_USED_BITS.nc_offset_variance;
+		}
 
-/**
- * @brief estimate a "good" spillover threshold parameter
- *
- * @param golomb_par	Golomb parameter
- * @param cmp_mode	compression mode
- * @param max_data_bits	maximum number of used data bits
- *
- * @returns a spillover threshold parameter or 0 if the Golomb parameter is not
- *	valid
- */
+		configure_encoder_setup(&setup_mean, enc, cfg->cmp_par_offset_mean, cfg->spill_offset_mean,
+					cfg->round, mean_bits_used, cfg);
+		configure_encoder_setup(&setup_var, enc, cfg->cmp_par_offset_variance, cfg->spill_offset_variance,
+					cfg->round, variance_bits_used, cfg);
+	}
+	setups[0] = &setup_mean;
+	setups[1] = &setup_var;
+	min_bits = min_sample_bits(setups, ARRAY_SIZE(setups));
 
-static uint32_t cmp_get_spill(uint32_t golomb_par, enum cmp_mode cmp_mode,
-			      uint32_t max_data_bits)
-{
-	if (zero_escape_mech_is_used(cmp_mode))
-		return cmp_best_zero_spill(golomb_par, max_data_bits);
+	for (i = 0;; i++) {
+		stream_len = encode_value(data_buf[i].mean, model.mean,
+					  &setup_mean, variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
+		stream_len = encode_value(data_buf[i].variance, model.variance,
+					  &setup_var, variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
 
-	return cmp_icu_max_spill(golomb_par);
+		if (i >= cfg->samples-1)
+			break;
+
+		if (!(variant & ENC_SIZE_ONLY) && min_bits &&
+		    i % FIT_CHECK_INTERVAL == FIT_CHECK_INTERVAL-1) {
+			stream_len = stop_if_stream_cannot_fit(enc, cfg->samples-1 - i, min_bits);
+			if (cmp_is_error(stream_len))
+				return stream_len;
+		}
+
+		model = next_model_p[i];
+	}
+
+	/* all fields have the same size and lossy_par, so the model of the
+	 * offset data can be updated as an array of 32-bit values
+	 */
+	if (up_model_buf)
+		cmp_up_model32_batch(cfg->updated_model_buf, cfg->src, cfg->model_buf,
+				     cfg->samples * 2, cfg->model_value, cfg->round);
+	return stream_len;
 }
 
 
 /**
- * @brief set the compressed collection size field
+ * @brief compress background data from the normal and fast cameras
  *
- * @param cmp_col_size_field	pointer to the compressed collection size field
- * @param cmp_col_size		size of the compressed collection (not including
- *				the compressed collection header size and the
- *				size of the compressed collection size field
- *				itself)
+ * @param cfg		pointer to the compression configuration structure
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
- * @returns error code
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t set_cmp_col_size(uint8_t *cmp_col_size_field, uint32_t cmp_col_size)
+FORCE_INLINE uint32_t compress_background_generic(const struct cmp_cfg *cfg,
+						  struct bit_encoder *enc,
+						  unsigned int const variant)
 {
-	uint16_t const v = cpu_to_be16((uint16_t)cmp_col_size);
+	size_t i;
+	uint32_t stream_len;
 
-	RETURN_ERROR_IF(cmp_col_size > UINT16_MAX, INT_CMP_COL_TOO_LARGE,
-			"%"PRIu32" is bigger than the maximum allowed compression collection size", cmp_col_size_field);
+	const struct background *data_buf = cfg->src;
+	const struct background *model_buf = cfg->model_buf;
+	struct background *up_model_buf = NULL;
+	const struct background *next_model_p;
+	struct background model;
+	struct encoder_setup setup_mean, setup_var, setup_pix;
+	const struct encoder_setup *setups[3];
+	uint32_t min_bits;
 
-	memcpy(cmp_col_size_field, &v, CMP_COLLECTION_FILD_SIZE);
+	if (model_mode_is_used(cfg->cmp_mode)) {
+		model = model_buf[0];
+		next_model_p = &model_buf[1];
+		up_model_buf = cfg->updated_model_buf;
+	} else {
+		memset(&model, 0, sizeof(model));
+		next_model_p = data_buf;
+	}
 
-	return 0;
-}
+	{
+		unsigned int mean_used_bits, varinace_used_bits, pixels_error_used_bits;
 
+		if (cfg->data_type == DATA_TYPE_F_CAM_BACKGROUND) {
+			mean_used_bits = MAX_USED_BITS.fc_background_mean;
+			varinace_used_bits = MAX_USED_BITS.fc_background_variance;
+			pixels_error_used_bits = MAX_USED_BITS.fc_background_outlier_pixels;
+		} else { /* DATA_TYPE_BACKGROUND */
+			mean_used_bits = MAX_USED_BITS.nc_background_mean;
+			varinace_used_bits = MAX_USED_BITS.nc_background_variance;
+			pixels_error_used_bits = MAX_USED_BITS.nc_background_outlier_pixels;
+		}
+		configure_encoder_setup(&setup_mean, enc, cfg->cmp_par_background_mean, cfg->spill_background_mean,
+					cfg->round, mean_used_bits, cfg);
+		configure_encoder_setup(&setup_var, enc, cfg->cmp_par_background_variance, cfg->spill_background_variance,
+					cfg->round, varinace_used_bits, cfg);
+		configure_encoder_setup(&setup_pix, enc, cfg->cmp_par_background_pixels_error, cfg->spill_background_pixels_error,
+					cfg->round, pixels_error_used_bits, cfg);
+	}
+	setups[0] = &setup_mean;
+	setups[1] = &setup_var;
+	setups[2] = &setup_pix;
+	min_bits = min_sample_bits(setups, ARRAY_SIZE(setups));
 
-/**
- * @brief compresses a collection (with a collection header followed by data)
- *
- * @param col		pointer to a collection header
- * @param model		pointer to the model to be used for compression, or NULL
- *			if not applicable
- * @param updated_model	pointer to the buffer where the updated model will be
- *			stored, or NULL if not applicable
- * @param dst		pointer to the buffer where the compressed data will be
- *			stored, or NULL to only get the compressed data size
- * @param dst_capacity	the size of the dst buffer in bytes
- * @param cfg		pointer to a compression configuration
- * @param dst_size	the already used size of the dst buffer in bytes
- *
- * @returns the size of the compressed data in bytes (new dst_size) on
- *	success or an error code if it fails (which can be tested with
- *	cmp_is_error())
- */
-static uint32_t cmp_collection(const uint8_t *col,
-			       const uint8_t *model, uint8_t *updated_model,
-			       uint32_t *dst, uint32_t dst_capacity,
-			       struct cmp_cfg *cfg, uint32_t dst_size)
-{
-	uint32_t const dst_size_begin = dst_size;
-	uint32_t dst_size_bits;
-	const struct collection_hdr *col_hdr = (const struct collection_hdr *)col;
-	uint16_t const col_data_length = cmp_col_get_data_length(col_hdr);
-	uint16_t sample_size;
+	for (i = 0;; i++) {
+		stream_len = encode_value(data_buf[i].mean, model.mean,
+					  &setup_mean, variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
+		stream_len = encode_value(data_buf[i].variance, model.variance,
+					  &setup_var, variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
+		stream_len = encode_value(data_buf[i].outlier_pixels, model.outlier_pixels,
+					  &setup_pix, variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
 
-	/* sanity check of the collection header */
-	cfg->data_type = convert_subservice_to_cmp_data_type(cmp_col_get_subservice(col_hdr));
-	sample_size = (uint16_t)size_of_a_sample(cfg->data_type);
-	RETURN_ERROR_IF(col_data_length % sample_size, COL_SIZE_INCONSISTENT,
-			"col_data_length: %u %% sample_size: %u != 0", col_data_length, sample_size);
-	cfg->samples = col_data_length/sample_size;
+		if (up_model_buf) {
+			up_model_buf[i].mean = cmp_up_model(data_buf[i].mean, model.mean,
+				cfg->model_value, setup_mean.lossy_par);
+			up_model_buf[i].variance = cmp_up_model(data_buf[i].variance, model.variance,
+				cfg->model_value, setup_var.lossy_par);
+			up_model_buf[i].outlier_pixels = cmp_up_model(data_buf[i].outlier_pixels, model.outlier_pixels,
+				cfg->model_value, setup_pix.lossy_par);
+		}
 
-	/* prepare the different buffers */
-	cfg->src = col + COLLECTION_HDR_SIZE;
-	if (model)
-		cfg->model_buf = model + COLLECTION_HDR_SIZE;
-	if (updated_model)
-		cfg->updated_model_buf = updated_model + COLLECTION_HDR_SIZE;
-	cfg->dst = dst;
-	cfg->stream_size = dst_capacity;
-	FORWARD_IF_ERROR(cmp_cfg_icu_is_invalid_error_code(cfg), "");
+		if (i >= cfg->samples-1)
+			break;
 
-	if (cfg->cmp_mode != CMP_MODE_RAW) {
-		/* hear we reserve space for the compressed data size field */
-		dst_size += CMP_COLLECTION_FILD_SIZE;
-	}
+		if (!(variant & ENC_SIZE_ONLY) && min_bits &&
+		    i % FIT_CHECK_INTERVAL == FIT_CHECK_INTERVAL-1) {
+			stream_len = stop_if_stream_cannot_fit(enc, cfg->samples-1 - i, min_bits);
+			if (cmp_is_error(stream_len))
+				return stream_len;
+		}
 
-	/* we do not compress the collection header, we simply copy the header
-	 * into the compressed data
-	 */
-	if (dst) {
-		RETURN_ERROR_IF(dst_size + COLLECTION_HDR_SIZE > dst_capacity,
-				SMALL_BUFFER, "");
-		memcpy((uint8_t *)dst + dst_size, col, COLLECTION_HDR_SIZE);
+		model = next_model_p[i];
 	}
-	dst_size += COLLECTION_HDR_SIZE;
-	if (model_mode_is_used(cfg->cmp_mode) && updated_model)
-		memcpy(updated_model, col, COLLECTION_HDR_SIZE);
+	return stream_len;
+}
 
-	/* is enough capacity in the dst buffer to store the data uncompressed */
-	if ((dst == NULL || dst_capacity >= dst_size + col_data_length) &&
-	    cfg->cmp_mode != CMP_MODE_RAW) {
-		/* we set the compressed buffer size to the data size -1 to provoke
-		 * a CMP_ERROR_SMALL_BUFFER error if the data are not compressible
-		 */
-		cfg->stream_size = dst_size + col_data_length - 1;
-		dst_size_bits = compress_data_internal(cfg, dst_size << 3);
 
-		if (cmp_get_error_code(dst_size_bits) == CMP_ERROR_SMALL_BUFFER ||
-		    (!dst && dst_size_bits > cmp_stream_size_to_bits(cfg->stream_size))) { /* if dst == NULL compress_data_internal will not return a CMP_ERROR_SMALL_BUFFER */
-			/* can not compress the data with the given parameters;
-			 * put them uncompressed (raw) into the dst buffer */
-			enum cmp_mode cmp_mode_cpy = cfg->cmp_mode;
+/**
+ * @brief compress smearing data from the normal cameras
+ *
+ * @param cfg		pointer to the compression configuration structure
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
+ *
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ */
 
-			cfg->stream_size = dst_size + col_data_length;
-			cfg->cmp_mode = CMP_MODE_RAW;
-			dst_size_bits = compress_data_internal(cfg, dst_size << 3);
-			cfg->cmp_mode = cmp_mode_cpy;
-			/* updated model is in this case a copy of the data to compress */
-			if (model_mode_is_used(cfg->cmp_mode) && cfg->updated_model_buf)
-				memcpy(cfg->updated_model_buf, cfg->src, col_data_length);
-		}
+FORCE_INLINE uint32_t compress_smearing_generic(const struct cmp_cfg *cfg,
+						struct bit_encoder *enc,
+						unsigned int const variant)
+{
+	size_t i;
+	uint32_t stream_len;
+
+	const struct smearing *data_buf = cfg->src;
+	const struct smearing *model_buf = cfg->model_buf;
+	struct smearing *up_model_buf = NULL;
+	const struct smearing *next_model_p;
+	struct smearing model;
+	struct encoder_setup setup_mean, setup_var_mean, setup_pix;
+	const struct encoder_setup *setups[3];
+	uint32_t min_bits;
+
+	if (model_mode_is_used(cfg->cmp_mode)) {
+		model = model_buf[0];
+		next_model_p = &model_buf[1];
+		up_model_buf = cfg->updated_model_buf;
 	} else {
-		cfg->stream_size = dst_capacity;
-		dst_size_bits = compress_data_internal(cfg, dst_size << 3);
+		memset(&model, 0, sizeof(model));
+		next_model_p = data_buf;
 	}
-	FORWARD_IF_ERROR(dst_size_bits, "compression failed");
 
-	dst_size = cmp_bit_to_byte(dst_size_bits);
-	if (cfg->cmp_mode != CMP_MODE_RAW && dst) {
-		uint8_t *cmp_col_size_field = (uint8_t *)dst+dst_size_begin;
-		uint32_t cmp_col_size = dst_size - dst_size_begin -
-			COLLECTION_HDR_SIZE - CMP_COLLECTION_FILD_SIZE;
+	configure_encoder_setup(&setup_mean, enc, cfg->cmp_par_smearing_mean, cfg->spill_smearing_mean,
+				cfg->round, MAX_USED_BITS.smearing_mean, cfg);
+	configure_encoder_setup(&setup_var_mean, enc, cfg->cmp_par_smearing_variance, cfg->spill_smearing_variance,
+				cfg->round, MAX_USED_BITS.smearing_variance_mean, cfg);
+	configure_encoder_setup(&setup_pix, enc, cfg->cmp_par_smearing_pixels_error, cfg->spill_smearing_pixels_error,
+				cfg->round, MAX_USED_BITS.smearing_outlier_pixels, cfg);
+	setups[0] = &setup_mean;
+	setups[1] = &setup_var_mean;
+	setups[2] = &setup_pix;
+	min_bits = min_sample_bits(setups, ARRAY_SIZE(setups));
 
-		FORWARD_IF_ERROR(set_cmp_col_size(cmp_col_size_field, cmp_col_size), "");
-	}
+	for (i = 0;; i++) {
+		stream_len = encode_value(data_buf[i].mean, model.mean,
+					  &setup_mean, variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
+		stream_len = encode_value(data_buf[i].variance_mean, model.variance_mean,
+					  &setup_var_mean, variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
+		stream_len = encode_value(data_buf[i].outlier_pixels, model.outlier_pixels,
+					  &setup_pix, variant);
+		if (cmp_is_error(stream_len))
+			return stream_len;
 
-	return dst_size;
+		if (up_model_buf) {
+			up_model_buf[i].mean = cmp_up_model(data_buf[i].mean, model.mean,
+				cfg->model_value, setup_mean.lossy_par);
+			up_model_buf[i].variance_mean = cmp_up_model(data_buf[i].variance_mean, model.variance_mean,
+				cfg->model_value, setup_var_mean.lossy_par);
+			up_model_buf[i].outlier_pixels = cmp_up_model(data_buf[i].outlier_pixels, model.outlier_pixels,
+				cfg->model_value, setup_pix.lossy_par);
+		}
+
+		if (i >= cfg->samples-1)
+			break;
+
+		if (!(variant & ENC_SIZE_ONLY) && min_bits &&
+		    i % FIT_CHECK_INTERVAL == FIT_CHECK_INTERVAL-1) {
+			stream_len = stop_if_stream_cannot_fit(enc, cfg->samples-1 - i, min_bits);
+			if (cmp_is_error(stream_len))
+				return stream_len;
+		}
+
+		model = next_model_p[i];
+	}
+	return stream_len;
 }
 
 
+/*
+ * compression functions specialised for every encoder variant
+ */
+
 /**
- * @brief builds a compressed entity header for a compressed chunk
+ * @brief compress imagette data and calculate the bitstream lengths of the
+ *	size probes in the same pass; calls compress_imagette_generic()
+ *	specialised for the selected encoder variant
  *
- * @param entity		start address of the compression entity header
- *				(can be NULL if you only want the entity header
- *				size)
- * @param chunk_size		the original size of the chunk in bytes
- * @param cfg			pointer to the compression configuration used to
- *				compress the chunk
- * @param start_timestamp	the start timestamp of the chunk compression
- * @param cmp_ent_size_byte	the size of the compression entity (entity
- *				header plus compressed data)
+ * @param cfg		pointer to the compression configuration structure
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
+ * @param probe		pointer to an array of size probes (can be NULL)
+ * @param n_probes	number of size probes
  *
- * @return the size of the compressed entity header in bytes or an error code
- *	if it fails (which can be tested with cmp_is_error())
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
  */
 
-static uint32_t cmp_ent_build_chunk_header(uint32_t *entity, uint32_t chunk_size,
-					   const struct cmp_cfg *cfg, uint64_t start_timestamp,
-					   uint32_t cmp_ent_size_byte)
+static uint32_t compress_imagette_probed(const struct cmp_cfg *cfg,
+					 struct bit_encoder *enc,
+					 unsigned int variant,
+					 struct ima_size_probe *probe,
+					 unsigned int n_probes)
 {
-	if (entity) { /* setup the compressed entity header */
-		struct cmp_entity *ent = (struct cmp_entity *)entity;
-		int err = 0;
-
-		err |= cmp_ent_set_version_id(ent, version_identifier); /* set by compress_chunk_init */
-		err |= cmp_ent_set_size(ent, cmp_ent_size_byte);
-		err |= cmp_ent_set_original_size(ent, chunk_size);
-		err |= cmp_ent_set_data_type(ent, DATA_TYPE_CHUNK, cfg->cmp_mode == CMP_MODE_RAW);
-		err |= cmp_ent_set_cmp_mode(ent, cfg->cmp_mode);
-		err |= cmp_ent_set_model_value(ent, cfg->model_value);
-		/* model id/counter are set by the user with the compress_chunk_set_model_id_and_counter() */
-		err |= cmp_ent_set_model_id(ent, 0);
-		err |= cmp_ent_set_model_counter(ent, 0);
-		err |= cmp_ent_set_reserved(ent, 0);
-		err |= cmp_ent_set_lossy_cmp_par(ent, cfg->round);
-		if (cfg->cmp_mode != CMP_MODE_RAW) {
-			err |= cmp_ent_set_non_ima_spill1(ent, cfg->spill_par_1);
-			err |= cmp_ent_set_non_ima_cmp_par1(ent, cfg->cmp_par_1);
-			err |= cmp_ent_set_non_ima_spill2(ent, cfg->spill_par_2);
-			err |= cmp_ent_set_non_ima_cmp_par2(ent, cfg->cmp_par_2);
-			err |= cmp_ent_set_non_ima_spill3(ent, cfg->spill_par_3);
-			err |= cmp_ent_set_non_ima_cmp_par3(ent, cfg->cmp_par_3);
-			err |= cmp_ent_set_non_ima_spill4(ent, cfg->spill_par_4);
-			err |= cmp_ent_set_non_ima_cmp_par4(ent, cfg->cmp_par_4);
-			err |= cmp_ent_set_non_ima_spill5(ent, cfg->spill_par_5);
-			err |= cmp_ent_set_non_ima_cmp_par5(ent, cfg->cmp_par_5);
-			err |= cmp_ent_set_non_ima_spill6(ent, cfg->spill_par_6);
-			err |= cmp_ent_set_non_ima_cmp_par6(ent, cfg->cmp_par_6);
-		}
-		RETURN_ERROR_IF(err, ENTITY_HEADER, "");
-		RETURN_ERROR_IF(cmp_ent_set_start_timestamp(ent, start_timestamp),
-				ENTITY_TIMESTAMP, "");
-		RETURN_ERROR_IF(cmp_ent_set_end_timestamp(ent, get_timestamp()),
-				ENTITY_TIMESTAMP, "");
+	switch (variant) {
+	case 0:
+		return compress_imagette_generic(cfg, enc, 0, probe, n_probes);
+	case ENC_RICE:
+		return compress_imagette_generic(cfg, enc, ENC_RICE, probe, n_probes);
+	case ENC_MULTI:
+		return compress_imagette_generic(cfg, enc, ENC_MULTI, probe, n_probes);
+	case ENC_MULTI | ENC_RICE:
+		return compress_imagette_generic(cfg, enc, ENC_MULTI | ENC_RICE,
+						 probe, n_probes);
+	case ENC_SIZE_ONLY:
+		return compress_imagette_generic(cfg, enc, ENC_SIZE_ONLY, probe, n_probes);
+	case ENC_SIZE_ONLY | ENC_RICE:
+		return compress_imagette_generic(cfg, enc, ENC_SIZE_ONLY | ENC_RICE,
+						 probe, n_probes);
+	case ENC_SIZE_ONLY | ENC_MULTI:
+		return compress_imagette_generic(cfg, enc, ENC_SIZE_ONLY | ENC_MULTI,
+						 probe, n_probes);
+	case ENC_SIZE_ONLY | ENC_HISTOGRAM:
+		return compress_imagette_generic(cfg, enc, ENC_SIZE_ONLY | ENC_HISTOGRAM,
+						 probe, n_probes);
+	case ENC_SIZE_ONLY | ENC_MULTI | ENC_RICE:
+	default:
+		return compress_imagette_generic(cfg, enc,
+						 ENC_SIZE_ONLY | ENC_MULTI | ENC_RICE,
+						 probe, n_probes);
 	}
-
-	if (cfg->cmp_mode == CMP_MODE_RAW)
-		return GENERIC_HEADER_SIZE;
-	else
-		return NON_IMAGETTE_HEADER_SIZE;
 }
 
 
 /**
- * @brief Set the compression configuration from the compression parameters
- *	based on the chunk type of the collection
+ * @brief compress imagette data (without size probes)
  *
- * @param[in] col	pointer to a collection header
- * @param[in] par	pointer to a compression parameters struct
- * @param[out] cfg	pointer to a compression configuration
+ * @param cfg		pointer to the compression configuration structure
+ * @param enc		pointer to the bitstream encoder
+ * @param variant	encoder variant flags (see the ENC_* flags)
  *
- * @returns the chunk type of the collection
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
  */
 
-static enum chunk_type init_cmp_cfg_from_cmp_par(const struct collection_hdr *col,
-						 const struct cmp_par *par,
-						 struct cmp_cfg *cfg)
+static uint32_t compress_imagette(const struct cmp_cfg *cfg, struct bit_encoder *enc,
+				  unsigned int variant)
 {
-	enum chunk_type chunk_type = cmp_col_get_chunk_type(col);
+	return compress_imagette_probed(cfg, enc, variant, NULL, 0);
+}
 
-	memset(cfg, 0, sizeof(struct cmp_cfg));
+DEFINE_COMPRESS_FUNCTION(compress_s_fx)
+DEFINE_COMPRESS_FUNCTION(compress_s_fx_efx)
+DEFINE_COMPRESS_FUNCTION(compress_s_fx_ncob)
+DEFINE_COMPRESS_FUNCTION(compress_s_fx_efx_ncob_ecob)
+DEFINE_COMPRESS_FUNCTION(compress_l_fx)
+DEFINE_COMPRESS_FUNCTION(compress_l_fx_efx)
+DEFINE_COMPRESS_FUNCTION(compress_l_fx_ncob)
+DEFINE_COMPRESS_FUNCTION(compress_l_fx_efx_ncob_ecob)
+DEFINE_COMPRESS_FUNCTION(compress_offset)
+DEFINE_COMPRESS_FUNCTION(compress_background)
+DEFINE_COMPRESS_FUNCTION(compress_smearing)
 
-	/* the ranges of the parameters are checked in cmp_cfg_icu_is_invalid_error_code() */
-	cfg->cmp_mode = par->cmp_mode;
-	cfg->model_value = par->model_value;
-	if (par->lossy_par)
-		debug_print("Warning: lossy compression is not supported for chunk compression, lossy_par will be ignored.");
-	cfg->round = 0;
 
-	switch (chunk_type) {
-	case CHUNK_TYPE_NCAM_IMAGETTE:
-		cfg->cmp_par_imagette = par->nc_imagette;
-		cfg->spill_imagette = cmp_get_spill(cfg->cmp_par_imagette, cfg->cmp_mode,
-						    MAX_USED_BITS.nc_imagette);
+/**
+ * @brief select the encoder variant for the compression of a collection
+ *
+ * The Rice code word generator is used if all compression parameters used
+ * for the data type are a power of two, otherwise the Golomb code word
+ * generator is used (which forms the same code words for a power of two).
+ * If there is no destination buffer, only the length of the bitstream is
+ * calculated. If the configuration has residual histograms, the mapped
+ * residuals are only counted in them.
+ *
+ * @param cfg	pointer to the compression configuration structure
+ *
+ * @returns the encoder variant flags
+ */
+
+static unsigned int select_encoder_variant(const struct cmp_cfg *cfg)
+{
+	unsigned int variant = 0;
+	int rice;
+
+	if (cfg->col_hist)
+		return ENC_SIZE_ONLY | ENC_HISTOGRAM;
+
+	/* CMP_MODE_RAW is already handled before */
+	if (cfg->cmp_mode != CMP_MODE_MODEL_ZERO &&
+	    cfg->cmp_mode != CMP_MODE_DIFF_ZERO)
+		variant |= ENC_MULTI;
+
+	switch (cfg->data_type) {
+	case DATA_TYPE_IMAGETTE:
+	case DATA_TYPE_IMAGETTE_ADAPTIVE:
+	case DATA_TYPE_SAT_IMAGETTE:
+	case DATA_TYPE_SAT_IMAGETTE_ADAPTIVE:
+	case DATA_TYPE_F_CAM_IMAGETTE:
+	case DATA_TYPE_F_CAM_IMAGETTE_ADAPTIVE:
+		rice = is_a_pow_of_2(cfg->cmp_par_imagette);
 		break;
-	case CHUNK_TYPE_SAT_IMAGETTE:
-		cfg->cmp_par_imagette = par->saturated_imagette;
-		cfg->spill_imagette = cmp_get_spill(cfg->cmp_par_imagette, cfg->cmp_mode,
-						    MAX_USED_BITS.saturated_imagette);
+	case DATA_TYPE_S_FX:
+		rice = is_a_pow_of_2(cfg->cmp_par_exp_flags) &&
+			is_a_pow_of_2(cfg->cmp_par_fx);
 		break;
-	case CHUNK_TYPE_SHORT_CADENCE:
-		cfg->cmp_par_exp_flags = par->s_exp_flags;
-		cfg->spill_exp_flags = cmp_get_spill(cfg->cmp_par_exp_flags, cfg->cmp_mode,
-						     MAX_USED_BITS.s_exp_flags);
-		cfg->cmp_par_fx = par->s_fx;
-		cfg->spill_fx = cmp_get_spill(cfg->cmp_par_fx, cfg->cmp_mode,
-					      MAX_USED_BITS.s_fx);
-		cfg->cmp_par_ncob = par->s_ncob;
-		cfg->spill_ncob = cmp_get_spill(cfg->cmp_par_ncob, cfg->cmp_mode,
-						MAX_USED_BITS.s_ncob);
-		cfg->cmp_par_efx = par->s_efx;
-		cfg->spill_efx = cmp_get_spill(cfg->cmp_par_efx, cfg->cmp_mode,
-					       MAX_USED_BITS.s_efx);
-		cfg->cmp_par_ecob = par->s_ecob;
-		cfg->spill_ecob = cmp_get_spill(cfg->cmp_par_ecob, cfg->cmp_mode,
-						MAX_USED_BITS.s_ecob);
+	case DATA_TYPE_S_FX_EFX:
+		rice = is_a_pow_of_2(cfg->cmp_par_exp_flags) &&
+			is_a_pow_of_2(cfg->cmp_par_fx) &&
+			is_a_pow_of_2(cfg->cmp_par_efx);
 		break;
-	case CHUNK_TYPE_LONG_CADENCE:
-		cfg->cmp_par_exp_flags = par->l_exp_flags;
-		cfg->spill_exp_flags = cmp_get_spill(cfg->cmp_par_exp_flags, cfg->cmp_mode,
-						     MAX_USED_BITS.l_exp_flags);
-		cfg->cmp_par_fx = par->l_fx;
-		cfg->spill_fx = cmp_get_spill(cfg->cmp_par_fx, cfg->cmp_mode,
-					      MAX_USED_BITS.l_fx);
-		cfg->cmp_par_ncob = par->l_ncob;
-		cfg->spill_ncob = cmp_get_spill(cfg->cmp_par_ncob, cfg->cmp_mode,
-						MAX_USED_BITS.l_ncob);
-		cfg->cmp_par_efx = par->l_efx;
-		cfg->spill_efx = cmp_get_spill(cfg->cmp_par_efx, cfg->cmp_mode,
-					       MAX_USED_BITS.l_efx);
-		cfg->cmp_par_ecob = par->l_ecob;
-		cfg->spill_ecob = cmp_get_spill(cfg->cmp_par_ecob, cfg->cmp_mode,
-						MAX_USED_BITS.l_ecob);
-		cfg->cmp_par_fx_cob_variance = par->l_fx_cob_variance;
-		cfg->spill_fx_cob_variance = cmp_get_spill(cfg->cmp_par_fx_cob_variance,
-							   cfg->cmp_mode, MAX_USED_BITS.l_fx_cob_variance);
+	case DATA_TYPE_S_FX_NCOB:
+		rice = is_a_pow_of_2(cfg->cmp_par_exp_flags) &&
+			is_a_pow_of_2(cfg->cmp_par_fx) &&
+			is_a_pow_of_2(cfg->cmp_par_ncob);
 		break;
-	case CHUNK_TYPE_OFFSET_BACKGROUND:
-		cfg->cmp_par_offset_mean = par->nc_offset_mean;
-		cfg->spill_offset_mean = cmp_get_spill(cfg->cmp_par_offset_mean,
-						cfg->cmp_mode, MAX_USED_BITS.nc_offset_mean);
-		cfg->cmp_par_offset_variance = par->nc_offset_variance;
-		cfg->spill_offset_variance = cmp_get_spill(cfg->cmp_par_offset_variance,
-						cfg->cmp_mode, MAX_USED_BITS.nc_offset_variance);
-		cfg->cmp_par_background_mean = par->nc_background_mean;
-		cfg->spill_background_mean = cmp_get_spill(cfg->cmp_par_background_mean,
-						cfg->cmp_mode, MAX_USED_BITS.nc_background_mean);
-		cfg->cmp_par_background_variance = par->nc_background_variance;
-		cfg->spill_background_variance = cmp_get_spill(cfg->cmp_par_background_variance,
-						cfg->cmp_mode, MAX_USED_BITS.nc_background_variance);
-		cfg->cmp_par_background_pixels_error = par->nc_background_outlier_pixels;
-		cfg->spill_background_pixels_error = cmp_get_spill(cfg->cmp_par_background_pixels_error,
-						cfg->cmp_mode, MAX_USED_BITS.nc_background_outlier_pixels);
+	case DATA_TYPE_S_FX_EFX_NCOB_ECOB:
+		rice = is_a_pow_of_2(cfg->cmp_par_exp_flags) &&
+			is_a_pow_of_2(cfg->cmp_par_fx) &&
+			is_a_pow_of_2(cfg->cmp_par_ncob) &&
+			is_a_pow_of_2(cfg->cmp_par_efx) &&
+			is_a_pow_of_2(cfg->cmp_par_ecob);
+		break;
+	case DATA_TYPE_L_FX:
+		rice = is_a_pow_of_2(cfg->cmp_par_exp_flags) &&
+			is_a_pow_of_2(cfg->cmp_par_fx) &&
+			is_a_pow_of_2(cfg->cmp_par_fx_cob_variance);
+		break;
+	case DATA_TYPE_L_FX_EFX:
+		rice = is_a_pow_of_2(cfg->cmp_par_exp_flags) &&
+			is_a_pow_of_2(cfg->cmp_par_fx) &&
+			is_a_pow_of_2(cfg->cmp_par_efx) &&
+			is_a_pow_of_2(cfg->cmp_par_fx_cob_variance);
+		break;
+	case DATA_TYPE_L_FX_NCOB:
+		rice = is_a_pow_of_2(cfg->cmp_par_exp_flags) &&
+			is_a_pow_of_2(cfg->cmp_par_fx) &&
+			is_a_pow_of_2(cfg->cmp_par_ncob) &&
+			is_a_pow_of_2(cfg->cmp_par_fx_cob_variance);
+		break;
+	case DATA_TYPE_L_FX_EFX_NCOB_ECOB:
+		rice = is_a_pow_of_2(cfg->cmp_par_exp_flags) &&
+			is_a_pow_of_2(cfg->cmp_par_fx) &&
+			is_a_pow_of_2(cfg->cmp_par_ncob) &&
+			is_a_pow_of_2(cfg->cmp_par_efx) &&
+			is_a_pow_of_2(cfg->cmp_par_ecob) &&
+			is_a_pow_of_2(cfg->cmp_par_fx_cob_variance);
 		break;
+	case DATA_TYPE_OFFSET:
+	case DATA_TYPE_F_CAM_OFFSET:
+		rice = is_a_pow_of_2(cfg->cmp_par_offset_mean) &&
+			is_a_pow_of_2(cfg->cmp_par_offset_variance);
+		break;
+	case DATA_TYPE_BACKGROUND:
+	case DATA_TYPE_F_CAM_BACKGROUND:
+		rice = is_a_pow_of_2(cfg->cmp_par_background_mean) &&
+			is_a_pow_of_2(cfg->cmp_par_background_variance) &&
+			is_a_pow_of_2(cfg->cmp_par_background_pixels_error);
+		break;
+	case DATA_TYPE_SMEARING:
+		rice = is_a_pow_of_2(cfg->cmp_par_smearing_mean) &&
+			is_a_pow_of_2(cfg->cmp_par_smearing_variance) &&
+			is_a_pow_of_2(cfg->cmp_par_smearing_pixels_error);
+		break;
+	default:
+		rice = 0;
+		break;
+	}
 
-	case CHUNK_TYPE_SMEARING:
-		cfg->cmp_par_smearing_mean = par->smearing_mean;
-		cfg->spill_smearing_mean = cmp_get_spill(cfg->cmp_par_smearing_mean,
-						cfg->cmp_mode, MAX_USED_BITS.smearing_mean);
-		cfg->cmp_par_smearing_variance = par->smearing_variance_mean;
-		cfg->spill_smearing_variance = cmp_get_spill(cfg->cmp_par_smearing_variance,
-						cfg->cmp_mode, MAX_USED_BITS.smearing_variance_mean);
-		cfg->cmp_par_smearing_pixels_error = par->smearing_outlier_pixels;
-		cfg->spill_smearing_pixels_error = cmp_get_spill(cfg->cmp_par_smearing_pixels_error,
-						cfg->cmp_mode, MAX_USED_BITS.smearing_outlier_pixels);
+	if (rice)
+		variant |= ENC_RICE;
+
+	if (!cfg->dst)
+		variant |= ENC_SIZE_ONLY;
+
+	return variant;
+}
+
+
+/**
+ * @brief check if two buffers are overlapping
+ * @see https://stackoverflow.com/a/325964
+ *
+ * @param buf_a		start address of the 1st buffer (can be NULL)
+ * @param size_a	byte size of the 1st buffer
+ * @param buf_b		start address of the 2nd buffer (can be NULL)
+ * @param size_b	byte size of the 2nd buffer
+ *
+ * @returns 0 if buffers are not overlapping, otherwise buffers are
+ *	overlapping
+ */
+
+static int buffer_overlaps(const void *buf_a, size_t size_a,
+			   const void *buf_b, size_t size_b)
+{
+	if (!buf_a)
+		return 0;
+
+	if (!buf_b)
+		return 0;
+
+	if ((const char *)buf_a < (const char *)buf_b + size_b &&
+	    (const char *)buf_b < (const char *)buf_a + size_a)
+		return 1;
+
+	return 0;
+}
+
+
+/**
+ * @brief fill the last part of the bitstream with zeros
+ *
+ * @param enc	pointer to the bitstream encoder
+ *
+ * @returns the bit length of the bitstream (without the padding) on success or
+ *	an error code if it fails (which can be tested with cmp_is_error())
+ */
+
+static uint32_t pad_bitstream(struct bit_encoder *enc)
+{
+	uint32_t const cmp_size = enc->stream_len;
+	unsigned int const n_pad_bits = 32 - (cmp_size & 0x1FU);
+
+	if (n_pad_bits < 32)
+		FORWARD_IF_ERROR(bit_write_bits32(enc, 0, n_pad_bits), "");
+
+	return cmp_size;
+}
+
+
+/**
+ * @brief internal data compression function
+ * This function can compress all types of collection data (one at a time).
+ * This function does not take the header of a collection into account.
+ *
+ * @param cfg		pointer to the compression configuration structure
+ * @param stream_len	already used length of the bitstream in bits
+ *
+ * @note the validity of the cfg structure is not checked
+ *
+ * @returns the bit length of the bitstream on success or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ */
+
+static uint32_t compress_data_internal(const struct cmp_cfg *cfg, uint32_t stream_len)
+{
+	uint32_t bitsize;
+	unsigned int variant;
+	struct bit_encoder enc;
+
+	FORWARD_IF_ERROR(stream_len, "");
+	RETURN_ERROR_IF(cfg == NULL, GENERIC, "");
+	RETURN_ERROR_IF(stream_len & 0x7, GENERIC, "The stream_len parameter must be a multiple of 8.");
+
+	if (cfg->samples == 0) /* nothing to compress we are done */
+		return stream_len;
+
+	if (raw_mode_is_used(cfg->cmp_mode)) {
+		uint32_t raw_size = cfg->samples * (uint32_t)size_of_a_sample(cfg->data_type);
+
+		if (cfg->dst) {
+			uint32_t offset_bytes = stream_len >> 3;
+			uint8_t *p = (uint8_t *)cfg->dst + offset_bytes;
+			uint32_t new_stream_size = offset_bytes + raw_size;
+
+			RETURN_ERROR_IF(new_stream_size > cfg->stream_size, SMALL_BUFFER, "");
+			memcpy(p, cfg->src, raw_size);
+			RETURN_ERROR_IF(cpu_to_be_data_type(p, raw_size, cfg->data_type),
+					INT_DATA_TYPE_UNSUPPORTED, "");
+		}
+		return stream_len + raw_size * 8; /* convert to bits */
+	}
+
+	bit_init_encoder(&enc, cfg->dst, cmp_stream_size_to_bits(cfg->stream_size),
+			 stream_len);
+	variant = select_encoder_variant(cfg);
+
+	switch (cfg->data_type) {
+	case DATA_TYPE_IMAGETTE:
+	case DATA_TYPE_IMAGETTE_ADAPTIVE:
+	case DATA_TYPE_SAT_IMAGETTE:
+	case DATA_TYPE_SAT_IMAGETTE_ADAPTIVE:
+	case DATA_TYPE_F_CAM_IMAGETTE:
+	case DATA_TYPE_F_CAM_IMAGETTE_ADAPTIVE:
+		bitsize = compress_imagette(cfg, &enc, variant);
 		break;
 
-	case CHUNK_TYPE_F_CHAIN:
-		cfg->cmp_par_imagette = par->fc_imagette;
-		cfg->spill_imagette = cmp_get_spill(cfg->cmp_par_imagette,
-						cfg->cmp_mode, MAX_USED_BITS.fc_imagette);
+	case DATA_TYPE_S_FX:
+		bitsize = compress_s_fx(cfg, &enc, variant);
+		break;
+	case DATA_TYPE_S_FX_EFX:
+		bitsize = compress_s_fx_efx(cfg, &enc, variant);
+		break;
+	case DATA_TYPE_S_FX_NCOB:
+		bitsize = compress_s_fx_ncob(cfg, &enc, variant);
+		break;
+	case DATA_TYPE_S_FX_EFX_NCOB_ECOB:
+		bitsize = compress_s_fx_efx_ncob_ecob(cfg, &enc, variant);
+		break;
 
-		cfg->cmp_par_offset_mean = par->fc_offset_mean;
-		cfg->spill_offset_mean = cmp_get_spill(cfg->cmp_par_offset_mean,
-						cfg->cmp_mode, MAX_USED_BITS.fc_offset_mean);
-		cfg->cmp_par_offset_variance = par->fc_offset_variance;
-		cfg->spill_offset_variance = cmp_get_spill(cfg->cmp_par_offset_variance,
-						cfg->cmp_mode, MAX_USED_BITS.fc_offset_variance);
 
-		cfg->cmp_par_background_mean = par->fc_background_mean;
-		cfg->spill_background_mean = cmp_get_spill(cfg->cmp_par_background_mean,
-						cfg->cmp_mode, MAX_USED_BITS.fc_background_mean);
-		cfg->cmp_par_background_variance = par->fc_background_variance;
-		cfg->spill_background_variance = cmp_get_spill(cfg->cmp_par_background_variance,
-						cfg->cmp_mode, MAX_USED_BITS.fc_background_variance);
-		cfg->cmp_par_background_pixels_error = par->fc_background_outlier_pixels;
-		cfg->spill_background_pixels_error = cmp_get_spill(cfg->cmp_par_background_pixels_error,
-						cfg->cmp_mode, MAX_USED_BITS.fc_background_outlier_pixels);
+	case DATA_TYPE_L_FX:
+		bitsize = compress_l_fx(cfg, &enc, variant);
+		break;
+	case DATA_TYPE_L_FX_EFX:
+		bitsize = compress_l_fx_efx(cfg, &enc, variant);
+		break;
+	case DATA_TYPE_L_FX_NCOB:
+		bitsize = compress_l_fx_ncob(cfg, &enc, variant);
+		break;
+	case DATA_TYPE_L_FX_EFX_NCOB_ECOB:
+		bitsize = compress_l_fx_efx_ncob_ecob(cfg, &enc, variant);
+		break;
+
+	case DATA_TYPE_OFFSET:
+	case DATA_TYPE_F_CAM_OFFSET:
+		bitsize = compress_offset(cfg, &enc, variant);
+		break;
+	case DATA_TYPE_BACKGROUND:
+	case DATA_TYPE_F_CAM_BACKGROUND:
+		bitsize = compress_background(cfg, &enc, variant);
+		break;
+	case DATA_TYPE_SMEARING:
+		bitsize = compress_smearing(cfg, &enc, variant);
+		break;
+
+	case DATA_TYPE_F_FX:
+	case DATA_TYPE_F_FX_EFX:
+	case DATA_TYPE_F_FX_NCOB:
+	case DATA_TYPE_F_FX_EFX_NCOB_ECOB:
+	case DATA_TYPE_CHUNK:
+	case DATA_TYPE_UNKNOWN:
+	default:
+		RETURN_ERROR(INT_DATA_TYPE_UNSUPPORTED, "");
+	}
+
+	if (cmp_is_error(bitsize))
+		return bitsize;
+
+	return pad_bitstream(&enc);
+}
+
+
+/**
+ * @brief check if the ICU buffer parameters are invalid
+ *
+ * @param cfg	pointer to the compressor configuration to check
+ *
+ * @returns 0 if the buffer parameters are valid, otherwise invalid
+ */
+
+static uint32_t check_compression_buffers(const struct cmp_cfg *cfg)
+{
+	size_t data_size;
+
+	RETURN_ERROR_IF(cfg == NULL, GENERIC, "");
+
+	RETURN_ERROR_IF(cfg->src == NULL, CHUNK_NULL, "");
+
+	data_size = size_of_a_sample(cfg->data_type) * cfg->samples;
+
+	if (cfg->samples == 0)
+		debug_print("Warning: The samples parameter is 0. No data are compressed. This behavior may not be intended.");
+
+	RETURN_ERROR_IF(buffer_overlaps(cfg->dst, cfg->stream_size,
+					cfg->src, data_size), PAR_BUFFERS,
+		"The compressed data buffer and the data to compress buffer are overlapping.");
+
+	if (model_mode_is_used(cfg->cmp_mode)) {
+		RETURN_ERROR_IF(cfg->model_buf == NULL, PAR_NO_MODEL, "");
+
+		RETURN_ERROR_IF(buffer_overlaps(cfg->model_buf, data_size,
+						cfg->src, data_size), PAR_BUFFERS,
+				"The model buffer and the data to compress buffer are overlapping.");
+		RETURN_ERROR_IF(buffer_overlaps(cfg->model_buf, data_size,
+						cfg->dst, cfg->stream_size), PAR_BUFFERS,
+				"The model buffer and the compressed data buffer are overlapping.");
+
+		RETURN_ERROR_IF(buffer_overlaps(cfg->updated_model_buf, data_size,
+						cfg->src, data_size), PAR_BUFFERS,
+				"The updated model buffer and the data to compress buffer are overlapping.");
+		RETURN_ERROR_IF(buffer_overlaps(cfg->updated_model_buf, data_size,
+						cfg->dst, cfg->stream_size), PAR_BUFFERS,
+				"The updated model buffer and the compressed data buffer are overlapping.");
+	}
+
+	return CMP_ERROR(NO_ERROR);
+}
+
+
+/**
+ * @brief checks if the compression parameters of an ICU compression
+ *	configuration are valid; the buffers are not checked
+ *
+ * @param cfg	pointer to the cmp_cfg structure to be validated
+ *
+ * @returns an error code if any of the compression parameters are invalid,
+ *	otherwise returns CMP_ERROR_NO_ERROR
+ */
+
+static uint32_t cmp_cfg_icu_par_is_invalid_error_code(const struct cmp_cfg *cfg)
+{
+	RETURN_ERROR_IF(cmp_cfg_gen_par_is_invalid(cfg), PAR_GENERIC, "");
+
+	if (cmp_imagette_data_type_is_used(cfg->data_type))
+		RETURN_ERROR_IF(cmp_cfg_imagette_is_invalid(cfg), PAR_SPECIFIC, "");
+	else if (cmp_fx_cob_data_type_is_used(cfg->data_type))
+		RETURN_ERROR_IF(cmp_cfg_fx_cob_is_invalid(cfg), PAR_SPECIFIC, "");
+	else
+		RETURN_ERROR_IF(cmp_cfg_aux_is_invalid(cfg), PAR_SPECIFIC, "");
+
+	return CMP_ERROR(NO_ERROR);
+}
+
+
+/**
+ * @brief checks if the ICU compression configuration is valid
+ *
+ * @param cfg	pointer to the cmp_cfg structure to be validated
+ *
+ * @returns an error code if any of the configuration parameters are invalid,
+ *	otherwise returns CMP_ERROR_NO_ERROR on valid configuration
+ */
+
+static uint32_t cmp_cfg_icu_is_invalid_error_code(const struct cmp_cfg *cfg)
+{
+	FORWARD_IF_ERROR(cmp_cfg_icu_par_is_invalid_error_code(cfg), "");
+
+	FORWARD_IF_ERROR(check_compression_buffers(cfg), "");
+
+	return CMP_ERROR(NO_ERROR);
+}
+
+
+/**
+ * @brief calculate the optimal spill threshold value for zero escape mechanism
+ *
+ * @param golomb_par	Golomb parameter
+ * @param max_data_bits	maximum number of used data bits
+ *
+ * @returns the highest optimal spill threshold value for a given Golomb
+ *	parameter, when the zero escape mechanism is used or 0 if the
+ *	Golomb parameter is not valid
+ */
+
+static uint32_t cmp_best_zero_spill(uint32_t golomb_par, uint32_t max_data_bits)
+{
+	uint32_t const max_spill = cmp_icu_max_spill(golomb_par);
+	uint32_t cutoff;
+	uint32_t spill;
+
+	if (golomb_par < MIN_NON_IMA_GOLOMB_PAR)
+		return 0;
+	if (golomb_par > MAX_NON_IMA_GOLOMB_PAR)
+		return 0;
+
+	cutoff = (0x2U << ilog_2(golomb_par)) - golomb_par;
+	spill = max_data_bits * golomb_par + cutoff;
+	if (spill > max_spill)
+		spill = max_spill;
+
+	return spill;
+}
+
+
+/**
+ * @brief estimate a "good" spillover threshold parameter
+ *
+ * @param golomb_par	Golomb parameter
+ * @param cmp_mode	compression mode
+ * @param max_data_bits	maximum number of used data bits
+ *
+ * @returns a spillover threshold parameter or 0 if the Golomb parameter is not
+ *	valid
+ */
+
+static uint32_t cmp_get_spill(uint32_t golomb_par, enum cmp_mode cmp_mode,
+			      uint32_t max_data_bits)
+{
+	if (zero_escape_mech_is_used(cmp_mode))
+		return cmp_best_zero_spill(golomb_par, max_data_bits);
+
+	return cmp_icu_max_spill(golomb_par);
+}
+
+
+/**
+ * @brief set the compressed collection size field
+ *
+ * @param cmp_col_size_field	pointer to the compressed collection size field
+ * @param cmp_col_size		size of the compressed collection (not including
+ *				the compressed collection header size and the
+ *				size of the compressed collection size field
+ *				itself)
+ *
+ * @returns error code
+ */
+
+static uint32_t set_cmp_col_size(uint8_t *cmp_col_size_field, uint32_t cmp_col_size)
+{
+	uint16_t const v = cpu_to_be16((uint16_t)cmp_col_size);
+
+	RETURN_ERROR_IF(cmp_col_size > UINT16_MAX, INT_CMP_COL_TOO_LARGE,
+			"%"PRIu32" is bigger than the maximum allowed compression collection size", cmp_col_size_field);
+
+	memcpy(cmp_col_size_field, &v, CMP_COLLECTION_FILD_SIZE);
+
+	return 0;
+}
+
+
+/**
+ * @brief check if the data of a collection are identical to its model
+ *
+ * In a lossless model mode all residuals of such a collection are zero. If
+ * enabled with cmp_ctx_set_equal_model(), the collection is then stored
+ * without compressed data (a compressed data size of zero) and the updated
+ * model is a copy of the data.
+ *
+ * @param cfg	pointer to a compression configuration of the collection
+ *
+ * @returns non-zero if the shortcut is enabled and the collection data are
+ *	equal to the model data
+ */
+
+static int collection_equals_model(const struct cmp_cfg *cfg)
+{
+	uint32_t const data_size = cfg->samples * size_of_a_sample(cfg->data_type);
+
+	if (!cfg->equal_model || !model_mode_is_used(cfg->cmp_mode) || cfg->round ||
+	    !data_size)
+		return 0;
+
+	return memcmp(cfg->src, cfg->model_buf, data_size) == 0;
+}
+
+
+/**
+ * @brief highest compression parameter tried by select_col_pars(); all powers
+ *	of two up to this value are tried
+ */
+
+#define COL_PAR_MAX_CANDIDATE	0x8000U
+
+
+/**
+ * @brief collect the residual histograms of the parameter slots of a
+ *	collection
+ *
+ * The collection is run through the compression with the ENC_HISTOGRAM
+ * variant, which counts the mapped residuals instead of encoding them. The
+ * residuals do not depend on the compression parameters, so the parameters
+ * of the configuration are replaced by the slot numbers; this way every
+ * encoder setup finds the histogram of its slot (see configure_encoder_setup()).
+ *
+ * @param cfg	pointer to the compression configuration of the collection
+ * @param hist	pointer to an array of CMP_COL_PAR_SLOTS histograms
+ *
+ * @returns zero on success; non-zero if the residuals could not be collected
+ *	(e.g. a value is too large)
+ */
+
+static int collect_col_hist(const struct cmp_cfg *cfg, struct col_hist *hist)
+{
+	struct cmp_cfg probe = *cfg;
+	unsigned int slot;
+
+	memset(hist, 0, CMP_COL_PAR_SLOTS * sizeof(*hist));
+	for (slot = 1; slot <= CMP_COL_PAR_SLOTS; slot++)
+		cmp_cfg_set_par_slot(&probe, slot, slot, MIN_NON_IMA_SPILL);
+	probe.dst = NULL;
+	probe.updated_model_buf = NULL;
+	probe.cw_cache = NULL;
+	probe.col_hist = hist;
+
+	return cmp_is_error(compress_data_internal(&probe, 0));
+}
+
+
+/**
+ * @brief estimate the bit length of the residuals of a histogram encoded with
+ *	a pair of compression parameters
+ *
+ * Every residual is accounted for with the value in the middle of its bucket.
+ *
+ * @param hist		pointer to the residual histogram of a parameter slot
+ * @param cmp_par	compression parameter
+ * @param spill		spillover threshold parameter
+ * @param cfg		pointer to the compression configuration of the
+ *			collection (without a code word table cache)
+ *
+ * @returns the estimated bit length; UINT32_MAX if a code word would be longer
+ *	than 32 bits
+ */
+
+static uint32_t col_hist_cost(const struct col_hist *hist, uint32_t cmp_par,
+			      uint32_t spill, const struct cmp_cfg *cfg)
+{
+	struct encoder_setup setup;
+	unsigned int variant = 0;
+	uint32_t invalid = 0;
+	uint32_t bits = 0;
+	unsigned int b;
+
+	configure_encoder_setup(&setup, NULL, cmp_par, spill, 0,
+				hist->max_data_bits, cfg);
+	if (multi_escape_mech_is_used(cfg->cmp_mode))
+		variant |= ENC_MULTI;
+	if (is_a_pow_of_2(cmp_par))
+		variant |= ENC_RICE;
+
+	for (b = 0; b < COL_HIST_BUCKETS; b++) {
+		uint32_t value;
+
+		if (!hist->count[b])
+			continue;
+		/* the middle of the values with a bit length of b */
+		value = b ? (1U << (b-1)) + ((1U << (b-1)) >> 1) : 0;
+		bits += hist->count[b] * encoded_mapped_len(value, &setup, variant, &invalid);
+	}
+
+	return invalid ? UINT32_MAX : bits;
+}
+
+
+/**
+ * @brief select compression parameters for the data of a collection
+ *
+ * For every parameter slot used by the data type of the collection, the power
+ * of two compression parameter (with the spillover threshold of
+ * cmp_get_spill()) with the shortest estimated bit length of the residual
+ * histogram is searched. It overrides the parameter of the chunk if the
+ * estimated saving is larger than the size of an override. The overrides are
+ * only used if the collection compressed with them is really smaller,
+ * including the size of the overrides.
+ *
+ * The parameter override field consists of a bit mask of the overridden
+ * slots (bit 0 for slot 1) followed by a 24-bit spillover threshold and a
+ * 16-bit compression parameter (big-endian) for every overridden slot in
+ * ascending order.
+ *
+ * @param cfg		pointer to the compression configuration of the
+ *			collection; the selected overrides are set in it
+ * @param pars_field	pointer to a buffer of CMP_COL_PARS_MAX_SIZE bytes
+ *			where the parameter override field is stored
+ *
+ * @returns the byte size of the parameter override field
+ */
+
+static uint32_t select_col_pars(struct cmp_cfg *cfg, uint8_t *pars_field)
+{
+	struct col_hist hist[CMP_COL_PAR_SLOTS];
+	struct cmp_cfg est, ovr;
+	uint32_t pars_size = CMP_COL_PAR_MASK_SIZE;
+	uint32_t base_bits, ovr_bits;
+	uint8_t mask = 0;
+	unsigned int slot;
+
+	pars_field[0] = 0;
+	if (cfg->samples == 0 || collect_col_hist(cfg, hist))
+		return CMP_COL_PAR_MASK_SIZE;
+
+	est = *cfg;
+	est.dst = NULL;
+	est.updated_model_buf = NULL;
+	est.cw_cache = NULL;
+	ovr = est;
+
+	for (slot = 1; slot <= CMP_COL_PAR_SLOTS; slot++) {
+		const struct col_hist *h = &hist[slot-1];
+		uint32_t cmp_par, spill, par, chunk_bits, best_bits;
+		uint32_t best_par = 0, best_spill = 0;
+		uint8_t *p = pars_field + pars_size;
+
+		if (!h->max_data_bits) /* slot not used by the data type */
+			continue;
+
+		cmp_cfg_get_par_slot(cfg, slot, &cmp_par, &spill);
+		chunk_bits = col_hist_cost(h, cmp_par, spill, &est);
+		best_bits = chunk_bits;
+		for (par = 1; par <= COL_PAR_MAX_CANDIDATE; par <<= 1) {
+			uint32_t const par_spill = cmp_get_spill(par, cfg->cmp_mode,
+								 h->max_data_bits);
+			uint32_t const bits = col_hist_cost(h, par, par_spill, &est);
+
+			if (bits < best_bits) {
+				best_bits = bits;
+				best_par = par;
+				best_spill = par_spill;
+			}
+		}
+		if (!best_par || chunk_bits - best_bits <= CMP_COL_PAR_SIZE * 8)
+			continue;
+
+		cmp_cfg_set_par_slot(&ovr, slot, best_par, best_spill);
+		mask |= (uint8_t)(1U << (slot-1));
+		p[0] = (uint8_t)(best_spill >> 16);
+		p[1] = (uint8_t)(best_spill >> 8);
+		p[2] = (uint8_t)best_spill;
+		p[3] = (uint8_t)(best_par >> 8);
+		p[4] = (uint8_t)best_par;
+		pars_size += CMP_COL_PAR_SIZE;
+	}
+	if (!mask)
+		return CMP_COL_PAR_MASK_SIZE;
+
+	base_bits = compress_data_internal(&est, 0);
+	ovr_bits = compress_data_internal(&ovr, 0);
+	if (cmp_is_error(base_bits) || cmp_is_error(ovr_bits) ||
+	    cmp_bit_to_byte(ovr_bits) + pars_size - CMP_COL_PAR_MASK_SIZE >=
+	    cmp_bit_to_byte(base_bits))
+		return CMP_COL_PAR_MASK_SIZE;
+
+	for (slot = 1; slot <= CMP_COL_PAR_SLOTS; slot++) {
+		uint32_t cmp_par, spill;
+
+		cmp_cfg_get_par_slot(&ovr, slot, &cmp_par, &spill);
+		cmp_cfg_set_par_slot(cfg, slot, cmp_par, spill);
+	}
+	pars_field[0] = mask;
+	return pars_size;
+}
+
+
+/**
+ * @brief check a collection and set up the compression configuration for it
+ *
+ * @param col		pointer to a collection header
+ * @param model		pointer to the model to be used for compression, or NULL
+ *			if not applicable
+ * @param updated_model	pointer to the buffer where the updated model will be
+ *			stored, or NULL if not applicable
+ * @param dst		pointer to the buffer where the compressed data will be
+ *			stored, or NULL to only get the compressed data size
+ * @param dst_capacity	the size of the dst buffer in bytes
+ * @param cfg		pointer to a compression configuration
+ *
+ * @returns CMP_ERROR_NO_ERROR on success or an error code if the collection
+ *	or the configuration is invalid (which can be tested with
+ *	cmp_is_error())
+ */
+
+static uint32_t setup_collection_cfg(const uint8_t *col,
+				     const uint8_t *model, uint8_t *updated_model,
+				     uint32_t *dst, uint32_t dst_capacity,
+				     struct cmp_cfg *cfg)
+{
+	const struct collection_hdr *col_hdr = (const struct collection_hdr *)col;
+	uint16_t const col_data_length = cmp_col_get_data_length(col_hdr);
+	uint16_t sample_size;
+	compile_time_assert(DATA_TYPE_CHUNK < bitsizeof(cfg->checked_data_types),
+			    CMP_CHECKED_DATA_TYPES_MASK_TO_SMALL);
+
+	/* sanity check of the collection header */
+	cfg->data_type = convert_subservice_to_cmp_data_type(cmp_col_get_subservice(col_hdr));
+	sample_size = (uint16_t)size_of_a_sample(cfg->data_type);
+	RETURN_ERROR_IF(col_data_length % sample_size, COL_SIZE_INCONSISTENT,
+			"col_data_length: %u %% sample_size: %u != 0", col_data_length, sample_size);
+	cfg->samples = col_data_length/sample_size;
+
+	/* prepare the different buffers */
+	cfg->src = col + COLLECTION_HDR_SIZE;
+	if (model)
+		cfg->model_buf = model + COLLECTION_HDR_SIZE;
+	if (updated_model)
+		cfg->updated_model_buf = updated_model + COLLECTION_HDR_SIZE;
+	cfg->dst = dst;
+	cfg->stream_size = dst_capacity;
+
+	/*
+	 * The compression parameters are the same for all collections of a
+	 * chunk; they only have to be checked once per data type. The buffers
+	 * are different for every collection and are always checked.
+	 */
+	if (!(cfg->checked_data_types & (1U << cfg->data_type))) {
+		FORWARD_IF_ERROR(cmp_cfg_icu_par_is_invalid_error_code(cfg), "");
+		cfg->checked_data_types |= 1U << cfg->data_type;
+	}
+	FORWARD_IF_ERROR(check_compression_buffers(cfg), "");
+
+	return CMP_ERROR(NO_ERROR);
+}
+
+
+/**
+ * @brief compresses a collection (with a collection header followed by data)
+ *
+ * @param col		pointer to a collection header
+ * @param model		pointer to the model to be used for compression, or NULL
+ *			if not applicable
+ * @param updated_model	pointer to the buffer where the updated model will be
+ *			stored, or NULL if not applicable
+ * @param dst		pointer to the buffer where the compressed data will be
+ *			stored, or NULL to only get the compressed data size
+ * @param dst_capacity	the size of the dst buffer in bytes
+ * @param cfg		pointer to a compression configuration
+ * @param dst_size	the already used size of the dst buffer in bytes
+ *
+ * @note if cfg->col_pars is set, the data of a compressed (not raw)
+ *	collection are followed by a parameter override field (see
+ *	select_col_pars())
+ *
+ * @note if cfg->equal_model is set, a collection with data identical to its
+ *	model is stored without compressed data (see collection_equals_model())
+ *
+ * @returns the size of the compressed data in bytes (new dst_size) on
+ *	success or an error code if it fails (which can be tested with
+ *	cmp_is_error())
+ */
+
+static uint32_t cmp_collection(const uint8_t *col,
+			       const uint8_t *model, uint8_t *updated_model,
+			       uint32_t *dst, uint32_t dst_capacity,
+			       struct cmp_cfg *cfg, uint32_t dst_size)
+{
+	uint32_t const dst_size_begin = dst_size;
+	uint32_t dst_size_bits;
+	const struct collection_hdr *col_hdr = (const struct collection_hdr *)col;
+	uint16_t const col_data_length = cmp_col_get_data_length(col_hdr);
+	struct cmp_cfg col_cfg;
+	uint8_t pars_field[CMP_COL_PARS_MAX_SIZE];
+	uint32_t pars_size = 0;
+
+	FORWARD_IF_ERROR(setup_collection_cfg(col, model, updated_model, dst,
+					      dst_capacity, cfg), "");
+
+	if (collection_equals_model(cfg)) {
+		/* only the collection header with a compressed data size of 0 */
+		if (dst) {
+			RETURN_ERROR_IF(dst_size + CMP_COLLECTION_FILD_SIZE + COLLECTION_HDR_SIZE >
+					dst_capacity, SMALL_BUFFER, "");
+			FORWARD_IF_ERROR(set_cmp_col_size((uint8_t *)dst + dst_size, 0), "");
+			memcpy((uint8_t *)dst + dst_size + CMP_COLLECTION_FILD_SIZE, col,
+			       COLLECTION_HDR_SIZE);
+		}
+		if (updated_model)
+			memcpy(updated_model, col, COLLECTION_HDR_SIZE + col_data_length);
+		return dst_size + CMP_COLLECTION_FILD_SIZE + COLLECTION_HDR_SIZE;
+	}
+
+	if (cfg->col_pars && cfg->cmp_mode != CMP_MODE_RAW) {
+		/* the parameter overrides only apply to this collection */
+		col_cfg = *cfg;
+		cfg = &col_cfg;
+		pars_size = select_col_pars(cfg, pars_field);
+	}
+
+	if (cfg->cmp_mode != CMP_MODE_RAW) {
+		/* hear we reserve space for the compressed data size field */
+		dst_size += CMP_COLLECTION_FILD_SIZE;
+	}
+
+	/* we do not compress the collection header, we simply copy the header
+	 * into the compressed data
+	 */
+	if (dst) {
+		RETURN_ERROR_IF(dst_size + COLLECTION_HDR_SIZE > dst_capacity,
+				SMALL_BUFFER, "");
+		memcpy((uint8_t *)dst + dst_size, col, COLLECTION_HDR_SIZE);
+	}
+	dst_size += COLLECTION_HDR_SIZE;
+	if (model_mode_is_used(cfg->cmp_mode) && updated_model)
+		memcpy(updated_model, col, COLLECTION_HDR_SIZE);
+
+	/* is enough capacity in the dst buffer to store the data uncompressed */
+	if ((dst == NULL || dst_capacity >= dst_size + col_data_length) &&
+	    cfg->cmp_mode != CMP_MODE_RAW) {
+		/* we set the compressed buffer size to the data size -1 to provoke
+		 * a CMP_ERROR_SMALL_BUFFER error if the data are not compressible;
+		 * the parameter overrides have to fit in the data size as well;
+		 * the compression stops as soon as the remaining data can no
+		 * longer fit (see stop_if_stream_cannot_fit())
+		 */
+		cfg->stream_size = dst_size + col_data_length - (pars_size ? pars_size : 1);
+		dst_size_bits = compress_data_internal(cfg, dst_size << 3);
+
+		if (cmp_get_error_code(dst_size_bits) == CMP_ERROR_SMALL_BUFFER ||
+		    (!dst && dst_size_bits > cmp_stream_size_to_bits(cfg->stream_size))) { /* if dst == NULL compress_data_internal will not return a CMP_ERROR_SMALL_BUFFER */
+			/* can not compress the data with the given parameters;
+			 * put them uncompressed (raw) into the dst buffer */
+			enum cmp_mode cmp_mode_cpy = cfg->cmp_mode;
+
+			cfg->stream_size = dst_size + col_data_length;
+			cfg->cmp_mode = CMP_MODE_RAW;
+			dst_size_bits = compress_data_internal(cfg, dst_size << 3);
+			cfg->cmp_mode = cmp_mode_cpy;
+			/* updated model is in this case a copy of the data to compress */
+			if (model_mode_is_used(cfg->cmp_mode) && cfg->updated_model_buf)
+				memcpy(cfg->updated_model_buf, cfg->src, col_data_length);
+		}
+	} else {
+		cfg->stream_size = dst_capacity;
+		dst_size_bits = compress_data_internal(cfg, dst_size << 3);
+	}
+	FORWARD_IF_ERROR(dst_size_bits, "compression failed");
+
+	dst_size = cmp_bit_to_byte(dst_size_bits);
+	if (cfg->cmp_mode != CMP_MODE_RAW && dst) {
+		uint8_t *cmp_col_size_field = (uint8_t *)dst+dst_size_begin;
+		uint32_t cmp_col_size = dst_size - dst_size_begin -
+			COLLECTION_HDR_SIZE - CMP_COLLECTION_FILD_SIZE;
+
+		FORWARD_IF_ERROR(set_cmp_col_size(cmp_col_size_field, cmp_col_size), "");
+	}
+
+	/* the parameter overrides follow the data of a compressed collection;
+	 * the decompressor detects an uncompressed (raw) collection by a
+	 * compressed data size equal to the collection data length
+	 */
+	if (pars_size && dst_size - dst_size_begin - COLLECTION_HDR_SIZE -
+	    CMP_COLLECTION_FILD_SIZE != col_data_length) {
+		if (dst) {
+			RETURN_ERROR_IF(dst_size + pars_size > dst_capacity, SMALL_BUFFER, "");
+			memcpy((uint8_t *)dst + dst_size, pars_field, pars_size);
+		}
+		dst_size += pars_size;
+	}
+
+	return dst_size;
+}
+
+
+/**
+ * @brief get the flags of the reserved field of a chunk compression entity
+ *
+ * @param cfg	pointer to the compression configuration used to compress the
+ *		chunk
+ *
+ * @returns the CMP_ENT_FLAG_* flags of the compression entity
+ */
+
+static uint8_t get_cmp_ent_flags(const struct cmp_cfg *cfg)
+{
+	uint8_t flags = 0;
+
+	if (cfg->col_pars && cfg->cmp_mode != CMP_MODE_RAW)
+		flags |= CMP_ENT_FLAG_COL_PARS;
+	if (cfg->equal_model && model_mode_is_used(cfg->cmp_mode) && !cfg->round)
+		flags |= CMP_ENT_FLAG_EQUAL_MODEL;
+
+	return flags;
+}
+
+
+/**
+ * @brief builds a compressed entity header for a compressed chunk
+ *
+ * @param entity		start address of the compression entity header
+ *				(can be NULL if you only want the entity header
+ *				size)
+ * @param chunk_size		the original size of the chunk in bytes
+ * @param ctx			pointer to the compression context providing
+ *				the version identifier and the end timestamp
+ * @param cfg			pointer to the compression configuration used to
+ *				compress the chunk
+ * @param start_timestamp	the start timestamp of the chunk compression
+ * @param cmp_ent_size_byte	the size of the compression entity (entity
+ *				header plus compressed data)
+ *
+ * @return the size of the compressed entity header in bytes or an error code
+ *	if it fails (which can be tested with cmp_is_error())
+ */
+
+static uint32_t cmp_ent_build_chunk_header(uint32_t *entity, uint32_t chunk_size,
+					   const struct cmp_ctx *ctx,
+					   const struct cmp_cfg *cfg, uint64_t start_timestamp,
+					   uint32_t cmp_ent_size_byte)
+{
+	if (entity) { /* setup the compressed entity header */
+		struct cmp_entity *ent = (struct cmp_entity *)entity;
+		int err = 0;
+
+		err |= cmp_ent_set_version_id(ent, ctx->version_id);
+		err |= cmp_ent_set_size(ent, cmp_ent_size_byte);
+		err |= cmp_ent_set_original_size(ent, chunk_size);
+		err |= cmp_ent_set_data_type(ent, DATA_TYPE_CHUNK, cfg->cmp_mode == CMP_MODE_RAW);
+		err |= cmp_ent_set_cmp_mode(ent, cfg->cmp_mode);
+		err |= cmp_ent_set_model_value(ent, cfg->model_value);
+		/* model id/counter are set by the user with the compress_chunk_set_model_id_and_counter() */
+		err |= cmp_ent_set_model_id(ent, 0);
+		err |= cmp_ent_set_model_counter(ent, 0);
+		err |= cmp_ent_set_reserved(ent, get_cmp_ent_flags(cfg));
+		/* a raw mode entity is never lossy */
+		err |= cmp_ent_set_lossy_cmp_par(ent, cfg->cmp_mode == CMP_MODE_RAW ? 0 : cfg->round);
+		if (cfg->cmp_mode != CMP_MODE_RAW) {
+			err |= cmp_ent_set_non_ima_spill1(ent, cfg->spill_par_1);
+			err |= cmp_ent_set_non_ima_cmp_par1(ent, cfg->cmp_par_1);
+			err |= cmp_ent_set_non_ima_spill2(ent, cfg->spill_par_2);
+			err |= cmp_ent_set_non_ima_cmp_par2(ent, cfg->cmp_par_2);
+			err |= cmp_ent_set_non_ima_spill3(ent, cfg->spill_par_3);
+			err |= cmp_ent_set_non_ima_cmp_par3(ent, cfg->cmp_par_3);
+			err |= cmp_ent_set_non_ima_spill4(ent, cfg->spill_par_4);
+			err |= cmp_ent_set_non_ima_cmp_par4(ent, cfg->cmp_par_4);
+			err |= cmp_ent_set_non_ima_spill5(ent, cfg->spill_par_5);
+			err |= cmp_ent_set_non_ima_cmp_par5(ent, cfg->cmp_par_5);
+			err |= cmp_ent_set_non_ima_spill6(ent, cfg->spill_par_6);
+			err |= cmp_ent_set_non_ima_cmp_par6(ent, cfg->cmp_par_6);
+		}
+		RETURN_ERROR_IF(err, ENTITY_HEADER, "");
+		RETURN_ERROR_IF(cmp_ent_set_start_timestamp(ent, start_timestamp),
+				ENTITY_TIMESTAMP, "");
+		RETURN_ERROR_IF(cmp_ent_set_end_timestamp(ent, get_timestamp(ctx)),
+				ENTITY_TIMESTAMP, "");
+	}
+
+	if (cfg->cmp_mode == CMP_MODE_RAW)
+		return GENERIC_HEADER_SIZE;
+	else
+		return NON_IMAGETTE_HEADER_SIZE;
+}
+
+
+/**
+ * @brief Set the compression configuration from the compression parameters
+ *	based on the chunk type of the collection
+ *
+ * @param[in] col	pointer to a collection header
+ * @param[in] par	pointer to a compression parameters struct
+ * @param[out] cfg	pointer to a compression configuration
+ *
+ * @returns the chunk type of the collection
+ */
+
+static enum chunk_type init_cmp_cfg_from_cmp_par(const struct collection_hdr *col,
+						 const struct cmp_par *par,
+						 struct cmp_cfg *cfg)
+{
+	enum chunk_type chunk_type = cmp_col_get_chunk_type(col);
+
+	memset(cfg, 0, sizeof(struct cmp_cfg));
+
+	/* the ranges of the parameters are checked in cmp_cfg_icu_is_invalid_error_code() */
+	cfg->cmp_mode = par->cmp_mode;
+	cfg->model_value = par->model_value;
+	/* only the auxiliary science data can tolerate a lossy compression;
+	 * the raw mode copies the data unchanged and is always lossless
+	 */
+	if ((chunk_type == CHUNK_TYPE_OFFSET_BACKGROUND || chunk_type == CHUNK_TYPE_SMEARING) &&
+	    cfg->cmp_mode != CMP_MODE_RAW) {
+		cfg->round = par->lossy_par;
+	} else {
+		if (par->lossy_par)
+			debug_print("Warning: lossy compression is only supported for offset, background and smearing chunks in a non-raw mode, lossy_par will be ignored.");
+		cfg->round = 0;
+	}
+
+	switch (chunk_type) {
+	case CHUNK_TYPE_NCAM_IMAGETTE:
+		cfg->cmp_par_imagette = par->nc_imagette;
+		cfg->spill_imagette = cmp_get_spill(cfg->cmp_par_imagette, cfg->cmp_mode,
+						    MAX_USED_BITS.nc_imagette);
+		break;
+	case CHUNK_TYPE_SAT_IMAGETTE:
+		cfg->cmp_par_imagette = par->saturated_imagette;
+		cfg->spill_imagette = cmp_get_spill(cfg->cmp_par_imagette, cfg->cmp_mode,
+						    MAX_USED_BITS.saturated_imagette);
+		break;
+	case CHUNK_TYPE_SHORT_CADENCE:
+		cfg->cmp_par_exp_flags = par->s_exp_flags;
+		cfg->spill_exp_flags = cmp_get_spill(cfg->cmp_par_exp_flags, cfg->cmp_mode,
+						     MAX_USED_BITS.s_exp_flags);
+		cfg->cmp_par_fx = par->s_fx;
+		cfg->spill_fx = cmp_get_spill(cfg->cmp_par_fx, cfg->cmp_mode,
+					      MAX_USED_BITS.s_fx);
+		cfg->cmp_par_ncob = par->s_ncob;
+		cfg->spill_ncob = cmp_get_spill(cfg->cmp_par_ncob, cfg->cmp_mode,
+						MAX_USED_BITS.s_ncob);
+		cfg->cmp_par_efx = par->s_efx;
+		cfg->spill_efx = cmp_get_spill(cfg->cmp_par_efx, cfg->cmp_mode,
+					       MAX_USED_BITS.s_efx);
+		cfg->cmp_par_ecob = par->s_ecob;
+		cfg->spill_ecob = cmp_get_spill(cfg->cmp_par_ecob, cfg->cmp_mode,
+						MAX_USED_BITS.s_ecob);
+		break;
+	case CHUNK_TYPE_LONG_CADENCE:
+		cfg->cmp_par_exp_flags = par->l_exp_flags;
+		cfg->spill_exp_flags = cmp_get_spill(cfg->cmp_par_exp_flags, cfg->cmp_mode,
+						     MAX_USED_BITS.l_exp_flags);
+		cfg->cmp_par_fx = par->l_fx;
+		cfg->spill_fx = cmp_get_spill(cfg->cmp_par_fx, cfg->cmp_mode,
+					      MAX_USED_BITS.l_fx);
+		cfg->cmp_par_ncob = par->l_ncob;
+		cfg->spill_ncob = cmp_get_spill(cfg->cmp_par_ncob, cfg->cmp_mode,
+						MAX_USED_BITS.l_ncob);
+		cfg->cmp_par_efx = par->l_efx;
+		cfg->spill_efx = cmp_get_spill(cfg->cmp_par_efx, cfg->cmp_mode,
+					       MAX_USED_BITS.l_efx);
+		cfg->cmp_par_ecob = par->l_ecob;
+		cfg->spill_ecob = cmp_get_spill(cfg->cmp_par_ecob, cfg->cmp_mode,
+						MAX_USED_BITS.l_ecob);
+		cfg->cmp_par_fx_cob_variance = par->l_fx_cob_variance;
+		cfg->spill_fx_cob_variance = cmp_get_spill(cfg->cmp_par_fx_cob_variance,
+							   cfg->cmp_mode, MAX_USED_BITS.l_fx_cob_variance);
+		break;
+	case CHUNK_TYPE_OFFSET_BACKGROUND:
+		cfg->cmp_par_offset_mean = par->nc_offset_mean;
+		cfg->spill_offset_mean = cmp_get_spill(cfg->cmp_par_offset_mean,
+						cfg->cmp_mode, MAX_USED_BITS.nc_offset_mean);
+		cfg->cmp_par_offset_variance = par->nc_offset_variance;
+		cfg->spill_offset_variance = cmp_get_spill(cfg->cmp_par_offset_variance,
+						cfg->cmp_mode, MAX_USED_BITS.nc_offset_variance);
+		cfg->cmp_par_background_mean = par->nc_background_mean;
+		cfg->spill_background_mean = cmp_get_spill(cfg->cmp_par_background_mean,
+						cfg->cmp_mode, MAX_USED_BITS.nc_background_mean);
+		cfg->cmp_par_background_variance = par->nc_background_variance;
+		cfg->spill_background_variance = cmp_get_spill(cfg->cmp_par_background_variance,
+						cfg->cmp_mode, MAX_USED_BITS.nc_background_variance);
+		cfg->cmp_par_background_pixels_error = par->nc_background_outlier_pixels;
+		cfg->spill_background_pixels_error = cmp_get_spill(cfg->cmp_par_background_pixels_error,
+						cfg->cmp_mode, MAX_USED_BITS.nc_background_outlier_pixels);
+		break;
+
+	case CHUNK_TYPE_SMEARING:
+		cfg->cmp_par_smearing_mean = par->smearing_mean;
+		cfg->spill_smearing_mean = cmp_get_spill(cfg->cmp_par_smearing_mean,
+						cfg->cmp_mode, MAX_USED_BITS.smearing_mean);
+		cfg->cmp_par_smearing_variance = par->smearing_variance_mean;
+		cfg->spill_smearing_variance = cmp_get_spill(cfg->cmp_par_smearing_variance,
+						cfg->cmp_mode, MAX_USED_BITS.smearing_variance_mean);
+		cfg->cmp_par_smearing_pixels_error = par->smearing_outlier_pixels;
+		cfg->spill_smearing_pixels_error = cmp_get_spill(cfg->cmp_par_smearing_pixels_error,
+						cfg->cmp_mode, MAX_USED_BITS.smearing_outlier_pixels);
+		break;
+
+	case CHUNK_TYPE_F_CHAIN:
+		cfg->cmp_par_imagette = par->fc_imagette;
+		cfg->spill_imagette = cmp_get_spill(cfg->cmp_par_imagette,
+						cfg->cmp_mode, MAX_USED_BITS.fc_imagette);
+
+		cfg->cmp_par_offset_mean = par->fc_offset_mean;
+		cfg->spill_offset_mean = cmp_get_spill(cfg->cmp_par_offset_mean,
+						cfg->cmp_mode, MAX_USED_BITS.fc_offset_mean);
+		cfg->cmp_par_offset_variance = par->fc_offset_variance;
+		cfg->spill_offset_variance = cmp_get_spill(cfg->cmp_par_offset_variance,
+						cfg->cmp_mode, MAX_USED_BITS.fc_offset_variance);
+
+		cfg->cmp_par_background_mean = par->fc_background_mean;
+		cfg->spill_background_mean = cmp_get_spill(cfg->cmp_par_background_mean,
+						cfg->cmp_mode, MAX_USED_BITS.fc_background_mean);
+		cfg->cmp_par_background_variance = par->fc_background_variance;
+		cfg->spill_background_variance = cmp_get_spill(cfg->cmp_par_background_variance,
+						cfg->cmp_mode, MAX_USED_BITS.fc_background_variance);
+		cfg->cmp_par_background_pixels_error = par->fc_background_outlier_pixels;
+		cfg->spill_background_pixels_error = cmp_get_spill(cfg->cmp_par_background_pixels_error,
+						cfg->cmp_mode, MAX_USED_BITS.fc_background_outlier_pixels);
+		break;
+	case CHUNK_TYPE_UNKNOWN:
+	default: /*
+		  * default case never reached because cmp_col_get_chunk_type
+		  * returns CHUNK_TYPE_UNKNOWN if the type is unknown
+		  */
+		chunk_type = CHUNK_TYPE_UNKNOWN;
+		break;
+	}
+
+	return chunk_type;
+}
+
+
+/**
+ * @brief initialise the compress_chunk() function
+ *
+ * If not initialised the compress_chunk() function sets the timestamps and
+ * version_id in the compression entity header to zero
+ *
+ * @param return_timestamp	pointer to a function returning a current 48-bit
+ *				timestamp
+ * @param version_id		application software version identifier
+ */
+
+void compress_chunk_init(uint64_t (*return_timestamp)(void), uint32_t version_id)
+{
+	if (return_timestamp)
+		default_ctx.return_timestamp = return_timestamp;
+
+	default_ctx.version_id = version_id;
+}
+
+
+/**
+ * @brief initialise a compression context
+ *
+ * A compression context holds the settings of the chunk compression, so that
+ * compressions with different settings can run at the same time. The context
+ * is owned by the caller; the library does not allocate any memory. The
+ * collections are compressed sequentially until a work buffer is set with
+ * cmp_ctx_set_parallel().
+ *
+ * @param ctx			pointer to the compression context to initialise
+ * @param return_timestamp	pointer to a function returning a current 48-bit
+ *				timestamp; can be NULL, then the timestamps in
+ *				the compression entity header are set to zero
+ * @param version_id		application software version identifier
+ */
+
+void cmp_ctx_init(struct cmp_ctx *ctx, uint64_t (*return_timestamp)(void),
+		  uint32_t version_id)
+{
+	if (!ctx)
+		return;
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->return_timestamp = return_timestamp;
+	ctx->version_id = version_id;
+}
+
+
+/**
+ * @brief set up a compression context to compress the collections of a
+ *	chunk in parallel
+ *
+ * @param ctx		pointer to an initialised compression context
+ * @param work_buf	pointer to a work buffer; has to be aligned for pointer
+ *			access; must not overlap with any other buffer; can
+ *			be NULL to compress sequentially
+ * @param work_buf_size	byte size of the work buffer; should be at least
+ *			compress_chunk_parallel_work_size() of the largest
+ *			chunk to compress
+ * @param run_jobs	function executing the compression jobs
+ * @param pool		opaque pointer passed to the run_jobs function
+ *
+ * @note a context with a work buffer must not be used by more than one
+ *	compression at the same time
+ */
+
+void cmp_ctx_set_parallel(struct cmp_ctx *ctx, void *work_buf, uint32_t work_buf_size,
+			  cmp_run_jobs_func run_jobs, void *pool)
+{
+	if (!ctx)
+		return;
+
+	ctx->work_buf = work_buf;
+	ctx->work_buf_size = work_buf_size;
+	ctx->run_jobs = run_jobs;
+	ctx->pool = pool;
+}
+
+
+/**
+ * @brief enable or disable the selection of the compression parameters per
+ *	collection
+ *
+ * If enabled, the compressor estimates the best compression parameters for
+ * every collection from a histogram of its residuals. Parameters which save
+ * more than they cost are stored as overrides after the compressed data of
+ * the collection. The compression entity is marked with the
+ * CMP_ENT_FLAG_COL_PARS flag in the reserved field of the header; every
+ * compressed (not raw) collection has a parameter override field, also if no
+ * parameter is overridden. The compressed size is never larger than
+ * compress_chunk_cmp_size_bound(). The selection needs some extra passes over
+ * the data and the collections are always compressed sequentially. The
+ * setting is disabled by cmp_ctx_init().
+ *
+ * @param ctx		pointer to an initialised compression context
+ * @param enable	non-zero to enable the per-collection parameters
+ */
+
+void cmp_ctx_set_col_pars(struct cmp_ctx *ctx, int enable)
+{
+	if (!ctx)
+		return;
+
+	ctx->col_pars = enable != 0;
+}
+
+
+/**
+ * @brief enable or disable the storage of collections identical to their
+ *	model without compressed data
+ *
+ * If enabled, a collection whose data are equal to its model data is stored
+ * in a lossless model mode as the collection header with a compressed data
+ * size of zero; the updated model is a copy of the data. The compression
+ * entity is marked with the CMP_ENT_FLAG_EQUAL_MODEL flag in the reserved
+ * field of the header. Decompressors without support for the flag can not
+ * decompress such an entity. The setting is disabled by cmp_ctx_init().
+ *
+ * @param ctx		pointer to an initialised compression context
+ * @param enable	non-zero to enable the shortcut for collections equal
+ *			to their model
+ */
+
+void cmp_ctx_set_equal_model(struct cmp_ctx *ctx, int enable)
+{
+	if (!ctx)
+		return;
+
+	ctx->equal_model = enable != 0;
+}
+
+
+/**
+ * @brief compress the collections of a chunk with a prepared compression
+ *	configuration
+ *
+ * @param ctx			pointer to a compression context
+ * @param chunk			pointer to the chunk to be compressed
+ * @param chunk_size		byte size of the chunk
+ * @param chunk_model		pointer to a model of a chunk; can be NULL
+ * @param updated_chunk_model	pointer to store the updated model; can be NULL
+ * @param dst			destination pointer to the compressed data
+ *				buffer; can be NULL to only get the size
+ * @param dst_capacity		capacity of the dst buffer
+ * @param cfg			compression configuration set up by
+ *				init_cmp_cfg_from_cmp_par() for the chunk type
+ * @param chunk_type		chunk type of the chunk
+ * @param start_timestamp	the start timestamp of the chunk compression
+ *
+ * @returns the byte size of the compressed data or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ */
+
+static uint32_t compress_collections(const struct cmp_ctx *ctx,
+				     const void *chunk, uint32_t chunk_size,
+				     const void *chunk_model, void *updated_chunk_model,
+				     uint32_t *dst, uint32_t dst_capacity,
+				     struct cmp_cfg *cfg, enum chunk_type chunk_type,
+				     uint64_t start_timestamp)
+{
+	const struct collection_hdr *col = (const struct collection_hdr *)chunk;
+	uint32_t cmp_size_byte; /* size of the compressed data in bytes */
+	size_t read_bytes;
+
+	/* reserve space for the compression entity header, we will build the
+	 * header after the compression of the chunk
+	 */
+	cmp_size_byte = cmp_ent_build_chunk_header(NULL, chunk_size, ctx, cfg, start_timestamp, 0);
+	RETURN_ERROR_IF(dst && dst_capacity < cmp_size_byte, SMALL_BUFFER,
+			"dst_capacity must be at least as large as the minimum size of the compression unit.");
+
+
+	/* the updated model is not needed if only the size is calculated */
+	if (!dst)
+		updated_chunk_model = NULL;
+
+	/* compress one collection after another */
+	for (read_bytes = 0;
+	     read_bytes <= chunk_size - COLLECTION_HDR_SIZE;
+	     read_bytes += cmp_col_get_size(col)) {
+		const uint8_t *col_model = NULL;
+		uint8_t *col_up_model = NULL;
+
+		/* setup pointers for the next collection we want to compress */
+		col = (const struct collection_hdr *)((const uint8_t *)chunk + read_bytes);
+		if (chunk_model)
+			col_model = (const uint8_t *)chunk_model + read_bytes;
+		if (updated_chunk_model)
+			col_up_model = (uint8_t *)updated_chunk_model + read_bytes;
+
+		RETURN_ERROR_IF(cmp_col_get_chunk_type(col) != chunk_type, CHUNK_SUBSERVICE_INCONSISTENT, "");
+
+		/* chunk size is inconsistent with the sum of sizes in the collection headers */
+		if (read_bytes + cmp_col_get_size(col) > chunk_size)
+			break;
+
+		cmp_size_byte = cmp_collection((const uint8_t *)col, col_model, col_up_model,
+					       dst, dst_capacity, cfg, cmp_size_byte);
+		FORWARD_IF_ERROR(cmp_size_byte, "error occurred when compressing the collection with offset %u", read_bytes);
+	}
+
+	RETURN_ERROR_IF(read_bytes != chunk_size, CHUNK_SIZE_INCONSISTENT, "");
+
+	FORWARD_IF_ERROR(cmp_ent_build_chunk_header(dst, chunk_size, ctx, cfg,
+					    start_timestamp, cmp_size_byte), "");
+
+	return cmp_size_byte;
+}
+
+
+/**
+ * @brief compress a data chunk collection by collection
+ *
+ * @param ctx			pointer to a compression context
+ *
+ * @see compress_chunk() for the other parameters and the return value
+ */
+
+static uint32_t compress_chunk_serial(const struct cmp_ctx *ctx,
+				      const void *chunk, uint32_t chunk_size,
+				      const void *chunk_model, void *updated_chunk_model,
+				      uint32_t *dst, uint32_t dst_capacity,
+				      const struct cmp_par *cmp_par)
+{
+	uint64_t const start_timestamp = get_timestamp(ctx);
+	const struct collection_hdr *col = (const struct collection_hdr *)chunk;
+	enum chunk_type chunk_type;
+	struct cmp_cfg cfg;
+	struct cw_table_cache cw_cache;
+
+	RETURN_ERROR_IF(chunk == NULL, CHUNK_NULL, "");
+	RETURN_ERROR_IF(cmp_par == NULL, PAR_NULL, "");
+	RETURN_ERROR_IF(chunk_size < COLLECTION_HDR_SIZE, CHUNK_SIZE_INCONSISTENT,
+			"chunk_size: %"PRIu32"", chunk_size);
+	RETURN_ERROR_IF(chunk_size > CMP_ENTITY_MAX_ORIGINAL_SIZE, CHUNK_TOO_LARGE,
+			"chunk_size: %"PRIu32"", chunk_size);
+
+	chunk_type = init_cmp_cfg_from_cmp_par(col, cmp_par, &cfg);
+	RETURN_ERROR_IF(chunk_type == CHUNK_TYPE_UNKNOWN, COL_SUBSERVICE_UNSUPPORTED,
+			"unsupported subservice: %u", cmp_col_get_subservice(col));
+	cfg.col_pars = (uint32_t)ctx->col_pars;
+	cfg.equal_model = (uint32_t)ctx->equal_model;
+
+	/* the code word tables are shared by all collections of the chunk */
+	cw_cache_init(&cw_cache);
+	cfg.cw_cache = &cw_cache;
+
+	return compress_collections(ctx, chunk, chunk_size, chunk_model,
+				    updated_chunk_model, dst, dst_capacity, &cfg,
+				    chunk_type, start_timestamp);
+}
+
+
+/**
+ * @brief compress a data chunk consisting of put together data collections
+ *
+ * @param chunk			pointer to the chunk to be compressed
+ * @param chunk_size		byte size of the chunk
+ * @param chunk_model		pointer to a model of a chunk; has the same size
+ *				as the chunk (can be NULL if no model compression
+ *				mode is used)
+ * @param updated_chunk_model	pointer to store the updated model for the next
+ *				model mode compression; has the same size as the
+ *				chunk (can be the same as the model_of_data
+ *				buffer for in-place update or NULL if updated
+ *				model is not needed); not used if dst is NULL
+ * @param dst			destination pointer to the compressed data
+ *				buffer; has to be 4-byte aligned; can be NULL to
+ *				only get the compressed data size, in this case
+ *				no updated model is created
+ * @param dst_capacity		capacity of the dst buffer; it's recommended to
+ *				provide a dst_capacity >=
+ *				compress_chunk_cmp_size_bound(chunk, chunk_size)
+ *				as it eliminates one potential failure scenario:
+ *				not enough space in the dst buffer to write the
+ *				compressed data; size is internally rounded down
+ *				to a multiple of 4
+ * @param cmp_par		pointer to a compression parameters struct
+ * @returns the byte size of the compressed data or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk(const void *chunk, uint32_t chunk_size,
+			const void *chunk_model, void *updated_chunk_model,
+			uint32_t *dst, uint32_t dst_capacity,
+			const struct cmp_par *cmp_par)
+{
+	return compress_chunk_serial(&default_ctx, chunk, chunk_size, chunk_model,
+				     updated_chunk_model, dst, dst_capacity, cmp_par);
+}
+
+
+/**
+ * @brief returns the maximum compressed size in a worst-case scenario
+ * In case the input data is not compressible
+ * This function is primarily useful for memory allocation purposes
+ * (destination buffer size).
+ *
+ * @note if the number of collections is known you can use the
+ *	COMPRESS_CHUNK_BOUND macro for compilation-time evaluation
+ *	(stack memory allocation for example)
+ *
+ * @param chunk		pointer to the chunk you want to compress
+ * @param chunk_size	size of the chunk in bytes
+ *
+ * @returns maximum compressed size for a chunk compression on success or an
+ *	error code if it fails (which can be tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_cmp_size_bound(const void *chunk, size_t chunk_size)
+{
+	int32_t read_bytes;
+	uint32_t num_col = 0;
+	size_t bound;
+	size_t const max_chunk_size = CMP_ENTITY_MAX_ORIGINAL_SIZE
+		- NON_IMAGETTE_HEADER_SIZE - CMP_COLLECTION_FILD_SIZE;
+
+	RETURN_ERROR_IF(chunk == NULL, CHUNK_NULL, "");
+	RETURN_ERROR_IF(chunk_size < COLLECTION_HDR_SIZE, CHUNK_SIZE_INCONSISTENT, "");
+	RETURN_ERROR_IF(chunk_size > max_chunk_size, CHUNK_TOO_LARGE,
+			"chunk_size: %"PRIu32" > max_chunk_size: %"PRIu32"",
+			chunk_size, max_chunk_size);
+
+	/* count the number of collections in the chunk */
+	for (read_bytes = 0;
+	     read_bytes <= (int32_t)(chunk_size-COLLECTION_HDR_SIZE);
+	     read_bytes += cmp_col_get_size((const struct collection_hdr *)
+					    ((const uint8_t *)chunk + read_bytes)))
+		num_col++;
+
+	RETURN_ERROR_IF((uint32_t)read_bytes != chunk_size, CHUNK_SIZE_INCONSISTENT, "");
+
+	bound = COMPRESS_CHUNK_BOUND_UNSAFE(chunk_size, num_col);
+	RETURN_ERROR_IF(bound > CMP_ENTITY_MAX_SIZE, CHUNK_TOO_LARGE, "bound: %lu", bound);
+
+	return (uint32_t)bound;
+}
+
+
+/**
+ * @brief compression state of a single collection compressed by
+ *	compress_chunk_parallel()
+ */
+
+struct cmp_col_job {
+	struct cmp_cfg cfg;	  /**< compression configuration of the collection */
+	const uint8_t *col;	  /**< start address of the collection */
+	const uint8_t *model;	  /**< model of the collection; can be NULL */
+	uint8_t *updated_model;	  /**< updated model of the collection; can be NULL */
+	uint32_t *scratch;	  /**< buffer for the compressed data of the collection */
+	uint32_t result;	  /**< bit length of the compressed data or an error code */
+};
+
+
+/**
+ * @brief argument of the cmp_col_job_run() jobs
+ */
+
+struct cmp_col_jobs {
+	struct cmp_col_job *job;  /**< array with the state of every job */
+	uint32_t *dst;		  /**< destination buffer of the chunk compression */
+	uint32_t dst_capacity;	  /**< capacity of the dst buffer */
+};
+
+
+/**
+ * @brief compress a single collection into its own scratch buffer
+ *
+ * The collection is compressed independent of its final position in the dst
+ * buffer. Whether the data fit in compressed form is decided later by
+ * compress_chunk_parallel() when the position of the collection is known.
+ * The job->result is set to the bit length of the compressed data, to a
+ * CMP_ERROR_SMALL_BUFFER error if the data should be stored uncompressed or to
+ * any other error code if the compression fails.
+ *
+ * @param job_arg	pointer to a struct cmp_col_jobs
+ * @param i		index of the collection to compress
+ */
+
+static void cmp_col_job_run(void *job_arg, uint32_t i)
+{
+	const struct cmp_col_jobs *jobs = (const struct cmp_col_jobs *)job_arg;
+	struct cmp_col_job *job = &jobs->job[i];
+	struct cmp_cfg *cfg = &job->cfg;
+	struct cw_table_cache cw_cache;
+	uint32_t result;
+
+	/* the overlap checks are done with the real dst buffer */
+	result = setup_collection_cfg(job->col, job->model, job->updated_model,
+				      jobs->dst, jobs->dst_capacity, cfg);
+	if (!cmp_is_error(result)) {
+		if (model_mode_is_used(cfg->cmp_mode) && job->updated_model)
+			memcpy(job->updated_model, job->col, COLLECTION_HDR_SIZE);
+
+		if (cfg->cmp_mode == CMP_MODE_RAW) {
+			result = CMP_ERROR(SMALL_BUFFER);
+		} else if (collection_equals_model(cfg)) {
+			/* no compressed data; see cmp_collection() */
+			if (job->updated_model)
+				memcpy(cfg->updated_model_buf, cfg->src,
+				       cfg->samples * size_of_a_sample(cfg->data_type));
+			result = 0;
+		} else {
+			/* every job needs its own code word tables */
+			cw_cache_init(&cw_cache);
+			cfg->cw_cache = &cw_cache;
+			if (jobs->dst)
+				cfg->dst = job->scratch;
+			/* the stream starts at bit 0 of the scratch buffer;
+			 * a collection which does not fit in the data length
+			 * of the collection is stored uncompressed anyway
+			 */
+			cfg->stream_size = (uint32_t)cfg->samples *
+				size_of_a_sample(cfg->data_type) + 2;
+			result = compress_data_internal(cfg, 0);
+			cfg->cw_cache = NULL;
+		}
+	}
+	job->result = result;
+}
+
+
+/**
+ * @brief count the collections of a chunk and calculate the size of the work
+ *	buffer needed to compress them in parallel
+ *
+ * @param chunk		pointer to the chunk
+ * @param chunk_size	byte size of the chunk
+ * @param num_col	pointer to store the number of collections in the chunk
+ *
+ * @returns the needed work buffer size in bytes or an error code if it fails
+ *	(which can be tested with cmp_is_error())
+ */
+
+static uint32_t chunk_work_size(const void *chunk, uint32_t chunk_size,
+				uint32_t *num_col)
+{
+	uint32_t read_bytes;
+	uint32_t work_size = 0;
+
+	FORWARD_IF_ERROR(compress_chunk_cmp_size_bound(chunk, chunk_size), "");
+
+	*num_col = 0;
+	for (read_bytes = 0;
+	     read_bytes <= chunk_size - COLLECTION_HDR_SIZE;
+	     read_bytes += cmp_col_get_size((const struct collection_hdr *)
+					    ((const uint8_t *)chunk + read_bytes))) {
+		const struct collection_hdr *col = (const struct collection_hdr *)
+			((const uint8_t *)chunk + read_bytes);
+
+		work_size += sizeof(struct cmp_col_job) +
+			ROUND_UP_TO_4(cmp_col_get_data_length(col));
+		(*num_col)++;
+	}
+
+	return work_size;
+}
+
+
+/**
+ * @brief get the size of the work buffer needed by compress_chunk_parallel()
+ *
+ * @param chunk		pointer to the chunk to be compressed
+ * @param chunk_size	byte size of the chunk
+ *
+ * @returns the needed work buffer size in bytes or an error code if it fails
+ *	(which can be tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_parallel_work_size(const void *chunk, uint32_t chunk_size)
+{
+	uint32_t num_col;
+
+	return chunk_work_size(chunk, chunk_size, &num_col);
+}
+
+
+/**
+ * @brief compress a data chunk with the collections compressed by the jobs
+ *	of a compression context
+ *
+ * The collections are compressed sequentially if the context has no run_jobs
+ * function or work buffer, if the work buffer is smaller than
+ * compress_chunk_parallel_work_size(), if dst_capacity is smaller than
+ * compress_chunk_cmp_size_bound() or if the per-collection parameters are
+ * enabled (see cmp_ctx_set_col_pars()).
+ *
+ * @param ctx			pointer to a compression context
+ *
+ * @see compress_chunk() for the other parameters and the return value
+ */
+
+static uint32_t compress_chunk_jobs(const struct cmp_ctx *ctx,
+				    const void *chunk, uint32_t chunk_size,
+				    const void *chunk_model, void *updated_chunk_model,
+				    uint32_t *dst, uint32_t dst_capacity,
+				    const struct cmp_par *cmp_par)
+{
+	uint64_t const start_timestamp = get_timestamp(ctx);
+	const struct collection_hdr *col = (const struct collection_hdr *)chunk;
+	enum chunk_type chunk_type;
+	struct cmp_cfg cfg;
+	struct cmp_col_jobs jobs;
+	uint32_t cmp_size_byte; /* size of the compressed data in bytes */
+	uint32_t work_size, num_col, read_bytes, i;
+	uint32_t n_jobs = 0;
+	uint32_t chunk_err = CMP_ERROR(NO_ERROR);
+	uint8_t *scratch;
+
+	if (!ctx->run_jobs || !ctx->work_buf || !cmp_par || ctx->col_pars)
+		return compress_chunk_serial(ctx, chunk, chunk_size, chunk_model,
+					     updated_chunk_model, dst, dst_capacity, cmp_par);
+
+	work_size = chunk_work_size(chunk, chunk_size, &num_col);
+	if (cmp_is_error(work_size) || ctx->work_buf_size < work_size ||
+	    (dst && dst_capacity < compress_chunk_cmp_size_bound(chunk, chunk_size)))
+		return compress_chunk_serial(ctx, chunk, chunk_size, chunk_model,
+					     updated_chunk_model, dst, dst_capacity, cmp_par);
+
+	chunk_type = init_cmp_cfg_from_cmp_par(col, cmp_par, &cfg);
+	RETURN_ERROR_IF(chunk_type == CHUNK_TYPE_UNKNOWN, COL_SUBSERVICE_UNSUPPORTED,
+			"unsupported subservice: %u", cmp_col_get_subservice(col));
+	cfg.equal_model = (uint32_t)ctx->equal_model;
+
+	cmp_size_byte = cmp_ent_build_chunk_header(NULL, chunk_size, ctx, &cfg, start_timestamp, 0);
+
+	/* the updated model is not needed if only the size is calculated */
+	if (!dst)
+		updated_chunk_model = NULL;
+
+	/* set up a job for every collection until the first inconsistent one */
+	jobs.job = (struct cmp_col_job *)ctx->work_buf;
+	jobs.dst = dst;
+	jobs.dst_capacity = dst_capacity;
+	scratch = (uint8_t *)ctx->work_buf + num_col * sizeof(struct cmp_col_job);
+	for (read_bytes = 0;
+	     read_bytes <= chunk_size - COLLECTION_HDR_SIZE;
+	     read_bytes += cmp_col_get_size(col)) {
+		struct cmp_col_job *job = &jobs.job[n_jobs];
+
+		col = (const struct collection_hdr *)((const uint8_t *)chunk + read_bytes);
+		if (cmp_col_get_chunk_type(col) != chunk_type) {
+			/* reported after the collections in front are processed */
+			chunk_err = CMP_ERROR(CHUNK_SUBSERVICE_INCONSISTENT);
+			break;
+		}
+
+		job->cfg = cfg;
+		job->col = (const uint8_t *)col;
+		job->model = chunk_model ? (const uint8_t *)chunk_model + read_bytes : NULL;
+		job->updated_model = updated_chunk_model ?
+			(uint8_t *)updated_chunk_model + read_bytes : NULL;
+		job->scratch = (uint32_t *)scratch;
+		scratch += ROUND_UP_TO_4(cmp_col_get_data_length(col));
+		n_jobs++;
+	}
+
+	if (n_jobs)
+		ctx->run_jobs(cmp_col_job_run, &jobs, n_jobs, ctx->pool);
+
+	/* put the compressed collections together */
+	for (i = 0; i < n_jobs; i++) {
+		struct cmp_col_job *job = &jobs.job[i];
+		struct cmp_cfg *col_cfg = &job->cfg;
+		uint32_t const col_start = cmp_size_byte;
+		uint32_t const col_data_length =
+			cmp_col_get_data_length((const struct collection_hdr *)job->col);
+		uint32_t data_start = cmp_size_byte + COLLECTION_HDR_SIZE;
+
+		if (cmp_get_error_code(job->result) != CMP_ERROR_SMALL_BUFFER)
+			FORWARD_IF_ERROR(job->result, "error occurred when compressing the collection with offset %u",
+					 (unsigned int)(job->col - (const uint8_t *)chunk));
+
+		if (cfg.cmp_mode != CMP_MODE_RAW)
+			data_start += CMP_COLLECTION_FILD_SIZE;
+		if (dst)
+			memcpy((uint8_t *)dst + data_start - COLLECTION_HDR_SIZE,
+			       job->col, COLLECTION_HDR_SIZE);
+
+		/* same decision as in cmp_collection(), where the data are
+		 * compressed with a stream size of data_start + col_data_length - 1;
+		 * a collection equal to its model has no compressed data
+		 */
+		if (!cmp_is_error(job->result) && (job->result == 0 ||
+		    (data_start << 3) + job->result <=
+		    cmp_stream_size_to_bits(data_start + col_data_length - 1))) {
+			cmp_size_byte = data_start + cmp_bit_to_byte(job->result);
+			if (dst)
+				memcpy((uint8_t *)dst + data_start, job->scratch,
+				       cmp_size_byte - data_start);
+		} else {
+			uint32_t dst_size_bits;
+
+			/* put the data uncompressed (raw) into the dst buffer */
+			col_cfg->cmp_mode = CMP_MODE_RAW;
+			col_cfg->dst = dst;
+			col_cfg->stream_size = data_start + col_data_length;
+			dst_size_bits = compress_data_internal(col_cfg, data_start << 3);
+			FORWARD_IF_ERROR(dst_size_bits, "compression failed");
+			cmp_size_byte = cmp_bit_to_byte(dst_size_bits);
+			/* updated model is in this case a copy of the data to compress */
+			if (model_mode_is_used(cfg.cmp_mode) && col_cfg->updated_model_buf)
+				memcpy(col_cfg->updated_model_buf, col_cfg->src, col_data_length);
+		}
+
+		if (cfg.cmp_mode != CMP_MODE_RAW && dst)
+			FORWARD_IF_ERROR(set_cmp_col_size((uint8_t *)dst + col_start,
+				cmp_size_byte - col_start - COLLECTION_HDR_SIZE - CMP_COLLECTION_FILD_SIZE), "");
+	}
+	FORWARD_IF_ERROR(chunk_err, "");
+
+	FORWARD_IF_ERROR(cmp_ent_build_chunk_header(dst, chunk_size, ctx, &cfg,
+					    start_timestamp, cmp_size_byte), "");
+
+	return cmp_size_byte;
+}
+
+
+/**
+ * @brief compress a data chunk with the collections compressed in parallel
+ *
+ * The collections of the chunk are compressed independently from each other
+ * by jobs executed with the run_jobs function; afterwards the compressed
+ * collections are put together into the dst buffer. The result is identical
+ * to the result of compress_chunk().
+ * The library does not create threads or allocate memory itself; the thread
+ * pool and the work buffer are provided by the caller.
+ * The compression is done sequentially by compress_chunk() if no run_jobs
+ * function or work buffer is provided, if the work buffer is smaller than
+ * compress_chunk_parallel_work_size() or if dst_capacity is smaller than
+ * compress_chunk_cmp_size_bound().
+ *
+ * @param chunk			pointer to the chunk to be compressed
+ * @param chunk_size		byte size of the chunk
+ * @param chunk_model		pointer to a model of a chunk; has the same size
+ *				as the chunk (can be NULL if no model compression
+ *				mode is used)
+ * @param updated_chunk_model	pointer to store the updated model for the next
+ *				model mode compression; has the same size as the
+ *				chunk (can be the same as the model_of_data
+ *				buffer for in-place update or NULL if updated
+ *				model is not needed); not used if dst is NULL
+ * @param dst			destination pointer to the compressed data
+ *				buffer; has to be 4-byte aligned; can be NULL to
+ *				only get the compressed data size
+ * @param dst_capacity		capacity of the dst buffer
+ * @param cmp_par		pointer to a compression parameters struct
+ * @param work_buf		pointer to a work buffer; has to be aligned for
+ *				pointer access; must not overlap with any other
+ *				buffer
+ * @param work_buf_size		byte size of the work buffer
+ * @param run_jobs		function executing the compression jobs
+ * @param pool			opaque pointer passed to the run_jobs function
+ *
+ * @returns the byte size of the compressed data or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_parallel(const void *chunk, uint32_t chunk_size,
+				 const void *chunk_model, void *updated_chunk_model,
+				 uint32_t *dst, uint32_t dst_capacity,
+				 const struct cmp_par *cmp_par,
+				 void *work_buf, uint32_t work_buf_size,
+				 cmp_run_jobs_func run_jobs, void *pool)
+{
+	struct cmp_ctx ctx = default_ctx;
+
+	cmp_ctx_set_parallel(&ctx, work_buf, work_buf_size, run_jobs, pool);
+
+	return compress_chunk_jobs(&ctx, chunk, chunk_size, chunk_model,
+				   updated_chunk_model, dst, dst_capacity, cmp_par);
+}
+
+
+/**
+ * @brief compress a data chunk with the settings of a compression context
+ *
+ * The result is identical to the result of compress_chunk() with the same
+ * timestamp function and version identifier. If a work buffer is set with
+ * cmp_ctx_set_parallel() the collections are compressed in parallel as
+ * described for compress_chunk_parallel().
+ *
+ * @param ctx			pointer to a compression context initialised
+ *				with cmp_ctx_init()
+ * @param chunk			pointer to the chunk to be compressed
+ * @param chunk_size		byte size of the chunk
+ * @param chunk_model		pointer to a model of a chunk; has the same size
+ *				as the chunk (can be NULL if no model compression
+ *				mode is used)
+ * @param updated_chunk_model	pointer to store the updated model for the next
+ *				model mode compression; has the same size as the
+ *				chunk (can be the same as the model_of_data
+ *				buffer for in-place update or NULL if updated
+ *				model is not needed); not used if dst is NULL
+ * @param dst			destination pointer to the compressed data
+ *				buffer; has to be 4-byte aligned; can be NULL to
+ *				only get the compressed data size
+ * @param dst_capacity		capacity of the dst buffer
+ * @param cmp_par		pointer to a compression parameters struct
+ *
+ * @returns the byte size of the compressed data or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_ctx(const struct cmp_ctx *ctx,
+			    const void *chunk, uint32_t chunk_size,
+			    const void *chunk_model, void *updated_chunk_model,
+			    uint32_t *dst, uint32_t dst_capacity,
+			    const struct cmp_par *cmp_par)
+{
+	RETURN_ERROR_IF(ctx == NULL, GENERIC, "compression context is NULL");
+
+	return compress_chunk_jobs(ctx, chunk, chunk_size, chunk_model,
+				   updated_chunk_model, dst, dst_capacity, cmp_par);
+}
+
+
+/**
+ * @brief arguments of the compress_chunks_batch() jobs
+ */
+
+struct cmp_chunk_batch {
+	const struct cmp_ctx *ctx;		/**< compression context */
+	const void *const *chunks;		/**< chunks to compress */
+	const uint32_t *chunk_sizes;		/**< byte sizes of the chunks */
+	const void *const *chunk_models;	/**< models of the chunks; can be NULL */
+	void *const *updated_chunk_models;	/**< updated models of the chunks; can be NULL */
+	uint32_t *const *dst;			/**< destination buffers; can be NULL */
+	const uint32_t *dst_capacities;		/**< capacities of the dst buffers */
+	uint32_t *cmp_sizes;			/**< compressed sizes or error codes */
+	struct cmp_cfg type_cfg[CHUNK_TYPE_F_CHAIN+1]; /**< prepared configuration for every chunk type */
+};
+
+
+/**
+ * @brief check the compression parameters of a chunk type configuration for
+ *	all data types of the chunk type
+ *
+ * The data types with valid parameters are marked in cfg->checked_data_types,
+ * so setup_collection_cfg() does not check them again for every collection.
+ * Invalid parameters are reported when a collection of the data type is
+ * compressed.
+ *
+ * @param cfg		pointer to the compression configuration of the chunk type
+ * @param chunk_type	chunk type of the configuration
+ */
+
+static void check_chunk_type_pars(struct cmp_cfg *cfg, enum chunk_type chunk_type)
+{
+	struct collection_hdr col;
+	enum cmp_data_type data_type;
+
+	memset(&col, 0, sizeof(col));
+	for (data_type = DATA_TYPE_IMAGETTE; data_type < DATA_TYPE_CHUNK; data_type++) {
+		uint8_t const sst = convert_cmp_data_type_to_subservice(data_type);
+
+		/* only data types a collection header can have; the fast
+		 * cadence data types belong to no chunk type
+		 */
+		if (convert_subservice_to_cmp_data_type(sst) != data_type ||
+		    (data_type >= DATA_TYPE_F_FX && data_type <= DATA_TYPE_F_FX_EFX_NCOB_ECOB))
+			continue;
+		if (cmp_col_set_subservice(&col, sst) || cmp_col_get_chunk_type(&col) != chunk_type)
+			continue;
+
+		cfg->data_type = data_type;
+		if (!cmp_is_error(cmp_cfg_icu_par_is_invalid_error_code(cfg)))
+			cfg->checked_data_types |= 1U << data_type;
+	}
+	cfg->data_type = DATA_TYPE_UNKNOWN;
+}
+
+
+/**
+ * @brief prepare the compression configuration of every chunk type used by
+ *	the chunks of a batch
+ *
+ * The compression parameters are checked here once per data type and not for
+ * every chunk of the batch.
+ *
+ * @param batch		pointer to the batch; the chunks and chunk sizes have to
+ *			be set
+ * @param n_chunks	number of chunks of the batch
+ * @param cmp_par	pointer to a compression parameters struct used for all
+ *			chunks
+ */
+
+static void prepare_batch_cfgs(struct cmp_chunk_batch *batch, uint32_t n_chunks,
+			       const struct cmp_par *cmp_par)
+{
+	int prepared[CHUNK_TYPE_F_CHAIN+1] = {0};
+	uint32_t i;
+
+	for (i = 0; i < n_chunks; i++) {
+		const struct collection_hdr *col = (const struct collection_hdr *)batch->chunks[i];
+		enum chunk_type chunk_type;
+
+		if (col == NULL || batch->chunk_sizes[i] < COLLECTION_HDR_SIZE)
+			continue;
+		chunk_type = cmp_col_get_chunk_type(col);
+		if (chunk_type != CHUNK_TYPE_UNKNOWN && !prepared[chunk_type]) {
+			struct cmp_cfg *cfg = &batch->type_cfg[chunk_type];
+
+			init_cmp_cfg_from_cmp_par(col, cmp_par, cfg);
+			cfg->col_pars = (uint32_t)batch->ctx->col_pars;
+			cfg->equal_model = (uint32_t)batch->ctx->equal_model;
+			check_chunk_type_pars(cfg, chunk_type);
+			prepared[chunk_type] = 1;
+		}
+	}
+}
+
+
+/**
+ * @brief compress a chunk of a batch with the prepared configuration of its
+ *	chunk type
+ *
+ * @param batch		pointer to the batch
+ * @param i		index of the chunk to compress
+ * @param cw_cache	code word table cache to use
+ *
+ * @returns the byte size of the compressed data or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ */
+
+static uint32_t compress_batch_chunk(const struct cmp_chunk_batch *batch, uint32_t i,
+				     struct cw_table_cache *cw_cache)
+{
+	uint64_t const start_timestamp = get_timestamp(batch->ctx);
+	const void *chunk = batch->chunks[i];
+	uint32_t const chunk_size = batch->chunk_sizes[i];
+	uint32_t *dst = batch->dst ? batch->dst[i] : NULL;
+	enum chunk_type chunk_type;
+	struct cmp_cfg cfg;
+
+	RETURN_ERROR_IF(chunk == NULL, CHUNK_NULL, "");
+	RETURN_ERROR_IF(chunk_size < COLLECTION_HDR_SIZE, CHUNK_SIZE_INCONSISTENT,
+			"chunk_size: %"PRIu32"", chunk_size);
+	RETURN_ERROR_IF(chunk_size > CMP_ENTITY_MAX_ORIGINAL_SIZE, CHUNK_TOO_LARGE,
+			"chunk_size: %"PRIu32"", chunk_size);
+
+	chunk_type = cmp_col_get_chunk_type((const struct collection_hdr *)chunk);
+	RETURN_ERROR_IF(chunk_type == CHUNK_TYPE_UNKNOWN, COL_SUBSERVICE_UNSUPPORTED,
+			"unsupported subservice: %u",
+			cmp_col_get_subservice((const struct collection_hdr *)chunk));
+
+	cfg = batch->type_cfg[chunk_type];
+	cfg.cw_cache = cw_cache;
+
+	return compress_collections(batch->ctx, chunk, chunk_size,
+				    batch->chunk_models ? batch->chunk_models[i] : NULL,
+				    batch->updated_chunk_models ? batch->updated_chunk_models[i] : NULL,
+				    dst, dst ? batch->dst_capacities[i] : 0,
+				    &cfg, chunk_type, start_timestamp);
+}
+
+
+/**
+ * @brief compress a chunk of a batch as a job of the run_jobs function
+ *
+ * @param job_arg	pointer to a struct cmp_chunk_batch
+ * @param i		index of the chunk to compress
+ */
+
+static void compress_batch_job_run(void *job_arg, uint32_t i)
+{
+	const struct cmp_chunk_batch *batch = (const struct cmp_chunk_batch *)job_arg;
+	struct cw_table_cache cw_cache;
+
+	cw_cache_init(&cw_cache);
+	batch->cmp_sizes[i] = compress_batch_chunk(batch, i, &cw_cache);
+}
+
+
+/**
+ * @brief compress many data chunks with the same compression parameters
+ *
+ * The compression parameters are prepared only once for every chunk type and
+ * the code word tables are shared by all chunks. Every chunk gives the same
+ * result as compress_chunk_ctx() with the same context. If the context has a
+ * run_jobs function (see cmp_ctx_set_parallel()) the chunks are compressed in
+ * parallel, one job per chunk; the work buffer of the context is not needed.
+ * In this case the timestamp function of the context has to be thread-safe.
+ *
+ * @param ctx			pointer to a compression context initialised
+ *				with cmp_ctx_init()
+ * @param n_chunks		number of chunks to compress
+ * @param chunks		array of pointers to the chunks to compress
+ * @param chunk_sizes		array with the byte sizes of the chunks
+ * @param chunk_models		array of pointers to the models of the chunks
+ *				(can be NULL if no model compression mode is
+ *				used)
+ * @param updated_chunk_models	array of pointers to store the updated models
+ *				(can be NULL if the updated models are not
+ *				needed)
+ * @param dst			array of destination pointers to the
+ *				compressed data buffers; has to be 4-byte
+ *				aligned; can be NULL to only get the compressed
+ *				data sizes
+ * @param dst_capacities	array with the capacities of the dst buffers;
+ *				can be NULL if dst is NULL
+ * @param cmp_par		pointer to a compression parameters struct used
+ *				for all chunks
+ * @param cmp_sizes		array to store the byte size of the compressed
+ *				data or an error code (which can be tested with
+ *				cmp_is_error()) for every chunk
+ *
+ * @returns the number of successfully compressed chunks or an error code if
+ *	the arguments of the batch are invalid (which can be tested with
+ *	cmp_is_error())
+ */
+
+uint32_t compress_chunks_batch(const struct cmp_ctx *ctx, uint32_t n_chunks,
+			       const void *const chunks[], const uint32_t chunk_sizes[],
+			       const void *const chunk_models[], void *const updated_chunk_models[],
+			       uint32_t *const dst[], const uint32_t dst_capacities[],
+			       const struct cmp_par *cmp_par, uint32_t cmp_sizes[])
+{
+	struct cmp_chunk_batch batch;
+	uint32_t i, n_ok = 0;
+
+	RETURN_ERROR_IF(ctx == NULL, GENERIC, "compression context is NULL");
+	RETURN_ERROR_IF(cmp_par == NULL, PAR_NULL, "");
+	RETURN_ERROR_IF(chunks == NULL, CHUNK_NULL, "");
+	RETURN_ERROR_IF(chunk_sizes == NULL || cmp_sizes == NULL, GENERIC, "");
+	RETURN_ERROR_IF(dst && !dst_capacities, GENERIC, "");
+
+	batch.ctx = ctx;
+	batch.chunks = chunks;
+	batch.chunk_sizes = chunk_sizes;
+	batch.chunk_models = chunk_models;
+	batch.updated_chunk_models = updated_chunk_models;
+	batch.dst = dst;
+	batch.dst_capacities = dst_capacities;
+	batch.cmp_sizes = cmp_sizes;
+
+	prepare_batch_cfgs(&batch, n_chunks, cmp_par);
+
+	if (ctx->run_jobs && n_chunks) {
+		ctx->run_jobs(compress_batch_job_run, &batch, n_chunks, ctx->pool);
+	} else {
+		/* the code word tables are shared by all chunks */
+		struct cw_table_cache cw_cache;
+
+		cw_cache_init(&cw_cache);
+		for (i = 0; i < n_chunks; i++)
+			cmp_sizes[i] = compress_batch_chunk(&batch, i, &cw_cache);
+	}
+
+	for (i = 0; i < n_chunks; i++)
+		if (!cmp_is_error(cmp_sizes[i]))
+			n_ok++;
+
+	return n_ok;
+}
+
+
+/**
+ * @brief maximum number of compression parameters used by a chunk type
+ */
+
+#define CMP_MAX_CHUNK_PARS	6U
+
+
+/**
+ * @brief get the compression parameters used by a chunk type
+ *
+ * @param chunk_type	chunk type
+ * @param par		pointer to a compression parameters struct
+ * @param pars		array where the pointers to the used compression
+ *			parameters of the par struct are stored
+ *
+ * @returns the number of used compression parameters
+ */
+
+static unsigned int chunk_type_cmp_pars(enum chunk_type chunk_type, struct cmp_par *par,
+					uint32_t *pars[CMP_MAX_CHUNK_PARS])
+{
+	unsigned int n = 0;
+
+	switch (chunk_type) {
+	case CHUNK_TYPE_NCAM_IMAGETTE:
+		pars[n++] = &par->nc_imagette;
+		break;
+	case CHUNK_TYPE_SAT_IMAGETTE:
+		pars[n++] = &par->saturated_imagette;
+		break;
+	case CHUNK_TYPE_SHORT_CADENCE:
+		pars[n++] = &par->s_exp_flags;
+		pars[n++] = &par->s_fx;
+		pars[n++] = &par->s_ncob;
+		pars[n++] = &par->s_efx;
+		pars[n++] = &par->s_ecob;
+		break;
+	case CHUNK_TYPE_LONG_CADENCE:
+		pars[n++] = &par->l_exp_flags;
+		pars[n++] = &par->l_fx;
+		pars[n++] = &par->l_ncob;
+		pars[n++] = &par->l_efx;
+		pars[n++] = &par->l_ecob;
+		pars[n++] = &par->l_fx_cob_variance;
+		break;
+	case CHUNK_TYPE_OFFSET_BACKGROUND:
+		pars[n++] = &par->nc_offset_mean;
+		pars[n++] = &par->nc_offset_variance;
+		pars[n++] = &par->nc_background_mean;
+		pars[n++] = &par->nc_background_variance;
+		pars[n++] = &par->nc_background_outlier_pixels;
+		break;
+	case CHUNK_TYPE_SMEARING:
+		pars[n++] = &par->smearing_mean;
+		pars[n++] = &par->smearing_variance_mean;
+		pars[n++] = &par->smearing_outlier_pixels;
+		break;
+	case CHUNK_TYPE_F_CHAIN:
+		pars[n++] = &par->fc_imagette;
+		pars[n++] = &par->fc_offset_mean;
+		pars[n++] = &par->fc_offset_variance;
+		pars[n++] = &par->fc_background_mean;
+		pars[n++] = &par->fc_background_variance;
+		pars[n++] = &par->fc_background_outlier_pixels;
 		break;
 	case CHUNK_TYPE_UNKNOWN:
-	default: /*
-		  * default case never reached because cmp_col_get_chunk_type
-		  * returns CHUNK_TYPE_UNKNOWN if the type is unknown
-		  */
-		chunk_type = CHUNK_TYPE_UNKNOWN;
+	default:
 		break;
 	}
 
-	return chunk_type;
+	return n;
 }
 
 
 /**
- * @brief initialise the compress_chunk() function
+ * @brief arguments of the size-only trial compressions of
+ *	compress_chunk_to_budget()
+ */
+
+struct cmp_budget {
+	const struct cmp_ctx *ctx;	/**< compression context */
+	const void *chunk;		/**< chunk to compress */
+	uint32_t chunk_size;		/**< byte size of the chunk */
+	const void *chunk_model;	/**< model of the chunk; can be NULL */
+	uint32_t max_cmp_size;		/**< maximum byte size of the compression entity */
+	struct cmp_par *cmp_par;	/**< compression parameters to tune */
+};
+
+
+/**
+ * @brief calculate the compressed size of the chunk with a new value of a
+ *	compression parameter; the value is kept if the size is smaller
  *
- * If not initialised the compress_chunk() function sets the timestamps and
- * version_id in the compression entity header to zero
+ * @param budget	pointer to the budget arguments
+ * @param par		pointer to the compression parameter to change
+ * @param value		new value of the compression parameter
+ * @param size		pointer to the smallest compressed size so far; is
+ *			updated if the new value is kept
  *
- * @param return_timestamp	pointer to a function returning a current 48-bit
- *				timestamp
- * @param version_id		application software version identifier
+ * @returns non-zero if the new value is kept, zero if not or an error code if
+ *	the trial compression fails (which can be tested with cmp_is_error())
  */
 
-void compress_chunk_init(uint64_t (*return_timestamp)(void), uint32_t version_id)
+static uint32_t budget_try_par(const struct cmp_budget *budget, uint32_t *par,
+			       uint32_t value, uint32_t *size)
 {
-	if (return_timestamp)
-		get_timestamp = return_timestamp;
+	uint32_t const old_value = *par;
+	uint32_t new_size;
+
+	*par = value;
+	new_size = compress_chunk_ctx(budget->ctx, budget->chunk, budget->chunk_size,
+				      budget->chunk_model, NULL, NULL, 0,
+				      budget->cmp_par);
+	if (cmp_is_error(new_size)) {
+		*par = old_value;
+		return new_size;
+	}
+	if (new_size >= *size) {
+		*par = old_value;
+		return 0;
+	}
+	*size = new_size;
+	return 1;
+}
+
+
+/**
+ * @brief tune a compression parameter until the chunk fits in the budget or
+ *	no smaller compressed size is found
+ *
+ * The compressed size is assumed to be unimodal in the compression parameter.
+ * The parameter is doubled or halved as long as the size decreases; after
+ * that, the values in the middle of the neighbouring powers of two are tried.
+ *
+ * @param budget	pointer to the budget arguments
+ * @param par		pointer to the compression parameter to tune
+ * @param size		pointer to the compressed size with the current
+ *			parameters; is updated with the new size
+ *
+ * @returns zero on success or an error code if a trial compression fails
+ *	(which can be tested with cmp_is_error())
+ */
+
+static uint32_t budget_tune_par(const struct cmp_budget *budget, uint32_t *par,
+			       uint32_t *size)
+{
+	uint32_t const start_value = *par;
+	uint32_t kept, g;
+
+	/* search upwards */
+	while (*size > budget->max_cmp_size && *par <= MAX_NON_IMA_GOLOMB_PAR/2) {
+		kept = budget_try_par(budget, par, *par * 2, size);
+		FORWARD_IF_ERROR(kept, "");
+		if (!kept)
+			break;
+	}
+	/* search downwards, if a larger parameter is not better */
+	while (*par == start_value && *size > budget->max_cmp_size &&
+	       *par >= 2*MIN_NON_IMA_GOLOMB_PAR) {
+		kept = budget_try_par(budget, par, *par / 2, size);
+		FORWARD_IF_ERROR(kept, "");
+		if (!kept)
+			break;
+	}
+	/* refine between the neighbouring powers of two */
+	g = *par;
+	if (*size > budget->max_cmp_size && g <= MAX_NON_IMA_GOLOMB_PAR - g/2 && g >= 2)
+		FORWARD_IF_ERROR(budget_try_par(budget, par, g + g/2, size), "");
+	if (*size > budget->max_cmp_size && *par == g && g >= 4)
+		FORWARD_IF_ERROR(budget_try_par(budget, par, g - g/4, size), "");
 
-	version_identifier = version_id;
+	return 0;
 }
 
 
 /**
- * @brief compress a data chunk consisting of put together data collections
+ * @brief compress a data chunk so that the compression entity fits in a
+ *	maximum size
  *
+ * The compressed size with the given compression parameters is calculated
+ * first (without writing any data). If it is larger than max_cmp_size, the
+ * compression parameters used by the chunk type are tuned one after another
+ * with size-only trial compressions until the compressed size fits. Only then
+ * the chunk is compressed into the dst buffer. The tuned parameters are
+ * returned in cmp_par, so they can be the starting point for the next chunk.
+ *
+ * @param ctx			pointer to a compression context initialised
+ *				with cmp_ctx_init()
  * @param chunk			pointer to the chunk to be compressed
  * @param chunk_size		byte size of the chunk
  * @param chunk_model		pointer to a model of a chunk; has the same size
@@ -2105,131 +4832,540 @@ void compress_chunk_init(uint64_t (*return_timestamp)(void), uint32_t version_id
  *				model mode compression; has the same size as the
  *				chunk (can be the same as the model_of_data
  *				buffer for in-place update or NULL if updated
- *				model is not needed)
+ *				model is not needed); not used if dst is NULL
  * @param dst			destination pointer to the compressed data
  *				buffer; has to be 4-byte aligned; can be NULL to
- *				only get the compressed data size
- * @param dst_capacity		capacity of the dst buffer; it's recommended to
- *				provide a dst_capacity >=
- *				compress_chunk_cmp_size_bound(chunk, chunk_size)
- *				as it eliminates one potential failure scenario:
- *				not enough space in the dst buffer to write the
- *				compressed data; size is internally rounded down
- *				to a multiple of 4
- * @param cmp_par		pointer to a compression parameters struct
+ *				only tune the compression parameters
+ * @param max_cmp_size		maximum byte size of the compression entity;
+ *				the dst buffer must be at least this large;
+ *				size is internally rounded down to a multiple
+ *				of 4
+ * @param cmp_par		pointer to a compression parameters struct with
+ *				valid start parameters; the tuned parameters
+ *				are stored there
+ *
  * @returns the byte size of the compressed data or an error code if it
- *	fails (which can be tested with cmp_is_error())
+ *	fails (which can be tested with cmp_is_error()); if no parameters are
+ *	found for which the chunk fits, a CMP_ERROR_SMALL_BUFFER error is
+ *	returned
  */
 
-uint32_t compress_chunk(const void *chunk, uint32_t chunk_size,
-			const void *chunk_model, void *updated_chunk_model,
-			uint32_t *dst, uint32_t dst_capacity,
-			const struct cmp_par *cmp_par)
+uint32_t compress_chunk_to_budget(const struct cmp_ctx *ctx,
+				  const void *chunk, uint32_t chunk_size,
+				  const void *chunk_model, void *updated_chunk_model,
+				  uint32_t *dst, uint32_t max_cmp_size,
+				  struct cmp_par *cmp_par)
 {
-	uint64_t const start_timestamp = get_timestamp();
-	const struct collection_hdr *col = (const struct collection_hdr *)chunk;
-	enum chunk_type chunk_type;
-	struct cmp_cfg cfg;
-	uint32_t cmp_size_byte; /* size of the compressed data in bytes */
-	size_t read_bytes;
+	struct cmp_budget budget;
+	uint32_t *pars[CMP_MAX_CHUNK_PARS];
+	unsigned int n_pars, i;
+	uint32_t size;
+
+	RETURN_ERROR_IF(ctx == NULL, GENERIC, "compression context is NULL");
+	RETURN_ERROR_IF(cmp_par == NULL, PAR_NULL, "");
+
+	budget.ctx = ctx;
+	budget.chunk = chunk;
+	budget.chunk_size = chunk_size;
+	budget.chunk_model = chunk_model;
+	/* the dst buffer is written in 4-byte words */
+	budget.max_cmp_size = max_cmp_size & ~0x3U;
+	budget.cmp_par = cmp_par;
+
+	/* the size-only compression also checks all arguments */
+	size = compress_chunk_ctx(ctx, chunk, chunk_size, chunk_model, NULL,
+				  NULL, 0, cmp_par);
+	FORWARD_IF_ERROR(size, "");
+
+	if (size > budget.max_cmp_size && cmp_par->cmp_mode != CMP_MODE_RAW) {
+		n_pars = chunk_type_cmp_pars(cmp_col_get_chunk_type(chunk),
+					     cmp_par, pars);
+		for (i = 0; i < n_pars && size > budget.max_cmp_size; i++)
+			FORWARD_IF_ERROR(budget_tune_par(&budget, pars[i], &size), "");
+	}
+
+	RETURN_ERROR_IF(size > budget.max_cmp_size, SMALL_BUFFER,
+			"the smallest found compressed size %"PRIu32" is larger than the budget of %"PRIu32" bytes",
+			size, budget.max_cmp_size);
+
+	if (!dst)
+		return size;
+
+	return compress_chunk_ctx(ctx, chunk, chunk_size, chunk_model,
+				  updated_chunk_model, dst, max_cmp_size, cmp_par);
+}
+
+
+/**
+ * @brief start the compression of a chunk collection by collection
+ *
+ * The collections of the chunk are added one after another with
+ * compress_chunk_add_collection() as they arrive; compress_chunk_finish()
+ * completes the compression entity. The chunk does not need to exist in one
+ * contiguous buffer. The result is identical to the result of
+ * compress_chunk_ctx() of the concatenated collections (compressed
+ * sequentially).
+ *
+ * @param ctx		pointer to a compression context initialised with
+ *			cmp_ctx_init(); holds the state of the compression
+ *			until compress_chunk_finish() is called
+ * @param dst		destination pointer to the compressed data buffer; has
+ *			to be 4-byte aligned; can be NULL to only get the
+ *			compressed data size, in this case no updated model
+ *			is created
+ * @param dst_capacity	capacity of the dst buffer
+ * @param cmp_par	pointer to a compression parameters struct; the
+ *			parameters are copied into the context
+ *
+ * @returns the byte size of the compression entity header reserved in the dst
+ *	buffer or an error code if it fails (which can be tested with
+ *	cmp_is_error())
+ */
+
+uint32_t compress_chunk_begin(struct cmp_ctx *ctx, uint32_t *dst, uint32_t dst_capacity,
+			      const struct cmp_par *cmp_par)
+{
+	uint32_t hdr_size;
+
+	RETURN_ERROR_IF(ctx == NULL, GENERIC, "compression context is NULL");
+	ctx->stream.cmp_size = 0;
+	RETURN_ERROR_IF(cmp_par == NULL, PAR_NULL, "");
+
+	ctx->stream.start_timestamp = get_timestamp(ctx);
+	ctx->stream.par = *cmp_par;
+	ctx->stream.dst = dst;
+	ctx->stream.dst_capacity = dst_capacity;
+	ctx->stream.chunk_size = 0;
+
+	/* the size of the entity header only depends on the compression mode */
+	memset(&ctx->stream.cfg, 0, sizeof(ctx->stream.cfg));
+	ctx->stream.cfg.cmp_mode = cmp_par->cmp_mode;
+	hdr_size = cmp_ent_build_chunk_header(NULL, 0, ctx, &ctx->stream.cfg, 0, 0);
+	RETURN_ERROR_IF(dst && dst_capacity < hdr_size, SMALL_BUFFER,
+			"dst_capacity must be at least as large as the minimum size of the compression unit.");
+
+	ctx->stream.cmp_size = hdr_size;
+	return hdr_size;
+}
+
+
+/**
+ * @brief compress a collection and append it to the compressed chunk
+ *
+ * @param ctx		pointer to the compression context
+ * @param col		pointer to the collection
+ * @param col_size	byte size of the collection
+ * @param model_col	pointer to the model of the collection
+ * @param up_model_col	pointer to store the updated model of the collection
+ *
+ * @returns the byte size of the compressed data so far or an error code if
+ *	it fails
+ */
+
+static uint32_t stream_add_collection(struct cmp_ctx *ctx,
+				      const struct collection_hdr *col, uint32_t col_size,
+				      const void *model_col, void *up_model_col)
+{
+	struct cw_table_cache cw_cache;
+	uint32_t cmp_size;
+
+	RETURN_ERROR_IF(ctx->stream.chunk_size + col_size > CMP_ENTITY_MAX_ORIGINAL_SIZE,
+			CHUNK_TOO_LARGE, "chunk_size: %"PRIu32"", ctx->stream.chunk_size + col_size);
+
+	if (ctx->stream.chunk_size == 0) {
+		ctx->stream.chunk_type = init_cmp_cfg_from_cmp_par(col, &ctx->stream.par,
+								   &ctx->stream.cfg);
+		RETURN_ERROR_IF(ctx->stream.chunk_type == CHUNK_TYPE_UNKNOWN, COL_SUBSERVICE_UNSUPPORTED,
+				"unsupported subservice: %u", cmp_col_get_subservice(col));
+		ctx->stream.cfg.col_pars = (uint32_t)ctx->col_pars;
+		ctx->stream.cfg.equal_model = (uint32_t)ctx->equal_model;
+	}
+	RETURN_ERROR_IF(cmp_col_get_chunk_type(col) != (enum chunk_type)ctx->stream.chunk_type,
+			CHUNK_SUBSERVICE_INCONSISTENT, "");
+
+	/* the updated model is not needed if only the size is calculated */
+	if (!ctx->stream.dst)
+		up_model_col = NULL;
+
+	/* do not use the model buffers of the previous collection */
+	ctx->stream.cfg.model_buf = NULL;
+	ctx->stream.cfg.updated_model_buf = NULL;
+	cw_cache_init(&cw_cache);
+	ctx->stream.cfg.cw_cache = &cw_cache;
+	cmp_size = cmp_collection((const uint8_t *)col, (const uint8_t *)model_col,
+				  (uint8_t *)up_model_col, ctx->stream.dst,
+				  ctx->stream.dst_capacity, &ctx->stream.cfg,
+				  ctx->stream.cmp_size);
+	ctx->stream.cfg.cw_cache = NULL;
+	FORWARD_IF_ERROR(cmp_size, "error occurred when compressing the collection with offset %u",
+			 ctx->stream.chunk_size);
+
+	ctx->stream.chunk_size += col_size;
+	return cmp_size;
+}
+
+
+/**
+ * @brief compress the next collection of a chunk started with
+ *	compress_chunk_begin()
+ *
+ * After an error, the compression has to be restarted with
+ * compress_chunk_begin(); all following calls return the same error.
+ *
+ * @param ctx		pointer to the compression context
+ * @param col		pointer to the collection (collection header followed
+ *			by the collection data)
+ * @param model_col	pointer to the model of the collection; has the same
+ *			size as the collection (can be NULL if no model
+ *			compression mode is used)
+ * @param up_model_col	pointer to store the updated model of the collection;
+ *			has the same size as the collection (can be the same
+ *			as the model_col buffer for in-place update or NULL if
+ *			updated model is not needed)
+ *
+ * @returns the byte size of the compressed data so far (including the
+ *	compression entity header) or an error code if it fails (which can be
+ *	tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_add_collection(struct cmp_ctx *ctx, const void *col,
+				       const void *model_col, void *up_model_col)
+{
+	RETURN_ERROR_IF(ctx == NULL, GENERIC, "compression context is NULL");
+	FORWARD_IF_ERROR(ctx->stream.cmp_size, "");
+	RETURN_ERROR_IF(ctx->stream.cmp_size == 0, GENERIC, "compress_chunk_begin() is not called");
+
+	if (col == NULL)
+		ctx->stream.cmp_size = CMP_ERROR(CHUNK_NULL);
+	else
+		ctx->stream.cmp_size = stream_add_collection(ctx, (const struct collection_hdr *)col,
+							     cmp_col_get_size((const struct collection_hdr *)col),
+							     model_col, up_model_col);
+	return ctx->stream.cmp_size;
+}
+
+
+/**
+ * @brief complete the compression of a chunk started with
+ *	compress_chunk_begin() by building the compression entity header
+ *
+ * @param ctx	pointer to the compression context
+ *
+ * @returns the byte size of the compressed data (size of the compression
+ *	entity) or an error code if it fails (which can be tested with
+ *	cmp_is_error())
+ */
+
+uint32_t compress_chunk_finish(struct cmp_ctx *ctx)
+{
+	uint32_t cmp_size;
 
+	RETURN_ERROR_IF(ctx == NULL, GENERIC, "compression context is NULL");
+	cmp_size = ctx->stream.cmp_size;
+	ctx->stream.cmp_size = 0;
+	FORWARD_IF_ERROR(cmp_size, "");
+	RETURN_ERROR_IF(cmp_size == 0, GENERIC, "compress_chunk_begin() is not called");
+	RETURN_ERROR_IF(ctx->stream.chunk_size == 0, CHUNK_SIZE_INCONSISTENT,
+			"no collection is added");
+
+	FORWARD_IF_ERROR(cmp_ent_build_chunk_header(ctx->stream.dst, ctx->stream.chunk_size,
+						    ctx, &ctx->stream.cfg,
+						    ctx->stream.start_timestamp, cmp_size), "");
+
+	return cmp_size;
+}
+
+
+/*
+ * byte offsets and sizes of the compression entity header fields, which are
+ * only known at the end of a resumable compression
+ */
+#define CMP_ENT_SIZE_OFFSET		4
+#define CMP_ENT_SIZE_LEN		3
+#define CMP_ENT_END_TIMESTAMP_OFFSET	16
+#define CMP_ENT_TIMESTAMP_LEN		6
+
+
+/**
+ * @brief start a resumable compression of a chunk, which puts the compression
+ *	entity piece by piece into output buffers of any size
+ *
+ * The collections are compressed one after another into the collection buffer
+ * and copied from there into the output buffers given to
+ * compress_chunk_resume(). No buffer for the whole compression entity is
+ * needed. The fields of the entity header which are only known at the end
+ * (entity size and end timestamp) are returned as back-patch table by
+ * compress_chunk_resume_finish(). After applying the back-patch table, the
+ * compression entity is identical to the result of compress_chunk_ctx() with
+ * the same context.
+ *
+ * @param ctx			pointer to a compression context initialised
+ *				with cmp_ctx_init(); holds the state of the
+ *				compression until compress_chunk_resume_finish()
+ *				is called
+ * @param chunk			pointer to the chunk to be compressed; has to
+ *				stay valid until the compression is finished
+ * @param chunk_size		byte size of the chunk
+ * @param chunk_model		pointer to a model of a chunk; has the same size
+ *				as the chunk (can be NULL if no model compression
+ *				mode is used)
+ * @param updated_chunk_model	pointer to store the updated model for the next
+ *				model mode compression; has the same size as the
+ *				chunk (can be the same as the model_of_data
+ *				buffer for in-place update or NULL if updated
+ *				model is not needed)
+ * @param col_buf		pointer to a buffer for one compressed
+ *				collection; has to be 4-byte aligned
+ * @param col_buf_size		byte size of the collection buffer; has to be
+ *				at least 3 + CMP_COLLECTION_FILD_SIZE + the size
+ *				of the largest collection of the chunk (see
+ *				COMPRESS_CHUNK_RESUME_COL_BUF_SIZE)
+ * @param cmp_par		pointer to a compression parameters struct; the
+ *				parameters are copied into the context
+ *
+ * @returns the byte size of the compression entity header or an error code if
+ *	it fails (which can be tested with cmp_is_error())
+ */
+
+uint32_t compress_chunk_resume_begin(struct cmp_ctx *ctx,
+				     const void *chunk, uint32_t chunk_size,
+				     const void *chunk_model, void *updated_chunk_model,
+				     uint32_t *col_buf, uint32_t col_buf_size,
+				     const struct cmp_par *cmp_par)
+{
+	uint32_t hdr_size;
+
+	RETURN_ERROR_IF(ctx == NULL, GENERIC, "compression context is NULL");
+	ctx->stream.cmp_size = 0;
 	RETURN_ERROR_IF(chunk == NULL, CHUNK_NULL, "");
 	RETURN_ERROR_IF(cmp_par == NULL, PAR_NULL, "");
+	RETURN_ERROR_IF(col_buf == NULL, PAR_BUFFERS, "collection buffer is NULL");
 	RETURN_ERROR_IF(chunk_size < COLLECTION_HDR_SIZE, CHUNK_SIZE_INCONSISTENT,
 			"chunk_size: %"PRIu32"", chunk_size);
 	RETURN_ERROR_IF(chunk_size > CMP_ENTITY_MAX_ORIGINAL_SIZE, CHUNK_TOO_LARGE,
 			"chunk_size: %"PRIu32"", chunk_size);
 
-	chunk_type = init_cmp_cfg_from_cmp_par(col, cmp_par, &cfg);
-	RETURN_ERROR_IF(chunk_type == CHUNK_TYPE_UNKNOWN, COL_SUBSERVICE_UNSUPPORTED,
-			"unsupported subservice: %u", cmp_col_get_subservice(col));
+	ctx->stream.start_timestamp = get_timestamp(ctx);
+	ctx->stream.par = *cmp_par;
+	ctx->stream.chunk_size = chunk_size;
+	ctx->stream.chunk_type = init_cmp_cfg_from_cmp_par(chunk, cmp_par, &ctx->stream.cfg);
+	RETURN_ERROR_IF(ctx->stream.chunk_type == CHUNK_TYPE_UNKNOWN, COL_SUBSERVICE_UNSUPPORTED,
+			"unsupported subservice: %u",
+			cmp_col_get_subservice((const struct collection_hdr *)chunk));
+	ctx->stream.cfg.col_pars = (uint32_t)ctx->col_pars;
+	ctx->stream.cfg.equal_model = (uint32_t)ctx->equal_model;
+
+	ctx->resume.chunk = chunk;
+	ctx->resume.chunk_model = chunk_model;
+	ctx->resume.updated_chunk_model = updated_chunk_model;
+	ctx->resume.col_buf = col_buf;
+	ctx->resume.col_buf_size = col_buf_size;
+	ctx->resume.read_bytes = 0;
+
+	/* the entity size and the end timestamp are set again at the end */
+	memset(ctx->resume.hdr, 0, sizeof(ctx->resume.hdr));
+	hdr_size = cmp_ent_build_chunk_header(NULL, chunk_size, ctx, &ctx->stream.cfg,
+					      ctx->stream.start_timestamp, 0);
+	FORWARD_IF_ERROR(cmp_ent_build_chunk_header(ctx->resume.hdr, chunk_size, ctx,
+						    &ctx->stream.cfg,
+						    ctx->stream.start_timestamp, hdr_size), "");
+	ctx->resume.pending = (const uint8_t *)ctx->resume.hdr;
+	ctx->resume.pending_size = hdr_size;
+
+	ctx->stream.cmp_size = hdr_size;
+	return hdr_size;
+}
 
-	/* reserve space for the compression entity header, we will build the
-	 * header after the compression of the chunk
-	 */
-	cmp_size_byte = cmp_ent_build_chunk_header(NULL, chunk_size, &cfg, start_timestamp, 0);
-	RETURN_ERROR_IF(dst && dst_capacity < cmp_size_byte, SMALL_BUFFER,
-			"dst_capacity must be at least as large as the minimum size of the compression unit.");
 
+/**
+ * @brief compress the next collection of a resumable compression into the
+ *	collection buffer
+ *
+ * The collection is compressed at the same offset modulo 4 as in the
+ * compression entity, so that the result is identical to compress_chunk().
+ *
+ * @param ctx	pointer to the compression context
+ *
+ * @returns the byte size of the compressed data so far (including the
+ *	compression entity header) or an error code if it fails
+ */
 
-	/* compress one collection after another */
-	for (read_bytes = 0;
-	     read_bytes <= chunk_size - COLLECTION_HDR_SIZE;
-	     read_bytes += cmp_col_get_size(col)) {
-		const uint8_t *col_model = NULL;
-		uint8_t *col_up_model = NULL;
+static uint32_t resume_next_collection(struct cmp_ctx *ctx)
+{
+	const struct collection_hdr *col =
+		(const struct collection_hdr *)(ctx->resume.chunk + ctx->resume.read_bytes);
+	uint32_t const col_offset = ctx->stream.cmp_size & 0x3;
+	uint32_t const read_bytes = ctx->resume.read_bytes;
+	struct cw_table_cache cw_cache;
+	uint32_t col_size, cmp_size;
+
+	RETURN_ERROR_IF(cmp_col_get_chunk_type(col) != (enum chunk_type)ctx->stream.chunk_type,
+			CHUNK_SUBSERVICE_INCONSISTENT, "");
+	col_size = cmp_col_get_size(col);
+	RETURN_ERROR_IF(read_bytes + col_size > ctx->stream.chunk_size,
+			CHUNK_SIZE_INCONSISTENT, "");
+	RETURN_ERROR_IF(col_offset + CMP_COLLECTION_FILD_SIZE + col_size > ctx->resume.col_buf_size,
+			SMALL_BUFFER, "the collection buffer is too small for the collection with offset %"PRIu32"",
+			read_bytes);
+
+	/* do not use the model buffers of the previous collection */
+	ctx->stream.cfg.model_buf = NULL;
+	ctx->stream.cfg.updated_model_buf = NULL;
+	cw_cache_init(&cw_cache);
+	ctx->stream.cfg.cw_cache = &cw_cache;
+	cmp_size = cmp_collection((const uint8_t *)col,
+				  ctx->resume.chunk_model ?
+					ctx->resume.chunk_model + read_bytes : NULL,
+				  ctx->resume.updated_chunk_model ?
+					ctx->resume.updated_chunk_model + read_bytes : NULL,
+				  ctx->resume.col_buf, ctx->resume.col_buf_size,
+				  &ctx->stream.cfg, col_offset);
+	ctx->stream.cfg.cw_cache = NULL;
+	FORWARD_IF_ERROR(cmp_size, "error occurred when compressing the collection with offset %"PRIu32"",
+			 read_bytes);
+
+	ctx->resume.pending = (const uint8_t *)ctx->resume.col_buf + col_offset;
+	ctx->resume.pending_size = cmp_size - col_offset;
+	ctx->resume.read_bytes += col_size;
+
+	return ctx->stream.cmp_size + ctx->resume.pending_size;
+}
 
-		/* setup pointers for the next collection we want to compress */
-		col = (const struct collection_hdr *)((const uint8_t *)chunk + read_bytes);
-		if (chunk_model)
-			col_model = (const uint8_t *)chunk_model + read_bytes;
-		if (updated_chunk_model)
-			col_up_model = (uint8_t *)updated_chunk_model + read_bytes;
 
-		RETURN_ERROR_IF(cmp_col_get_chunk_type(col) != chunk_type, CHUNK_SUBSERVICE_INCONSISTENT, "");
+/**
+ * @brief continue a compression started with compress_chunk_resume_begin()
+ *	and put the next part of the compression entity into an output buffer
+ *
+ * After an error, the compression has to be restarted with
+ * compress_chunk_resume_begin(); all following calls return the same error.
+ *
+ * @param ctx		pointer to the compression context
+ * @param dst		pointer to the output buffer
+ * @param dst_capacity	byte size of the output buffer
+ * @param dst_size	pointer to store the number of bytes put into the output
+ *			buffer
+ *
+ * @returns 0 if the compression entity is complete, CMP_NEED_MORE_OUTPUT if
+ *	the output buffer is full and the function has to be called again with
+ *	the next output buffer, or an error code if it fails (which can be
+ *	tested with cmp_is_error())
+ */
 
-		/* chunk size is inconsistent with the sum of sizes in the collection headers */
-		if (read_bytes + cmp_col_get_size(col) > chunk_size)
-			break;
+uint32_t compress_chunk_resume(struct cmp_ctx *ctx, void *dst, uint32_t dst_capacity,
+			       uint32_t *dst_size)
+{
+	uint32_t written = 0;
+
+	RETURN_ERROR_IF(ctx == NULL, GENERIC, "compression context is NULL");
+	RETURN_ERROR_IF(dst_size == NULL, GENERIC, "dst_size is NULL");
+	*dst_size = 0;
+	FORWARD_IF_ERROR(ctx->stream.cmp_size, "");
+	RETURN_ERROR_IF(ctx->stream.cmp_size == 0, GENERIC,
+			"compress_chunk_resume_begin() is not called");
+	RETURN_ERROR_IF(dst == NULL && dst_capacity, GENERIC, "dst is NULL");
+
+	while (1) {
+		uint32_t n = ctx->resume.pending_size;
+
+		if (n > dst_capacity - written)
+			n = dst_capacity - written;
+		memcpy((uint8_t *)dst + written, ctx->resume.pending, n);
+		ctx->resume.pending += n;
+		ctx->resume.pending_size -= n;
+		written += n;
+		*dst_size = written;
+
+		if (ctx->resume.pending_size)
+			return CMP_NEED_MORE_OUTPUT;
+
+		/* the remaining bytes are too few for a collection */
+		if (ctx->resume.read_bytes + COLLECTION_HDR_SIZE > ctx->stream.chunk_size) {
+			if (ctx->resume.read_bytes == ctx->stream.chunk_size)
+				return 0;
+			ctx->stream.cmp_size = CMP_ERROR(CHUNK_SIZE_INCONSISTENT);
+			return ctx->stream.cmp_size;
+		}
+		if (written == dst_capacity)
+			return CMP_NEED_MORE_OUTPUT;
 
-		cmp_size_byte = cmp_collection((const uint8_t *)col, col_model, col_up_model,
-					       dst, dst_capacity, &cfg, cmp_size_byte);
-		FORWARD_IF_ERROR(cmp_size_byte, "error occurred when compressing the collection with offset %u", read_bytes);
+		ctx->stream.cmp_size = resume_next_collection(ctx);
+		FORWARD_IF_ERROR(ctx->stream.cmp_size, "");
 	}
+}
 
-	RETURN_ERROR_IF(read_bytes != chunk_size, CHUNK_SIZE_INCONSISTENT, "");
 
-	FORWARD_IF_ERROR(cmp_ent_build_chunk_header(dst, chunk_size, &cfg,
-					    start_timestamp, cmp_size_byte), "");
+/**
+ * @brief complete a compression started with compress_chunk_resume_begin()
+ *
+ * @param ctx		pointer to the compression context
+ * @param patches	pointer to store the back-patch table; the entries have
+ *			to be applied to the output buffers (see
+ *			compress_chunk_apply_patches())
+ *
+ * @returns the byte size of the compression entity or an error code if it
+ *	fails (which can be tested with cmp_is_error())
+ */
 
-	return cmp_size_byte;
+uint32_t compress_chunk_resume_finish(struct cmp_ctx *ctx, struct cmp_patch_table *patches)
+{
+	const uint8_t *hdr;
+	uint32_t cmp_size;
+
+	RETURN_ERROR_IF(ctx == NULL, GENERIC, "compression context is NULL");
+	cmp_size = ctx->stream.cmp_size;
+	ctx->stream.cmp_size = 0;
+	FORWARD_IF_ERROR(cmp_size, "");
+	RETURN_ERROR_IF(cmp_size == 0, GENERIC, "compress_chunk_resume_begin() is not called");
+	RETURN_ERROR_IF(patches == NULL, GENERIC, "patches is NULL");
+	RETURN_ERROR_IF(ctx->resume.pending_size || ctx->resume.read_bytes != ctx->stream.chunk_size,
+			GENERIC, "the compression entity is not complete");
+
+	FORWARD_IF_ERROR(cmp_ent_build_chunk_header(ctx->resume.hdr, ctx->stream.chunk_size,
+						    ctx, &ctx->stream.cfg,
+						    ctx->stream.start_timestamp, cmp_size), "");
+	hdr = (const uint8_t *)ctx->resume.hdr;
+
+	patches->n_patches = 2;
+	patches->patch[0].offset = CMP_ENT_SIZE_OFFSET;
+	patches->patch[0].size = CMP_ENT_SIZE_LEN;
+	memcpy(patches->patch[0].data, hdr + CMP_ENT_SIZE_OFFSET, CMP_ENT_SIZE_LEN);
+	patches->patch[1].offset = CMP_ENT_END_TIMESTAMP_OFFSET;
+	patches->patch[1].size = CMP_ENT_TIMESTAMP_LEN;
+	memcpy(patches->patch[1].data, hdr + CMP_ENT_END_TIMESTAMP_OFFSET, CMP_ENT_TIMESTAMP_LEN);
+
+	return cmp_size;
 }
 
 
 /**
- * @brief returns the maximum compressed size in a worst-case scenario
- * In case the input data is not compressible
- * This function is primarily useful for memory allocation purposes
- * (destination buffer size).
- *
- * @note if the number of collections is known you can use the
- *	COMPRESS_CHUNK_BOUND macro for compilation-time evaluation
- *	(stack memory allocation for example)
- *
- * @param chunk		pointer to the chunk you want to compress
- * @param chunk_size	size of the chunk in bytes
+ * @brief apply the entries of a back-patch table to a part of a compression
+ *	entity
  *
- * @returns maximum compressed size for a chunk compression on success or an
- *	error code if it fails (which can be tested with cmp_is_error())
+ * @param buf		pointer to the part of the compression entity, e.g. an
+ *			output buffer of compress_chunk_resume()
+ * @param buf_offset	byte offset of the part in the compression entity
+ * @param buf_size	byte size of the part
+ * @param patches	pointer to the back-patch table
  */
 
-uint32_t compress_chunk_cmp_size_bound(const void *chunk, size_t chunk_size)
+void compress_chunk_apply_patches(void *buf, uint32_t buf_offset, uint32_t buf_size,
+				  const struct cmp_patch_table *patches)
 {
-	int32_t read_bytes;
-	uint32_t num_col = 0;
-	size_t bound;
-	size_t const max_chunk_size = CMP_ENTITY_MAX_ORIGINAL_SIZE
-		- NON_IMAGETTE_HEADER_SIZE - CMP_COLLECTION_FILD_SIZE;
-
-	RETURN_ERROR_IF(chunk == NULL, CHUNK_NULL, "");
-	RETURN_ERROR_IF(chunk_size < COLLECTION_HDR_SIZE, CHUNK_SIZE_INCONSISTENT, "");
-	RETURN_ERROR_IF(chunk_size > max_chunk_size, CHUNK_TOO_LARGE,
-			"chunk_size: %"PRIu32" > max_chunk_size: %"PRIu32"",
-			chunk_size, max_chunk_size);
+	uint32_t i, j;
 
-	/* count the number of collections in the chunk */
-	for (read_bytes = 0;
-	     read_bytes <= (int32_t)(chunk_size-COLLECTION_HDR_SIZE);
-	     read_bytes += cmp_col_get_size((const struct collection_hdr *)
-					    ((const uint8_t *)chunk + read_bytes)))
-		num_col++;
+	if (!buf || !patches)
+		return;
 
-	RETURN_ERROR_IF((uint32_t)read_bytes != chunk_size, CHUNK_SIZE_INCONSISTENT, "");
+	for (i = 0; i < patches->n_patches && i < ARRAY_SIZE(patches->patch); i++) {
+		const struct cmp_patch *patch = &patches->patch[i];
 
-	bound = COMPRESS_CHUNK_BOUND_UNSAFE(chunk_size, num_col);
-	RETURN_ERROR_IF(bound > CMP_ENTITY_MAX_SIZE, CHUNK_TOO_LARGE, "bound: %lu", bound);
+		for (j = 0; j < patch->size && j < CMP_PATCH_MAX_SIZE; j++) {
+			uint32_t const pos = patch->offset + j;
 
-	return (uint32_t)bound;
+			if (pos >= buf_offset && pos - buf_offset < buf_size)
+				((uint8_t *)buf)[pos - buf_offset] = patch->data[j];
+		}
+	}
 }
 
 
@@ -2275,15 +5411,24 @@ uint32_t compress_chunk_set_model_id_and_counter(void *dst, uint32_t dst_size,
  * @returns the bit length of the bitstream on success or an error code if it
  *	fails (which can be tested with cmp_is_error())
  *
+ * @note if no output buffer (icu_output_buf) is set, only the size of the
+ *	compressed data is calculated and no updated model is created
  * @warning only the small buffer error in the info.cmp_err field is implemented
  */
 
 uint32_t compress_like_rdcu(const struct rdcu_cfg *rcfg, struct cmp_info *info)
 {
 	struct cmp_cfg cfg;
-	uint32_t cmp_size_bit;
+	struct cw_table_cache cw_cache;
+	uint32_t cmp_size_bit, cfg_error;
+	struct ima_size_probe probe[2];
+	unsigned int i, n_probes = 0;
+	uint32_t ap_par[2], ap_spill[2];
+	uint32_t *ap_size[2];
 
 	memset(&cfg, 0, sizeof(cfg));
+	cw_cache_init(&cw_cache);
+	cfg.cw_cache = &cw_cache;
 
 	if (info)
 		memset(info, 0, sizeof(*info));
@@ -2314,29 +5459,71 @@ uint32_t compress_like_rdcu(const struct rdcu_cfg *rcfg, struct cmp_info *info)
 		info->cmp_size = 0;
 		info->ap1_cmp_size = 0;
 		info->ap2_cmp_size = 0;
-
-		cfg.cmp_par_imagette = rcfg->ap1_golomb_par;
-		cfg.spill_imagette = rcfg->ap1_spill;
-		if (cfg.cmp_par_imagette &&
-		    cmp_cfg_icu_is_invalid_error_code(&cfg) == CMP_ERROR_NO_ERROR)
-			info->ap1_cmp_size = compress_data_internal(&cfg, 0);
-
-
-		cfg.cmp_par_imagette = rcfg->ap2_golomb_par;
-		cfg.spill_imagette = rcfg->ap2_spill;
-		if (cfg.cmp_par_imagette &&
-		    cmp_cfg_icu_is_invalid_error_code(&cfg) == CMP_ERROR_NO_ERROR)
-			info->ap2_cmp_size = compress_data_internal(&cfg, 0);
 	}
 
 	cfg.cmp_par_imagette = rcfg->golomb_par;
 	cfg.spill_imagette = rcfg->spill;
-	cfg.updated_model_buf = rcfg->icu_new_model_buf;
 	cfg.dst = rcfg->icu_output_buf;
+	if (cfg.dst) /* no updated model needed if only the size is calculated */
+		cfg.updated_model_buf = rcfg->icu_new_model_buf;
+
+	cfg_error = cmp_cfg_icu_is_invalid_error_code(&cfg);
 
-	FORWARD_IF_ERROR(cmp_cfg_icu_is_invalid_error_code(&cfg), "");
+	if (info) {
+		/*
+		 * The sizes of the adaptive parameters are calculated in the
+		 * same pass as the compression (see struct ima_size_probe);
+		 * this is not possible if the imagette is not encoded
+		 */
+		int const combined = !cmp_is_error(cfg_error) && cfg.samples &&
+			!raw_mode_is_used(cfg.cmp_mode);
+		struct cmp_cfg ap_cfg = cfg;
+
+		ap_cfg.dst = NULL;
+		ap_cfg.updated_model_buf = NULL;
+		ap_par[0] = rcfg->ap1_golomb_par;
+		ap_spill[0] = rcfg->ap1_spill;
+		ap_size[0] = &info->ap1_cmp_size;
+		ap_par[1] = rcfg->ap2_golomb_par;
+		ap_spill[1] = rcfg->ap2_spill;
+		ap_size[1] = &info->ap2_cmp_size;
+
+		for (i = 0; i < ARRAY_SIZE(ap_par); i++) {
+			ap_cfg.cmp_par_imagette = ap_par[i];
+			ap_cfg.spill_imagette = ap_spill[i];
+			if (!ap_cfg.cmp_par_imagette ||
+			    cmp_cfg_icu_is_invalid_error_code(&ap_cfg) != CMP_ERROR_NO_ERROR)
+				continue;
+
+			if (combined) {
+				struct ima_size_probe *p = &probe[n_probes++];
+
+				p->cmp_par = ap_cfg.cmp_par_imagette;
+				p->spill = ap_cfg.spill_imagette;
+				p->variant = select_encoder_variant(&ap_cfg);
+				p->cmp_size = ap_size[i];
+			} else {
+				*ap_size[i] = compress_data_internal(&ap_cfg, 0);
+			}
+		}
+	}
 
-	cmp_size_bit = compress_data_internal(&cfg, 0);
+	FORWARD_IF_ERROR(cfg_error, "");
+
+	if (n_probes) {
+		struct bit_encoder enc;
+
+		bit_init_encoder(&enc, cfg.dst, cmp_stream_size_to_bits(cfg.stream_size), 0);
+		cmp_size_bit = compress_imagette_probed(&cfg, &enc, select_encoder_variant(&cfg),
+							probe, n_probes);
+		if (!cmp_is_error(cmp_size_bit))
+			cmp_size_bit = pad_bitstream(&enc);
+		if (!cmp_is_error(cmp_size_bit))
+			for (i = 0; i < n_probes; i++)
+				*probe[i].cmp_size = probe[i].stream_len;
+	} else {
+		cmp_size_bit = compress_data_internal(&cfg, 0);
+	}
 
 	if (info) {
 		if (cmp_get_error_code(cmp_size_bit) == CMP_ERROR_SMALL_BUFFER)
@@ -0,0 +1,232 @@
+/**
+ * @file   write_bitstream.h
+ * @author Dominik Loidolt (dominik.loidolt@univie.ac.at)
+ * @date   2024
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief this library handles the writing to an MSB-first bitstream
+ *
+ * This API consists of small unitary functions, which must be inlined for best
+ * performance. Since link-time-optimization is not available for all
+ * compilers, these functions are defined into a .h to be included.
+ *
+ * Start by invoking bit_init_encoder(). The bits to write are accumulated in a
+ * 64-bit local register. As soon as a 32-bit word of the bitstream is complete
+ * it is stored in big-endian byte order in the destination buffer, so every
+ * word of the bitstream is written exactly once and never read back (except
+ * the first word if the bitstream starts in the middle of a word).
+ * The bits of a not yet completed word are held in the local register until
+ * bit_flush_encoder() is called. Bits of the destination buffer after the
+ * end of the bitstream are not modified.
+ *
+ * This is the counterpart of the bitstream decoder in read_bitstream.h.
+ */
+
+#ifndef WRITE_BITSTREAM_H
+#define WRITE_BITSTREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "../common/byteorder.h"
+#include "../common/compiler.h"
+#include "../common/cmp_debug.h"
+#include "../common/cmp_error.h"
+#include "../common/cmp_error_list.h"
+
+
+
+/**
+ * @brief bitstream encoder context type
+ */
+
+struct bit_encoder {
+	uint64_t bit_container;  /**< local register; the (stream_len & 0x1F) lowest bits are not yet written */
+	uint32_t stream_len;     /**< length of the bitstream in bits, seen from the beginning of the buffer */
+	uint32_t max_stream_len; /**< maximum length of the bitstream in bits */
+	uint32_t *cursor;        /**< address of the word where the next bits belong; NULL if only counting */
+};
+
+
+/*
+ * bitstream encoder API
+ */
+
+static __inline void bit_init_encoder(struct bit_encoder *enc, uint32_t *dst,
+				      uint32_t max_stream_len, uint32_t bit_offset);
+static __inline uint32_t bit_write_bits32(struct bit_encoder *enc, uint32_t value,
+					  unsigned int n_bits);
+static __inline uint32_t bit_write_bits32_unchecked(struct bit_encoder *enc,
+						    uint32_t value,
+						    unsigned int n_bits);
+static __inline uint32_t bit_free_bits(const struct bit_encoder *enc);
+static __inline void bit_flush_encoder(struct bit_encoder *enc);
+
+
+/*
+ * internal implementation
+ */
+
+/**
+ * @brief initialize a bit_encoder
+ *
+ * @param enc			a pointer to an already allocated bit_encoder structure
+ * @param dst			start address of the bitstream buffer; has to
+ *				be 4-byte aligned; can be NULL if only the
+ *				length of the bitstream is needed
+ * @param max_stream_len	maximum length of the bitstream in *bits*; is
+ *				ignored if dst is NULL
+ * @param bit_offset		bit index where the first bits will be put,
+ *				seen from the very beginning of the bitstream
+ *
+ * @note the bits in front of bit_offset are preserved
+ */
+
+static __inline void bit_init_encoder(struct bit_encoder *enc, uint32_t *dst,
+				      uint32_t max_stream_len, uint32_t bit_offset)
+{
+	uint32_t const bits_pending = bit_offset & 0x1F;
+
+	enc->bit_container = 0;
+	enc->stream_len = bit_offset;
+	enc->max_stream_len = max_stream_len;
+	enc->cursor = NULL;
+
+	if (!dst)
+		return;
+
+	enc->cursor = dst + (bit_offset >> 5);
+
+	/* load the already used bits of the first (partial) word */
+	if (bits_pending && bit_offset < max_stream_len)
+		enc->bit_container = be32_to_cpu(*enc->cursor) >> (32 - bits_pending);
+}
+
+
+/**
+ * @brief merge the not yet written bits of the local register into the
+ *	bitstream buffer; the bits after the end of the bitstream are preserved
+ *
+ * @param enc	pointer to a bit_encoder context
+ *
+ * @note the encoder can still be used after a flush
+ */
+
+static __inline void bit_flush_encoder(struct bit_encoder *enc)
+{
+	uint32_t const bits_pending = enc->stream_len & 0x1F;
+	uint32_t mask, tmp;
+
+	if (!enc->cursor || !bits_pending)
+		return;
+
+	if (enc->stream_len > enc->max_stream_len)
+		return;
+
+	mask = 0xFFFFFFFFU << (32 - bits_pending);
+	tmp = be32_to_cpu(*enc->cursor) & ~mask;
+	tmp |= (uint32_t)enc->bit_container << (32 - bits_pending);
+	*enc->cursor = cpu_to_be32(tmp);
+}
+
+
+/**
+ * @brief get the number of bits which can still be put into the bitstream
+ *	buffer
+ *
+ * @param enc	pointer to a bit_encoder context
+ *
+ * @returns the number of free bits; 0 if the encoder only counts the bits
+ */
+
+static __inline uint32_t bit_free_bits(const struct bit_encoder *enc)
+{
+	if (!enc->cursor || enc->stream_len > enc->max_stream_len)
+		return 0;
+
+	return enc->max_stream_len - enc->stream_len;
+}
+
+
+/**
+ * @brief put the value of 1 to 32 bits into the bitstream without any checks
+ *
+ * @param enc		pointer to a bit_encoder context with a bitstream buffer
+ * @param value		the value to put into the bitstream; only the n_bits
+ *			lowest bits are used
+ * @param n_bits	number of bits to put into the bitstream; has to be
+ *			between 1 and 32
+ *
+ * @returns the length of the generated bitstream in bits
+ *
+ * @warning the caller has to make sure that there is enough space in the
+ *	bitstream buffer (see bit_free_bits())
+ */
+
+static __inline uint32_t bit_write_bits32_unchecked(struct bit_encoder *enc,
+						    uint32_t value,
+						    unsigned int n_bits)
+{
+	uint32_t const bits_pending = enc->stream_len & 0x1F;
+
+	value &= 0xFFFFFFFFU >> (32 - n_bits);
+	enc->bit_container = (enc->bit_container << n_bits) | value;
+	enc->stream_len += n_bits;
+
+	/* store the completed word */
+	if (bits_pending + n_bits >= 32) {
+		*enc->cursor = cpu_to_be32((uint32_t)(enc->bit_container >> (enc->stream_len & 0x1F)));
+		enc->cursor++;
+	}
+	return enc->stream_len;
+}
+
+
+/**
+ * @brief put the value of up to 32 bits into the bitstream
+ *
+ * @param enc		pointer to a bit_encoder context
+ * @param value		the value to put into the bitstream; only the n_bits
+ *			lowest bits are used
+ * @param n_bits	number of bits to put into the bitstream
+ *
+ * @returns the length of the generated bitstream in bits on success or an error
+ *          code (which can be tested with cmp_is_error()) in the event of an
+ *          incorrect input or if the bitstream buffer is too small to put the
+ *          value in the bitstream; in the latter case, all bits put before
+ *          are flushed to the bitstream buffer
+ */
+
+static __inline uint32_t bit_write_bits32(struct bit_encoder *enc, uint32_t value,
+					  unsigned int n_bits)
+{
+	/* Leave in case of erroneous input */
+	RETURN_ERROR_IF(n_bits > 32, INT_DECODER, "cannot insert more than 32 bits into the bit stream");
+
+	if (n_bits == 0)
+		return enc->stream_len;
+
+	if (!enc->cursor) {  /* Do we need to write data to the bitstream? */
+		enc->stream_len += n_bits;  /* no check for overflow */
+		return enc->stream_len;
+	}
+
+	/* Check if the bitstream buffer is large enough */
+	if (enc->stream_len + n_bits > enc->max_stream_len) {
+		bit_flush_encoder(enc);
+		return CMP_ERROR(SMALL_BUFFER);
+	}
+
+	return bit_write_bits32_unchecked(enc, value, n_bits);
+}
+
+#endif /* WRITE_BITSTREAM_H */
@@ -284,22 +284,14 @@ uint32_t cmp_guess(struct rdcu_cfg *rcfg, int level)
 		printf("This compression mode is not implied yet.\n");
 		return 0;
 	}
-	/* make a working copy of the input data (and model) because the
-	 * following function works in-place
+	/* make a working copy of the configuration; without an output buffer
+	 * only the compressed size is calculated and no updated model is needed
 	 */
 	work_rcfg = *rcfg;
 	work_rcfg.icu_new_model_buf = NULL;
 	work_rcfg.icu_output_buf = NULL;
 	work_rcfg.buffer_length = 0;
 
-	if (model_mode_is_used(rcfg->cmp_mode)) {
-		work_rcfg.icu_new_model_buf = malloc(rcfg->samples * sizeof(uint16_t));
-		if (!work_rcfg.icu_new_model_buf) {
-			printf("malloc() failed!\n");
-			goto error;
-		}
-	}
-
 	/* find the best parameters */
 	switch (level) {
 	case 3:
@@ -313,12 +305,10 @@ uint32_t cmp_guess(struct rdcu_cfg *rcfg, int level)
 		break;
 	default:
 		fprintf(stderr, "cmp_tool: guess level not supported for RDCU guess mode!\n");
-		goto error;
+		return 0;
 	}
 	if (!cmp_size)
-		goto error;
-
-	free(work_rcfg.icu_new_model_buf);
+		return 0;
 
 	rcfg->golomb_par = work_rcfg.golomb_par;
 	rcfg->spill = work_rcfg.spill;
@@ -330,10 +320,6 @@ uint32_t cmp_guess(struct rdcu_cfg *rcfg, int level)
 	rcfg->buffer_length = ((cmp_size + 32)&~0x1FU)/(size_of_a_sample(DATA_TYPE_IMAGETTE)*8);
 
 	return cmp_size;
-
-error:
-	free(work_rcfg.icu_new_model_buf);
-	return 0;
 }
 
 
@@ -396,7 +382,7 @@ static uint32_t cmp_guess_chunk_par(const void *chunk, uint32_t chunk_size,
 	int i;
 
 	if (cmp_par->lossy_par)
-		debug_print("Warning: lossy compression is not supported for chunk compression, lossy_par will be ignored.");
+		debug_print("Warning: the guessing of lossy chunk compression parameters is not supported, lossy_par will be ignored.");
 	cmp_par->lossy_par = 0;
 	cmp_par->model_value = cmp_guess_model_value(num_model_updates);
 
@@ -486,7 +486,7 @@ uint32_t generate_random_collection_hdr(struct collection_hdr *col, enum cmp_dat
 		TEST_ASSERT_FALSE(cmp_col_set_pkt_type(col, COL_SCI_PKTS_TYPE));
 		TEST_ASSERT_FALSE(cmp_col_set_subservice(col, convert_cmp_data_type_to_subservice(data_type)));
 		TEST_ASSERT_FALSE(cmp_col_set_ccd_id(col, (uint8_t)cmp_rand_between(0, 3)));
-		TEST_ASSERT_FALSE(cmp_col_set_sequence_num(col, sequence_num++));
+		TEST_ASSERT_FALSE(cmp_col_set_sequence_num(col, sequence_num++ & 0x7F));
 
 		TEST_ASSERT_FALSE(cmp_col_set_data_length(col, (uint16_t)data_size));
 	}
@@ -640,6 +640,114 @@ static uint32_t generate_random_chunk(void *chunk, struct chunk_def col_array[],
 }
 
 
+/**
+ * @brief buffers to compress and decompress a random chunk
+ */
+
+struct chunk_fixture {
+	uint32_t chunk_size;
+	uint32_t dst_capacity;	/* compress_chunk_cmp_size_bound() of the chunk */
+	uint32_t work_size;	/* compress_chunk_parallel_work_size() of the chunk */
+	uint8_t *chunk;
+	uint8_t *model;
+	uint8_t *up_model;
+	uint8_t *up_model_cmp;	/* second updated model for comparisons */
+	uint8_t *decmp_chunk;
+	uint8_t *decmp_chunk_cmp; /* second decompression buffer for comparisons */
+	uint8_t *decmp_model;
+	uint32_t *dst;
+	uint32_t *dst_cmp;	/* second compression buffer for comparisons */
+	void *work_buf;
+};
+
+
+/**
+ * @brief allocates the chunk sized buffers of a chunk fixture
+ *
+ * @param f		pointer to the chunk fixture
+ * @param chunk_size	size of the chunk in bytes
+ */
+
+static void chunk_fixture_alloc(struct chunk_fixture *f, uint32_t chunk_size)
+{
+	memset(f, 0, sizeof(*f));
+	f->chunk_size = chunk_size;
+	f->chunk = malloc(chunk_size); TEST_ASSERT_NOT_NULL(f->chunk);
+	f->model = malloc(chunk_size); TEST_ASSERT_NOT_NULL(f->model);
+	f->up_model = malloc(chunk_size); TEST_ASSERT_NOT_NULL(f->up_model);
+	f->up_model_cmp = malloc(chunk_size); TEST_ASSERT_NOT_NULL(f->up_model_cmp);
+	f->decmp_chunk = malloc(chunk_size); TEST_ASSERT_NOT_NULL(f->decmp_chunk);
+	f->decmp_chunk_cmp = malloc(chunk_size); TEST_ASSERT_NOT_NULL(f->decmp_chunk_cmp);
+	f->decmp_model = malloc(chunk_size); TEST_ASSERT_NOT_NULL(f->decmp_model);
+}
+
+
+/**
+ * @brief allocates the compression and work buffers of a chunk fixture; the
+ *	chunk has to be generated before
+ *
+ * @param f	pointer to the chunk fixture
+ */
+
+static void chunk_fixture_alloc_dst(struct chunk_fixture *f)
+{
+	f->dst_capacity = compress_chunk_cmp_size_bound(f->chunk, f->chunk_size);
+	TEST_ASSERT_FALSE(cmp_is_error(f->dst_capacity));
+	/* the reserved fields of the entity header are not written */
+	f->dst = calloc(1, f->dst_capacity); TEST_ASSERT_NOT_NULL(f->dst);
+	f->dst_cmp = calloc(1, f->dst_capacity); TEST_ASSERT_NOT_NULL(f->dst_cmp);
+	f->work_size = compress_chunk_parallel_work_size(f->chunk, f->chunk_size);
+	TEST_ASSERT_FALSE(cmp_is_error(f->work_size));
+	f->work_buf = malloc(f->work_size); TEST_ASSERT_NOT_NULL(f->work_buf);
+}
+
+
+/**
+ * @brief generates a random chunk and a random model and allocates the
+ *	buffers to compress and decompress them
+ *
+ * @param f		pointer to the chunk fixture
+ * @param col_array	specifies which collections are contained in the chunk
+ * @param array_elements	number of elements in the col_array
+ * @param gen_data_f	function pointer to a data generation function
+ * @param extra		pointer to additional data required by the data
+ *			generation function
+ */
+
+static void chunk_fixture_init(struct chunk_fixture *f, struct chunk_def col_array[],
+			       size_t array_elements,
+			       uint32_t (*gen_data_f)(uint32_t, void*), void *extra)
+{
+	chunk_fixture_alloc(f, generate_random_chunk(NULL, col_array, array_elements,
+						     gen_data_f, extra));
+	generate_random_chunk(f->chunk, col_array, array_elements, gen_data_f, extra);
+	generate_random_chunk(f->model, col_array, array_elements, gen_data_f, extra);
+	chunk_fixture_alloc_dst(f);
+}
+
+
+/**
+ * @brief frees the buffers of a chunk fixture
+ *
+ * @param f	pointer to the chunk fixture
+ */
+
+static void chunk_fixture_free(struct chunk_fixture *f)
+{
+	free(f->chunk);
+	free(f->model);
+	free(f->up_model);
+	free(f->up_model_cmp);
+	free(f->decmp_chunk);
+	free(f->decmp_chunk_cmp);
+	free(f->decmp_model);
+	free(f->dst);
+	free(f->dst_cmp);
+	free(f->work_buf);
+	memset(f, 0, sizeof(*f));
+}
+
+
 /**
  * @brief generate random compression configuration
  *
@@ -1691,3 +1799,1205 @@ void test_cmp_decmp_diff(void)
 	free(dst);
 	free(chunk);
 }
+
+
+/**
+ * @brief round the fields of an offset, background or smearing collection
+ *	like a lossy compression with the given lossy parameter
+ *
+ * @param col	pointer to the collection to round
+ * @param round	lossy compression parameter
+ */
+
+static void round_aux_collection(struct collection_hdr *col, uint32_t round)
+{
+	uint32_t const mask = ~0U << round;
+	enum cmp_data_type data_type = convert_subservice_to_cmp_data_type(cmp_col_get_subservice(col));
+	uint32_t samples = cmp_col_get_data_length(col) / size_of_a_sample(data_type);
+	uint32_t i;
+
+	for (i = 0; i < samples; i++) {
+		switch (data_type) {
+		case DATA_TYPE_OFFSET: {
+			struct offset *entry = (struct offset *)col->entry + i;
+
+			entry->mean &= mask;
+			entry->variance &= mask;
+			break;
+		}
+		case DATA_TYPE_BACKGROUND: {
+			struct background *entry = (struct background *)col->entry + i;
+
+			entry->mean &= mask;
+			entry->variance &= mask;
+			entry->outlier_pixels &= (uint16_t)mask;
+			break;
+		}
+		case DATA_TYPE_SMEARING: {
+			struct smearing *entry = (struct smearing *)col->entry + i;
+
+			entry->mean &= mask;
+			entry->variance_mean &= mask;
+			entry->outlier_pixels &= (uint16_t)mask;
+			break;
+		}
+		default:
+			TEST_FAIL();
+		}
+	}
+}
+
+
+/**
+ * @brief compress offset, background and smearing chunks lossy and check that
+ *	the decompressed chunks are rounded
+ *
+ * @test compress_chunk
+ * @test decompress_cmp_entiy
+ */
+
+void test_cmp_decmp_chunk_lossy(void)
+{
+	struct chunk_def aux_chunk_def[2] = {{DATA_TYPE_OFFSET, 0}, {DATA_TYPE_BACKGROUND, 0}};
+	struct chunk_def smearing_chunk_def[1] = {{DATA_TYPE_SMEARING, 0}};
+	struct chunk_def flux_chunk_def[1] = {{DATA_TYPE_S_FX, 100}};
+	struct chunk_def *chunk_defs[2];
+	size_t n_defs[2];
+	double p = 0.01;
+	size_t d, i;
+
+	chunk_defs[0] = aux_chunk_def;
+	n_defs[0] = ARRAY_SIZE(aux_chunk_def);
+	chunk_defs[1] = smearing_chunk_def;
+	n_defs[1] = ARRAY_SIZE(smearing_chunk_def);
+	for (i = 0; i < ARRAY_SIZE(aux_chunk_def); i++)
+		aux_chunk_def[i].samples = cmp_rand_between(100, 300);
+	smearing_chunk_def[0].samples = cmp_rand_between(100, 300);
+
+	for (d = 0; d < ARRAY_SIZE(chunk_defs); d++) {
+		struct chunk_fixture f;
+		uint32_t lossy_par, read_bytes;
+		uint32_t lossless_size = 0;
+		struct cmp_par par;
+
+		chunk_fixture_init(&f, chunk_defs[d], n_defs[d], gen_geometric_data, &p);
+
+		for (lossy_par = CMP_LOSSLESS; lossy_par <= MAX_ICU_ROUND; lossy_par++) {
+			uint32_t cmp_size;
+			int decmp_size;
+
+			memset(&par, 0, sizeof(par));
+			par.cmp_mode = CMP_MODE_MODEL_ZERO;
+			par.model_value = 11;
+			par.lossy_par = lossy_par;
+			par.nc_offset_mean = 32;
+			par.nc_offset_variance = 32;
+			par.nc_background_mean = 32;
+			par.nc_background_variance = 32;
+			par.nc_background_outlier_pixels = 32;
+			par.smearing_mean = 32;
+			par.smearing_variance_mean = 32;
+			par.smearing_outlier_pixels = 32;
+
+			memcpy(f.up_model, f.model, f.chunk_size);
+			cmp_size = compress_chunk(f.chunk, f.chunk_size, f.model, f.up_model,
+						  f.dst, f.dst_capacity, &par);
+			TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+			TEST_ASSERT_EQUAL_UINT(lossy_par, cmp_ent_get_lossy_cmp_par((struct cmp_entity *)f.dst));
+			if (lossy_par == CMP_LOSSLESS)
+				lossless_size = cmp_size;
+			else
+				TEST_ASSERT(cmp_size < lossless_size);
+
+			decmp_size = decompress_cmp_entiy((struct cmp_entity *)f.dst, f.model,
+							  f.decmp_model, f.decmp_chunk);
+			TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+			TEST_ASSERT_EQUAL_HEX8_ARRAY(f.up_model, f.decmp_model, f.chunk_size);
+
+			/* the lossy compression only rounds the data */
+			memcpy(f.decmp_chunk_cmp, f.chunk, f.chunk_size);
+			for (read_bytes = 0; read_bytes < f.chunk_size;
+			     read_bytes += cmp_col_get_size((struct collection_hdr *)(f.chunk + read_bytes)))
+				round_aux_collection((struct collection_hdr *)(f.decmp_chunk_cmp + read_bytes),
+						     lossy_par);
+			TEST_ASSERT_EQUAL_HEX8_ARRAY(f.decmp_chunk_cmp, f.decmp_chunk, f.chunk_size);
+		}
+
+		/* error: lossy parameter too large */
+		par.lossy_par = MAX_ICU_ROUND + 1;
+		TEST_ASSERT_EQUAL_INT(CMP_ERROR_PAR_GENERIC, cmp_get_error_code(
+			compress_chunk(f.chunk, f.chunk_size, f.model, f.up_model, f.dst,
+				       f.dst_capacity, &par)));
+
+		/* the round trip helper checks the rounded data; the uniform
+		 * distributed data are put uncompressed into the entity
+		 */
+		par.lossy_par = MAX_ICU_ROUND;
+		TEST_ASSERT_FALSE(cmp_is_error(chunk_round_trip(f.chunk, f.chunk_size, f.model,
+								f.up_model, f.dst, f.dst_capacity,
+								&par, 1, 1)));
+		generate_random_chunk(f.chunk, chunk_defs[d], n_defs[d], gen_uniform_data, NULL);
+		TEST_ASSERT_FALSE(cmp_is_error(chunk_round_trip(f.chunk, f.chunk_size, f.model,
+								f.up_model, f.dst, f.dst_capacity,
+								&par, 1, 1)));
+
+		/* the lossy parameter is ignored in raw mode */
+		par.cmp_mode = CMP_MODE_RAW;
+		TEST_ASSERT_FALSE(cmp_is_error(compress_chunk(f.chunk, f.chunk_size, NULL, NULL,
+							      f.dst, f.dst_capacity, &par)));
+		TEST_ASSERT_EQUAL_UINT(CMP_LOSSLESS, cmp_ent_get_lossy_cmp_par((struct cmp_entity *)f.dst));
+		TEST_ASSERT_EQUAL_INT(f.chunk_size, decompress_cmp_entiy((struct cmp_entity *)f.dst,
+									 NULL, NULL, f.decmp_chunk));
+		TEST_ASSERT_EQUAL_HEX8_ARRAY(f.chunk, f.decmp_chunk, f.chunk_size);
+
+		chunk_fixture_free(&f);
+	}
+
+	/* the lossy parameter is ignored for flux and imagette chunks */
+	{
+		struct chunk_fixture f;
+		uint32_t cmp_size;
+		struct cmp_par par;
+
+		chunk_fixture_init(&f, flux_chunk_def, ARRAY_SIZE(flux_chunk_def),
+				   gen_geometric_data, &p);
+
+		generate_random_cmp_par(&par);
+		par.cmp_mode = CMP_MODE_DIFF_ZERO;
+		par.lossy_par = MAX_ICU_ROUND;
+		cmp_size = compress_chunk(f.chunk, f.chunk_size, NULL, NULL, f.dst,
+					  f.dst_capacity, &par);
+		TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+		TEST_ASSERT_EQUAL_UINT(CMP_LOSSLESS, cmp_ent_get_lossy_cmp_par((struct cmp_entity *)f.dst));
+		TEST_ASSERT_EQUAL_INT(f.chunk_size, decompress_cmp_entiy((struct cmp_entity *)f.dst,
+									 NULL, NULL, f.decmp_chunk));
+		TEST_ASSERT_EQUAL_HEX8_ARRAY(f.chunk, f.decmp_chunk, f.chunk_size);
+
+		chunk_fixture_free(&f);
+	}
+}
+
+
+/**
+ * @brief executes the jobs of compress_chunk_parallel() in reverse order
+ */
+
+static void run_jobs_reverse(void (*job)(void *job_arg, uint32_t i),
+			     void *job_arg, uint32_t n_jobs, void *pool)
+{
+	uint32_t *n_calls = pool;
+
+	while (n_jobs--) {
+		job(job_arg, n_jobs);
+		(*n_calls)++;
+	}
+}
+
+
+/**
+ * @brief compress random chunks in parallel and compare the result with the
+ *	sequential compression
+ *
+ * @test compress_chunk_parallel
+ * @test compress_chunk_parallel_work_size
+ */
+
+void test_compress_chunk_parallel(void)
+{
+	struct chunk_def chunk_def[3] = {{DATA_TYPE_S_FX, 0}, {DATA_TYPE_S_FX_EFX_NCOB_ECOB, 0},
+					 {DATA_TYPE_S_FX_NCOB, 0}};
+	double p = 0.01;
+	int run;
+
+	for (run = 0; run < 4; run++) {
+		uint32_t (*gen_data_f)(uint32_t max_data_bits, void *extra) =
+			run & 1 ? gen_geometric_data : gen_uniform_data;
+		struct chunk_fixture f;
+		enum cmp_mode cmp_mode;
+		uint32_t n_calls;
+		size_t i;
+
+		for (i = 0; i < ARRAY_SIZE(chunk_def); i++)
+			chunk_def[i].samples = cmp_rand_between(0, 300);
+		chunk_fixture_init(&f, chunk_def, ARRAY_SIZE(chunk_def), gen_data_f, &p);
+
+		for (cmp_mode = CMP_MODE_RAW; cmp_mode <= CMP_MODE_DIFF_MULTI; cmp_mode++) {
+			struct cmp_par par;
+			uint32_t cmp_size, cmp_size_par;
+
+			generate_random_cmp_par(&par);
+			par.cmp_mode = cmp_mode;
+			par.lossy_par = CMP_LOSSLESS;
+			if (run & 2) { /* small parameters favour compressed collections */
+				par.s_exp_flags = cmp_rand_between(1, 4);
+				par.s_fx = cmp_rand_between(1, 4);
+				par.s_ncob = cmp_rand_between(1, 4);
+				par.s_efx = cmp_rand_between(1, 4);
+				par.s_ecob = cmp_rand_between(1, 4);
+			}
+
+			memcpy(f.up_model, f.model, f.chunk_size);
+			memcpy(f.up_model_cmp, f.model, f.chunk_size);
+			cmp_size = compress_chunk(f.chunk, f.chunk_size, f.model, f.up_model,
+						  f.dst, f.dst_capacity, &par);
+			TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+
+			n_calls = 0;
+			cmp_size_par = compress_chunk_parallel(f.chunk, f.chunk_size, f.model,
+							       f.up_model_cmp, f.dst_cmp,
+							       f.dst_capacity, &par, f.work_buf,
+							       f.work_size, run_jobs_reverse, &n_calls);
+			TEST_ASSERT_EQUAL_HEX32(cmp_size, cmp_size_par);
+			TEST_ASSERT_EQUAL_UINT32(ARRAY_SIZE(chunk_def), n_calls);
+			TEST_ASSERT_EQUAL_HEX8_ARRAY(f.dst, f.dst_cmp, cmp_size);
+			if (model_mode_is_used(cmp_mode))
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(f.up_model, f.up_model_cmp, f.chunk_size);
+
+			/* in-place model update */
+			memcpy(f.up_model_cmp, f.model, f.chunk_size);
+			cmp_size_par = compress_chunk_parallel(f.chunk, f.chunk_size, f.up_model_cmp,
+							       f.up_model_cmp, f.dst_cmp,
+							       f.dst_capacity, &par, f.work_buf,
+							       f.work_size, run_jobs_reverse, &n_calls);
+			TEST_ASSERT_EQUAL_HEX32(cmp_size, cmp_size_par);
+			TEST_ASSERT_EQUAL_HEX8_ARRAY(f.dst, f.dst_cmp, cmp_size);
+			if (model_mode_is_used(cmp_mode))
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(f.up_model, f.up_model_cmp, f.chunk_size);
+
+			/* only get the compressed size */
+			cmp_size = compress_chunk(f.chunk, f.chunk_size, f.model, NULL, NULL, 0, &par);
+			cmp_size_par = compress_chunk_parallel(f.chunk, f.chunk_size, f.model, NULL,
+							       NULL, 0, &par, f.work_buf, f.work_size,
+							       run_jobs_reverse, &n_calls);
+			TEST_ASSERT_EQUAL_HEX32(cmp_size, cmp_size_par);
+
+			/* too small work buffer; the compression is done sequentially */
+			n_calls = 0;
+			cmp_size_par = compress_chunk_parallel(f.chunk, f.chunk_size, f.model, NULL,
+							       NULL, 0, &par, f.work_buf, f.work_size-1,
+							       run_jobs_reverse, &n_calls);
+			TEST_ASSERT_EQUAL_HEX32(cmp_size, cmp_size_par);
+			TEST_ASSERT_EQUAL_UINT32(0, n_calls);
+		}
+
+		chunk_fixture_free(&f);
+	}
+}
+
+
+/**
+ * @brief decompress random chunks in parallel and compare the result with the
+ *	sequential decompression
+ *
+ * @test decompress_cmp_entity_mt
+ * @test decompress_cmp_entity_mt_work_size
+ */
+
+void test_decompress_cmp_entity_mt(void)
+{
+	struct chunk_def chunk_def[5] = {{DATA_TYPE_OFFSET, 0}, {DATA_TYPE_OFFSET, 0},
+					 {DATA_TYPE_OFFSET, 0}, {DATA_TYPE_OFFSET, 0},
+					 {DATA_TYPE_OFFSET, 0}};
+	static const uint32_t n_threads[] = {2, 3, 5, 64};
+	double p = 0.01;
+	int run;
+
+	for (run = 0; run < 2; run++) {
+		uint32_t (*gen_data_f)(uint32_t max_data_bits, void *extra) =
+			run & 1 ? gen_geometric_data : gen_uniform_data;
+		const struct cmp_entity *ent;
+		struct chunk_fixture f;
+		enum cmp_mode cmp_mode;
+		uint32_t n_calls;
+		size_t i;
+
+		for (i = 0; i < ARRAY_SIZE(chunk_def); i++)
+			chunk_def[i].samples = cmp_rand_between(1, 200);
+		chunk_fixture_init(&f, chunk_def, ARRAY_SIZE(chunk_def), gen_data_f, &p);
+		ent = (const struct cmp_entity *)f.dst;
+
+		for (cmp_mode = CMP_MODE_RAW; cmp_mode <= CMP_MODE_DIFF_MULTI; cmp_mode++) {
+			struct cmp_par par;
+			uint32_t cmp_size;
+			int decmp_size;
+
+			generate_random_cmp_par(&par);
+			par.cmp_mode = cmp_mode;
+			par.lossy_par = CMP_LOSSLESS;
+			cmp_size = compress_chunk(f.chunk, f.chunk_size, f.model, NULL,
+						  f.dst, f.dst_capacity, &par);
+			TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+
+			decmp_size = decompress_cmp_entiy(ent, f.model, f.up_model, f.decmp_chunk);
+			TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+
+			/* a raw entity is decompressed sequentially without a work buffer */
+			if (cmp_mode == CMP_MODE_RAW) {
+				TEST_ASSERT_EQUAL_UINT32(0, decompress_cmp_entity_mt_work_size(ent, 2));
+				n_calls = 0;
+				memset(f.decmp_chunk_cmp, 0, f.chunk_size);
+				decmp_size = decompress_cmp_entity_mt(ent, NULL, NULL, f.decmp_chunk_cmp,
+								      2, NULL, 0, run_jobs_reverse,
+								      &n_calls);
+				TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(f.decmp_chunk, f.decmp_chunk_cmp, f.chunk_size);
+				TEST_ASSERT_EQUAL_UINT32(0, n_calls);
+				continue;
+			}
+
+			/* the work buffer is sized for the number of collections */
+			TEST_ASSERT_EQUAL_UINT32(
+				decompress_cmp_entity_mt_work_size(ent, ARRAY_SIZE(chunk_def)),
+				decompress_cmp_entity_mt_work_size(ent, 64));
+
+			for (i = 0; i < ARRAY_SIZE(n_threads); i++) {
+				uint32_t const work_size =
+					decompress_cmp_entity_mt_work_size(ent, n_threads[i]);
+				void *work_buf = malloc(work_size);
+
+				TEST_ASSERT_NOT_NULL(work_buf);
+				memset(f.decmp_chunk_cmp, 0, f.chunk_size);
+				memset(f.up_model_cmp, 0, f.chunk_size);
+				n_calls = 0;
+				decmp_size = decompress_cmp_entity_mt(ent, f.model, f.up_model_cmp,
+								      f.decmp_chunk_cmp, n_threads[i],
+								      work_buf, work_size,
+								      run_jobs_reverse, &n_calls);
+				TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(f.decmp_chunk, f.decmp_chunk_cmp, f.chunk_size);
+				if (model_mode_is_used(cmp_mode))
+					TEST_ASSERT_EQUAL_HEX8_ARRAY(f.up_model, f.up_model_cmp, f.chunk_size);
+				if (n_threads[i] < ARRAY_SIZE(chunk_def))
+					TEST_ASSERT_EQUAL_UINT32(n_threads[i], n_calls);
+				else
+					TEST_ASSERT_EQUAL_UINT32(ARRAY_SIZE(chunk_def), n_calls);
+
+				/* in-place model update */
+				memcpy(f.up_model_cmp, f.model, f.chunk_size);
+				decmp_size = decompress_cmp_entity_mt(ent, f.up_model_cmp, f.up_model_cmp,
+								      f.decmp_chunk_cmp, n_threads[i],
+								      work_buf, work_size,
+								      run_jobs_reverse, &n_calls);
+				TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(f.decmp_chunk, f.decmp_chunk_cmp, f.chunk_size);
+				if (model_mode_is_used(cmp_mode))
+					TEST_ASSERT_EQUAL_HEX8_ARRAY(f.up_model, f.up_model_cmp, f.chunk_size);
+
+				/* too small work buffer; the decompression is done sequentially */
+				n_calls = 0;
+				memset(f.decmp_chunk_cmp, 0, f.chunk_size);
+				decmp_size = decompress_cmp_entity_mt(ent, f.model, NULL, f.decmp_chunk_cmp,
+								      n_threads[i], work_buf,
+								      work_size-1, run_jobs_reverse,
+								      &n_calls);
+				TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(f.decmp_chunk, f.decmp_chunk_cmp, f.chunk_size);
+				TEST_ASSERT_EQUAL_UINT32(0, n_calls);
+
+				free(work_buf);
+			}
+		}
+
+		chunk_fixture_free(&f);
+	}
+}
+
+
+/**
+ * @brief compress random chunks collection by collection and compare the
+ *	result with the compression of the whole chunk
+ *
+ * @test compress_chunk_begin
+ * @test compress_chunk_add_collection
+ * @test compress_chunk_finish
+ */
+
+void test_compress_chunk_stream(void)
+{
+	struct chunk_def chunk_def[3] = {{DATA_TYPE_L_FX, 0}, {DATA_TYPE_L_FX_EFX_NCOB_ECOB, 0},
+					 {DATA_TYPE_L_FX_EFX, 0}};
+	double p = 0.01;
+	int run;
+
+	for (run = 0; run < 2; run++) {
+		uint32_t (*gen_data_f)(uint32_t max_data_bits, void *extra) =
+			run & 1 ? gen_geometric_data : gen_uniform_data;
+		struct chunk_fixture f;
+		enum cmp_mode cmp_mode;
+		struct cmp_ctx ctx;
+		size_t i;
+
+		for (i = 0; i < ARRAY_SIZE(chunk_def); i++)
+			chunk_def[i].samples = cmp_rand_between(0, 200);
+		chunk_fixture_init(&f, chunk_def, ARRAY_SIZE(chunk_def), gen_data_f, &p);
+
+		cmp_ctx_init(&ctx, NULL, 0);
+		compress_chunk_init(NULL, 0);
+
+		for (cmp_mode = CMP_MODE_RAW; cmp_mode <= CMP_MODE_DIFF_MULTI; cmp_mode++) {
+			struct cmp_par par;
+			uint32_t cmp_size, cmp_size_stream, read_bytes;
+
+			generate_random_cmp_par(&par);
+			par.cmp_mode = cmp_mode;
+			par.lossy_par = CMP_LOSSLESS;
+
+			memcpy(f.up_model, f.model, f.chunk_size);
+			memcpy(f.up_model_cmp, f.model, f.chunk_size);
+			cmp_size = compress_chunk(f.chunk, f.chunk_size, f.model, f.up_model,
+						  f.dst, f.dst_capacity, &par);
+			TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+
+			cmp_size_stream = compress_chunk_begin(&ctx, f.dst_cmp, f.dst_capacity, &par);
+			TEST_ASSERT_FALSE(cmp_is_error(cmp_size_stream));
+			for (read_bytes = 0; read_bytes < f.chunk_size;
+			     read_bytes += cmp_col_get_size((struct collection_hdr *)(f.chunk + read_bytes))) {
+				cmp_size_stream = compress_chunk_add_collection(&ctx, f.chunk + read_bytes,
+										f.model + read_bytes,
+										f.up_model_cmp + read_bytes);
+				TEST_ASSERT_FALSE(cmp_is_error(cmp_size_stream));
+			}
+			cmp_size_stream = compress_chunk_finish(&ctx);
+			TEST_ASSERT_EQUAL_HEX32(cmp_size, cmp_size_stream);
+			TEST_ASSERT_EQUAL_HEX8_ARRAY(f.dst, f.dst_cmp, cmp_size);
+			if (model_mode_is_used(cmp_mode))
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(f.up_model, f.up_model_cmp, f.chunk_size);
+
+			/* only get the compressed size */
+			TEST_ASSERT_FALSE(cmp_is_error(compress_chunk_begin(&ctx, NULL, 0, &par)));
+			for (read_bytes = 0; read_bytes < f.chunk_size;
+			     read_bytes += cmp_col_get_size((struct collection_hdr *)(f.chunk + read_bytes)))
+				compress_chunk_add_collection(&ctx, f.chunk + read_bytes,
+							      f.model + read_bytes, NULL);
+			TEST_ASSERT_EQUAL_HEX32(cmp_size, compress_chunk_finish(&ctx));
+		}
+
+		/* error: no compression started */
+		TEST_ASSERT_EQUAL_INT(CMP_ERROR_GENERIC, cmp_get_error_code(
+			compress_chunk_add_collection(&ctx, f.chunk, NULL, NULL)));
+		TEST_ASSERT_EQUAL_INT(CMP_ERROR_GENERIC, cmp_get_error_code(compress_chunk_finish(&ctx)));
+
+		/* error: no collection added */
+		{
+			struct cmp_par par;
+
+			generate_random_cmp_par(&par);
+			par.cmp_mode = CMP_MODE_DIFF_ZERO;
+			TEST_ASSERT_FALSE(cmp_is_error(compress_chunk_begin(&ctx, f.dst_cmp, f.dst_capacity, &par)));
+			TEST_ASSERT_EQUAL_INT(CMP_ERROR_CHUNK_SIZE_INCONSISTENT,
+					      cmp_get_error_code(compress_chunk_finish(&ctx)));
+
+			/* error: the error sticks until the next compress_chunk_begin() */
+			TEST_ASSERT_FALSE(cmp_is_error(compress_chunk_begin(&ctx, f.dst_cmp, f.dst_capacity, &par)));
+			TEST_ASSERT_EQUAL_INT(CMP_ERROR_CHUNK_NULL, cmp_get_error_code(
+				compress_chunk_add_collection(&ctx, NULL, NULL, NULL)));
+			TEST_ASSERT_EQUAL_INT(CMP_ERROR_CHUNK_NULL, cmp_get_error_code(
+				compress_chunk_add_collection(&ctx, f.chunk, NULL, NULL)));
+			TEST_ASSERT_EQUAL_INT(CMP_ERROR_CHUNK_NULL, cmp_get_error_code(compress_chunk_finish(&ctx)));
+
+			/* error: dst buffer smaller than entity header */
+			TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(
+				compress_chunk_begin(&ctx, f.dst_cmp, 4, &par)));
+			TEST_ASSERT_EQUAL_INT(CMP_ERROR_PAR_NULL, cmp_get_error_code(
+				compress_chunk_begin(&ctx, f.dst_cmp, f.dst_capacity, NULL)));
+			TEST_ASSERT_EQUAL_INT(CMP_ERROR_GENERIC, cmp_get_error_code(
+				compress_chunk_begin(NULL, f.dst_cmp, f.dst_capacity, &par)));
+		}
+
+		chunk_fixture_free(&f);
+	}
+}
+
+
+/**
+ * @brief compress random chunks piece by piece into small output buffers and
+ *	compare the results with compress_chunk_ctx()
+ *
+ * @test compress_chunk_resume_begin
+ * @test compress_chunk_resume
+ * @test compress_chunk_resume_finish
+ * @test compress_chunk_apply_patches
+ */
+
+void test_compress_chunk_resume(void)
+{
+	struct chunk_def chunk_def[3] = {{DATA_TYPE_S_FX, 0}, {DATA_TYPE_S_FX_EFX_NCOB_ECOB, 0},
+					 {DATA_TYPE_S_FX_NCOB, 0}};
+	uint32_t const out_sizes[] = {1, 7, 64, 1000};
+	uint32_t col_buf[COMPRESS_CHUNK_RESUME_COL_BUF_SIZE/4];
+	struct chunk_fixture f;
+	uint8_t *dst_resume;
+	struct cmp_ctx ctx;
+	struct cmp_par par;
+	struct cmp_patch_table patches;
+	enum cmp_mode cmp_mode;
+	uint32_t out_size_dummy;
+	double p = 0.01;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(chunk_def); i++)
+		chunk_def[i].samples = cmp_rand_between(0, 300);
+
+	chunk_fixture_init(&f, chunk_def, ARRAY_SIZE(chunk_def), gen_geometric_data, &p);
+	dst_resume = (uint8_t *)f.dst_cmp;
+
+	cmp_ctx_init(&ctx, NULL, 0);
+
+	for (cmp_mode = CMP_MODE_RAW; cmp_mode <= CMP_MODE_DIFF_MULTI; cmp_mode++) {
+		for (i = 0; i < ARRAY_SIZE(out_sizes); i++) {
+			uint32_t const out_size = out_sizes[i];
+			uint32_t cmp_size, hdr_size, ret, written, off;
+
+			generate_random_cmp_par(&par);
+			par.cmp_mode = cmp_mode;
+			par.lossy_par = CMP_LOSSLESS;
+
+			memcpy(f.up_model, f.model, f.chunk_size);
+			/* the reserved fields of the entity header are not written */
+			memset(f.dst, 0, f.dst_capacity);
+			cmp_size = compress_chunk_ctx(&ctx, f.chunk, f.chunk_size, f.model, f.up_model,
+						      f.dst, f.dst_capacity, &par);
+			TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+
+			memcpy(f.up_model_cmp, f.model, f.chunk_size);
+			memset(dst_resume, 0xA5, f.dst_capacity);
+			hdr_size = compress_chunk_resume_begin(&ctx, f.chunk, f.chunk_size, f.model,
+							       f.up_model_cmp, col_buf,
+							       sizeof(col_buf), &par);
+			TEST_ASSERT_FALSE(cmp_is_error(hdr_size));
+			TEST_ASSERT(hdr_size < cmp_size);
+
+			off = 0;
+			do {
+				uint32_t n = out_size;
+
+				if (n > f.dst_capacity - off)
+					n = f.dst_capacity - off;
+				ret = compress_chunk_resume(&ctx, dst_resume + off, n, &written);
+				TEST_ASSERT_FALSE(cmp_is_error(ret));
+				TEST_ASSERT(written <= n);
+				off += written;
+			} while (ret == CMP_NEED_MORE_OUTPUT);
+			TEST_ASSERT_EQUAL_UINT32(0, ret);
+			TEST_ASSERT_EQUAL_UINT32(cmp_size, off);
+			TEST_ASSERT_EQUAL_UINT32(cmp_size, compress_chunk_resume_finish(&ctx, &patches));
+
+			/* apply the patches to every output buffer */
+			for (off = 0; off < cmp_size; off += out_size) {
+				uint32_t n = out_size;
+
+				if (n > cmp_size - off)
+					n = cmp_size - off;
+				compress_chunk_apply_patches(dst_resume + off, off, n, &patches);
+			}
+			TEST_ASSERT_EQUAL_HEX8_ARRAY(f.dst, dst_resume, cmp_size);
+			if (model_mode_is_used(cmp_mode))
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(f.up_model, f.up_model_cmp, f.chunk_size);
+		}
+	}
+
+	/* error: no compression started */
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_GENERIC, cmp_get_error_code(
+		compress_chunk_resume(&ctx, dst_resume, f.dst_capacity, &out_size_dummy)));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_GENERIC, cmp_get_error_code(
+		compress_chunk_resume_finish(&ctx, &patches)));
+
+	/* error: the compression entity is not complete */
+	TEST_ASSERT_FALSE(cmp_is_error(compress_chunk_resume_begin(&ctx, f.chunk, f.chunk_size, NULL,
+								    NULL, col_buf, sizeof(col_buf),
+								    &par)));
+	TEST_ASSERT_EQUAL_UINT32(CMP_NEED_MORE_OUTPUT,
+				 compress_chunk_resume(&ctx, dst_resume, 1, &out_size_dummy));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_GENERIC, cmp_get_error_code(
+		compress_chunk_resume_finish(&ctx, &patches)));
+
+	/* error: the collection buffer is too small; the error sticks */
+	TEST_ASSERT_FALSE(cmp_is_error(compress_chunk_resume_begin(&ctx, f.chunk, f.chunk_size, NULL,
+								    NULL, col_buf, 8, &par)));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(
+		compress_chunk_resume(&ctx, dst_resume, f.dst_capacity, &out_size_dummy)));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(
+		compress_chunk_resume(&ctx, dst_resume, f.dst_capacity, &out_size_dummy)));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(
+		compress_chunk_resume_finish(&ctx, &patches)));
+
+	/* error: chunk size is inconsistent with the collection sizes */
+	TEST_ASSERT_FALSE(cmp_is_error(compress_chunk_resume_begin(&ctx, f.chunk, f.chunk_size - 1, NULL,
+								    NULL, col_buf, sizeof(col_buf),
+								    &par)));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_CHUNK_SIZE_INCONSISTENT, cmp_get_error_code(
+		compress_chunk_resume(&ctx, dst_resume, f.dst_capacity, &out_size_dummy)));
+
+	/* error: invalid arguments */
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_GENERIC, cmp_get_error_code(
+		compress_chunk_resume_begin(NULL, f.chunk, f.chunk_size, NULL, NULL, col_buf,
+					    sizeof(col_buf), &par)));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_CHUNK_NULL, cmp_get_error_code(
+		compress_chunk_resume_begin(&ctx, NULL, f.chunk_size, NULL, NULL, col_buf,
+					    sizeof(col_buf), &par)));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_PAR_NULL, cmp_get_error_code(
+		compress_chunk_resume_begin(&ctx, f.chunk, f.chunk_size, NULL, NULL, col_buf,
+					    sizeof(col_buf), NULL)));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_PAR_BUFFERS, cmp_get_error_code(
+		compress_chunk_resume_begin(&ctx, f.chunk, f.chunk_size, NULL, NULL, NULL,
+					    sizeof(col_buf), &par)));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_GENERIC, cmp_get_error_code(
+		compress_chunk_resume(&ctx, dst_resume, f.dst_capacity, NULL)));
+
+	chunk_fixture_free(&f);
+}
+
+
+/**
+ * @brief compress a batch of random chunks and compare the results with the
+ *	compression of every single chunk
+ *
+ * @test compress_chunks_batch
+ */
+
+void test_compress_chunks_batch(void)
+{
+	enum { N_CHUNKS = 4 };
+	struct chunk_def chunk_def[N_CHUNKS][2] = {
+		{{DATA_TYPE_S_FX, 0}, {DATA_TYPE_S_FX_NCOB, 0}},
+		{{DATA_TYPE_L_FX_EFX, 0}, {DATA_TYPE_L_FX, 0}},
+		{{DATA_TYPE_SMEARING, 0}, {DATA_TYPE_SMEARING, 0}},
+		{{DATA_TYPE_S_FX_EFX, 0}, {DATA_TYPE_S_FX, 0}}
+	};
+	struct chunk_fixture f[N_CHUNKS];
+	void *chunks[N_CHUNKS + 1];
+	void *models[N_CHUNKS + 1];
+	void *up_models[N_CHUNKS + 1];
+	uint32_t *dst[N_CHUNKS + 1];
+	uint32_t chunk_sizes[N_CHUNKS + 1];
+	uint32_t dst_capacities[N_CHUNKS + 1];
+	uint32_t cmp_sizes[N_CHUNKS + 1];
+	uint32_t *dst_single;
+	uint8_t *up_model_single;
+	struct cmp_ctx ctx;
+	enum cmp_mode cmp_mode;
+	uint32_t n_calls;
+	double p = 0.01;
+	int i, parallel;
+
+	for (i = 0; i < N_CHUNKS; i++) {
+		chunk_def[i][0].samples = cmp_rand_between(0, 100);
+		chunk_def[i][1].samples = cmp_rand_between(0, 100);
+		chunk_fixture_init(&f[i], chunk_def[i], 2, gen_geometric_data, &p);
+		chunks[i] = f[i].chunk;
+		models[i] = f[i].model;
+		up_models[i] = f[i].up_model;
+		dst[i] = f[i].dst;
+		chunk_sizes[i] = f[i].chunk_size;
+		dst_capacities[i] = f[i].dst_capacity;
+	}
+	/* the last chunk is missing */
+	chunks[N_CHUNKS] = NULL;
+	models[N_CHUNKS] = NULL;
+	up_models[N_CHUNKS] = NULL;
+	chunk_sizes[N_CHUNKS] = 0;
+	dst[N_CHUNKS] = NULL;
+	dst_capacities[N_CHUNKS] = 0;
+	dst_single = calloc(1, COMPRESS_CHUNK_BOUND(CMP_ENTITY_MAX_ORIGINAL_SIZE/4, 2));
+	TEST_ASSERT_NOT_NULL(dst_single);
+	up_model_single = malloc(CMP_ENTITY_MAX_ORIGINAL_SIZE/4);
+	TEST_ASSERT_NOT_NULL(up_model_single);
+
+	cmp_ctx_init(&ctx, NULL, 42);
+	compress_chunk_init(NULL, 42);
+
+	for (parallel = 0; parallel <= 1; parallel++) {
+		if (parallel)
+			cmp_ctx_set_parallel(&ctx, NULL, 0, run_jobs_reverse, &n_calls);
+
+		for (cmp_mode = CMP_MODE_RAW; cmp_mode <= CMP_MODE_DIFF_MULTI; cmp_mode++) {
+			struct cmp_par par;
+			uint32_t n_ok;
+
+			generate_random_cmp_par(&par);
+			par.cmp_mode = cmp_mode;
+			par.lossy_par = CMP_LOSSLESS;
+
+			/* the reserved fields of the entity header are not written */
+			for (i = 0; i < N_CHUNKS; i++) {
+				memcpy(up_models[i], models[i], chunk_sizes[i]);
+				memset(dst[i], 0, dst_capacities[i]);
+			}
+			n_calls = 0;
+			n_ok = compress_chunks_batch(&ctx, N_CHUNKS + 1, (const void *const *)chunks,
+						     chunk_sizes, (const void *const *)models, up_models,
+						     dst, dst_capacities, &par, cmp_sizes);
+			TEST_ASSERT_EQUAL_UINT32(N_CHUNKS, n_ok);
+			TEST_ASSERT_EQUAL_UINT32(parallel ? N_CHUNKS + 1 : 0, n_calls);
+			TEST_ASSERT_EQUAL_INT(CMP_ERROR_CHUNK_NULL, cmp_get_error_code(cmp_sizes[N_CHUNKS]));
+
+			for (i = 0; i < N_CHUNKS; i++) {
+				uint32_t cmp_size;
+
+				TEST_ASSERT(chunk_sizes[i] <= CMP_ENTITY_MAX_ORIGINAL_SIZE/4);
+				memcpy(up_model_single, models[i], chunk_sizes[i]);
+				memset(dst_single, 0, dst_capacities[i]);
+				cmp_size = compress_chunk(chunks[i], chunk_sizes[i], models[i],
+							  up_model_single, dst_single,
+							  dst_capacities[i], &par);
+				TEST_ASSERT_EQUAL_HEX32(cmp_size, cmp_sizes[i]);
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(dst_single, dst[i], cmp_size);
+				if (model_mode_is_used(cmp_mode))
+					TEST_ASSERT_EQUAL_HEX8_ARRAY(up_model_single, up_models[i],
+								     chunk_sizes[i]);
+			}
+
+			/* only get the compressed sizes */
+			n_ok = compress_chunks_batch(&ctx, N_CHUNKS, (const void *const *)chunks,
+						     chunk_sizes, (const void *const *)models, NULL,
+						     NULL, NULL, &par, cmp_sizes);
+			TEST_ASSERT_EQUAL_UINT32(N_CHUNKS, n_ok);
+			for (i = 0; i < N_CHUNKS; i++)
+				TEST_ASSERT_EQUAL_HEX32(compress_chunk(chunks[i], chunk_sizes[i], models[i],
+								       NULL, NULL, 0, &par), cmp_sizes[i]);
+		}
+	}
+
+	/* error cases */
+	{
+		struct cmp_par par = {0};
+
+		TEST_ASSERT_EQUAL_INT(CMP_ERROR_GENERIC, cmp_get_error_code(compress_chunks_batch(
+			NULL, 1, (const void *const *)chunks, chunk_sizes, NULL, NULL, NULL, NULL, &par, cmp_sizes)));
+		TEST_ASSERT_EQUAL_INT(CMP_ERROR_PAR_NULL, cmp_get_error_code(compress_chunks_batch(
+			&ctx, 1, (const void *const *)chunks, chunk_sizes, NULL, NULL, NULL, NULL, NULL, cmp_sizes)));
+		TEST_ASSERT_EQUAL_INT(CMP_ERROR_CHUNK_NULL, cmp_get_error_code(compress_chunks_batch(
+			&ctx, 1, NULL, chunk_sizes, NULL, NULL, NULL, NULL, &par, cmp_sizes)));
+		TEST_ASSERT_EQUAL_INT(CMP_ERROR_GENERIC, cmp_get_error_code(compress_chunks_batch(
+			&ctx, 1, (const void *const *)chunks, chunk_sizes, NULL, NULL, dst, NULL, &par, cmp_sizes)));
+		TEST_ASSERT_EQUAL_UINT32(0, compress_chunks_batch(&ctx, 0, (const void *const *)chunks,
+			chunk_sizes, NULL, NULL, NULL, NULL, &par, cmp_sizes));
+	}
+
+	for (i = 0; i < N_CHUNKS; i++)
+		chunk_fixture_free(&f[i]);
+	free(dst_single);
+	free(up_model_single);
+}
+
+
+/**
+ * @brief compress a random chunk with parameters tuned to fit a budget
+ *
+ * @test compress_chunk_to_budget
+ */
+
+void test_compress_chunk_to_budget(void)
+{
+	struct chunk_def chunk_def[2] = {{DATA_TYPE_S_FX, 200}, {DATA_TYPE_S_FX_NCOB, 200}};
+	struct cmp_par par, good_par;
+	struct cmp_ctx ctx;
+	struct chunk_fixture f;
+	uint32_t start_size, good_size, budget, cmp_size;
+	double p = 0.01;
+	int decmp_size;
+
+	chunk_fixture_init(&f, chunk_def, ARRAY_SIZE(chunk_def), gen_geometric_data, &p);
+	cmp_ctx_init(&ctx, NULL, 42);
+
+	/* the smallest parameters are a bad choice for geometric data with p = 0.01 */
+	memset(&par, 0, sizeof(par));
+	par.cmp_mode = CMP_MODE_DIFF_ZERO;
+	par.s_exp_flags = 1;
+	par.s_fx = 1;
+	par.s_ncob = 1;
+	par.s_efx = 1;
+	par.s_ecob = 1;
+	good_par = par;
+	good_par.s_exp_flags = 2;
+	good_par.s_fx = 64;
+	good_par.s_ncob = 64;
+	start_size = compress_chunk_ctx(&ctx, f.chunk, f.chunk_size, NULL, NULL, NULL, 0, &par);
+	good_size = compress_chunk_ctx(&ctx, f.chunk, f.chunk_size, NULL, NULL, NULL, 0, &good_par);
+	TEST_ASSERT_FALSE(cmp_is_error(start_size));
+	TEST_ASSERT_FALSE(cmp_is_error(good_size));
+	TEST_ASSERT(good_size < start_size);
+
+	/* the parameters are tuned until the chunk fits */
+	budget = good_size + 8;
+	cmp_size = compress_chunk_to_budget(&ctx, f.chunk, f.chunk_size, NULL, NULL,
+					    f.dst, budget, &par);
+	TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+	TEST_ASSERT(cmp_size <= budget);
+	TEST_ASSERT_EQUAL_UINT32(cmp_size, compress_chunk_ctx(&ctx, f.chunk, f.chunk_size, NULL,
+							      NULL, NULL, 0, &par));
+	decmp_size = decompress_cmp_entiy((struct cmp_entity *)f.dst, NULL, NULL, f.decmp_chunk);
+	TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(f.chunk, f.decmp_chunk, f.chunk_size);
+
+	/* the tuned parameters fit; they are not changed again */
+	good_par = par;
+	TEST_ASSERT_EQUAL_UINT32(cmp_size, compress_chunk_to_budget(&ctx, f.chunk, f.chunk_size,
+								     NULL, NULL, NULL, budget,
+								     &par));
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(&good_par, &par, sizeof(par));
+
+	/* a budget which is not a multiple of 4; the dst buffer is written
+	 * in 4-byte words
+	 */
+	start_size = cmp_size;
+	for (budget = start_size; budget < start_size + 4; budget++) {
+		if (!(budget & 0x3))
+			continue;
+		par = good_par;
+		cmp_size = compress_chunk_to_budget(&ctx, f.chunk, f.chunk_size, NULL, NULL,
+						    f.dst, budget, &par);
+		TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+		TEST_ASSERT(cmp_size <= (budget & ~0x3U));
+		decmp_size = decompress_cmp_entiy((struct cmp_entity *)f.dst, NULL, NULL,
+						  f.decmp_chunk);
+		TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+		TEST_ASSERT_EQUAL_HEX8_ARRAY(f.chunk, f.decmp_chunk, f.chunk_size);
+	}
+
+	/* the budget is too small for any parameters */
+	cmp_size = compress_chunk_to_budget(&ctx, f.chunk, f.chunk_size, NULL, NULL,
+					    f.dst, NON_IMAGETTE_HEADER_SIZE, &par);
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(cmp_size));
+
+	/* error cases */
+	cmp_size = compress_chunk_to_budget(NULL, f.chunk, f.chunk_size, NULL, NULL,
+					    f.dst, budget, &par);
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_GENERIC, cmp_get_error_code(cmp_size));
+	cmp_size = compress_chunk_to_budget(&ctx, f.chunk, f.chunk_size, NULL, NULL,
+					    f.dst, budget, NULL);
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_PAR_NULL, cmp_get_error_code(cmp_size));
+	par.s_fx = 0;
+	cmp_size = compress_chunk_to_budget(&ctx, f.chunk, f.chunk_size, NULL, NULL,
+					    f.dst, budget, &par);
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_PAR_SPECIFIC, cmp_get_error_code(cmp_size));
+
+	chunk_fixture_free(&f);
+}
+
+
+/**
+ * @brief compress random chunks with per-collection parameter overrides and
+ *	check the round trip and the size against the plain compression
+ *
+ * @test cmp_ctx_set_col_pars
+ * @test decompress_cmp_entiy
+ */
+
+void test_compress_chunk_col_pars(void)
+{
+	struct col_def {
+		enum cmp_data_type data_type;
+		uint32_t samples;
+		double p; /* 0 for uniform distributed data */
+	};
+	static const struct col_def short_cadence[] = {
+		{DATA_TYPE_S_FX, 150, 0.5}, {DATA_TYPE_S_FX_EFX_NCOB_ECOB, 100, 0.001},
+		{DATA_TYPE_S_FX_NCOB, 50, 0}, {DATA_TYPE_S_FX, 0, 0.1}};
+	static const struct col_def long_cadence[] = {
+		{DATA_TYPE_L_FX_EFX_NCOB_ECOB, 100, 0.01}, {DATA_TYPE_L_FX_NCOB, 100, 0.3}};
+	static const struct col_def imagette[] = {
+		{DATA_TYPE_IMAGETTE, 400, 0.1}, {DATA_TYPE_IMAGETTE, 400, 0.001}};
+	static const struct col_def aux[] = {
+		{DATA_TYPE_OFFSET, 100, 0.05}, {DATA_TYPE_BACKGROUND, 100, 0.002}};
+	static const struct col_def smearing[] = {{DATA_TYPE_SMEARING, 200, 0.02}};
+	static const struct col_def f_chain[] = {
+		{DATA_TYPE_F_CAM_IMAGETTE, 300, 0.2}, {DATA_TYPE_F_CAM_OFFSET, 50, 0.01},
+		{DATA_TYPE_F_CAM_BACKGROUND, 50, 0.005}};
+	static const struct {
+		const struct col_def *cols;
+		size_t n_cols;
+	} chunks[] = {
+		{short_cadence, ARRAY_SIZE(short_cadence)}, {long_cadence, ARRAY_SIZE(long_cadence)},
+		{imagette, ARRAY_SIZE(imagette)}, {aux, ARRAY_SIZE(aux)},
+		{smearing, ARRAY_SIZE(smearing)}, {f_chain, ARRAY_SIZE(f_chain)}};
+	size_t c;
+
+	for (c = 0; c < ARRAY_SIZE(chunks); c++) {
+		struct chunk_fixture f;
+		uint32_t chunk_size = 0, n_calls;
+		enum cmp_mode cmp_mode;
+		struct cmp_ctx ctx;
+		size_t i;
+		int run;
+
+		for (i = 0; i < chunks[c].n_cols; i++)
+			chunk_size += (uint32_t)generate_random_collection(NULL,
+				chunks[c].cols[i].data_type, chunks[c].cols[i].samples, NULL, NULL);
+		chunk_fixture_alloc(&f, chunk_size);
+		for (run = 0; run < 2; run++) {
+			uint8_t *buf = run ? f.model : f.chunk;
+			uint32_t offset = 0;
+
+			for (i = 0; i < chunks[c].n_cols; i++) {
+				double p = chunks[c].cols[i].p;
+
+				offset += (uint32_t)generate_random_collection(
+					(struct collection_hdr *)(buf + offset),
+					chunks[c].cols[i].data_type, chunks[c].cols[i].samples,
+					p > 0 ? gen_geometric_data : gen_uniform_data, &p);
+			}
+		}
+
+		chunk_fixture_alloc_dst(&f);
+
+		cmp_ctx_init(&ctx, NULL, 0);
+		compress_chunk_init(NULL, 0);
+		cmp_ctx_set_col_pars(&ctx, 1);
+
+		for (cmp_mode = CMP_MODE_MODEL_ZERO; cmp_mode <= CMP_MODE_DIFF_MULTI; cmp_mode++) {
+			for (run = 0; run < 2; run++) {
+				struct cmp_par par;
+				uint32_t cmp_size, cmp_size_col, read_bytes;
+				int decmp_size;
+
+				generate_random_cmp_par(&par);
+				par.cmp_mode = cmp_mode;
+				par.model_value = 8;
+				par.lossy_par = CMP_LOSSLESS;
+				if (run == 0) { /* poor parameters for all collections */
+					uint32_t *field;
+
+					for (field = &par.nc_imagette;
+					     field <= &par.fc_background_outlier_pixels; field++)
+						*field = 1;
+				}
+
+				cmp_size = compress_chunk(f.chunk, f.chunk_size, f.model, NULL,
+							  NULL, 0, &par);
+				TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+				memcpy(f.up_model, f.model, f.chunk_size);
+				cmp_size_col = compress_chunk_ctx(&ctx, f.chunk, f.chunk_size, f.model,
+								  f.up_model, f.dst,
+								  f.dst_capacity, &par);
+				TEST_ASSERT_FALSE(cmp_is_error(cmp_size_col));
+				TEST_ASSERT_TRUE(cmp_size_col <= f.dst_capacity);
+				TEST_ASSERT_EQUAL_HEX8(CMP_ENT_FLAG_COL_PARS,
+						       cmp_ent_get_reserved((struct cmp_entity *)f.dst));
+				if (run == 0)
+					TEST_ASSERT_TRUE(cmp_size_col < cmp_size);
+				else /* at most the mask byte per collection is lost */
+					TEST_ASSERT_TRUE(cmp_size_col <= cmp_size + chunks[c].n_cols);
+
+				decmp_size = decompress_cmp_entiy((struct cmp_entity *)f.dst, f.model,
+								  f.decmp_model, f.decmp_chunk);
+				TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(f.chunk, f.decmp_chunk, f.chunk_size);
+				if (model_mode_is_used(cmp_mode))
+					TEST_ASSERT_EQUAL_HEX8_ARRAY(f.up_model, f.decmp_model, f.chunk_size);
+
+				/* only get the compressed size */
+				TEST_ASSERT_EQUAL_HEX32(cmp_size_col, compress_chunk_ctx(&ctx,
+					f.chunk, f.chunk_size, f.model, NULL, NULL, 0, &par));
+
+				/* the streaming API gives the same result */
+				memset(f.dst_cmp, 0, f.dst_capacity);
+				TEST_ASSERT_FALSE(cmp_is_error(compress_chunk_begin(&ctx, f.dst_cmp,
+										    f.dst_capacity, &par)));
+				for (read_bytes = 0; read_bytes < f.chunk_size;
+				     read_bytes += cmp_col_get_size((struct collection_hdr *)(f.chunk + read_bytes)))
+					TEST_ASSERT_FALSE(cmp_is_error(compress_chunk_add_collection(&ctx,
+						f.chunk + read_bytes, f.model + read_bytes, NULL)));
+				TEST_ASSERT_EQUAL_HEX32(cmp_size_col, compress_chunk_finish(&ctx));
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(f.dst, f.dst_cmp, cmp_size_col);
+
+				/* a parallel context falls back to the serial compression */
+				n_calls = 0;
+				cmp_ctx_set_parallel(&ctx, f.work_buf, f.work_size, run_jobs_reverse, &n_calls);
+				memset(f.dst_cmp, 0, f.dst_capacity);
+				TEST_ASSERT_EQUAL_HEX32(cmp_size_col, compress_chunk_ctx(&ctx,
+					f.chunk, f.chunk_size, f.model, NULL, f.dst_cmp, f.dst_capacity, &par));
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(f.dst, f.dst_cmp, cmp_size_col);
+				cmp_ctx_set_parallel(&ctx, NULL, 0, NULL, NULL);
+			}
+		}
+
+		/* without overrides the flag is not set */
+		cmp_ctx_set_col_pars(&ctx, 0);
+		{
+			struct cmp_par par;
+
+			generate_random_cmp_par(&par);
+			par.cmp_mode = CMP_MODE_DIFF_ZERO;
+			par.lossy_par = CMP_LOSSLESS;
+			memset(f.dst, 0, f.dst_capacity);
+			TEST_ASSERT_EQUAL_HEX32(compress_chunk(f.chunk, f.chunk_size, NULL, NULL,
+							       NULL, 0, &par),
+						compress_chunk_ctx(&ctx, f.chunk, f.chunk_size, NULL,
+								   NULL, f.dst, f.dst_capacity, &par));
+			TEST_ASSERT_EQUAL_HEX8(0, cmp_ent_get_reserved((struct cmp_entity *)f.dst));
+		}
+
+		chunk_fixture_free(&f);
+	}
+}
+
+
+/**
+ * @brief compress chunks with collections identical to their model
+ *
+ * @test cmp_ctx_set_equal_model
+ * @test cmp_collection
+ * @test decompress_cmp_entiy
+ */
+
+void test_cmp_decmp_chunk_equal_to_model(void)
+{
+	struct chunk_def chunk_def[3] = {{DATA_TYPE_S_FX, 100}, {DATA_TYPE_S_FX_EFX_NCOB_ECOB, 50},
+					 {DATA_TYPE_S_FX_NCOB, 70}};
+	uint32_t const chunk_hdr_size = NON_IMAGETTE_HEADER_SIZE +
+		ARRAY_SIZE(chunk_def) * (CMP_COLLECTION_FILD_SIZE + COLLECTION_HDR_SIZE);
+	struct chunk_fixture f;
+	uint32_t n_calls;
+	enum cmp_mode cmp_mode;
+	struct cmp_ctx ctx;
+	double p = 0.01;
+
+	chunk_fixture_init(&f, chunk_def, ARRAY_SIZE(chunk_def), gen_geometric_data, &p);
+	cmp_ctx_init(&ctx, NULL, 0);
+	compress_chunk_init(NULL, 0);
+	cmp_ctx_set_equal_model(&ctx, 1);
+
+	for (cmp_mode = CMP_MODE_RAW; cmp_mode <= CMP_MODE_DIFF_MULTI; cmp_mode++) {
+		struct cmp_par par;
+		uint32_t cmp_size;
+		int decmp_size;
+
+		generate_random_cmp_par(&par);
+		par.cmp_mode = cmp_mode;
+		par.lossy_par = CMP_LOSSLESS;
+
+		/* all collections are equal to the model */
+		memcpy(f.model, f.chunk, f.chunk_size);
+		memset(f.up_model, 0, f.chunk_size);
+		memset(f.dst, 0, f.dst_capacity);
+		cmp_size = compress_chunk_ctx(&ctx, f.chunk, f.chunk_size, f.model, f.up_model,
+					      f.dst, f.dst_capacity, &par);
+		TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+		if (model_mode_is_used(cmp_mode)) {
+			TEST_ASSERT_EQUAL_UINT32(chunk_hdr_size, cmp_size);
+			TEST_ASSERT_EQUAL_HEX8(CMP_ENT_FLAG_EQUAL_MODEL,
+					       cmp_ent_get_reserved((struct cmp_entity *)f.dst));
+			TEST_ASSERT_EQUAL_HEX8_ARRAY(f.chunk, f.up_model, f.chunk_size);
+		} else {
+			TEST_ASSERT_TRUE(cmp_size > chunk_hdr_size);
+			TEST_ASSERT_EQUAL_HEX8(0, cmp_ent_get_reserved((struct cmp_entity *)f.dst));
+		}
+		TEST_ASSERT_EQUAL_HEX32(cmp_size, compress_chunk_ctx(&ctx, f.chunk, f.chunk_size,
+								     f.model, NULL, NULL, 0, &par));
+
+		decmp_size = decompress_cmp_entiy((struct cmp_entity *)f.dst, f.model,
+						  f.decmp_model, f.decmp_chunk);
+		TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+		TEST_ASSERT_EQUAL_HEX8_ARRAY(f.chunk, f.decmp_chunk, f.chunk_size);
+		if (model_mode_is_used(cmp_mode)) {
+			TEST_ASSERT_EQUAL_HEX8_ARRAY(f.up_model, f.decmp_model, f.chunk_size);
+
+			/* in-place decompression */
+			memcpy(f.decmp_chunk, f.model, f.chunk_size);
+			decmp_size = decompress_cmp_entiy((struct cmp_entity *)f.dst, f.decmp_chunk,
+							  f.decmp_chunk, f.decmp_chunk);
+			TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+			TEST_ASSERT_EQUAL_HEX8_ARRAY(f.chunk, f.decmp_chunk, f.chunk_size);
+
+			/* a model is needed */
+			TEST_ASSERT_EQUAL_INT(-1, decompress_cmp_entiy((struct cmp_entity *)f.dst,
+								       NULL, NULL, f.decmp_chunk));
+		}
+
+		/* the parallel compression gives the same result */
+		n_calls = 0;
+		cmp_ctx_set_parallel(&ctx, f.work_buf, f.work_size, run_jobs_reverse, &n_calls);
+		memset(f.dst_cmp, 0, f.dst_capacity);
+		TEST_ASSERT_EQUAL_HEX32(cmp_size, compress_chunk_ctx(&ctx, f.chunk, f.chunk_size,
+								     f.model, NULL, f.dst_cmp,
+								     f.dst_capacity, &par));
+		TEST_ASSERT_EQUAL_HEX8_ARRAY(f.dst, f.dst_cmp, cmp_size);
+		cmp_ctx_set_parallel(&ctx, NULL, 0, NULL, NULL);
+
+		/* collections equal to their model carry no parameter overrides */
+		if (model_mode_is_used(cmp_mode)) {
+			cmp_ctx_set_col_pars(&ctx, 1);
+			memset(f.dst_cmp, 0, f.dst_capacity);
+			TEST_ASSERT_EQUAL_HEX32(cmp_size, compress_chunk_ctx(&ctx, f.chunk, f.chunk_size,
+									     f.model, NULL, f.dst_cmp,
+									     f.dst_capacity, &par));
+			TEST_ASSERT_EQUAL_HEX8(CMP_ENT_FLAG_COL_PARS | CMP_ENT_FLAG_EQUAL_MODEL,
+					       cmp_ent_get_reserved((struct cmp_entity *)f.dst_cmp));
+			TEST_ASSERT_EQUAL_INT(f.chunk_size, decompress_cmp_entiy(
+				(struct cmp_entity *)f.dst_cmp, f.model, NULL, f.decmp_chunk));
+			TEST_ASSERT_EQUAL_HEX8_ARRAY(f.chunk, f.decmp_chunk, f.chunk_size);
+			cmp_ctx_set_col_pars(&ctx, 0);
+		}
+
+		/* without the flag, the collections are compressed and decompressed
+		 * as before
+		 */
+		memset(f.dst_cmp, 0, f.dst_capacity);
+		cmp_size = compress_chunk(f.chunk, f.chunk_size, f.model, NULL, f.dst_cmp,
+					  f.dst_capacity, &par);
+		TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+		TEST_ASSERT_TRUE(cmp_size > chunk_hdr_size);
+		TEST_ASSERT_EQUAL_HEX8(0, cmp_ent_get_reserved((struct cmp_entity *)f.dst_cmp));
+		memset(f.decmp_chunk, 0, f.chunk_size);
+		decmp_size = decompress_cmp_entiy((struct cmp_entity *)f.dst_cmp, f.model,
+						  NULL, f.decmp_chunk);
+		TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+		TEST_ASSERT_EQUAL_HEX8_ARRAY(f.chunk, f.decmp_chunk, f.chunk_size);
+
+		/* a collection without compressed data is not taken as a copy of
+		 * the model if the flag is not set
+		 */
+		if (model_mode_is_used(cmp_mode)) {
+			cmp_ent_set_reserved((struct cmp_entity *)f.dst, 0);
+			TEST_ASSERT_EQUAL_INT(-1, decompress_cmp_entiy((struct cmp_entity *)f.dst,
+								       f.model, NULL, f.decmp_chunk));
+		}
+
+		/* only the second collection differs from its model */
+		{
+			uint32_t const col_size = cmp_col_get_size((struct collection_hdr *)f.chunk);
+
+			f.model[col_size + COLLECTION_HDR_SIZE] ^= 0x1;
+			cmp_size = compress_chunk_ctx(&ctx, f.chunk, f.chunk_size, f.model,
+						      f.up_model, f.dst, f.dst_capacity, &par);
+			TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+			TEST_ASSERT_TRUE(cmp_size > chunk_hdr_size);
+			decmp_size = decompress_cmp_entiy((struct cmp_entity *)f.dst, f.model,
+							  f.decmp_model, f.decmp_chunk);
+			TEST_ASSERT_EQUAL_INT(f.chunk_size, decmp_size);
+			TEST_ASSERT_EQUAL_HEX8_ARRAY(f.chunk, f.decmp_chunk, f.chunk_size);
+			if (model_mode_is_used(cmp_mode))
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(f.up_model, f.decmp_model, f.chunk_size);
+		}
+
+	}
+
+	/* a lossy compression does not use the shortcut */
+	{
+		struct cmp_par par;
+		uint32_t col_size = (uint32_t)generate_random_collection(NULL, DATA_TYPE_OFFSET,
+									  50, NULL, NULL);
+		uint32_t cmp_size;
+
+		TEST_ASSERT_TRUE(col_size <= f.chunk_size);
+		generate_random_collection((struct collection_hdr *)f.chunk, DATA_TYPE_OFFSET,
+					   50, gen_geometric_data, &p);
+		memcpy(f.model, f.chunk, col_size);
+		generate_random_cmp_par(&par);
+		par.cmp_mode = CMP_MODE_MODEL_ZERO;
+		par.lossy_par = CMP_LOSSLESS;
+		cmp_size = compress_chunk_ctx(&ctx, f.chunk, col_size, f.model, NULL, NULL, 0, &par);
+		TEST_ASSERT_EQUAL_UINT32(NON_IMAGETTE_HEADER_SIZE + CMP_COLLECTION_FILD_SIZE +
+					 COLLECTION_HDR_SIZE, cmp_size);
+		par.lossy_par = 1;
+		cmp_size = compress_chunk_ctx(&ctx, f.chunk, col_size, f.model, NULL, f.dst,
+					      f.dst_capacity, &par);
+		TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+		TEST_ASSERT_TRUE(cmp_size > NON_IMAGETTE_HEADER_SIZE + CMP_COLLECTION_FILD_SIZE +
+				 COLLECTION_HDR_SIZE);
+		TEST_ASSERT_EQUAL_HEX8(0, cmp_ent_get_reserved((struct cmp_entity *)f.dst));
+	}
+
+	chunk_fixture_free(&f);
+}
@@ -158,7 +158,39 @@ void test_map_to_pos(void)
 
 
 /**
- * @test put_n_bits32
+ * @brief put the value of up to 32 bits into a big-endian bitstream using a
+ *	bit_encoder and flush the bits to the bitstream
+ *
+ * @param value			the value to put into the bitstream
+ * @param n_bits		number of bits to put into the bitstream
+ * @param bit_offset		bit index where the bits will be put, seen from
+ *				the very beginning of the bitstream
+ * @param bitstream_adr		this is the pointer to the beginning of the
+ *				bitstream (can be NULL)
+ * @param max_stream_len	maximum length of the bitstream in *bits*; is
+ *				ignored if bitstream_adr is NULL
+ *
+ * @returns the length of the generated bitstream in bits on success or an error
+ *          code (which can be tested with cmp_is_error())
+ */
+
+static uint32_t put_n_bits32(uint32_t value, unsigned int n_bits, uint32_t bit_offset,
+			     uint32_t *bitstream_adr, unsigned int max_stream_len)
+{
+	struct bit_encoder enc;
+	uint32_t stream_len;
+
+	bit_init_encoder(&enc, bitstream_adr, max_stream_len, bit_offset);
+	stream_len = bit_write_bits32(&enc, value, n_bits);
+	if (!cmp_is_error(stream_len))
+		bit_flush_encoder(&enc);
+
+	return stream_len;
+}
+
+
+/**
+ * @test bit_write_bits32
  */
 
 #define SDP_PB_N 3
@@ -176,7 +208,7 @@ static void init_PB32_arrays(uint32_t *z, uint32_t *o)
 }
 
 
-void test_put_n_bits32(void)
+void test_bit_write_bits32(void)
 {
 	uint32_t v, n;
 	uint32_t o;
@@ -578,6 +610,46 @@ void test_put_n_bits32(void)
 }
 
 
+/**
+ * @test bit_write_bits32_unchecked
+ * @test bit_free_bits
+ */
+
+void test_bit_write_bits32_unchecked(void)
+{
+	uint32_t buf_checked[8], buf_unchecked[8];
+	struct bit_encoder enc_checked, enc_unchecked;
+	uint32_t i, rval;
+
+	memset(buf_checked, 0xA5, sizeof(buf_checked));
+	memset(buf_unchecked, 0xA5, sizeof(buf_unchecked));
+	bit_init_encoder(&enc_checked, buf_checked, 8*32, 3);
+	bit_init_encoder(&enc_unchecked, buf_unchecked, 8*32, 3);
+	TEST_ASSERT_EQUAL_INT(8*32 - 3, bit_free_bits(&enc_unchecked));
+
+	/* the unchecked version forms the same bitstream */
+	for (i = 1; i <= 21; i++) {
+		uint32_t const v = 0x9E3779B9U * i;
+
+		rval = bit_write_bits32(&enc_checked, v, i);
+		TEST_ASSERT_EQUAL_INT(rval, bit_write_bits32_unchecked(&enc_unchecked, v, i));
+	}
+	TEST_ASSERT_EQUAL_INT(3 + 21*22/2, rval);
+	TEST_ASSERT_EQUAL_INT(8*32 - rval, bit_free_bits(&enc_unchecked));
+	bit_flush_encoder(&enc_checked);
+	bit_flush_encoder(&enc_unchecked);
+	TEST_ASSERT_EQUAL_HEX32_ARRAY(buf_checked, buf_unchecked, 8);
+
+	/* no free bits if only the length is counted or the buffer is full */
+	bit_init_encoder(&enc_unchecked, NULL, 8*32, 0);
+	TEST_ASSERT_EQUAL_INT(0, bit_free_bits(&enc_unchecked));
+	bit_init_encoder(&enc_unchecked, buf_unchecked, 8*32, 8*32);
+	TEST_ASSERT_EQUAL_INT(0, bit_free_bits(&enc_unchecked));
+	bit_init_encoder(&enc_unchecked, buf_unchecked, 8*32, 8*32+1);
+	TEST_ASSERT_EQUAL_INT(0, bit_free_bits(&enc_unchecked));
+}
+
+
 /**
  * @test rice_encoder
  */
@@ -658,136 +730,229 @@ void test_golomb_encoder(void)
 
 	/* test minimum Golomb parameter */
 	value = 0; g_par = MIN_NON_IMA_GOLOMB_PAR; log2_g_par = ilog_2(g_par); cw = ~0U;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(1, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x0, cw);
 
 	value = 31;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFE, cw);
 
 	/* error case: value larger than allowed */
 	value = 32; g_par = 1; log2_g_par = ilog_2(g_par); cw = ~0U;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_GREATER_THAN_UINT(32, cw_len);
 
 	/* error case: value larger than allowed */
 	value = 33; g_par = 1; log2_g_par = ilog_2(g_par); cw = ~0U;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_GREATER_THAN_UINT(32, cw_len);
 
 #if 0
 	/* error case: value larger than allowed overflow in returned len */
 	value = UINT32_MAX; g_par = 1; log2_g_par = ilog_2(g_par); cw = ~0U;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_GREATER_THAN_UINT(32, cw_len);
 #endif
 
 	/* test some arbitrary values with g_par = 16 */
 	value = 0; g_par = 16; log2_g_par = ilog_2(g_par); cw = ~0U;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(5, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x0, cw);
 
 	value = 1;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(5, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x1, cw);
 
 	value = 42;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(7, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x6a, cw);
 
 	value = 446;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0xFFFFFFEE, cw);
 
 	value = 447;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0xFFFFFFEF, cw);
 
 
 	/* test some arbitrary values with g_par = 3 */
 	value = 0; g_par = 3; log2_g_par = ilog_2(g_par); cw = ~0U;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(2, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x0, cw);
 
 	value = 1;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(3, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x2, cw);
 
 	value = 42;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(16, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0xFFFC, cw);
 
 	value = 44;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(17, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x1FFFB, cw);
 
 	value = 88;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFA, cw);
 
 	value = 89;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFB, cw);
 
 	/* test some arbitrary values with g_par = 0x7FFFFFFF */
 	value = 0; g_par = 0x7FFFFFFF; log2_g_par = ilog_2(g_par); cw = ~0U;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(31, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x0, cw);
 
 	value = 1;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x2, cw);
 
 	value = 0x7FFFFFFE;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x7FFFFFFF, cw);
 
 	value = 0x7FFFFFFF;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x80000000, cw);
 
 	/* test maximum Golomb parameter for golomb_encoder */
 	value = 0; g_par = MAX_GOLOMB_PAR; log2_g_par = ilog_2(g_par); cw = ~0U;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x0, cw);
 
 	value = 1; g_par = MAX_GOLOMB_PAR; log2_g_par = ilog_2(g_par); cw = ~0U;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x1, cw);
 
 	value = 0x7FFFFFFE;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x7FFFFFFE, cw);
 
 	value = 0x7FFFFFFF;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x7FFFFFFF, cw);
 
 	value = 0; g_par = 0xFFFFFFFF; log2_g_par = ilog_2(g_par); cw = ~0U;
-	cw_len = golomb_encoder(value, g_par, log2_g_par, &cw);
+	cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
 	TEST_ASSERT_EQUAL_INT(32, cw_len);
 	TEST_ASSERT_EQUAL_HEX(0x0, cw);
+
+	/* for a power of two parameter the Golomb and Rice code words are equal */
+	for (log2_g_par = 0; log2_g_par < 16; log2_g_par++) {
+		g_par = 1U << log2_g_par;
+		for (value = 0; value < 32; value++) {
+			uint32_t rice_cw;
+			uint32_t rice_cw_len = rice_encoder(value, g_par, log2_g_par, &rice_cw);
+
+			cw_len = golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw);
+			TEST_ASSERT_EQUAL_INT(rice_cw_len, cw_len);
+			TEST_ASSERT_EQUAL_HEX(rice_cw, cw);
+		}
+	}
+}
+
+
+/**
+ * @test rice_cw_len
+ * @test golomb_cw_len
+ */
+
+void test_cw_len(void)
+{
+	uint32_t value, g_par, log2_g_par, cw, max_value;
+
+	for (g_par = MIN_NON_IMA_GOLOMB_PAR; g_par < 300; g_par++) {
+		log2_g_par = ilog_2(g_par);
+		for (value = 0; value < 600; value++)
+			TEST_ASSERT_EQUAL_INT(golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw),
+					      golomb_cw_len(value, g_par, log2_g_par, golomb_recip(g_par)));
+	}
+
+	for (log2_g_par = 0; log2_g_par < 32; log2_g_par++) {
+		/* the Rice encoder only forms code words up to 32 bits */
+		max_value = (32 - log2_g_par) << log2_g_par;
+		g_par = 1U << log2_g_par;
+		for (value = 0; value < 600 && value < max_value; value++)
+			TEST_ASSERT_EQUAL_INT(rice_encoder(value, g_par, log2_g_par, &cw),
+					      rice_cw_len(value, log2_g_par));
+		/* the length of a too long code word is still calculated */
+		TEST_ASSERT_EQUAL_INT(32, rice_cw_len(max_value - 1, log2_g_par));
+		TEST_ASSERT_EQUAL_INT(33, rice_cw_len(max_value, log2_g_par));
+	}
+
+	value = 0xFFFFFFFF; g_par = MAX_NON_IMA_GOLOMB_PAR; log2_g_par = ilog_2(g_par);
+	TEST_ASSERT_EQUAL_INT(golomb_encoder(value, g_par, log2_g_par, golomb_recip(g_par), &cw),
+			      golomb_cw_len(value, g_par, log2_g_par, golomb_recip(g_par)));
+}
+
+
+/**
+ * @test cw_cache_get
+ */
+
+void test_cw_cache_get(void)
+{
+	struct cw_table_cache cache;
+	const struct cw_table *table, *table2;
+	uint32_t value, g_par, cw, cw_len;
+
+	cw_cache_init(&cache);
+
+	g_par = 5;
+	table = cw_cache_get(&cache, g_par);
+	TEST_ASSERT_EQUAL_INT(1, cache.n_built);
+	TEST_ASSERT_EQUAL_INT(g_par, table->golomb_par);
+	for (value = 0; value < CW_TABLE_SIZE; value++) {
+		cw_len = golomb_encoder(value, g_par, ilog_2(g_par), golomb_recip(g_par), &cw);
+		if (cw_len > 32) {
+			TEST_ASSERT_EQUAL_INT(33, table->len[value]);
+		} else {
+			TEST_ASSERT_EQUAL_INT(cw_len, table->len[value]);
+			TEST_ASSERT_EQUAL_HEX(cw, table->cw[value]);
+		}
+	}
+
+	/* a table in the cache is not rebuilt */
+	table2 = cw_cache_get(&cache, g_par);
+	TEST_ASSERT_EQUAL_PTR(table, table2);
+	TEST_ASSERT_EQUAL_INT(1, cache.n_built);
+
+	/* code word lengths greater than 32 bits */
+	g_par = 3;
+	table = cw_cache_get(&cache, g_par);
+	TEST_ASSERT_EQUAL_INT(2, cache.n_built);
+	TEST_ASSERT_EQUAL_INT(33, table->len[CW_TABLE_SIZE-1]);
+
+	/* the oldest table is replaced if the cache is full */
+	for (g_par = 6; g_par < 6 + CW_CACHE_ENTRIES - 1; g_par++)
+		cw_cache_get(&cache, g_par);
+	TEST_ASSERT_EQUAL_INT(CW_CACHE_ENTRIES + 1, cache.n_built);
+	TEST_ASSERT_EQUAL_INT(6 + CW_CACHE_ENTRIES - 2, cache.table[0].golomb_par);
+	TEST_ASSERT_EQUAL_INT(3, cache.table[1].golomb_par);
 }
 
 
@@ -800,6 +965,7 @@ void test_encode_value_zero(void)
 	uint32_t data, model;
 	uint32_t stream_len;
 	struct encoder_setup setup = {0};
+	struct bit_encoder enc;
 	uint32_t bitstream[3] = {0};
 
 	/* setup the setup */
@@ -807,28 +973,28 @@ void test_encode_value_zero(void)
 	setup.encoder_par2 = ilog_2(setup.encoder_par1);
 	setup.spillover_par = 32;
 	setup.max_data_bits = 32;
-	setup.generate_cw_f = rice_encoder;
-	setup.bitstream_adr = bitstream;
-	setup.max_stream_len = sizeof(bitstream) * CHAR_BIT;
-
-	stream_len = 0;
+	setup.enc = &enc;
+	bit_init_encoder(&enc, bitstream, sizeof(bitstream) * CHAR_BIT, 0);
 
 	data = 0; model = 0;
-	stream_len = encode_value_zero(data, model, stream_len, &setup);
+	stream_len = encode_value_zero(data, model, &setup, ENC_RICE);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(2, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0x80000000, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0x00000000, be32_to_cpu(bitstream[1]));
 	TEST_ASSERT_EQUAL_HEX(0x00000000, be32_to_cpu(bitstream[2]));
 
 	data = 5; model = 0;
-	stream_len = encode_value_zero(data, model, stream_len, &setup);
+	stream_len = encode_value_zero(data, model, &setup, ENC_RICE);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(14, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0xBFF80000, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0x00000000, be32_to_cpu(bitstream[1]));
 	TEST_ASSERT_EQUAL_HEX(0x00000000, be32_to_cpu(bitstream[2]));
 
 	data = 2; model = 7;
-	stream_len = encode_value_zero(data, model, stream_len, &setup);
+	stream_len = encode_value_zero(data, model, &setup, ENC_RICE);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(25, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0xBFFBFF00, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0x00000000, be32_to_cpu(bitstream[1]));
@@ -837,7 +1003,8 @@ void test_encode_value_zero(void)
 	/* zero escape mechanism */
 	data = 100; model = 42;
 	/* (100-42)*2+1=117 -> cw 0 + 0x0000_0000_0000_0075 */
-	stream_len = encode_value_zero(data, model, stream_len, &setup);
+	stream_len = encode_value_zero(data, model, &setup, ENC_RICE);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(58, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0xBFFBFF00, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0x00001D40, be32_to_cpu(bitstream[1]));
@@ -846,7 +1013,8 @@ void test_encode_value_zero(void)
 	/* test overflow */
 	data = (uint32_t)INT32_MIN; model = 0;
 	/* (INT32_MIN)*-2-1+1=0(overflow) -> cw 0 + 0x0000_0000_0000_0000 */
-	stream_len = encode_value_zero(data, model, stream_len, &setup);
+	stream_len = encode_value_zero(data, model, &setup, ENC_RICE);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(91, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0xBFFBFF00, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0x00001D40, be32_to_cpu(bitstream[1]));
@@ -854,7 +1022,7 @@ void test_encode_value_zero(void)
 
 	/* small buffer error */
 	data = 23; model = 26;
-	stream_len = encode_value_zero(data, model, stream_len, &setup);
+	stream_len = encode_value_zero(data, model, &setup, ENC_RICE);
 	TEST_ASSERT_TRUE(cmp_is_error(stream_len));
 	TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(stream_len));
 
@@ -862,14 +1030,15 @@ void test_encode_value_zero(void)
 	bitstream[0] = ~0U;
 	bitstream[1] = ~0U;
 	bitstream[2] = ~0U;
-	stream_len = 0;
+	bit_init_encoder(&enc, bitstream, sizeof(bitstream) * CHAR_BIT, 0);
 
 	/* we use now values with maximum 6 bits */
 	setup.max_data_bits = 6;
 
 	/* lowest value before zero encoding */
 	data = 53; model = 38;
-	stream_len = encode_value_zero(data, model, stream_len, &setup);
+	stream_len = encode_value_zero(data, model, &setup, ENC_RICE);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(32, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFE, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFF, be32_to_cpu(bitstream[1]));
@@ -877,7 +1046,8 @@ void test_encode_value_zero(void)
 
 	/* lowest value with zero encoding */
 	data = 0; model = 16;
-	stream_len = encode_value_zero(data, model, stream_len, &setup);
+	stream_len = encode_value_zero(data, model, &setup, ENC_RICE);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(39, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFE, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0x41FFFFFF, be32_to_cpu(bitstream[1]));
@@ -885,7 +1055,8 @@ void test_encode_value_zero(void)
 
 	/* maximum positive value to encode */
 	data = 31; model = 0;
-	stream_len = encode_value_zero(data, model, stream_len, &setup);
+	stream_len = encode_value_zero(data, model, &setup, ENC_RICE);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(46, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFE, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0x40FFFFFF, be32_to_cpu(bitstream[1]));
@@ -893,7 +1064,8 @@ void test_encode_value_zero(void)
 
 	/* maximum negative value to encode */
 	data = 0; model = 32;
-	stream_len = encode_value_zero(data, model, stream_len, &setup);
+	stream_len = encode_value_zero(data, model, &setup, ENC_RICE);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(53, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFE, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0x40FC07FF, be32_to_cpu(bitstream[1]));
@@ -903,10 +1075,9 @@ void test_encode_value_zero(void)
 	bitstream[0] = 0;
 	bitstream[1] = 0;
 	bitstream[2] = 0;
-	stream_len = 32;
-	setup.max_stream_len = 32;
+	bit_init_encoder(&enc, bitstream, 32, 32);
 	data = 31; model = 0;
-	stream_len = encode_value_zero(data, model, stream_len, &setup);
+	stream_len = encode_value_zero(data, model, &setup, ENC_RICE);
 	TEST_ASSERT_TRUE(cmp_is_error(stream_len));
 	TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(stream_len));
 	TEST_ASSERT_EQUAL_HEX(0, be32_to_cpu(bitstream[0]));
@@ -924,6 +1095,7 @@ void test_encode_value_multi(void)
 	uint32_t data, model;
 	uint32_t stream_len;
 	struct encoder_setup setup = {0};
+	struct bit_encoder enc;
 	uint32_t bitstream[4] = {0};
 
 	/* setup the setup */
@@ -931,14 +1103,12 @@ void test_encode_value_multi(void)
 	setup.encoder_par2 = ilog_2(setup.encoder_par1);
 	setup.spillover_par = 16;
 	setup.max_data_bits = 32;
-	setup.generate_cw_f = golomb_encoder;
-	setup.bitstream_adr = bitstream;
-	setup.max_stream_len = sizeof(bitstream) * CHAR_BIT;
-
-	stream_len = 0;
+	setup.enc = &enc;
+	bit_init_encoder(&enc, bitstream, sizeof(bitstream) * CHAR_BIT, 0);
 
 	data = 0; model = 0;
-	stream_len = encode_value_multi(data, model, stream_len, &setup);
+	stream_len = encode_value_multi(data, model, &setup, ENC_MULTI);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(1, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0x00000000, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0x00000000, be32_to_cpu(bitstream[1]));
@@ -946,7 +1116,8 @@ void test_encode_value_multi(void)
 	TEST_ASSERT_EQUAL_HEX(0x00000000, be32_to_cpu(bitstream[3]));
 
 	data = 0; model = 1;
-	stream_len = encode_value_multi(data, model, stream_len, &setup);
+	stream_len = encode_value_multi(data, model, &setup, ENC_MULTI);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(3, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0x40000000, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0x00000000, be32_to_cpu(bitstream[1]));
@@ -954,7 +1125,8 @@ void test_encode_value_multi(void)
 	TEST_ASSERT_EQUAL_HEX(0x00000000, be32_to_cpu(bitstream[3]));
 
 	data = 1+23; model = 0+23;
-	stream_len = encode_value_multi(data, model, stream_len, &setup);
+	stream_len = encode_value_multi(data, model, &setup, ENC_MULTI);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(6, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0x58000000, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0x00000000, be32_to_cpu(bitstream[1]));
@@ -963,7 +1135,8 @@ void test_encode_value_multi(void)
 
 	/* highest value without multi outlier encoding */
 	data = 0+42; model = 8+42;
-	stream_len = encode_value_multi(data, model, stream_len, &setup);
+	stream_len = encode_value_multi(data, model, &setup, ENC_MULTI);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(22, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0x5BFFF800, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0x00000000, be32_to_cpu(bitstream[1]));
@@ -972,7 +1145,8 @@ void test_encode_value_multi(void)
 
 	/* lowest value with multi outlier encoding */
 	data = 8+42; model = 0+42;
-	stream_len = encode_value_multi(data, model, stream_len, &setup);
+	stream_len = encode_value_multi(data, model, &setup, ENC_MULTI);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(41, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0x5BFFFBFF, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0xFC000000, be32_to_cpu(bitstream[1]));
@@ -981,7 +1155,8 @@ void test_encode_value_multi(void)
 
 	/* highest value with multi outlier encoding */
 	data = (uint32_t)INT32_MIN; model = 0;
-	stream_len = encode_value_multi(data, model, stream_len, &setup);
+	stream_len = encode_value_multi(data, model, &setup, ENC_MULTI);
+	bit_flush_encoder(&enc);
 	TEST_ASSERT_EQUAL_INT(105, stream_len);
 	TEST_ASSERT_EQUAL_HEX(0x5BFFFBFF, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0xFC7FFFFF, be32_to_cpu(bitstream[1]));
@@ -990,47 +1165,22 @@ void test_encode_value_multi(void)
 
 	/* small buffer error */
 	data = 0; model = 38;
-	stream_len = encode_value_multi(data, model, stream_len, &setup);
+	stream_len = encode_value_multi(data, model, &setup, ENC_MULTI);
 	TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(stream_len));
 
 	/* small buffer error when creating the multi escape symbol*/
 	bitstream[0] = 0;
 	bitstream[1] = 0;
-	setup.max_stream_len = 32;
+	bit_init_encoder(&enc, bitstream, 32, 32);
 
-	stream_len = 32;
 	data = 31; model = 0;
-	stream_len = encode_value_multi(data, model, stream_len, &setup);
+	stream_len = encode_value_multi(data, model, &setup, ENC_MULTI);
 	TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(stream_len));
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[0]);
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[1]);
 }
 
 
-/**
- * @brief put the value unencoded with setup->cmp_par_1 bits without any changes
- *      in the bitstream
- *
- * @param value		value to put unchanged in the bitstream
- *			(setup->cmp_par_1 how many bits of the value are used)
- * @param unused	this parameter is ignored
- * @param stream_len	length of the bitstream in bits
- * @param setup		pointer to the encoder setup
- *
- * @returns the bit length of the bitstream with the added unencoded value on
- *	success; negative on error
- */
-
-static uint32_t encode_value_none(uint32_t value, uint32_t unused, uint32_t stream_len,
-				  const struct encoder_setup *setup)
-{
-	(void)(unused);
-
-	return put_n_bits32(value, setup->encoder_par1, stream_len,
-			    setup->bitstream_adr, setup->max_stream_len);
-}
-
-
 /**
  * @test encode_value
  */
@@ -1038,109 +1188,277 @@ static uint32_t encode_value_none(uint32_t value, uint32_t unused, uint32_t stre
 void test_encode_value(void)
 {
 	struct encoder_setup setup = {0};
+	struct bit_encoder enc;
 	uint32_t bitstream[4] = {0};
 	uint32_t data, model;
 	uint32_t cmp_size;
 
-	setup.encode_method_f = encode_value_none;
-	setup.bitstream_adr = bitstream;
-	setup.max_stream_len = 128;
-	cmp_size = 0;
-
-	/* test 32 bit input */
-	setup.encoder_par1 = 32;
+	setup.encoder_par1 = 1;
+	setup.encoder_par2 = ilog_2(setup.encoder_par1);
+	setup.spillover_par = 16;
 	setup.max_data_bits = 32;
 	setup.lossy_par = 0;
+	setup.enc = &enc;
+	bit_init_encoder(&enc, bitstream, 128, 0);
 
+	/* test multi escape symbol mechanism with Rice code words */
 	data = 0; model = 0;
-	cmp_size = encode_value(data, model, cmp_size, &setup);
-	TEST_ASSERT_EQUAL_UINT(32, cmp_size);
+	cmp_size = encode_value(data, model, &setup, ENC_MULTI | ENC_RICE);
+	bit_flush_encoder(&enc);
+	TEST_ASSERT_EQUAL_UINT(1, cmp_size);
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[0]);
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[1]);
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[2]);
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[3]);
 
-	data = UINT32_MAX; model = 0;
-	cmp_size = encode_value(data, model, cmp_size, &setup);
-	TEST_ASSERT_EQUAL_UINT(64, cmp_size);
-	TEST_ASSERT_EQUAL_HEX(0, bitstream[0]);
-	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFF, bitstream[1]);
+	data = 2; model = 1;
+	cmp_size = encode_value(data, model, &setup, ENC_MULTI | ENC_RICE);
+	bit_flush_encoder(&enc);
+	TEST_ASSERT_EQUAL_UINT(4, cmp_size);
+	TEST_ASSERT_EQUAL_HEX(0x60000000, be32_to_cpu(bitstream[0]));
+	TEST_ASSERT_EQUAL_HEX(0, bitstream[1]);
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[2]);
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[3]);
 
 	/* test rounding */
 	setup.lossy_par = 1;
-	data = UINT32_MAX; model = 0;
-	cmp_size = encode_value(data, model, cmp_size, &setup);
-	TEST_ASSERT_EQUAL_UINT(96, cmp_size);
-	TEST_ASSERT_EQUAL_HEX(0, bitstream[0]);
-	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFF, be32_to_cpu(bitstream[1]));
-	TEST_ASSERT_EQUAL_HEX(0x7FFFFFFF, be32_to_cpu(bitstream[2]));
+	data = 7; model = 1;
+	cmp_size = encode_value(data, model, &setup, ENC_MULTI | ENC_RICE);
+	bit_flush_encoder(&enc);
+	TEST_ASSERT_EQUAL_UINT(11, cmp_size);
+	TEST_ASSERT_EQUAL_HEX(0x6FC00000, be32_to_cpu(bitstream[0]));
+	TEST_ASSERT_EQUAL_HEX(0, bitstream[1]);
+	TEST_ASSERT_EQUAL_HEX(0, bitstream[2]);
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[3]);
 
-	setup.lossy_par = 2;
-	data = 0x3; model = 0;
-	cmp_size = encode_value(data, model, cmp_size, &setup);
-	TEST_ASSERT_EQUAL_UINT(128, cmp_size);
-	TEST_ASSERT_EQUAL_HEX(0, bitstream[0]);
-	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFF, bitstream[1]);
-	TEST_ASSERT_EQUAL_HEX(0x7FFFFFFF, be32_to_cpu(bitstream[2]));
-	TEST_ASSERT_EQUAL_HEX(0x00000000, bitstream[3]);
-
-	/* small buffer error bitstream can not hold more data*/
-	cmp_size = encode_value(data, model, cmp_size, &setup);
-	TEST_ASSERT_EQUAL_UINT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(cmp_size));
-
-	/* reset bitstream */
-	bitstream[0] = 0;
-	bitstream[1] = 0;
-	bitstream[2] = 0;
-	bitstream[3] = 0;
-	cmp_size = 0;
-
-	/* test 31 bit input */
-	setup.encoder_par1 = 31;
+	/* round = 1 with 31 bit input */
 	setup.max_data_bits = 31;
-	setup.lossy_par = 0;
-
-	data = 0; model = 0;
-	cmp_size = encode_value(data, model, cmp_size, &setup);
-	TEST_ASSERT_EQUAL_UINT(31, cmp_size);
-	TEST_ASSERT_EQUAL_HEX(0, bitstream[0]);
+	data = UINT32_MAX; model = UINT32_MAX;
+	cmp_size = encode_value(data, model, &setup, ENC_MULTI | ENC_RICE);
+	bit_flush_encoder(&enc);
+	TEST_ASSERT_EQUAL_UINT(12, cmp_size);
+	TEST_ASSERT_EQUAL_HEX(0x6FC00000, be32_to_cpu(bitstream[0]));
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[1]);
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[2]);
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[3]);
 
-	data = 0x7FFFFFFF; model = 0;
-	cmp_size = encode_value(data, model, cmp_size, &setup);
-	TEST_ASSERT_EQUAL_UINT(62, cmp_size);
-	TEST_ASSERT_EQUAL_HEX(0x00000001, be32_to_cpu(bitstream[0]));
-	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFC, be32_to_cpu(bitstream[1]));
+	/* test zero escape symbol mechanism */
+	data = 0; model = 0;
+	cmp_size = encode_value(data, model, &setup, ENC_RICE);
+	bit_flush_encoder(&enc);
+	TEST_ASSERT_EQUAL_UINT(14, cmp_size);
+	TEST_ASSERT_EQUAL_HEX(0x6FC80000, be32_to_cpu(bitstream[0]));
+	TEST_ASSERT_EQUAL_HEX(0, bitstream[1]);
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[2]);
 	TEST_ASSERT_EQUAL_HEX(0, bitstream[3]);
 
-	/* round = 1 */
-	setup.lossy_par = 1;
-	data = UINT32_MAX; model = UINT32_MAX;
-	cmp_size = encode_value(data, model, cmp_size, &setup);
-	TEST_ASSERT_EQUAL_UINT(93, cmp_size);
-	TEST_ASSERT_EQUAL_HEX(0x00000001, be32_to_cpu(bitstream[0]));
-	TEST_ASSERT_EQUAL_HEX(0xFFFFFFFF, be32_to_cpu(bitstream[1]));
-	TEST_ASSERT_EQUAL_HEX(0xFFFFFFF8, be32_to_cpu(bitstream[2]));
-	TEST_ASSERT_EQUAL_HEX(0, bitstream[3]);
-
 	/* data are bigger than max_data_bits */
 	setup.lossy_par = 0;
 	data = UINT32_MAX; model = 0;
-	cmp_size = encode_value(data, model, cmp_size, &setup);
+	cmp_size = encode_value(data, model, &setup, ENC_MULTI | ENC_RICE);
 	TEST_ASSERT_EQUAL_UINT(CMP_ERROR_DATA_VALUE_TOO_LARGE, cmp_get_error_code(cmp_size));
 
 	/* model are bigger than max_data_bits */
 	setup.lossy_par = 0;
-	cmp_size = 93;
 	data = 0; model = UINT32_MAX;
-	cmp_size = encode_value(data, model, cmp_size, &setup);
+	cmp_size = encode_value(data, model, &setup, ENC_MULTI | ENC_RICE);
 	TEST_ASSERT_EQUAL_UINT(CMP_ERROR_DATA_VALUE_TOO_LARGE, cmp_get_error_code(cmp_size));
+
+	/* small buffer error bitstream can not hold more data */
+	bit_init_encoder(&enc, bitstream, 128, 126);
+	data = 2; model = 1;
+	cmp_size = encode_value(data, model, &setup, ENC_MULTI | ENC_RICE);
+	TEST_ASSERT_EQUAL_UINT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(cmp_size));
+	TEST_ASSERT_EQUAL_HEX(0x6FC80000, be32_to_cpu(bitstream[0]));
+	TEST_ASSERT_EQUAL_HEX(0, bitstream[3]);
+}
+
+
+/**
+ * @test imagette_residuals
+ */
+
+void test_imagette_residuals(void)
+{
+	uint16_t data[IMA_BLOCK_SIZE+1], model[IMA_BLOCK_SIZE+1];
+	uint16_t up_model[IMA_BLOCK_SIZE+1];
+	uint32_t residual[IMA_BLOCK_SIZE+1];
+	uint8_t unaligned_buf[2*IMA_BLOCK_SIZE+1];
+	size_t const n = ARRAY_SIZE(data);
+	uint32_t too_large;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		data[i] = (uint16_t)cmp_rand_nbits(15);
+		model[i] = (uint16_t)cmp_rand_nbits(15);
+	}
+
+	too_large = imagette_residuals(residual, NULL, data, model, n, 0, 16, 0);
+	TEST_ASSERT_FALSE(too_large);
+	for (i = 0; i < n; i++)
+		TEST_ASSERT_EQUAL_HEX(map_to_pos((uint32_t)data[i] - model[i], 16), residual[i]);
+
+	/* test rounding */
+	too_large = imagette_residuals(residual, NULL, data, model, n, 2, 13, 0);
+	TEST_ASSERT_FALSE(too_large);
+	for (i = 0; i < n; i++)
+		TEST_ASSERT_EQUAL_HEX(map_to_pos(round_fwd(data[i], 2) - round_fwd(model[i], 2), 13),
+				      residual[i]);
+
+	/* test the model update */
+	too_large = imagette_residuals(residual, up_model, data, model, n, 1, 16, 11);
+	TEST_ASSERT_FALSE(too_large);
+	for (i = 0; i < n; i++)
+		TEST_ASSERT_EQUAL_HEX(cmp_up_model16(data[i], model[i], 11, 1), up_model[i]);
+
+	/* test a full block of unaligned data */
+	memcpy(unaligned_buf+1, data, 2*IMA_BLOCK_SIZE);
+	too_large = imagette_residuals(residual, up_model, (uint16_t *)(unaligned_buf+1),
+				       model, IMA_BLOCK_SIZE, 0, 16, 5);
+	TEST_ASSERT_FALSE(too_large);
+	for (i = 0; i < IMA_BLOCK_SIZE; i++) {
+		TEST_ASSERT_EQUAL_HEX(map_to_pos((uint32_t)data[i] - model[i], 16), residual[i]);
+		TEST_ASSERT_EQUAL_HEX(cmp_up_model16(data[i], model[i], 5, 0), up_model[i]);
+	}
+
+	/* data are bigger than max_data_bits */
+	data[IMA_BLOCK_SIZE] = 0x8000;
+	too_large = imagette_residuals(residual, NULL, data, model, n, 0, 15, 0);
+	TEST_ASSERT_TRUE(too_large);
+	/* the last sample is not processed */
+	too_large = imagette_residuals(residual, NULL, data, model, n-1, 0, 15, 0);
+	TEST_ASSERT_FALSE(too_large);
+
+	/* model are bigger than max_data_bits */
+	model[0] = 0xFFFF;
+	too_large = imagette_residuals(residual, NULL, data, model, 1, 0, 15, 0);
+	TEST_ASSERT_TRUE(too_large);
+	too_large = imagette_residuals(residual, NULL, data, model, 1, 1, 15, 0);
+	TEST_ASSERT_FALSE(too_large);
+}
+
+
+/**
+ * @test column_residuals
+ * @test diff_model_columns
+ */
+
+void test_columns(void)
+{
+	struct column col[2];
+	struct encoder_setup setup;
+	uint32_t too_large;
+	size_t j;
+
+	memset(&setup, 0, sizeof(setup));
+	setup.max_data_bits = 32;
+	init_column(&col[0], &setup);
+	init_column(&col[1], &setup);
+
+	/* 1d-differencing model over two blocks */
+	for (j = 0; j < COL_BLOCK_SIZE; j++) {
+		col[0].data[j] = (uint32_t)j;
+		col[1].data[j] = 0xFFFFFFFF - (uint32_t)j;
+	}
+	diff_model_columns(col, ARRAY_SIZE(col), COL_BLOCK_SIZE);
+	TEST_ASSERT_EQUAL_HEX32(0, col[0].model[0]);
+	TEST_ASSERT_EQUAL_HEX32(0, col[1].model[0]);
+	for (j = 1; j < COL_BLOCK_SIZE; j++) {
+		TEST_ASSERT_EQUAL_HEX32(col[0].data[j-1], col[0].model[j]);
+		TEST_ASSERT_EQUAL_HEX32(col[1].data[j-1], col[1].model[j]);
+	}
+	col[0].data[0] = 42;
+	diff_model_columns(col, ARRAY_SIZE(col), 1);
+	TEST_ASSERT_EQUAL_HEX32(COL_BLOCK_SIZE-1, col[0].model[0]);
+	TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF - (COL_BLOCK_SIZE-1), col[1].model[0]);
+	TEST_ASSERT_EQUAL_HEX32(42, col[0].last);
+
+	/* residuals */
+	for (j = 0; j < COL_BLOCK_SIZE; j++) {
+		col[0].data[j] = cmp_rand32();
+		col[0].model[j] = cmp_rand32();
+	}
+	too_large = column_residuals(col[0].residual, col[0].data, col[0].model,
+				     COL_BLOCK_SIZE, 0, 32);
+	TEST_ASSERT_FALSE(too_large);
+	for (j = 0; j < COL_BLOCK_SIZE; j++)
+		TEST_ASSERT_EQUAL_HEX32(map_to_pos(col[0].data[j] - col[0].model[j], 32),
+					col[0].residual[j]);
+
+	too_large = column_residuals(col[0].residual, col[0].data, col[0].model,
+				     COL_BLOCK_SIZE, 3, 29);
+	TEST_ASSERT_FALSE(too_large);
+	for (j = 0; j < COL_BLOCK_SIZE; j++)
+		TEST_ASSERT_EQUAL_HEX32(map_to_pos(round_fwd(col[0].data[j], 3) -
+						   round_fwd(col[0].model[j], 3), 29),
+					col[0].residual[j]);
+
+	col[0].data[COL_BLOCK_SIZE-1] = 0x10000;
+	col[0].model[COL_BLOCK_SIZE-1] = 0;
+	for (j = 0; j < COL_BLOCK_SIZE-1; j++) {
+		col[0].data[j] &= 0xFFFF;
+		col[0].model[j] &= 0xFFFF;
+	}
+	too_large = column_residuals(col[0].residual, col[0].data, col[0].model,
+				     COL_BLOCK_SIZE, 0, 16);
+	TEST_ASSERT_TRUE(too_large);
+	too_large = column_residuals(col[0].residual, col[0].data, col[0].model,
+				     COL_BLOCK_SIZE-1, 0, 16);
+	TEST_ASSERT_FALSE(too_large);
+}
+
+
+/**
+ * @test cmp_up_model32
+ * @test cmp_up_model16_batch
+ * @test cmp_up_model32_batch
+ */
+
+void test_cmp_up_model_batch(void)
+{
+	uint16_t data16[67], model16[67], up_model16[67];
+	uint32_t data32[67], model32[67], up_model32[67];
+	size_t const n = ARRAY_SIZE(data16);
+	unsigned int model_value, round;
+	size_t i;
+
+	/* the 32-bit update has to be the same as a 64-bit calculation */
+	for (i = 0; i < 10000; i++) {
+		uint32_t data = cmp_rand32();
+		uint32_t model = i < 4 ? 0xFFFFFFFF - (uint32_t)i : cmp_rand32();
+		uint64_t exp;
+
+		model_value = cmp_rand_between(0, MAX_MODEL_VALUE);
+		round = cmp_rand_between(0, 3);
+		exp = ((uint64_t)round_inv(round_fwd(data, round), round) * (MAX_MODEL_VALUE - model_value)
+		       + (uint64_t)model * model_value) / MAX_MODEL_VALUE;
+		TEST_ASSERT_EQUAL_HEX32((uint32_t)exp, cmp_up_model32(data, model, model_value, round));
+	}
+
+	for (model_value = 0; model_value <= MAX_MODEL_VALUE; model_value++) {
+		round = model_value % 3;
+		for (i = 0; i < n; i++) {
+			data16[i] = (uint16_t)cmp_rand32();
+			model16[i] = (uint16_t)cmp_rand32();
+			data32[i] = cmp_rand32();
+			model32[i] = cmp_rand32();
+		}
+
+		cmp_up_model16_batch(up_model16, data16, model16, n, model_value, round);
+		cmp_up_model32_batch(up_model32, data32, model32, n, model_value, round);
+		for (i = 0; i < n; i++) {
+			TEST_ASSERT_EQUAL_HEX16(cmp_up_model16(data16[i], model16[i], model_value, round),
+						up_model16[i]);
+			TEST_ASSERT_EQUAL_HEX32(cmp_up_model32(data32[i], model32[i], model_value, round),
+						up_model32[i]);
+		}
+
+		/* in-place update */
+		cmp_up_model16_batch(model16, data16, model16, n, model_value, round);
+		cmp_up_model32_batch(model32, data32, model32, n, model_value, round);
+		TEST_ASSERT_EQUAL_HEX16_ARRAY(up_model16, model16, n);
+		TEST_ASSERT_EQUAL_HEX32_ARRAY(up_model32, model32, n);
+	}
 }
 
 
@@ -1269,6 +1587,7 @@ void test_compress_imagette_model(void)
 	uint32_t golomb_par = 3;
 	uint32_t spill = 8;
 	uint32_t cmp_size;
+	uint32_t i;
 	int error;
 
 	error = rdcu_cfg_create(&rcfg, CMP_MODE_MODEL_MULTI, model_value, CMP_LOSSLESS);
@@ -1297,6 +1616,15 @@ void test_compress_imagette_model(void)
 	TEST_ASSERT_EQUAL_HEX(0xFFFF, model_up[5]);
 	TEST_ASSERT_EQUAL_HEX(0x7FFF, model_up[6]);
 
+	/* only the size is calculated; no updated model is created */
+	memset(model_up, 0, sizeof(model_up));
+	rcfg.icu_output_buf = NULL;
+	cmp_size = compress_like_rdcu(&rcfg, NULL);
+	TEST_ASSERT_EQUAL_INT(76, cmp_size);
+	for (i = 0; i < samples; i++)
+		TEST_ASSERT_EQUAL_HEX(0, model_up[i]);
+	rcfg.icu_output_buf = output_buf;
+
 
 	/* error case: model mode without model data */
 	rcfg.model_buf = NULL; /* this is the error */
@@ -1306,6 +1634,81 @@ void test_compress_imagette_model(void)
 }
 
 
+/**
+ * @test compress_like_rdcu
+ */
+
+void test_compress_like_rdcu_adaptive_sizes(void)
+{
+	enum { SAMPLES = 300 };
+	uint16_t data[SAMPLES], model[SAMPLES], model_up[SAMPLES];
+	uint32_t output_buf[SAMPLES];
+	struct rdcu_cfg rcfg;
+	struct cmp_info info;
+	uint32_t cmp_size, ap1_size, ap2_size;
+	unsigned int i, cmp_mode;
+
+	for (i = 0; i < SAMPLES; i++) {
+		data[i] = (uint16_t)(1000 + (i * 37) % 23 + (i % 50 == 0 ? 9000 : 0));
+		model[i] = (uint16_t)(1000 + (i * 11) % 19);
+	}
+
+	for (cmp_mode = CMP_MODE_MODEL_ZERO; cmp_mode <= CMP_MODE_DIFF_MULTI; cmp_mode++) {
+		memset(&rcfg, 0, sizeof(rcfg));
+		rcfg.cmp_mode = cmp_mode;
+		rcfg.model_value = 8;
+		rcfg.input_buf = data;
+		rcfg.model_buf = model;
+		rcfg.icu_new_model_buf = model_up;
+		rcfg.samples = SAMPLES;
+		rcfg.buffer_length = SAMPLES * 2;
+
+		/* sizes of the adaptive parameters compressed as primary parameters */
+		rcfg.golomb_par = 4;
+		rcfg.spill = 40;
+		ap1_size = compress_like_rdcu(&rcfg, NULL);
+		TEST_ASSERT_FALSE(cmp_is_error(ap1_size));
+		rcfg.golomb_par = 7;
+		rcfg.spill = 22;
+		ap2_size = compress_like_rdcu(&rcfg, NULL);
+		TEST_ASSERT_FALSE(cmp_is_error(ap2_size));
+
+		/* the adaptive sizes are calculated with and without compressed data */
+		rcfg.golomb_par = 3;
+		rcfg.spill = 30;
+		rcfg.ap1_golomb_par = 4;
+		rcfg.ap1_spill = 40;
+		rcfg.ap2_golomb_par = 7;
+		rcfg.ap2_spill = 22;
+		cmp_size = compress_like_rdcu(&rcfg, &info);
+		TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+		TEST_ASSERT_EQUAL_INT(cmp_size, info.cmp_size);
+		TEST_ASSERT_EQUAL_INT(ap1_size, info.ap1_cmp_size);
+		TEST_ASSERT_EQUAL_INT(ap2_size, info.ap2_cmp_size);
+
+		rcfg.icu_output_buf = output_buf;
+		TEST_ASSERT_EQUAL_INT(cmp_size, compress_like_rdcu(&rcfg, &info));
+		TEST_ASSERT_EQUAL_INT(cmp_size, info.cmp_size);
+		TEST_ASSERT_EQUAL_INT(ap1_size, info.ap1_cmp_size);
+		TEST_ASSERT_EQUAL_INT(ap2_size, info.ap2_cmp_size);
+
+		/* an adaptive parameter of 0 is not used */
+		rcfg.ap2_golomb_par = 0;
+		TEST_ASSERT_EQUAL_INT(cmp_size, compress_like_rdcu(&rcfg, &info));
+		TEST_ASSERT_EQUAL_INT(ap1_size, info.ap1_cmp_size);
+		TEST_ASSERT_EQUAL_INT(0, info.ap2_cmp_size);
+
+		/* error case: the adaptive sizes are reset if the compression fails */
+		rcfg.ap2_golomb_par = 7;
+		rcfg.buffer_length = 2;
+		cmp_size = compress_like_rdcu(&rcfg, &info);
+		TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(cmp_size));
+		TEST_ASSERT_EQUAL_INT(0, info.ap1_cmp_size);
+		TEST_ASSERT_EQUAL_INT(0, info.ap2_cmp_size);
+	}
+}
+
+
 /**
  * @test compress_imagette
  */
@@ -1503,48 +1906,37 @@ void test_compress_imagette_error_cases(void)
 
 void test_pad_bitstream(void)
 {
-	struct cmp_cfg cfg = {0};
+	struct bit_encoder enc;
 	uint32_t cmp_size;
 	uint32_t cmp_size_return;
 	uint32_t cmp_data[3];
 	const int MAX_BIT_LEN = 96;
 
 	memset(cmp_data, 0xFF, sizeof(cmp_data));
-	cfg.dst = cmp_data;
-	cfg.data_type = DATA_TYPE_IMAGETTE; /* 16 bit samples */
-	cfg.stream_size = sizeof(cmp_data); /* 6 * 16 bit samples -> 3 * 32 bit */
-
-	/* test negative cmp_size */
-	cmp_size = -1U;
-	cmp_size_return = pad_bitstream(&cfg, cmp_size);
-	TEST_ASSERT_EQUAL_UINT32(-1U, cmp_size_return);
-	cmp_size = -3U;
-	cmp_size_return = pad_bitstream(&cfg, cmp_size);
-	TEST_ASSERT_EQUAL_UINT32(-3U, cmp_size_return);
-
-	/* test RAW_MODE */
-	cfg.cmp_mode = CMP_MODE_RAW;
-	cmp_size = MAX_BIT_LEN;
-	cmp_size_return = pad_bitstream(&cfg, cmp_size);
-	TEST_ASSERT_EQUAL_INT(MAX_BIT_LEN, cmp_size_return);
+
+	/* test without a bitstream buffer */
+	bit_init_encoder(&enc, NULL, 0, 0);
+	cmp_size = bit_write_bits32(&enc, 0, 1);
+	cmp_size_return = pad_bitstream(&enc);
+	TEST_ASSERT_EQUAL_INT(1, cmp_size);
+	TEST_ASSERT_EQUAL_INT(cmp_size, cmp_size_return);
 	TEST_ASSERT_EQUAL_INT(cmp_data[0], 0xFFFFFFFF);
 	TEST_ASSERT_EQUAL_INT(cmp_data[1], 0xFFFFFFFF);
 	TEST_ASSERT_EQUAL_INT(cmp_data[2], 0xFFFFFFFF);
 
 	/* test Normal operation */
-	cfg.cmp_mode = CMP_MODE_MODEL_MULTI;
-	cmp_size = 0;
+	bit_init_encoder(&enc, cmp_data, MAX_BIT_LEN, 0);
 	/* set the first 32 bits zero no change should occur */
-	cmp_size = put_n_bits32(0, 32, cmp_size, cfg.dst, MAX_BIT_LEN);
-	cmp_size_return = pad_bitstream(&cfg, cmp_size);
+	cmp_size = bit_write_bits32(&enc, 0, 32);
+	cmp_size_return = pad_bitstream(&enc);
 	TEST_ASSERT_EQUAL_INT(cmp_size, cmp_size_return);
 	TEST_ASSERT_EQUAL_INT(cmp_data[0], 0);
 	TEST_ASSERT_EQUAL_INT(cmp_data[1], 0xFFFFFFFF);
 	TEST_ASSERT_EQUAL_INT(cmp_data[2], 0xFFFFFFFF);
 
 	/* set the first 33 bits zero; and checks the padding  */
-	cmp_size = put_n_bits32(0, 1, cmp_size, cfg.dst, MAX_BIT_LEN);
-	cmp_size_return = pad_bitstream(&cfg, cmp_size);
+	cmp_size = bit_write_bits32(&enc, 0, 1);
+	cmp_size_return = pad_bitstream(&enc);
 	TEST_ASSERT_EQUAL_INT(cmp_size, cmp_size_return);
 	TEST_ASSERT_EQUAL_INT(cmp_data[0], 0);
 	TEST_ASSERT_EQUAL_INT(cmp_data[1], 0);
@@ -1552,9 +1944,9 @@ void test_pad_bitstream(void)
 
 	/* set the first 63 bits zero; and checks the padding  */
 	cmp_data[1] = 0xFFFFFFFF;
-	cmp_size = 32;
-	cmp_size = put_n_bits32(0, 31, cmp_size, cfg.dst, MAX_BIT_LEN);
-	cmp_size_return = pad_bitstream(&cfg, cmp_size);
+	bit_init_encoder(&enc, cmp_data, MAX_BIT_LEN, 32);
+	cmp_size = bit_write_bits32(&enc, 0, 31);
+	cmp_size_return = pad_bitstream(&enc);
 	TEST_ASSERT_EQUAL_INT(cmp_size, cmp_size_return);
 	TEST_ASSERT_EQUAL_INT(cmp_data[0], 0);
 	TEST_ASSERT_EQUAL_INT(cmp_data[1], 0);
@@ -1562,10 +1954,10 @@ void test_pad_bitstream(void)
 
 	/* error case the rest of the compressed data are to small for a 32 bit
 	 * access  */
-	cfg.stream_size -= 1;
-	cmp_size = 64;
-	cmp_size = put_n_bits32(0, 1, cmp_size, cfg.dst, MAX_BIT_LEN);
-	cmp_size_return = pad_bitstream(&cfg, cmp_size);
+	bit_init_encoder(&enc, cmp_data, 65, 64);
+	cmp_size = bit_write_bits32(&enc, 0, 1);
+	TEST_ASSERT_EQUAL_INT(65, cmp_size);
+	cmp_size_return = pad_bitstream(&enc);
 	TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(cmp_size_return));
 }
 
@@ -1631,6 +2023,200 @@ void test_compress_data_internal_error_cases(void)
 }
 
 
+/**
+ * @brief the compression of incompressible data stops as soon as the data can
+ *	no longer fit into the bitstream buffer
+ *
+ * @test min_sample_bits
+ * @test stop_if_stream_cannot_fit
+ */
+
+void test_stop_if_stream_cannot_fit(void)
+{
+	enum {SAMPLES = 1024};
+	uint16_t data[SAMPLES];
+	struct offset offset_data[SAMPLES];
+	uint32_t dst[SAMPLES * sizeof(struct offset) / 4];
+	struct encoder_setup setup_a, setup_b;
+	const struct encoder_setup *setups[2];
+	struct bit_encoder enc;
+	struct cmp_cfg cfg;
+	uint32_t ret;
+	size_t i;
+
+	/* no minimum if a code word can be invalid */
+	memset(&setup_a, 0, sizeof(setup_a));
+	memset(&setup_b, 0, sizeof(setup_b));
+	setup_a.min_cw_len = 3;
+	setup_a.max_cw_len = 20;
+	setup_b.min_cw_len = 5;
+	setup_b.max_cw_len = 32;
+	setups[0] = &setup_a;
+	setups[1] = &setup_b;
+	TEST_ASSERT_EQUAL_UINT32(8, min_sample_bits(setups, 2));
+	setup_b.max_cw_len = 33;
+	TEST_ASSERT_EQUAL_UINT32(0, min_sample_bits(setups, 2));
+
+	/* the lower bound of the bitstream length is checked against the buffer */
+	bit_init_encoder(&enc, dst, 100, 10);
+	TEST_ASSERT_EQUAL_UINT32(10, stop_if_stream_cannot_fit(&enc, 10, 9));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER,
+			      cmp_get_error_code(stop_if_stream_cannot_fit(&enc, 10, 10)));
+	bit_init_encoder(&enc, NULL, 100, 10);
+	TEST_ASSERT_EQUAL_UINT32(10, stop_if_stream_cannot_fit(&enc, 10, 10));
+
+	/* noisy imagette data with a bitstream one byte smaller than the data */
+	for (i = 0; i < SAMPLES; i++)
+		data[i] = (uint16_t)cmp_rand32();
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.data_type = DATA_TYPE_IMAGETTE;
+	cfg.cmp_mode = CMP_MODE_DIFF_MULTI;
+	cfg.cmp_par_imagette = 16;
+	cfg.spill_imagette = 16;
+	cfg.src = data;
+	cfg.samples = SAMPLES;
+	cfg.dst = dst;
+	cfg.stream_size = sizeof(data) - 1;
+	bit_init_encoder(&enc, dst, cmp_stream_size_to_bits(cfg.stream_size), 0);
+	ret = compress_imagette(&cfg, &enc, select_encoder_variant(&cfg));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(ret));
+	/* the compression stopped long before the end of the buffer */
+	TEST_ASSERT_TRUE(enc.stream_len + SAMPLES < enc.max_stream_len);
+	/* the data are really incompressible */
+	bit_init_encoder(&enc, NULL, 0, 0);
+	ret = compress_imagette(&cfg, &enc, select_encoder_variant(&cfg) | ENC_SIZE_ONLY);
+	TEST_ASSERT_FALSE(cmp_is_error(ret));
+	TEST_ASSERT_TRUE(ret > cmp_stream_size_to_bits(cfg.stream_size));
+
+	/* the same for multi-field data */
+	for (i = 0; i < SAMPLES; i++) {
+		offset_data[i].mean = cmp_rand32();
+		offset_data[i].variance = cmp_rand32();
+	}
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.data_type = DATA_TYPE_OFFSET;
+	cfg.cmp_mode = CMP_MODE_DIFF_ZERO;
+	cfg.cmp_par_offset_mean = 1U << 12;
+	cfg.spill_offset_mean = 16;
+	cfg.cmp_par_offset_variance = 1U << 12;
+	cfg.spill_offset_variance = 16;
+	cfg.src = offset_data;
+	cfg.samples = SAMPLES;
+	cfg.dst = dst;
+	cfg.stream_size = sizeof(offset_data) - 1;
+	bit_init_encoder(&enc, dst, cmp_stream_size_to_bits(cfg.stream_size), 0);
+	ret = compress_offset(&cfg, &enc, select_encoder_variant(&cfg));
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_SMALL_BUFFER, cmp_get_error_code(ret));
+	TEST_ASSERT_TRUE(enc.stream_len + SAMPLES < enc.max_stream_len);
+}
+
+
+/**
+ * @brief a collection which is only noisy at the beginning is compressed and
+ *	not stored uncompressed
+ *
+ * @test compress_chunk
+ */
+
+void test_compress_chunk_noisy_start(void)
+{
+	enum {	SAMPLES = 1024,
+		DATA_SIZE = SAMPLES * sizeof(uint16_t),
+		CHUNK_SIZE = COLLECTION_HDR_SIZE + DATA_SIZE
+	};
+	uint8_t chunk[CHUNK_SIZE];
+	struct collection_hdr *col = (struct collection_hdr *)chunk;
+	uint16_t *data = (uint16_t *)col->entry;
+	uint32_t dst[ROUND_UP_TO_4(COMPRESS_CHUNK_BOUND(CHUNK_SIZE, 1))/4];
+	struct cmp_par cmp_par;
+	uint32_t cmp_size, cmp_size_only;
+	uint8_t *cmp_col;
+	size_t i;
+
+	memset(chunk, 0, sizeof(chunk));
+	TEST_ASSERT_FALSE(cmp_col_set_subservice(col, SST_NCxx_S_SCIENCE_IMAGETTE));
+	TEST_ASSERT_FALSE(cmp_col_set_data_length(col, DATA_SIZE));
+	for (i = 0; i < 32; i++)
+		data[i] = (uint16_t)cmp_rand32();
+
+	memset(&cmp_par, 0, sizeof(cmp_par));
+	cmp_par.cmp_mode = CMP_MODE_DIFF_MULTI;
+	cmp_par.nc_imagette = 4;
+
+	cmp_size_only = compress_chunk(chunk, CHUNK_SIZE, NULL, NULL, NULL, 0, &cmp_par);
+	TEST_ASSERT_FALSE(cmp_is_error(cmp_size_only));
+	cmp_size = compress_chunk(chunk, CHUNK_SIZE, NULL, NULL, dst, sizeof(dst), &cmp_par);
+	TEST_ASSERT_EQUAL_UINT32(cmp_size_only, cmp_size);
+	TEST_ASSERT(cmp_size < NON_IMAGETTE_HEADER_SIZE + CHUNK_SIZE / 2);
+
+	/* the compressed data size is not the raw data size */
+	cmp_col = cmp_ent_get_data_buf((struct cmp_entity *)dst);
+	TEST_ASSERT_NOT_EQUAL(DATA_SIZE, cmp_col[0] << 8 | cmp_col[1]);
+}
+
+
+/**
+ * @brief the compression parameters of a batch are checked once when the
+ *	configuration of the chunk type is prepared and not for every chunk
+ *
+ * @test prepare_batch_cfgs
+ * @test compress_batch_chunk
+ */
+
+void test_compress_batch_pars_checked_once(void)
+{
+	enum {	SAMPLES = 16,
+		CHUNK_SIZE = COLLECTION_HDR_SIZE + SAMPLES * sizeof(uint16_t)
+	};
+	uint8_t chunk[CHUNK_SIZE];
+	const void *chunks[1];
+	uint32_t chunk_sizes[1], cmp_sizes[1];
+	struct cmp_chunk_batch batch;
+	struct cw_table_cache cw_cache;
+	struct cmp_ctx ctx;
+	struct cmp_par cmp_par;
+	struct cmp_cfg *cfg;
+	uint32_t cmp_size;
+
+	memset(chunk, 0, sizeof(chunk));
+	TEST_ASSERT_FALSE(cmp_col_set_subservice((struct collection_hdr *)chunk,
+						 SST_NCxx_S_SCIENCE_IMAGETTE));
+	TEST_ASSERT_FALSE(cmp_col_set_data_length((struct collection_hdr *)chunk,
+						  SAMPLES * sizeof(uint16_t)));
+	chunks[0] = chunk;
+	chunk_sizes[0] = CHUNK_SIZE;
+	memset(&cmp_par, 0, sizeof(cmp_par));
+	cmp_par.cmp_mode = CMP_MODE_DIFF_ZERO;
+	cmp_par.nc_imagette = 4;
+	cmp_ctx_init(&ctx, NULL, 42);
+
+	memset(&batch, 0, sizeof(batch));
+	batch.ctx = &ctx;
+	batch.chunks = chunks;
+	batch.chunk_sizes = chunk_sizes;
+	batch.cmp_sizes = cmp_sizes;
+	prepare_batch_cfgs(&batch, 1, &cmp_par);
+	cfg = &batch.type_cfg[CHUNK_TYPE_NCAM_IMAGETTE];
+	TEST_ASSERT_EQUAL_HEX32(1U << DATA_TYPE_IMAGETTE, cfg->checked_data_types);
+
+	/* an invalid parameter is not noticed, because it is not checked again */
+	cfg->round = MAX_ICU_ROUND + 1;
+	cw_cache_init(&cw_cache);
+	cmp_size = compress_batch_chunk(&batch, 0, &cw_cache);
+	TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+
+	/* an unchecked configuration is checked for the chunk */
+	cfg->checked_data_types = 0;
+	cmp_size = compress_batch_chunk(&batch, 0, &cw_cache);
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_PAR_GENERIC, cmp_get_error_code(cmp_size));
+
+	/* invalid parameters are not marked as checked */
+	cmp_par.nc_imagette = 0;
+	prepare_batch_cfgs(&batch, 1, &cmp_par);
+	TEST_ASSERT_EQUAL_HEX32(0, cfg->checked_data_types);
+}
+
+
 /**
  * @test compress_chunk
  */
@@ -1968,6 +2554,57 @@ void test_collection_zero_data_length(void)
 }
 
 
+/**
+ * @test setup_collection_cfg
+ */
+
+void test_setup_collection_cfg(void)
+{
+	enum {	DATA_SIZE = 2*sizeof(struct offset),
+		COL_SIZE = COLLECTION_HDR_SIZE + DATA_SIZE
+	};
+	uint8_t col[COL_SIZE] = {0};
+	uint8_t model[COL_SIZE] = {0};
+	uint32_t dst[COL_SIZE];
+	struct collection_hdr *col_hdr = (struct collection_hdr *)col;
+	struct cmp_par cmp_par = {0};
+	struct cmp_cfg cfg;
+	uint32_t return_val;
+
+	TEST_ASSERT_FALSE(cmp_col_set_subservice(col_hdr, SST_NCxx_S_SCIENCE_OFFSET));
+	TEST_ASSERT_FALSE(cmp_col_set_data_length(col_hdr, DATA_SIZE));
+	cmp_par.cmp_mode = CMP_MODE_MODEL_MULTI;
+	cmp_par.model_value = 8;
+	cmp_par.nc_offset_mean = 1;
+	cmp_par.nc_offset_variance = 2;
+	init_cmp_cfg_from_cmp_par(col_hdr, &cmp_par, &cfg);
+	TEST_ASSERT_EQUAL_HEX32(0, cfg.checked_data_types);
+
+	/* the parameters are checked at the first collection of a data type */
+	return_val = setup_collection_cfg(col, model, NULL, dst, sizeof(dst), &cfg);
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_NO_ERROR, cmp_get_error_code(return_val));
+	TEST_ASSERT_EQUAL_HEX32(1U << DATA_TYPE_OFFSET, cfg.checked_data_types);
+
+	/* ... and are not checked again for the following collections */
+	cfg.cmp_par_offset_mean = 0;
+	return_val = setup_collection_cfg(col, model, NULL, dst, sizeof(dst), &cfg);
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_NO_ERROR, cmp_get_error_code(return_val));
+
+	/* the buffers are checked for every collection */
+	return_val = setup_collection_cfg(col, col, NULL, dst, sizeof(dst), &cfg);
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_PAR_BUFFERS, cmp_get_error_code(return_val));
+	return_val = setup_collection_cfg(col, model, NULL, (uint32_t *)col, sizeof(col), &cfg);
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_PAR_BUFFERS, cmp_get_error_code(return_val));
+
+	/* error case: the parameters of a new data type are invalid */
+	TEST_ASSERT_FALSE(cmp_col_set_subservice(col_hdr, SST_NCxx_S_SCIENCE_BACKGROUND));
+	TEST_ASSERT_FALSE(cmp_col_set_data_length(col_hdr, 0));
+	return_val = setup_collection_cfg(col, model, NULL, dst, sizeof(dst), &cfg);
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_PAR_SPECIFIC, cmp_get_error_code(return_val));
+	TEST_ASSERT_EQUAL_HEX32(1U << DATA_TYPE_OFFSET, cfg.checked_data_types);
+}
+
+
 static int n_timestamp_fail; /* fail after n calls */
 static uint64_t get_timstamp_test(void)
 {
@@ -2215,15 +2852,115 @@ void test_compress_chunk_error_cases(void)
 		uint64_t start_timestamp = 123;
 		uint32_t cmp_ent_size_byte = sizeof(entity);
 
+		struct cmp_ctx ctx;
+
+		cmp_ctx_init(&ctx, NULL, 23);
 		cfg.cmp_mode = CMP_MODE_DIFF_ZERO;
 		cfg.cmp_par_1 = UINT16_MAX + 1; /* to big for entity header */
-		ent_hdr_size = cmp_ent_build_chunk_header(entity, chunk_size, &cfg,
+		ent_hdr_size = cmp_ent_build_chunk_header(entity, chunk_size, &ctx, &cfg,
 							  start_timestamp, cmp_ent_size_byte);
 		TEST_ASSERT_EQUAL_INT(CMP_ERROR_ENTITY_HEADER, cmp_get_error_code(ent_hdr_size));
 	}
 }
 
 
+static uint64_t get_timestamp_ctx_1(void)
+{
+	return 0x111111111111ULL;
+}
+
+
+static uint64_t get_timestamp_ctx_2(void)
+{
+	return 0x222222222222ULL;
+}
+
+
+static void run_jobs_serial(void (*job)(void *job_arg, uint32_t i),
+			    void *job_arg, uint32_t n_jobs, void *pool UNUSED)
+{
+	uint32_t i;
+
+	for (i = 0; i < n_jobs; i++)
+		job(job_arg, i);
+}
+
+
+/**
+ * @test cmp_ctx_init
+ * @test cmp_ctx_set_parallel
+ * @test compress_chunk_ctx
+ */
+
+void test_compress_chunk_ctx(void)
+{
+	enum {	DATA_SIZE = 4*sizeof(struct s_fx),
+		CHUNK_SIZE = COLLECTION_HDR_SIZE + DATA_SIZE
+	};
+	uint8_t chunk[CHUNK_SIZE] = {0};
+	uint32_t dst1[COMPRESS_CHUNK_BOUND(CHUNK_SIZE, 1)/sizeof(uint32_t)] = {0};
+	uint32_t dst2[COMPRESS_CHUNK_BOUND(CHUNK_SIZE, 1)/sizeof(uint32_t)] = {0};
+	uint64_t work_buf[64];
+	struct cmp_ctx ctx1, ctx2;
+	struct cmp_par cmp_par = {0};
+	struct cmp_entity *ent1 = (struct cmp_entity *)dst1;
+	struct cmp_entity *ent2 = (struct cmp_entity *)dst2;
+	uint32_t size1, size2;
+
+	TEST_ASSERT_FALSE(cmp_col_set_subservice((struct collection_hdr *)chunk,
+						 SST_NCxx_S_SCIENCE_S_FX));
+	TEST_ASSERT_FALSE(cmp_col_set_data_length((struct collection_hdr *)chunk, DATA_SIZE));
+	cmp_par.cmp_mode = CMP_MODE_DIFF_ZERO;
+	cmp_par.s_exp_flags = 1;
+	cmp_par.s_fx = 1;
+
+	cmp_ctx_init(&ctx1, get_timestamp_ctx_1, 0x1111);
+	cmp_ctx_init(&ctx2, get_timestamp_ctx_2, 0x2222);
+	compress_chunk_init(NULL, 0x3333);
+
+	/* the contexts do not influence each other */
+	size1 = compress_chunk_ctx(&ctx1, chunk, CHUNK_SIZE, NULL, NULL,
+				   dst1, sizeof(dst1), &cmp_par);
+	size2 = compress_chunk_ctx(&ctx2, chunk, CHUNK_SIZE, NULL, NULL,
+				   dst2, sizeof(dst2), &cmp_par);
+	TEST_ASSERT_FALSE(cmp_is_error(size1));
+	TEST_ASSERT_EQUAL_UINT32(size1, size2);
+	TEST_ASSERT_EQUAL_HEX32(0x1111, cmp_ent_get_version_id(ent1));
+	TEST_ASSERT(cmp_ent_get_start_timestamp(ent1) == 0x111111111111ULL);
+	TEST_ASSERT(cmp_ent_get_end_timestamp(ent1) == 0x111111111111ULL);
+	TEST_ASSERT_EQUAL_HEX32(0x2222, cmp_ent_get_version_id(ent2));
+	TEST_ASSERT(cmp_ent_get_start_timestamp(ent2) == 0x222222222222ULL);
+	TEST_ASSERT(cmp_ent_get_end_timestamp(ent2) == 0x222222222222ULL);
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(cmp_ent_get_data_buf(ent1), cmp_ent_get_data_buf(ent2),
+				     size1 - NON_IMAGETTE_HEADER_SIZE);
+
+	/* compress_chunk() uses the settings of compress_chunk_init() */
+	size2 = compress_chunk(chunk, CHUNK_SIZE, NULL, NULL, dst2, sizeof(dst2), &cmp_par);
+	TEST_ASSERT_EQUAL_UINT32(size1, size2);
+	TEST_ASSERT_EQUAL_HEX32(0x3333, cmp_ent_get_version_id(ent2));
+
+	/* the parallel compression gives the same result */
+	cmp_ctx_set_parallel(&ctx2, work_buf, sizeof(work_buf), run_jobs_serial, NULL);
+	memset(dst2, 0, sizeof(dst2));
+	cmp_ctx_init(&ctx1, get_timestamp_ctx_2, 0x2222);
+	size1 = compress_chunk_ctx(&ctx1, chunk, CHUNK_SIZE, NULL, NULL,
+				   dst1, sizeof(dst1), &cmp_par);
+	size2 = compress_chunk_ctx(&ctx2, chunk, CHUNK_SIZE, NULL, NULL,
+				   dst2, sizeof(dst2), &cmp_par);
+	TEST_ASSERT_EQUAL_UINT32(size1, size2);
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(dst1, dst2, size1);
+
+	/* error: no context */
+	size1 = compress_chunk_ctx(NULL, chunk, CHUNK_SIZE, NULL, NULL,
+				   dst1, sizeof(dst1), &cmp_par);
+	TEST_ASSERT_EQUAL_INT(CMP_ERROR_GENERIC, cmp_get_error_code(size1));
+
+	/* no crash */
+	cmp_ctx_init(NULL, NULL, 0);
+	cmp_ctx_set_parallel(NULL, NULL, 0, NULL, NULL);
+}
+
+
 /**
  * @test zero_escape_mech_is_used
  */
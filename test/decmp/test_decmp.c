@@ -1049,6 +1049,263 @@ void test_decompress_imagette_model(void)
 }
 
 
+/**
+ * @test build_decode_table
+ * @test decode_values
+ */
+
+void test_build_decode_table(void)
+{
+	static const uint32_t cmp_pars[] = {1, 2, 3, 4, 5, 7, 8, 12, 16, 31, 32, 100};
+	static const uint32_t spills[] = {2, 9, 60};
+	static struct decode_table_entry table[1U << DECODE_TABLE_BITS];
+	size_t p, s;
+	int m;
+
+	for (m = 0; m < 2; m++) {
+		enum cmp_mode const cmp_mode = m ? CMP_MODE_MODEL_MULTI : CMP_MODE_MODEL_ZERO;
+
+		for (p = 0; p < ARRAY_SIZE(cmp_pars); p++) {
+			for (s = 0; s < ARRAY_SIZE(spills); s++) {
+				struct decoder_setup setup;
+				struct bit_decoder dec;
+				uint32_t idx;
+
+				configure_decoder_setup(&setup, &dec, cmp_mode, cmp_pars[p],
+							spills[s], CMP_LOSSLESS, 16);
+				build_decode_table(table, &setup);
+
+				for (idx = 0; idx < (1U << DECODE_TABLE_BITS); idx++) {
+					const struct decode_table_entry *entry = &table[idx];
+					uint64_t window = cpu_to_be64((uint64_t)idx << (64 - DECODE_TABLE_BITS));
+					uint32_t k, value, cw;
+
+					/* the values in the table are decoded like without table */
+					bit_init_decoder(&dec, &window, sizeof(window));
+					for (k = 0; k < entry->n_values; k++) {
+						TEST_ASSERT_FALSE(setup.decode_method_f(&setup, &value));
+						TEST_ASSERT_EQUAL_HEX32(value, entry->value[k]);
+					}
+					TEST_ASSERT_EQUAL_UINT(entry->n_bits, dec.bits_consumed);
+					TEST_ASSERT_TRUE(entry->n_bits <= DECODE_TABLE_BITS);
+					if (entry->n_values == DECODE_TABLE_VALUES)
+						continue;
+
+					/* the next code word is not in the look up bits or
+					 * is an escape symbol
+					 */
+					cw = setup.decode_cw_f(&dec, setup.encoder_par1, setup.encoder_par2);
+					TEST_ASSERT_TRUE(dec.bits_consumed > DECODE_TABLE_BITS ||
+							 cw >= setup.outlier_par || (!m && cw == 0));
+				}
+			}
+		}
+	}
+}
+
+
+/**
+ * @brief decompress imagette chunks large enough to be decoded with a decode
+ *	table and compare the result with the original data
+ *
+ * @test decompress_imagette
+ */
+
+void test_decompress_imagette_table(void)
+{
+	static const uint32_t cmp_pars[] = {1, 3, 4, 6, 8, 16};
+	enum {SAMPLES = DECODE_TABLE_MIN_SAMPLES + 77};
+	uint32_t const chunk_size = COLLECTION_HDR_SIZE + SAMPLES * sizeof(uint16_t);
+	uint8_t *chunk, *model, *up_model, *decmp_data, *decmp_model;
+	uint16_t *data_p, *model_p;
+	uint32_t *dst, dst_capacity;
+	uint32_t rnd = 42;
+	enum cmp_mode cmp_mode;
+	size_t p, i;
+
+	chunk = calloc(1, chunk_size); TEST_ASSERT_NOT_NULL(chunk);
+	model = calloc(1, chunk_size); TEST_ASSERT_NOT_NULL(model);
+	up_model = malloc(chunk_size); TEST_ASSERT_NOT_NULL(up_model);
+	decmp_data = malloc(chunk_size); TEST_ASSERT_NOT_NULL(decmp_data);
+	decmp_model = malloc(chunk_size); TEST_ASSERT_NOT_NULL(decmp_model);
+	TEST_ASSERT_FALSE(cmp_col_set_subservice((struct collection_hdr *)chunk,
+						 SST_NCxx_S_SCIENCE_IMAGETTE));
+	TEST_ASSERT_FALSE(cmp_col_set_data_length((struct collection_hdr *)chunk,
+						  SAMPLES * sizeof(uint16_t)));
+	memcpy(model, chunk, COLLECTION_HDR_SIZE);
+
+	/* small residuals with some outliers */
+	data_p = (uint16_t *)(chunk + COLLECTION_HDR_SIZE);
+	model_p = (uint16_t *)(model + COLLECTION_HDR_SIZE);
+	for (i = 0; i < SAMPLES; i++) {
+		uint32_t residual;
+
+		rnd = rnd * 1103515245U + 12345U;
+		residual = (rnd >> 16) % 7;
+		if ((rnd >> 8) % 64 == 0)
+			residual = (rnd >> 4) % 3000;
+		model_p[i] = (uint16_t)(1000 + (rnd >> 20) % 8);
+		data_p[i] = (uint16_t)(model_p[i] + residual - 3);
+	}
+
+	dst_capacity = compress_chunk_cmp_size_bound(chunk, chunk_size);
+	TEST_ASSERT_FALSE(cmp_is_error(dst_capacity));
+	dst = malloc(dst_capacity); TEST_ASSERT_NOT_NULL(dst);
+
+	for (cmp_mode = CMP_MODE_MODEL_ZERO; cmp_mode <= CMP_MODE_DIFF_MULTI; cmp_mode++) {
+		for (p = 0; p < ARRAY_SIZE(cmp_pars); p++) {
+			struct cmp_par par;
+			uint32_t cmp_size;
+			int decmp_size;
+
+			memset(&par, 0, sizeof(par));
+			par.cmp_mode = cmp_mode;
+			par.model_value = 8;
+			par.lossy_par = CMP_LOSSLESS;
+			par.nc_imagette = cmp_pars[p];
+
+			cmp_size = compress_chunk(chunk, chunk_size, model, up_model,
+						  dst, dst_capacity, &par);
+			TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+
+			decmp_size = decompress_cmp_entiy((struct cmp_entity *)dst, model,
+							  decmp_model, decmp_data);
+			TEST_ASSERT_EQUAL_INT(chunk_size, decmp_size);
+			TEST_ASSERT_EQUAL_HEX8_ARRAY(chunk, decmp_data, chunk_size);
+			if (model_mode_is_used(cmp_mode))
+				TEST_ASSERT_EQUAL_HEX8_ARRAY(up_model, decmp_model, chunk_size);
+
+			/* a truncated bitstream is detected */
+			if (cmp_size > NON_IMAGETTE_HEADER_SIZE + CMP_COLLECTION_FILD_SIZE +
+			    COLLECTION_HDR_SIZE + 8 && cmp_size < chunk_size) {
+				uint8_t *col_size_field = (uint8_t *)dst + NON_IMAGETTE_HEADER_SIZE;
+				uint16_t col_size = (uint16_t)(col_size_field[0] << 8 | col_size_field[1]);
+
+				col_size -= 8;
+				col_size_field[0] = (uint8_t)(col_size >> 8);
+				col_size_field[1] = (uint8_t)col_size;
+				TEST_ASSERT_FALSE(cmp_ent_set_size((struct cmp_entity *)dst, cmp_size - 8));
+				TEST_ASSERT_TRUE(decompress_cmp_entiy((struct cmp_entity *)dst, model,
+								      NULL, decmp_data) < 0);
+			}
+		}
+	}
+
+	free(chunk);
+	free(model);
+	free(up_model);
+	free(decmp_data);
+	free(decmp_model);
+	free(dst);
+}
+
+
+/**
+ * @test index_cmp_collections
+ * @test count_cmp_collections
+ * @test decompress_cmp_entiy
+ */
+
+void test_index_cmp_collections(void)
+{
+	enum {N_COLS = 2 * CMP_COL_INDEX_BATCH + 3};
+	struct cmp_col_index index[N_COLS + 1];
+	struct cmp_col_walk walk;
+	struct cmp_entity *ent;
+	uint8_t *chunk, *decmp_data, *col_size_field;
+	uint32_t chunk_size = 0, dst_capacity, cmp_size, decmp_pos;
+	uint32_t *dst;
+	struct cmp_par par;
+	uint16_t col_size;
+	int i, n;
+
+	/* a chunk with many small collections of different sizes */
+	for (i = 0; i < N_COLS; i++)
+		chunk_size += COLLECTION_HDR_SIZE + (uint32_t)(1 + i % 5) * sizeof(uint16_t);
+	chunk = calloc(1, chunk_size); TEST_ASSERT_NOT_NULL(chunk);
+	decmp_data = malloc(chunk_size); TEST_ASSERT_NOT_NULL(decmp_data);
+	decmp_pos = 0;
+	for (i = 0; i < N_COLS; i++) {
+		struct collection_hdr *col = (struct collection_hdr *)(chunk + decmp_pos);
+		uint16_t *data_p = (uint16_t *)(chunk + decmp_pos + COLLECTION_HDR_SIZE);
+		int j;
+
+		TEST_ASSERT_FALSE(cmp_col_set_subservice(col, SST_NCxx_S_SCIENCE_IMAGETTE));
+		TEST_ASSERT_FALSE(cmp_col_set_data_length(col, (uint16_t)((1 + i % 5) * sizeof(uint16_t))));
+		for (j = 0; j < 1 + i % 5; j++)
+			data_p[j] = (uint16_t)(i * 7 + j);
+		decmp_pos += cmp_col_get_size(col);
+	}
+
+	dst_capacity = compress_chunk_cmp_size_bound(chunk, chunk_size);
+	TEST_ASSERT_FALSE(cmp_is_error(dst_capacity));
+	dst = calloc(1, dst_capacity); TEST_ASSERT_NOT_NULL(dst);
+	memset(&par, 0, sizeof(par));
+	par.cmp_mode = CMP_MODE_DIFF_ZERO;
+	par.lossy_par = CMP_LOSSLESS;
+	par.nc_imagette = 4;
+	cmp_size = compress_chunk(chunk, chunk_size, NULL, NULL, dst, dst_capacity, &par);
+	TEST_ASSERT_FALSE(cmp_is_error(cmp_size));
+	ent = (struct cmp_entity *)dst;
+
+	/* the collections are indexed in one walk */
+	cmp_col_walk_init(&walk, ent, 0, 0, chunk_size);
+	n = index_cmp_collections(&walk, index, ARRAY_SIZE(index));
+	TEST_ASSERT_EQUAL_INT(N_COLS, n);
+	TEST_ASSERT_EQUAL_INT(0, index_cmp_collections(&walk, index, ARRAY_SIZE(index)));
+	TEST_ASSERT_EQUAL_UINT32(cmp_ent_get_cmp_data_size(ent), walk.cmp_pos);
+	TEST_ASSERT_EQUAL_UINT32(chunk_size, walk.decmp_pos);
+	decmp_pos = 0;
+	for (i = 0; i < n; i++) {
+		const struct collection_hdr *col = (struct collection_hdr *)(chunk + decmp_pos);
+
+		TEST_ASSERT_EQUAL_UINT32(decmp_pos, index[i].decmp_offset);
+		TEST_ASSERT_EQUAL_UINT32(cmp_col_get_data_length(col), index[i].data_length);
+		TEST_ASSERT_EQUAL_INT(DATA_TYPE_IMAGETTE, index[i].data_type);
+		if (i > 0)
+			TEST_ASSERT_EQUAL_UINT32(index[i-1].cmp_offset + CMP_COLLECTION_FILD_SIZE +
+						 COLLECTION_HDR_SIZE + index[i-1].cmp_data_size,
+						 index[i].cmp_offset);
+		decmp_pos += cmp_col_get_size(col);
+	}
+
+	/* the index is built in batches */
+	cmp_col_walk_init(&walk, ent, 0, 0, chunk_size);
+	TEST_ASSERT_EQUAL_INT(5, index_cmp_collections(&walk, index, 5));
+	TEST_ASSERT_EQUAL_INT(n - 5, index_cmp_collections(&walk, &index[5], ARRAY_SIZE(index)));
+	TEST_ASSERT_EQUAL_UINT32(index[5].cmp_offset + CMP_COLLECTION_FILD_SIZE +
+				 COLLECTION_HDR_SIZE + index[5].cmp_data_size, index[6].cmp_offset);
+
+	TEST_ASSERT_EQUAL_INT(chunk_size, decompress_cmp_entiy(ent, NULL, NULL, decmp_data));
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(chunk, decmp_data, chunk_size);
+
+	/* the decompressed data do not fit in the original size */
+	cmp_col_walk_init(&walk, ent, 0, 0, chunk_size - 1);
+	TEST_ASSERT_EQUAL_INT(-1, index_cmp_collections(&walk, index, ARRAY_SIZE(index)));
+
+	/* a collection size not matching the compressed data size is detected
+	 * before any data are decompressed
+	 */
+	col_size_field = (uint8_t *)cmp_ent_get_data_buf(ent) + index[n-1].cmp_offset;
+	col_size = (uint16_t)(col_size_field[0] << 8 | col_size_field[1]);
+	col_size_field[0] = (uint8_t)((col_size + 1) >> 8);
+	col_size_field[1] = (uint8_t)(col_size + 1);
+	memset(decmp_data, 0, chunk_size);
+	TEST_ASSERT_TRUE(decompress_cmp_entiy(ent, NULL, NULL, decmp_data) < 0);
+	for (i = 0; i < (int)chunk_size; i++)
+		TEST_ASSERT_EQUAL_HEX8(0, decmp_data[i]);
+	col_size_field[0] = (uint8_t)((col_size - 1) >> 8);
+	col_size_field[1] = (uint8_t)(col_size - 1);
+	TEST_ASSERT_TRUE(decompress_cmp_entiy(ent, NULL, NULL, decmp_data) < 0);
+	for (i = 0; i < (int)chunk_size; i++)
+		TEST_ASSERT_EQUAL_HEX8(0, decmp_data[i]);
+
+	free(chunk);
+	free(decmp_data);
+	free(dst);
+}
+
+
 /**
  * @test decompress_cmp_entiy
  */
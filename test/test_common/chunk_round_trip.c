@@ -22,6 +22,8 @@
 #include "../test_common/test_common.h"
 #include "../../lib/cmp_chunk.h"
 #include "../../lib/decmp.h"
+#include "../../lib/common/cmp_data_types.h"
+#include "../../lib/common/cmp_cal_up_model.h"
 #include "chunk_round_trip.h"
 
 #ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
@@ -53,6 +55,103 @@ static void *TEST_malloc(size_t size)
 }
 
 
+/**
+ * @brief rounds the data of a collection like a lossy compression
+ *
+ * @param col	pointer to the collection
+ * @param round	lossy compression parameter
+ */
+
+static void round_collection(struct collection_hdr *col, uint32_t round)
+{
+	enum cmp_data_type data_type =
+		convert_subservice_to_cmp_data_type(cmp_col_get_subservice(col));
+	uint32_t const data_length = cmp_col_get_data_length(col);
+	uint32_t i;
+
+	switch (data_type) {
+	case DATA_TYPE_OFFSET: {
+		struct offset *entry = (struct offset *)col->entry;
+
+		for (i = 0; i < data_length / sizeof(*entry); i++) {
+			entry[i].mean = round_inv(round_fwd(entry[i].mean, round), round);
+			entry[i].variance = round_inv(round_fwd(entry[i].variance, round), round);
+		}
+		break;
+	}
+	case DATA_TYPE_BACKGROUND: {
+		struct background *entry = (struct background *)col->entry;
+
+		for (i = 0; i < data_length / sizeof(*entry); i++) {
+			entry[i].mean = round_inv(round_fwd(entry[i].mean, round), round);
+			entry[i].variance = round_inv(round_fwd(entry[i].variance, round), round);
+			entry[i].outlier_pixels = (uint16_t)round_inv(
+				round_fwd(entry[i].outlier_pixels, round), round);
+		}
+		break;
+	}
+	case DATA_TYPE_SMEARING: {
+		struct smearing *entry = (struct smearing *)col->entry;
+
+		for (i = 0; i < data_length / sizeof(*entry); i++) {
+			entry[i].mean = round_inv(round_fwd(entry[i].mean, round), round);
+			entry[i].variance_mean = round_inv(round_fwd(entry[i].variance_mean,
+								     round), round);
+			entry[i].outlier_pixels = (uint16_t)round_inv(
+				round_fwd(entry[i].outlier_pixels, round), round);
+		}
+		break;
+	}
+	default: /* the other data types are compressed lossless */
+		break;
+	}
+}
+
+
+/**
+ * @brief gets the expected decompressed data of a lossy compressed chunk
+ *
+ * The compressed collections are rounded by the lossy compression parameter;
+ * collections put uncompressed into the compression entity keep their data.
+ *
+ * @param chunk		pointer to the uncompressed chunk
+ * @param chunk_size	byte size of the chunk
+ * @param ent		pointer to the compression entity of the chunk
+ *
+ * @returns a pointer to the allocated expected chunk data
+ */
+
+static void *get_lossy_chunk(const void *chunk, uint32_t chunk_size,
+			     const struct cmp_entity *ent)
+{
+	uint8_t *exp_chunk = TEST_malloc(chunk_size);
+	const uint8_t *cmp_col = cmp_ent_get_data_buf_const(ent);
+	uint32_t const round = cmp_ent_get_lossy_cmp_par(ent);
+	uint32_t read_bytes;
+
+	memcpy(exp_chunk, chunk, chunk_size);
+	if (cmp_ent_get_cmp_mode(ent) == CMP_MODE_RAW)
+		return exp_chunk;
+
+	for (read_bytes = 0; read_bytes < chunk_size;
+	     read_bytes += cmp_col_get_size((struct collection_hdr *)(exp_chunk + read_bytes))) {
+		struct collection_hdr *col = (struct collection_hdr *)(exp_chunk + read_bytes);
+		uint32_t const cmp_data_size = (uint32_t)cmp_col[0] << 8 | cmp_col[1];
+
+		/* see get_cmp_collection_data_length() for the layout */
+		cmp_col += CMP_COLLECTION_FILD_SIZE + COLLECTION_HDR_SIZE + cmp_data_size;
+		if (cmp_data_size == cmp_col_get_data_length(col))
+			continue; /* uncompressed collection */
+
+		round_collection(col, round);
+		if (cmp_ent_get_reserved(ent) & CMP_ENT_FLAG_COL_PARS)
+			cmp_col += CMP_COL_PAR_MASK_SIZE +
+				CMP_COL_PAR_SIZE * (uint32_t)__builtin_popcount(cmp_col[0]);
+	}
+	return exp_chunk;
+}
+
+
 /**
  * @brief performs chunk compression and checks if a decompression is possible
  *
@@ -149,7 +248,15 @@ uint32_t chunk_round_trip(const void *chunk, uint32_t chunk_size,
 		TEST_ASSERT((uint32_t)decmp_size == chunk_size);
 
 		if (use_decmp_buf) {
-			TEST_ASSERT(!memcmp(chunk, decmp_data, chunk_size));
+			if (cmp_ent_get_lossy_cmp_par((struct cmp_entity *)dst) == CMP_LOSSLESS) {
+				TEST_ASSERT(!memcmp(chunk, decmp_data, chunk_size));
+			} else {
+				void *exp_chunk = get_lossy_chunk(chunk, chunk_size,
+								  (struct cmp_entity *)dst);
+
+				TEST_ASSERT(!memcmp(exp_chunk, decmp_data, chunk_size));
+				free(exp_chunk);
+			}
 
 			/*
 			 * the model is only updated when the decompressed_data